@@ -30,6 +30,8 @@ ADC.c
 #include<xc.h>
 #include "header.h"
 #include <proc/p32mz2048efm100.h>
+#include "hal.h"
+#include "ADC.h"
 
 
 void ADC_init()
@@ -37,7 +39,7 @@ void ADC_init()
     
 /* Function to initialize ADC for PIC32 MZ
  */    
-    asm volatile("di"); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
+    __builtin_disable_interrupts(); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
 
     
 /*Configure pins 2,3,and 4 of port B( AN2,AN3,AN4) as analog pins*/
@@ -158,30 +160,30 @@ void ADC_init()
     ADCCON3bits.DIGEN3 = 1; // Enable ADC3
     ADCCON3bits.DIGEN4 = 1; // Enable ADC4
  
-    //asm volatile("ei"); // Enable Global Interrupts once all peripherals are configured
+    //__builtin_enable_interrupts(); // Enable Global Interrupts once all peripherals are configured
 
     
 }
 
 
 
-void getADC(uint16_t *ADC1, uint16_t *ADC2, uint16_t *ADC3)
+RAMFUNC void getADC(volatile uint16_t *ADC1, volatile uint16_t *ADC2, volatile uint16_t *ADC3)
 {
         //extern uint16_t resultADC[3];
         // Trigger a conversion 
-        ADCCON3bits.GSWTRG = 1;
+        hal_adc_trigger();
         // Wait the conversions to complete 
-        while (ADCDSTAT1bits.ARDY2 == 0);
+        while (!hal_adc_ready(2));
         // fetch the result 
         //resultADC[0] = ADCDATA2;
-        *ADC1=ADCDATA2;
-        while (ADCDSTAT1bits.ARDY3 == 0);
+        *ADC1=hal_adc_result(2);
+        while (!hal_adc_ready(3));
         // fetch the result 
         //resultADC[1] = ADCDATA3;
-        *ADC2=ADCDATA3;
-        while (ADCDSTAT1bits.ARDY4 == 0);
+        *ADC2=hal_adc_result(3);
+        while (!hal_adc_ready(4));
         // fetch the result 
         //resultADC[2] = ADCDATA4;
-        *ADC3=ADCDATA4;
+        *ADC3=hal_adc_result(4);
         //return resultADC;
 }
\ No newline at end of file
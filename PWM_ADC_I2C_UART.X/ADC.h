@@ -14,16 +14,19 @@ ADC.h
 
 @Summary
  Function prototypes for ADC.c
+ */
 
 #ifndef _ADC_H    /* Guard against multiple inclusion */
 #define _ADC_H
 
+#include <stdint.h>
+#include "ramfunc.h"
 
 /*prototypes in ADC.c*/
 void ADC_init();
-void getADC(volatile uint16_t *,volatile uint16_t *,volatile uint16_t *);
+RAMFUNC void getADC(volatile uint16_t *,volatile uint16_t *,volatile uint16_t *);
 
-#endif /* _EXAMPLE_FILE_NAME_H */
+#endif /* _ADC_H */
 
 /* *****************************************************************************
  End of File
@@ -13,6 +13,10 @@
   @Description
  This file contains the function definition of the functions for the 
  * AS5600L encoder from AMS system.
+ * The angle of each joint can either be polled over I2C1 or decoded from the 
+ * PWM output of the encoder. The PWM output is timestamped by Input Capture 
+ * modules IC1(knee) and IC2(ankle) using Timer3 as the time base, the angle is 
+ * computed in the capture ISR and no I2C transaction is needed to read it.
  /* ************************************************************************** */
 
 
@@ -20,6 +24,9 @@
 #include "header.h"
 #include <proc/p32mz2048efm100.h>
 #include "I2C.h"
+#include "AS5600L.h"
+#include "isr_profile.h"
+#include "ramfunc.h"
 
 /*Methods for the Encoders
  ........................
@@ -58,3 +65,220 @@ void encoderRead(uint8_t i2c_address, uint8_t data_address, uint16_t *angle)
 }
 
 
+/*Methods for decoding the PWM output of the Encoders
+ ........................
+ *************************/
+/*State of the decoder for each joint, written in the capture ISR's*/
+static volatile uint16_t rise_time[NUMBER_OF_JOINTS];   /* Timer3 value at the last rising edge*/
+static volatile uint16_t high_time[NUMBER_OF_JOINTS];   /* Timer3 ticks the output was high in the last frame*/
+static volatile uint16_t pwm_angle[NUMBER_OF_JOINTS];   /* Latest decoded angle*/
+static volatile uint8_t edge_level[NUMBER_OF_JOINTS];   /* Level of the pin after the next captured edge*/
+static volatile uint8_t frame_edges[NUMBER_OF_JOINTS];  /* Edges of the current frame since the sync, 1 rising, 2 both*/
+static uint8_t encoder_source[NUMBER_OF_JOINTS]={ENCODER_SOURCE_I2C,ENCODER_SOURCE_I2C};
+
+static const uint8_t encoder_address[NUMBER_OF_JOINTS]={KNEE_ENCODER_ADDRESS,ANKLE_ENCODER_ADDRESS};
+
+/*Function to wait for the first rising edge after the Input Capture of the joint is (re)started.
+ * The capture starts with a rising edge (FEDGE) and the edges alternate from there*/
+static RAMFUNC void encoderPWM_sync(uint8_t joint)
+{
+    edge_level[joint] = 1;
+    frame_edges[joint] = 0;
+}
+
+/*Function to convert a single edge captured by the Input Capture into an angle.
+ * The level after the edge follows from the parity of the edges since the sync, not 
+ * from the pin, which is only valid for the last of several queued edges. On every 
+ * rising edge after a complete frame the angle is returned, computed from the ratio of 
+ * high time and period so the result does not depend on the clock frequency of the 
+ * encoder or of Timer3, -1 otherwise*/
+static RAMFUNC int16_t encoderPWM_edge(uint8_t joint, uint16_t timestamp)
+{
+    uint8_t level = edge_level[joint];
+
+    edge_level[joint] = !level;
+    if(level)
+    {
+        uint16_t period = timestamp - rise_time[joint];  /* wraps correctly as Timer3 runs over 16 bits*/
+        uint8_t complete = frame_edges[joint] == 2;
+        uint32_t clocks;
+        rise_time[joint] = timestamp;
+        frame_edges[joint] = 1;
+        if(!complete || period == 0 || high_time[joint] >= period)
+            return -1;                                  /* first frame after the sync or a bad frame, skip it*/
+
+        clocks = ((uint32_t)high_time[joint] * ENCODER_PWM_FRAME_CLOCKS + period / 2) / period;
+        if(clocks < ENCODER_PWM_HEADER_CLOCKS)
+            clocks = ENCODER_PWM_HEADER_CLOCKS;
+        clocks -= ENCODER_PWM_HEADER_CLOCKS;
+        if(clocks > 4095)
+            clocks = 4095;
+        return clocks;
+    }
+    if(frame_edges[joint] == 1)
+    {
+        high_time[joint] = timestamp - rise_time[joint];
+        frame_edges[joint] = 2;
+    }
+    return -1;
+}
+
+/*Input Capture 1 ISR, captures both edges of the PWM output of the knee encoder on RPD0.
+ * The flag is cleared first, an edge captured while the buffer is read raises it again.
+ * After the buffer is empty the pin has to be at the level of the last edge; if it is 
+ * not, or the buffer overflowed, edges were lost: the angles of this run are dropped and
+ * the capture is restarted, which empties the buffer and clears ICOV. The pin is read 
+ * before ICBNE, an edge in between is in the buffer and is checked by the next run*/
+void __attribute__((vector(_INPUT_CAPTURE_1_VECTOR), interrupt(ipl5srs), nomips16)) knee_encoder_capture()
+{
+    int16_t angle = -1, frame;
+    uint8_t level;
+
+    ISR_PROFILE_ENTER(ISR_ID_KNEE_CAPTURE);
+    reg_clear(&IFS0, _IFS0_IC1IF_MASK);     // Clear interrupt flag for input capture 1
+    while(IC1CONbits.ICBNE)
+    {
+        frame = encoderPWM_edge(KNEE_JOINT, IC1BUF);
+        if(frame >= 0)
+            angle = frame;
+    }
+    level = PORTDbits.RD0;
+    if(IC1CONbits.ICOV || (level == edge_level[KNEE_JOINT] && !IC1CONbits.ICBNE))
+    {
+        IC1CONbits.ON = 0;                  // Empty the buffer and clear the overflow
+        IC1CONbits.ON = 1;                  // Capture from the next rising edge
+        encoderPWM_sync(KNEE_JOINT);
+    }
+    else if(angle >= 0)
+        pwm_angle[KNEE_JOINT] = angle;
+    ISR_PROFILE_EXIT(ISR_ID_KNEE_CAPTURE);
+}
+
+/*Input Capture 2 ISR, captures both edges of the PWM output of the ankle encoder on RPB8*/
+void __attribute__((vector(_INPUT_CAPTURE_2_VECTOR), interrupt(ipl5srs), nomips16)) ankle_encoder_capture()
+{
+    int16_t angle = -1, frame;
+    uint8_t level;
+
+    ISR_PROFILE_ENTER(ISR_ID_ANKLE_CAPTURE);
+    reg_clear(&IFS0, _IFS0_IC2IF_MASK);     // Clear interrupt flag for input capture 2
+    while(IC2CONbits.ICBNE)
+    {
+        frame = encoderPWM_edge(ANKLE_JOINT, IC2BUF);
+        if(frame >= 0)
+            angle = frame;
+    }
+    level = PORTBbits.RB8;
+    if(IC2CONbits.ICOV || (level == edge_level[ANKLE_JOINT] && !IC2CONbits.ICBNE))
+    {
+        IC2CONbits.ON = 0;                  // Empty the buffer and clear the overflow
+        IC2CONbits.ON = 1;                  // Capture from the next rising edge
+        encoderPWM_sync(ANKLE_JOINT);
+    }
+    else if(angle >= 0)
+        pwm_angle[ANKLE_JOINT] = angle;
+    ISR_PROFILE_EXIT(ISR_ID_ANKLE_CAPTURE);
+}
+
+/*Function to setup the Input Capture for the encoder of the given joint.
+ * Timer3 is used as a free running time base for the captures. It is clocked by PBCLK3 with the
+ * smallest prescaler for which one frame of the PWM output spans less than 2^16 ticks of Timer3,
+ * for the slowest PWM the oscillator of the encoder allows (ENCODER_PWM_FREQ_MIN).
+ * Timer3 can still be used to trigger the ADC, as long as PR3 is left at 0xFFFF.
+ */
+void encoderPWM_init(uint8_t joint)
+{
+    uint32_t status = __builtin_disable_interrupts(); // the source can be changed at run time, restored at the end
+
+    /*setup timer3 as a free running timer if it has not been setup already*/
+    if(!T3CONbits.ON)
+    {
+        T3CON = 0x0;            // Disable timer 3 when setting it up
+        TMR3 = 0;               // Set timer 3 counter to 0
+        T3CONbits.TCKPS = CLOCK_TCKPS(ENCODER_CAPTURE_PRESCALER);
+        PR3 = 0xFFFF;           // Let the timer run over the full 16 bits
+        T3CONbits.ON = 1;       // Turn on timer 3
+    }
+
+    encoderPWM_sync(joint);
+    if(joint == KNEE_JOINT)
+    {
+        TRISDbits.TRISD0 = 1;       // set RD0 as input
+        IC1R = KNEE_ENCODER_IC_PPS; // RPD0 = IC1
+
+        IC1CON = 0x0;               // Disable input capture 1 when setting it up
+        IC1CONbits.C32 = 0;         // 16 bit capture
+        IC1CONbits.ICTMR = 0;       // Timer3 is the time base
+        IC1CONbits.ICI = 0;         // Interrupt on every capture event
+        IC1CONbits.ICM = 0b110;     // Capture every edge
+        IC1CONbits.FEDGE = 1;       // starting with a rising edge
+
+        reg_clear(&IFS0, _IFS0_IC1IF_MASK);         // Clear interrupt flag for input capture 1
+        IPC1bits.IC1IP = 5;         // Interrupt priority 5
+        IPC1bits.IC1IS = 1;         // Sub-priority 1
+        IEC0bits.IC1IE = 1;         // Enable input capture 1 interrupt
+        IC1CONbits.ON = 1;          // Turn on input capture 1
+    }
+    else
+    {
+        ANSELBbits.ANSB8 = 0;       // force RB8 to be digital
+        TRISBbits.TRISB8 = 1;       // set RB8 as input
+        IC2R = ANKLE_ENCODER_IC_PPS;// RPB8 = IC2
+
+        IC2CON = 0x0;               // Disable input capture 2 when setting it up
+        IC2CONbits.C32 = 0;         // 16 bit capture
+        IC2CONbits.ICTMR = 0;       // Timer3 is the time base
+        IC2CONbits.ICI = 0;         // Interrupt on every capture event
+        IC2CONbits.ICM = 0b110;     // Capture every edge
+        IC2CONbits.FEDGE = 1;       // starting with a rising edge
+
+        reg_clear(&IFS0, _IFS0_IC2IF_MASK);         // Clear interrupt flag for input capture 2
+        IPC2bits.IC2IP = 5;         // Interrupt priority 5
+        IPC2bits.IC2IS = 1;         // Sub-priority 1
+        IEC0bits.IC2IE = 1;         // Enable input capture 2 interrupt
+        IC2CONbits.ON = 1;          // Turn on input capture 2
+    }
+
+    __builtin_mtc0(12, 0, status);  // interrupts as they were, still disabled during the setup at boot
+}
+
+/*Function to select where the angle of a joint comes from.
+ * For ENCODER_SOURCE_PWM the output stage of the encoder is switched to a 920Hz PWM 
+ * over I2C and the Input Capture of the joint is started. CONF_L is read with CONF_H 
+ * and only PWMF and OUTS are changed, the hysteresis and power mode are kept.
+ * For ENCODER_SOURCE_I2C the Input Capture of the joint is switched off.
+ * main() selects the PWM source for both joints when ENCODER_PWM is defined.
+ */
+void encoderSetSource(uint8_t joint, uint8_t source)
+{
+    uint16_t conf;
+
+    if(source == ENCODER_SOURCE_PWM)
+    {
+        encoderRead(encoder_address[joint], ENCODER_CONF_H_REG, &conf);     // CONF_L in the low byte
+        encoderWrite(encoder_address[joint], ENCODER_CONF_L_REG,
+                     (conf & ~ENCODER_CONF_L_OUTPUT_MASK & 0xFF) | ENCODER_CONF_L_PWM_920HZ);
+        encoderPWM_init(joint);
+    }
+    else if(joint == KNEE_JOINT)
+    {
+        IEC0bits.IC1IE = 0;         // Disable input capture 1 interrupt
+        IC1CONbits.ON = 0;          // Turn off input capture 1
+    }
+    else
+    {
+        IEC0bits.IC2IE = 0;         // Disable input capture 2 interrupt
+        IC2CONbits.ON = 0;          // Turn off input capture 2
+    }
+    encoder_source[joint] = source;
+}
+
+/*Function to get the angle of a joint from the source selected by encoderSetSource().
+ * The PWM source returns the angle decoded at the last complete frame and does not use I2C*/
+void encoderGetAngle(uint8_t joint, uint16_t *angle)
+{
+    if(encoder_source[joint] == ENCODER_SOURCE_PWM)
+        *angle = pwm_angle[joint];
+    else
+        encoderRead(encoder_address[joint], ENCODER_ANGLE_REG, angle);
+}
@@ -22,6 +22,35 @@
 #define KNEE_ENCODER_ADDRESS 0x30     // The address of knee Encoder on the I2C bus
 #define ANKLE_ENCODER_ADDRESS 0x40      //The address of the ankle Encoder on tht I2c bus
 #define ENCODER_ANGLE_REG  0x0E  // Register that stores the angle data in the encoder
+#define ENCODER_CONF_H_REG 0x07  // Upper configuration byte, followed by the lower one
+#define ENCODER_CONF_L_REG 0x08  // Lower configuration byte: PWMF[7:6], OUTS[5:4], HYST[3:2], PM[1:0]
+
+/*Joints that carry an encoder, used to select the source of the angle per joint*/
+#define KNEE_JOINT  0
+#define ANKLE_JOINT 1
+#define NUMBER_OF_JOINTS 2
+
+/*Sources from which the angle of a joint can be obtained*/
+#define ENCODER_SOURCE_I2C 0    // angle is polled from ENCODER_ANGLE_REG over I2C1
+#define ENCODER_SOURCE_PWM 1    // angle is decoded from the PWM output of the encoder using Input Capture
+
+/*Output stage setting for the PWM source: OUTS=10 (digital PWM), PWMF=11 (920Hz)
+ * The frame of the PWM output is 4351 PWM clocks long, 128 clocks high header, 
+ * 4095 clocks of angle data and 128 clocks low trailer*/
+#define ENCODER_CONF_L_PWM_920HZ 0b11100000
+#define ENCODER_CONF_L_OUTPUT_MASK 0b11110000   // PWMF and OUTS, HYST and PM are kept
+#define ENCODER_PWM_FRAME_CLOCKS 4351
+#define ENCODER_PWM_HEADER_CLOCKS 128
+#define ENCODER_PWM_FREQ_MIN    800     // 920Hz less the tolerance of the oscillator of the encoder
+#define ENCODER_CAPTURE_PRESCALER CLOCK_TIMER_PRESCALER(ENCODER_PWM_FREQ_MIN)  // Timer3, time base of the captures
+
+/*Pins used by the Input Capture modules for the PWM output of the encoders
+ * IC1 - RPD0 for the knee encoder
+ * IC2 - RPB8 for the ankle encoder
+ * IC1 and IC2 are in different input groups of the Peripheral Pin Select, each can
+ * only be mapped to the pins of its group, check table 12-1 of the data sheet*/
+#define KNEE_ENCODER_IC_PPS  0b0011     // IC1R value to map IC1 to RPD0
+#define ANKLE_ENCODER_IC_PPS 0b0010     // IC2R value to map IC2 to RPB8
 
 
 /* Methods for the Encoders*
@@ -32,6 +61,16 @@ void encoderWrite(uint8_t i2c_address, uint8_t data_address,uint8_t value);
 // Read 2 bytes from register at data_address and return in *angle
 void encoderRead(uint8_t i2c_address, uint8_t data_address, uint16_t *angle);
 
+/* Methods for selecting the source of the angle of each joint*
+ * ****************************************************************
+ * ............*/
+// Select ENCODER_SOURCE_I2C or ENCODER_SOURCE_PWM for joint KNEE_JOINT/ANKLE_JOINT. I2C1 needs to be initialized
+void encoderSetSource(uint8_t joint, uint8_t source);
+// Return the latest angle of the joint (0-4095) from the selected source
+void encoderGetAngle(uint8_t joint, uint16_t *angle);
+// Setup Timer3 and Input Capture for decoding the PWM output of the encoder of the joint
+void encoderPWM_init(uint8_t joint);
+
 
 #endif 
 
@@ -28,6 +28,7 @@
 #include <xc.h>
 #include "header.h"
 #include <proc/p32mz2048efm100.h>
+#include "hal.h"
 
 
 
@@ -35,12 +36,12 @@
  to get free before proceeding with the next operation*/
 void I2C_wait_for_idle(void)
 {
-    while(I2C1CON & 0x1F); // Acknowledge sequence not in progress
+    while(hal_i2c_sequence_pending()); // Acknowledge sequence not in progress
                                 // Receive sequence not in progress
                                 // Stop condition not in progress
                                 // Repeated Start condition not in progress
                                 // Start condition not in progress
-    while(I2C1STATbits.TRSTAT); // Bit = 0 ? Master transmit is not in progress
+    while(hal_i2c_transmitting()); // Bit = 0 ? Master transmit is not in progress
 }
 
 // I2C_start() sends a start condition  
@@ -48,9 +49,9 @@ void I2C_start()
 {
     RED_LED_ON;//turn on RED user LED to depict failure to generate start condition
     I2C_wait_for_idle();
-    I2C1CONbits.SEN = 1;
+    hal_i2c_start();
 
-    while (I2C1CONbits.SEN == 1);
+    while (hal_i2c_start_pending());
     RED_LED_OFF;
 }
 
@@ -59,7 +60,7 @@ void I2C_stop()
 {   
     YELLOW_LED_ON;
     I2C_wait_for_idle();
-    I2C1CONbits.PEN = 1;
+    hal_i2c_stop();
     YELLOW_LED_OFF;
 }
 
@@ -67,36 +68,34 @@ void I2C_stop()
 void I2C_restart()
 {
     I2C_wait_for_idle();
-    I2C1CONbits.RSEN = 1;
-    while (I2C1CONbits.RSEN == 1);
+    hal_i2c_restart();
+    while (hal_i2c_restart_pending());
 }
 
 // I2C_ack() sends an ACK condition
 void I2C_ack(void)
 {
     I2C_wait_for_idle();
-    I2C1CONbits.ACKDT = 0; // Set hardware to send ACK bit
-    I2C1CONbits.ACKEN = 1; // Send ACK bit, will be automatically cleared by hardware when sent  
-    while(I2C1CONbits.ACKEN); // Wait until ACKEN bit is cleared, meaning ACK bit has been sent
+    hal_i2c_acknowledge(0); // Send ACK bit, will be automatically cleared by hardware when sent  
+    while(hal_i2c_acknowledge_pending()); // Wait until ACKEN bit is cleared, meaning ACK bit has been sent
 }
 
 // I2C_nack() sends a NACK condition
 void I2C_nack(void) // Acknowledge Data bit
 {
     I2C_wait_for_idle();
-    I2C1CONbits.ACKDT = 1; // Set hardware to send NACK bit
-    I2C1CONbits.ACKEN = 1; // Send NACK bit, will be automatically cleared by hardware when sent  
-    while(I2C1CONbits.ACKEN); // Wait until ACKEN bit is cleared, meaning NACK bit has been sent
+    hal_i2c_acknowledge(1); // Send NACK bit, will be automatically cleared by hardware when sent  
+    while(hal_i2c_acknowledge_pending()); // Wait until ACKEN bit is cleared, meaning NACK bit has been sent
 }
 
 // address is I2C slave address, set wait_ack to 1 to wait for ACK bit or anything else to skip ACK checking  
 void I2C_write(unsigned char address, char wait_ack)
 {
     YELLOW_LED_ON;
-    I2C1TRN = address | 0;				// Send slave address with Read/Write bit cleared
-    while (I2C1STATbits.TBF == 1);		// Wait until transmit buffer is empty
+    hal_i2c_write(address | 0);			// Send slave address with Read/Write bit cleared
+    while (hal_i2c_tx_full());		// Wait until transmit buffer is empty
     I2C_wait_for_idle();				// Wait until I2C bus is idle
-    if (wait_ack) while (I2C1STATbits.ACKSTAT == 1); // Wait until ACK is received  
+    if (wait_ack) while (hal_i2c_nacked()); // Wait until ACK is received  
     YELLOW_LED_OFF;
 }
 
@@ -104,10 +103,10 @@ void I2C_write(unsigned char address, char wait_ack)
 void I2C_read(unsigned char *value, char ack_nack)
 {
     RED_LED_ON;
-    I2C1CONbits.RCEN = 1;				// Receive enable
-    while (I2C1CONbits.RCEN);			// Wait until RCEN is cleared (automatic)  
-    while (!I2C1STATbits.RBF);    		// Wait until Receive Buffer is Full (RBF flag)  
-    *value = I2C1RCV;    				// Retrieve value from I2C1RCV
+    hal_i2c_receive();					// Receive enable
+    while (hal_i2c_receive_pending());	// Wait until RCEN is cleared (automatic)  
+    while (!hal_i2c_rx_full());    		// Wait until Receive Buffer is Full (RBF flag)  
+    *value = hal_i2c_read();			// Retrieve value from I2C1RCV
     
     if (!ack_nack)						// Do we need to send an ACK or a NACK?  
         I2C_ack();						// Send ACK  
@@ -119,7 +118,7 @@ void I2C_read(unsigned char *value, char ack_nack)
 // I2C_init() initializes I2C1 at at frequency of [frequency]Hz
 void I2C_init(double frequency)
 {
-    asm volatile("di"); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
+    __builtin_disable_interrupts(); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
 
     //set i2c pins as input
     TRISAbits.TRISA14=1;
@@ -132,15 +131,15 @@ void I2C_init(double frequency)
     double BRG;
     
     I2C1CON = 0;			// Turn off I2C1 module
-    I2C1CONbits.DISSLW = 1; // Disable slew rate for 100kHz
+    I2C1CONbits.DISSLW = frequency <= 100000 || frequency > 400000; // slew rate control for 400kHz only
     
-    BRG = (1 / (2 * frequency)) - 0.000000104;
-    BRG *= (SYS_FREQ / 2) - 2;    
+    BRG = (1 / (2 * frequency)) - 0.000000104;   // I2CxBRG = (1/(2*F) - TPGD) * PBCLK2 - 2
+    BRG = BRG * PBCLK2_FREQ - 2;
     
     I2C1BRG = (int)BRG;		// Set baud rate
     I2C1CONbits.ON = 1;		// Turn on I2C1 module
     
-    //asm volatile("ei"); // Enable Global Interrupts once all peripherals are configured
+    //__builtin_enable_interrupts(); // Enable Global Interrupts once all peripherals are configured
 
 }
 
@@ -4,7 +4,7 @@ void set_performance_mode()
 	unsigned int cp0;
 	
     // Unlock Sequence
-    asm volatile("di"); // Disable all interrupts
+    __builtin_disable_interrupts(); // Disable all interrupts
     SYSKEY = 0xAA996655;
     SYSKEY = 0x556699AA;  
 
@@ -50,7 +50,7 @@ void set_performance_mode()
 
     // Lock Sequence
     SYSKEY = 0x33333333;
-    asm volatile("ei"); // Enable all interrupts
+    __builtin_enable_interrupts(); // Enable all interrupts
 }
 void set_digital()
 {
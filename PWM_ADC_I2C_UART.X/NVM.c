@@ -0,0 +1,65 @@
+/* ************************************************************************** */
+/** NVM.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+  
+@Company
+University of Groningen
+
+  @File Name
+NVM.c
+
+@Summary
+ Run time self programming of the program flash
+
+@Description
+ The flash is erased per page of 16KB and programmed per quad word (16 bytes, 
+ * aligned to 16 bytes). Every operation is started with the unlock sequence 
+ * with interrupts disabled, the CPU stalls while the flash is busy.
+ * Check section 52 Flash Program Memory of the reference manual for more details.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include <proc/p32mz2048efm100.h>
+#include "NVM.h"
+
+/*Function to perform the operation set in NVMADDR/NVMDATA, returns WRERR and LVDERR*/
+static uint32_t NVM_operation(uint32_t nvmop)
+{
+    uint32_t status;
+    
+    status = __builtin_disable_interrupts();    // The unlock sequence must not be interrupted
+    NVMCON = NVMCON_WREN | nvmop;               // Enable writes and select the operation
+    NVMKEY = 0;
+    NVMKEY = 0xAA996655;                        // Unlock sequence
+    NVMKEY = 0x556699AA;
+    NVMCONSET = NVMCON_WR;                      // Start the operation
+    while(NVMCON & NVMCON_WR);                  // Wait until it is done
+    NVMCONCLR = NVMCON_WREN;                    // Disable writes
+    __builtin_mtc0(12, 0, status);              // Restore the interrupt state
+    
+    return NVMCON & (NVMCON_WRERR | NVMCON_LVDERR);
+}
+
+/*Function to erase the page of flash that holds address*/
+uint32_t NVM_erase_page(const void *address)
+{
+    NVMADDR = KVA_TO_PA(address);
+    return NVM_operation(NVMOP_PAGE_ERASE);
+}
+
+/*Function to program 4 words at address, address has to be aligned to 16 bytes and erased*/
+uint32_t NVM_write_quad_word(const void *address, const uint32_t data[4])
+{
+    NVMADDR = KVA_TO_PA(address);
+    NVMDATA0 = data[0];
+    NVMDATA1 = data[1];
+    NVMDATA2 = data[2];
+    NVMDATA3 = data[3];
+    return NVM_operation(NVMOP_QUAD_WORD_PROGRAM);
+}
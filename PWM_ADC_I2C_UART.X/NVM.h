@@ -0,0 +1,45 @@
+/* ************************************************************************** */
+/** NVM.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+  
+@Company
+University of Groningen
+
+  @File Name
+NVM.h
+
+@Summary
+ Function prototypes for NVM.c
+
+@Description
+ Methods to erase and program the program flash at run time, used to keep 
+ * calibration data over a power cycle.
+ */
+/* ************************************************************************** */
+
+#ifndef _NVM_H    /* Guard against multiple inclusion */
+#define _NVM_H
+
+#define NVM_PAGE_SIZE 16384                 // Smallest area of flash that can be erased (bytes)
+
+/*NVMCON bits and operations*/
+#define NVMCON_WR     0x8000
+#define NVMCON_WREN   0x4000
+#define NVMCON_WRERR  0x2000
+#define NVMCON_LVDERR 0x1000
+#define NVMOP_QUAD_WORD_PROGRAM 0b0010
+#define NVMOP_PAGE_ERASE        0b0100
+
+/*prototypes in NVM.c, return 0 on success*/
+uint32_t NVM_erase_page(const void *address);
+uint32_t NVM_write_quad_word(const void *address, const uint32_t data[4]);
+
+#endif /* _NVM_H */
+
+/* *****************************************************************************
+ End of File
+ */
@@ -0,0 +1,73 @@
+/* ************************************************************************** */
+/** PID.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+PID.c
+
+@Summary
+ PI/PID controller with Q15 inputs and outputs
+
+@Description
+ Converts the Q15 signals of the control loops to the numeric type selected with
+ * CONTROL_NUMERIC and runs the PID kernel of that type, see PID.h.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include "PID.h"
+#include "systime.h"
+
+/*Kernel and conversions of the selected numeric type*/
+#if CONTROL_NUMERIC == CONTROL_FLOAT
+#define PID_KERNEL(name)    name##_f32
+#else
+#define PID_KERNEL(name)    name##_q31
+#endif
+
+//set the gains and limits of a controller
+void PID_init(pid_controller_t *pid, pid_gain_t kp, pid_gain_t ki, pid_gain_t kd, pid_gain_t kff,
+              pid_coef_t d_filter, int16_t out_min, int16_t out_max)
+{
+    PID_KERNEL(pid_init)(pid, kp, ki, kd, kff, d_filter,
+                         PID_KERNEL(ctrl_from_q15)(out_min), PID_KERNEL(ctrl_from_q15)(out_max));
+}
+
+//clear the state of a controller
+void PID_reset(pid_controller_t *pid, int16_t measurement)
+{
+    PID_KERNEL(pid_reset)(pid, PID_KERNEL(ctrl_from_q15)(measurement));
+}
+
+//compute the output of the controller for a new measurement
+RAMFUNC int16_t PID_update(pid_controller_t *pid, int16_t reference, int16_t measurement, int16_t feed_forward)
+{
+    return PID_KERNEL(ctrl_to_q15)(PID_KERNEL(pid_update)(pid, PID_KERNEL(ctrl_from_q15)(reference),
+                                   PID_KERNEL(ctrl_from_q15)(measurement), PID_KERNEL(ctrl_from_q15)(feed_forward)));
+}
+
+//time the update of a PID controller with the core timer, which counts at SYS_FREQ/2
+uint32_t PID_benchmark(uint32_t iterations)
+{
+    pid_controller_t pid;
+    volatile int16_t measurement = 0;
+    uint32_t start, ticks, i;
+
+    PID_init(&pid, PID_GAIN(2.0), PID_GAIN(0.01), PID_GAIN(0.5), PID_GAIN(1.0),
+             PID_FILTER(100, 1000), Q15(-1.0), Q15(1.0));
+
+    start = systime_count();
+    for(i = 0; i < iterations; ++i)
+        measurement = PID_update(&pid, Q15(0.5), measurement >> 1, Q15(0.01));
+    ticks = systime_count() - start;
+
+    return (uint32_t)(2ull * ticks / iterations);
+}
@@ -0,0 +1,81 @@
+/* ************************************************************************** */
+/** PID.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+PID.h
+
+@Summary
+ PI/PID controller for the cascaded current and position loops
+
+@Description
+ Signals (reference, measurement, feed forward and output) are Q15, i.e. -1.0 to
+ * 1.0 of the full scale of the sensor or actuator is -32768 to 32767.
+ * The controller itself runs on the kernels of control_kernels.h in the numeric
+ * type selected with CONTROL_NUMERIC:
+ *  CONTROL_Q31   - Q31 fixed point, gains Q16.16 (default)
+ *  CONTROL_FLOAT - single precision float on the FPU
+ * Set the gains with PID_GAIN() and the filter with PID_FILTER() so they follow the type.
+ * The integral gain has to include the sample time: ki = Ki*Ts.
+ * The derivative gain has to include the sample time: kd = Kd/Ts.
+ * A PI controller is a PID controller with kd=0, the derivative is then skipped.
+ */
+/* ************************************************************************** */
+
+#ifndef _PID_H    /* Guard against multiple inclusion */
+#define _PID_H
+
+#include <stdint.h>
+#include "control_kernels.h"
+
+/*Numeric types of the controller*/
+#define CONTROL_Q31   0
+#define CONTROL_FLOAT 1
+#ifndef CONTROL_NUMERIC
+#define CONTROL_NUMERIC CONTROL_Q31
+#endif
+
+#if CONTROL_NUMERIC == CONTROL_FLOAT
+typedef pid_f32_t pid_controller_t;
+typedef ctrl_gain_f32_t pid_gain_t;
+typedef ctrl_f32_t pid_coef_t;
+#define PID_GAIN(x)         CTRL_GAIN_F32(x)
+#define PID_COEF(x)         CTRL_COEF_F32(x)
+#else
+typedef pid_q31_t pid_controller_t;
+typedef ctrl_gain_q31_t pid_gain_t;
+typedef ctrl_q31_t pid_coef_t;
+#define PID_GAIN(x)         CTRL_GAIN_Q31(x)
+#define PID_COEF(x)         CTRL_COEF_Q31(x)
+#endif
+
+/*Conversion of constants, only for use at compile time as they expand to floating point*/
+#define Q15(x)              ((int16_t)((x) >= 1.0 ? 32767 : (x) * 32768.0))    // signal -1.0 ... 1.0
+/*coefficient of the derivative filter for a cut off frequency of fc at a sample frequency of fs*/
+#define PID_FILTER(fc, fs)  PID_COEF((6.2831853 * (fc) / (fs)) / (1.0 + 6.2831853 * (fc) / (fs)))
+#define PID_FILTER_NONE     PID_COEF(1.0)
+
+/*Methods for the controllers
+ *******************************************************************
+ .................*/
+/*Set the gains (PID_GAIN), derivative filter (PID_FILTER) and Q15 limits of a controller and reset its state*/
+void PID_init(pid_controller_t *pid, pid_gain_t kp, pid_gain_t ki, pid_gain_t kd, pid_gain_t kff,
+              pid_coef_t d_filter, int16_t out_min, int16_t out_max);
+
+/*Clear the integrator and the derivative, measurement is used as the previous measurement*/
+void PID_reset(pid_controller_t *pid, int16_t measurement);
+
+/*Compute the output for a new measurement, call at the sample rate of the loop*/
+RAMFUNC int16_t PID_update(pid_controller_t *pid, int16_t reference, int16_t measurement, int16_t feed_forward);
+
+/*Time [iterations] updates of a controller, returns the average number of CPU cycles per update*/
+uint32_t PID_benchmark(uint32_t iterations);
+
+#endif /* _PID_H */
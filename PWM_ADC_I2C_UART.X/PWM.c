@@ -1,96 +1,277 @@
-/** Descriptive File Name
- 
-  @Author
- Aniket Mazumder
- 
-  @Company
- Universiy of Groningen
+/* ************************************************************************** */
+/** PWM.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
 
   @File Name
- PWM.c
+PWM.c
+
+@Summary
+ Peripherals used:
+  * Timer2 (Timer2/3 in 32 bit mode) - time base of all channels
+  * OC1 ... OC4 - PWM outputs
 
-  @Summary
-  source file to setup PWM's of PIC 32MZ.
-  
-    
+@Description
+ The Output Compares run in PWM mode: the output goes high when Timer2 restarts and
+ * low when it reaches OCxR. OCxRS is copied to OCxR by the hardware at the end of every
+ * period, so the duty cycle is only ever written to OCxRS and a period is never cut
+ * short or stretched by an update. OCxR=0 keeps the output low and OCxR>PR2 keeps it high.
+ * PWM_init() called again with the same prescaler and timer width changes the frequency
+ * without a glitch: the rescaled duty cycles are written to OCxRS at the start of a
+ * period and PR2 is written at the start of the next one, when they have been latched.
+ * This blocks with interrupts disabled for up to two periods. Any other change stops
+ * Timer2 and restarts all channels.
+ * Dithering: the duty cycle of a dithered channel is kept as a target in timer counts
+ * with 16 fractional bits. The Timer2 interrupt, at the end of every period, adds the
+ * fraction to the residue of the channel and writes the integer part plus the carry
+ * to OCxRS, used in the period after the next. The interrupt is a fixed sequence of
+ * a few instructions per channel.
  */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include <proc/p32mz2048efm100.h>
+#include "PWM.h"
+#include "hal.h"
+#include "isr_profile.h"
+#include "perf.h"
+
+/*Bits of OCxCON*/
+#define OCCON_ON    0x8000
+#define OCCON_OC32  0x0020      // 32 bit compare, Timer2/3
+#define OCCON_PWM   0b110       // PWM mode without fault pin, OCTSEL=0 selects Timer2
 
+/*Channel table
+ * pps is the output pin register of the channel and pps_value the code of the Output
+ * Compare for it, 0 leaves the pin mapping to the application. OC3 can be mapped with
+ * 0b1011 to the pins of output group 1 (e.g. RPD2) and OC4 with 0b1011 to those of group 2 (e.g. RPD3)*/
+static const struct
+{
+    volatile uint32_t *con, *r, *rs;    // OCxCON, OCxR, OCxRS
+    volatile uint32_t *pps;
+    uint8_t pps_value;
+} RAMDATA pwm_channels[PWM_NUMBER_OF_CHANNELS] =
+{
+    {&OC1CON, &OC1R, &OC1RS, &RPE8R, 0b1100},  // OC1 on RPE8
+    {&OC2CON, &OC2R, &OC2RS, &RPF2R, 0b1011},  // OC2 on RPF2
+    {&OC3CON, &OC3R, &OC3RS, 0,      0},
+    {&OC4CON, &OC4R, &OC4RS, 0,      0},
+};
 
+/*Prescalers of Timer2 in order of TCKPS*/
+static const uint16_t prescalers[] = {1, 2, 4, 8, 16, 32, 64, 256};
 
+static uint32_t period = 0;                         // timer counts in one period, PR2+1
+static uint16_t duty[PWM_NUMBER_OF_CHANNELS];       // 16 bit duty cycles, kept to rescale them
 
+/*Dithering*/
+static uint8_t dither_enabled[PWM_NUMBER_OF_CHANNELS];
+static volatile uint8_t dithered[PWM_NUMBER_OF_CHANNELS];  // dithered by the interrupt, not at 0% or 100%
+static volatile uint32_t target[PWM_NUMBER_OF_CHANNELS];   // duty cycle in timer counts, 16 fractional bits
+static uint16_t residue[PWM_NUMBER_OF_CHANNELS];
 
-#include <xc.h>
 
+/*Function returning the compare value of a 16 bit duty cycle for the current period*/
+RAMFUNC uint32_t PWM_compare(uint16_t duty_cycle)
+{
+    if(duty_cycle == PWM_DUTY16_MAX)
+        return period;     // larger than PR2, the output stays high
+    return (uint32_t)(((uint64_t)duty_cycle * period + 0x8000) >> 16);    // rounded to the nearest step
+}
 
-/*Timer 2(x) is used as the timer source for the PWM
- Value in the period register PR sets the frequency for the PWM.
- This corresponds to the TOP value for the timer2(x)
- Value in register OC1R,OC2R,OC1RS,OC2RS set the duty cycle of the PWM 
- */
+//write the duty cycle of a channel to OCxRS or hand it to the dithering
+static RAMFUNC void PWM_apply(uint8_t channel)
+{
+    if(dither_enabled[channel] && duty[channel] && duty[channel] != PWM_DUTY16_MAX)
+    {
+        target[channel] = (uint32_t)duty[channel] * period;    // < 2^32 with a 16 bit period
+        dithered[channel] = 1;
+    }
+    else
+    {
+        dithered[channel] = 0;
+        hal_oc_write(pwm_channels[channel].rs, PWM_compare(duty[channel]));
+    }
+}
+
+//Timer2 interrupt on when a channel is dithered
+static void PWM_dither_enable_interrupt()
+{
+    uint8_t channel, enable = 0;
+    for(channel = 0; channel < PWM_NUMBER_OF_CHANNELS; ++channel)
+        enable |= dither_enabled[channel];
+
+    IPC2bits.T2IP = PWM_DITHER_IPL; // Interrupt priority
+    IPC2bits.T2IS = 0;              // Sub-priority 0
+    IEC0bits.T2IE = enable;         // Timer 2 Interrupt while dithering
+}
 
-//Initializes global PWM frequency to be used by the motors
-//OUTPUTs at RPE8 and RF2
-void PWM_init()
+/*Function to wait for Timer2 to restart, polled so it works whether the Timer2 interrupt is used or not*/
+void PWM_wait_period()
 {
-    /* Initialize a PWM of 60KHz that is to be used to drive the motors
-     * Peripherals used:
-     * Timer2, OC1,OC2  
-     * PortE8,PortF2   
-     */
-    
-    //check https://microchipdeveloper.com/32bit:mz-osc
-    //and  Section 42. Oscillators with Enhanced PLL page13 of microchip reference manual 
-    
-       
-    //convert pin8 of port E to a digitalPIN
-    //this needs to be done as the development board has only a single pin for PWM
-    ANSELEbits.ANSE8=0;
-    // set pin8 of port E as output
-    TRISEbits.TRISE8=0;
-    
-    
-    
-    RPE8R=0b1100;// set output pin for OC1 as pin8 port E 
-    RPF2R=0b1011;// set output pin for OC2 as pi2 port F 
-    
-    OC1CONbits.ON=0; //disable output compare1
-    OC2CONbits.ON=0; //disable output compare2
-    T2CONbits.ON=0; //disable timer2
-    TMR2=0; //Initialize timer 2 to 0
-    //setup Output Compare1 to be used for generating PWM1
-    OC1CONbits.OC32=0;// set compare mode to 16 bit timer source(in this case timer 2)
-    OC1CONbits.OCTSEL=0; //select timer 2(X) as the comparison reference timer.
-    OC1CONbits.OCM=0b110;//compare event forces OC1 high
-    OC1R=100;// set initial duty cycle of signal as 0
-    
-    //setup Output Compare1 to be used for generating PWM2
-    OC2CONbits.OC32=0;// set compare mode to 16 bit timer source(in this case timer 2)
-    OC2CONbits.OCTSEL=0; //select timer 2(X) as the comparison reference timer.
-    OC2CONbits.OCM=0b110;//compare event forces OC2 high
-    OC2R=100;// set initial duty cycle of signal as 0
-    
-    //setup timer2 for output compare
-    T2CONbits.TCKPS=0b000;//set timer2 pre-scaler to none
-    PR2=4095; //setup  period register for overflow
-    
-    OC1CONbits.ON=1; //enable output compare
-    OC2CONbits.ON=1; //enable output compare
-    T2CONbits.ON=1; //enable timer
-    
-   
-    //to change duty cycle write new duty cycle value to OC1RS and not directly OC1R; 
+    uint32_t last = hal_timer2_count(), now;
+    while((now = hal_timer2_count()) >= last)
+        last = now;
 }
 
-//set dutyCycle to Motor1; set 4095 for 100% DC 
-void setDutyCycleM1(uint16_t dutyCycle1)
+
+/*Function to setup Timer2 and the Output Compares for the frequency and resolution*/
+uint8_t PWM_init(uint32_t frequency, uint8_t resolution)
 {
-    // required dutyCycle is applied to Motor1
-    OC1RS=dutyCycle1;
+    uint32_t counts = 0, status;
+    uint8_t tckps, wide = 0, channel;
+
+    if(!frequency || resolution > 31)
+        return 0;
+
+    /*smallest prescaler with a 16 bit period*/
+    for(tckps = 0; tckps < sizeof(prescalers) / sizeof(prescalers[0]); ++tckps)
+    {
+        counts = (PWM_TIMER_CLOCK / prescalers[tckps] + frequency / 2) / frequency;
+        if(counts <= 0x10000)
+            break;
+    }
+    /*32 bit period without a prescaler if 16 bits do not give the resolution*/
+    if(tckps == sizeof(prescalers) / sizeof(prescalers[0]) || counts < (1UL << resolution))
+    {
+        tckps = 0;
+        wide = 1;
+        counts = (PWM_TIMER_CLOCK + frequency / 2) / frequency;
+    }
+    if(counts < 2 || counts < (1UL << resolution))
+        return 0;
+    if(wide && T3CONbits.ON)
+        return 0;   // Timer3 is the time base of the encoder captures
+
+    if(T2CONbits.ON && T2CONbits.TCKPS == tckps && T2CONbits.T32 == wide)
+    {
+        /*same timer setup, change the period between two periods*/
+        status = __builtin_disable_interrupts();
+        PWM_wait_period();
+        period = counts;
+        for(channel = 0; channel < PWM_NUMBER_OF_CHANNELS; ++channel)
+            hal_oc_write(pwm_channels[channel].rs, PWM_compare(duty[channel]));   // latched at the end of this period
+        PWM_wait_period();
+        PR2 = counts - 1;                                               // the next period uses both
+        for(channel = 0; channel < PWM_NUMBER_OF_CHANNELS; ++channel)
+            PWM_apply(channel);                                         // dithering targets of the new period
+        __builtin_mtc0(12, 0, status);
+    }
+    else
+    {
+        /* Force PIN to be digital output*/
+        ANSELEbits.ANSE8=0;
+        // set pin8 of port E as output
+        TRISEbits.TRISE8=0;
+
+        T2CONbits.ON=0; //disable timer2
+        for(channel = 0; channel < PWM_NUMBER_OF_CHANNELS; ++channel)
+            *pwm_channels[channel].con = 0;    //disable output compare
+        IEC0bits.T2IE = 0;  // Disable Timer 2 Interrupt
+
+        T2CON = 0x0;
+        TMR2 = 0;//set timer2 value to 0
+        T2CONbits.TCKPS = tckps;
+        T2CONbits.T32 = wide;//Timer2/3 as one 32 bit timer, PR2 and TMR2 are 32 bit wide
+        PR2 = counts - 1;//period register: PBCLK3/(prescaler*frequency)-1
+        period = counts;
+
+        for(channel = 0; channel < PWM_NUMBER_OF_CHANNELS; ++channel)
+        {
+            if(wide)
+                dither_enabled[channel] = 0;    // the targets do not fit a 32 bit period
+            if(pwm_channels[channel].pps)
+                *pwm_channels[channel].pps = pwm_channels[channel].pps_value;
+            *pwm_channels[channel].r = *pwm_channels[channel].rs = PWM_compare(duty[channel]);
+            PWM_apply(channel);
+            *pwm_channels[channel].con = OCCON_PWM | (wide ? OCCON_OC32 : 0);
+            *pwm_channels[channel].con |= OCCON_ON;     //enable output compare
+        }
+        reg_clear(&IFS0, _IFS0_T2IF_MASK);  // Clear interrupt flag for timer 2
+        PWM_dither_enable_interrupt();
+        T2CONbits.ON = 1;//enable timer2
+    }
+
+    return 31 - __builtin_clz(counts);
+}
+
+/*Functions to set the duty cycle of a channel, written to OCxRS only*/
+void PWM_set_duty(uint8_t channel, int16_t duty_cycle)
+{
+    if(duty_cycle <= 0)
+        PWM_set_duty16(channel, 0);
+    else if(duty_cycle >= PWM_DUTY_MAX)
+        PWM_set_duty16(channel, PWM_DUTY16_MAX);
+    else
+        PWM_set_duty16(channel, (uint16_t)duty_cycle << 1);
+}
+
+RAMFUNC void PWM_set_duty16(uint8_t channel, uint16_t duty_cycle)
+{
+    duty[channel] = duty_cycle;
+    PWM_apply(channel);
+}
+
+/*Function to switch dithering of a channel, the residue starts from 0*/
+uint8_t PWM_set_dither(uint8_t channel, uint8_t enable)
+{
+    uint32_t status;
+
+    if(enable && T2CONbits.T32)
+        return 0;
+
+    status = __builtin_disable_interrupts();
+    dither_enabled[channel] = enable ? 1 : 0;
+    residue[channel] = 0;
+    PWM_apply(channel);
+    reg_clear(&IFS0, _IFS0_T2IF_MASK);  // Clear interrupt flag for timer 2
+    PWM_dither_enable_interrupt();
+    __builtin_mtc0(12, 0, status);
+    return 1;
+}
+
+uint32_t PWM_period()
+{
+    return period;
+}
+
+uint8_t PWM_dithered(uint8_t channel)
+{
+    return dither_enabled[channel];
+}
+
+/*First order sigma-delta of the dithered duty cycles, at the end of every period*/
+static RAMFUNC void PWM_dither_update()
+{
+    uint32_t sum, counts;
+    uint8_t channel;
+
+    hal_timer2_clear_flag();
+    for(channel = 0; channel < PWM_NUMBER_OF_CHANNELS; ++channel)
+    {
+        if(dithered[channel])
+        {
+            counts = target[channel];
+            sum = residue[channel] + (counts & 0xFFFF);
+            residue[channel] = (uint16_t)sum;
+            hal_oc_write(pwm_channels[channel].rs, (counts >> 16) + (sum >> 16));  // rounded up when the residue carries
+        }
+    }
 }
 
-//set dutyCycle to Motor2; set 4095 for 100% DC 
-void setDutyCycleM2(uint16_t dutyCycle2)
+/*ISR for Timer2, the vector stays in flash and calls the update in RAM*/
+void __attribute__((vector(_TIMER_2_VECTOR), interrupt(ipl4srs), nomips16)) PWM_dither_isr()
 {
-    // required dutyCycle is applied to Motor2
-    OC2RS=dutyCycle2;
+    ISR_PROFILE_ENTER(ISR_ID_PWM_DITHER);
+    PERF_ENTER(PERF_PWM_DITHER);
+    PWM_dither_update();
+    PERF_EXIT(PERF_PWM_DITHER);
+    ISR_PROFILE_EXIT(ISR_ID_PWM_DITHER);
 }
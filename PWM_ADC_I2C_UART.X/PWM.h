@@ -0,0 +1,99 @@
+/* ************************************************************************** */
+/** PWM.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+PWM.h
+
+@Summary
+ Defines and function prototypes of the PWM driver
+
+@Description
+ All channels share Timer2 as the time base, so they run at the same frequency.
+ * PWM_init() takes the frequency and the required resolution in bits and picks the
+ * prescaler and the period register of Timer2. The smallest prescaler for which the
+ * period fits in 16 bits is used, as it gives the finest duty steps. A resolution
+ * that a 16 bit period cannot give at that frequency uses Timer2/3 as a 32 bit timer
+ * with the Output Compares in 32 bit mode; Timer3 is then not available for the
+ * Input Capture of the encoders (encoderPWM_init()).
+ * The duty cycle is a Q15 fraction of the period, 0 ... PWM_DUTY_MAX (100%), or a 16 bit
+ * fraction, 0 ... PWM_DUTY16_MAX (100%).
+ * Dithering: at 20KHz the period has 5000 steps (12.3 bits). With dithering enabled for
+ * a channel the Timer2 interrupt writes OCxRS at every period, rounding the duty cycle
+ * down or up so that the rounding errors add up to less than one step (first order
+ * sigma-delta). The mean over a few periods then has the resolution of the 16 bit duty
+ * cycle, the current of a motor follows that mean. Dithering needs a 16 bit period.
+ */
+/* ************************************************************************** */
+
+#ifndef _PWM_H    /* Guard against multiple inclusion */
+#define _PWM_H
+
+#include <stdint.h>
+#include "header.h"
+#include "ramfunc.h"
+
+/*Timer2 is clocked by PBCLK3 (clock_config.h)*/
+#define PWM_TIMER_CLOCK PBCLK3_FREQ
+
+/*Settings of the motor PWM used by Motor_driver_init(): 20KHz with at least 12 bits,
+ * 5000 steps with a prescaler of 1 at 200MHz, 4200 at 252MHz*/
+#define PWM_FREQUENCY   20000
+#define PWM_RESOLUTION  12
+#define PWM_MOTOR_DITHER 1      // dither the duty cycles of the motors
+
+/*Channels, see the channel table in PWM.c for the pins*/
+#define PWM_CHANNEL_M1  0       // OC1 on RPE8, knee motor
+#define PWM_CHANNEL_M2  1       // OC2 on RPF2, ankle motor
+#define PWM_CHANNEL_3   2       // OC3, map a pin to it before PWM_init()
+#define PWM_CHANNEL_4   3       // OC4, map a pin to it before PWM_init()
+#define PWM_NUMBER_OF_CHANNELS 4
+
+/*Duty cycle in Q15*/
+#define PWM_DUTY_MAX            0x7FFF                                          // 100%, the output stays high
+#define PWM_DUTY(fraction)      ((int16_t)((fraction) * PWM_DUTY_MAX + 0.5))    // e.g. PWM_DUTY(0.25) for 25%
+#define PWM_DUTY16_MAX          0xFFFF                                          // 100% of a 16 bit duty cycle
+
+/*Priority of the Timer2 interrupt used for dithering, above the tasks of the scheduler*/
+#define PWM_DITHER_IPL  4
+
+/*Methods for the PWM
+ *******************************************************************
+ .................*/
+/*Setup Timer2 and all channels for the frequency with at least the given resolution in bits.
+ * Can be called again while the PWM runs, see PWM.c for when the change is glitch free.
+ * Returns the resolution in bits that is obtained, 0 if the frequency and the resolution
+ * cannot be met; the PWM is left unchanged in that case*/
+uint8_t PWM_init(uint32_t frequency, uint8_t resolution);
+
+/*Set the duty cycle of a channel in Q15, takes effect at the start of the next period.
+ * Negative duty cycles are 0%*/
+void PWM_set_duty(uint8_t channel, int16_t duty);
+
+/*Set the duty cycle of a channel as a 16 bit fraction, the finest steps when dithering*/
+RAMFUNC void PWM_set_duty16(uint8_t channel, uint16_t duty);
+
+/*Enable (1) or disable (0) dithering of a channel. The Timer2 interrupt runs while
+ * a channel is dithered. Returns 0 if the PWM uses a 32 bit period*/
+uint8_t PWM_set_dither(uint8_t channel, uint8_t enable);
+
+/*1 if dithering is enabled for a channel*/
+uint8_t PWM_dithered(uint8_t channel);
+
+/*Number of timer counts in one period, the duty cycle steps are 1/PWM_period() of the period*/
+uint32_t PWM_period();
+
+/*OCxRS value of a 16 bit duty cycle at the current frequency, for writers of OCxRS other than the driver (DMA)*/
+RAMFUNC uint32_t PWM_compare(uint16_t duty);
+
+/*Wait for the start of the next period*/
+void PWM_wait_period();
+
+#endif /* _PWM_H */
@@ -0,0 +1,170 @@
+/* SPI.c
+ 
+  @Author
+ Aniket Mazumder
+ Department of Robotics
+ a.mazumder@rug.nl
+ 
+  @Company
+ University of Groningen
+ 
+  @File Name
+ SPI.c
+
+  @Summary
+ Source file containing definition of all methods for the SPI2 bus of the PIC32 MZ
+ 
+ @Description
+ This code sets up SPI2 as a master with the enhanced (16 deep) buffers enabled.
+ * Single bytes can be exchanged with SPI_transfer(), longer bursts are moved by 
+ * two DMA channels without CPU involvement:
+ * DMA0 - moves bytes from spi_tx_buf to SPI2BUF on the SPI2 TX interrupt request
+ * DMA1 - moves bytes from SPI2BUF to spi_rx_buf on the SPI2 RX interrupt request
+ * The DMA buffers are uncached buffers of dma_buf.c so that the data cache set in 
+ * set_performance_mode() does not hide the data moved by the DMA.
+ * SPI2 is clocked by PBCLK2 (clock_config.h).
+ */
+
+
+#include "SPI.h"
+#include <xc.h>
+#include "header.h"
+#include <proc/p32mz2048efm100.h>
+#include "dma_buf.h"
+
+/*Buffers used by the DMA, uncached and allocated by SPI_init()*/
+static uint8_t *spi_tx_buf = 0, *spi_rx_buf = 0;
+static uint16_t spi_dma_length = 0;
+
+// SPI_set_frequency() sets the closest clock frequency of SPI2 that is not above [frequency]Hz
+void SPI_set_frequency(uint32_t frequency)
+{
+    /*Fsck=PBCLK2/(2*(SPI2BRG+1)), round the divider up to stay below the requested frequency*/
+    uint32_t brg = (PBCLK2_FREQ + 2 * frequency - 1) / (2 * frequency);
+    
+    while(SPI2STATbits.SPIBUSY);    // Wait for an ongoing transfer to finish
+    SPI2BRG = brg ? brg - 1 : 0;
+}
+
+// SPI_init() initializes SPI2 as a master in mode 3 at a frequency of [frequency]Hz
+void SPI_init(uint32_t frequency)
+{
+    __builtin_disable_interrupts(); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
+    
+    /*Set up the pins of SPI2*/
+    ANSELGbits.ANSG6 = 0;   // SCK2 is digital
+    ANSELGbits.ANSG7 = 0;   // SDI2 is digital
+    ANSELGbits.ANSG8 = 0;   // SDO2 is digital
+    ANSELGbits.ANSG9 = 0;   // CS is digital
+    TRISGbits.TRISG6 = 0;   // SCK2 is an output
+    TRISGbits.TRISG7 = 1;   // SDI2 is an input
+    TRISGbits.TRISG8 = 0;   // SDO2 is an output
+    TRISGbits.TRISG9 = 0;   // CS is an output
+    pin_set(SPI_CS_PIN);    // CS is released
+    SDI2R = SPI_SDI_PPS;    // RPG7 = SDI2
+    RPG8R = SPI_SDO_PPS;    // RPG8 = SDO2
+    
+    /*Set up SPI2*/
+    SPI2CON = 0;            // Turn off SPI2 before setting it up
+    SPI2CON2 = 0;           // No audio mode, no error interrupts
+    SPI2BUF;                // Clear the receive buffer
+    SPI2STATbits.SPIROV = 0;// Clear the overflow flag
+    SPI2CONbits.ENHBUF = 1; // Enable the enhanced buffers
+    SPI2CONbits.MSTEN = 1;  // Master mode
+    SPI2CONbits.CKP = 1;    // Clock is idle high
+    SPI2CONbits.CKE = 0;    // Data changes on the falling edge (mode 3)
+    SPI2CONbits.SMP = 1;    // Input data is sampled at the end of data output time
+    SPI2CONbits.STXISEL = 0b11; // TX request while the buffer is not full, used by the DMA
+    SPI2CONbits.SRXISEL = 0b01; // RX request while the buffer is not empty, used by the DMA
+    SPI_set_frequency(frequency);
+    SPI2CONbits.ON = 1;     // Turn on SPI2
+    
+    /*Set up the DMA channels, they are only enabled during a burst*/
+    DMACONbits.ON = 1;      // Turn on the DMA controller
+    if(!spi_tx_buf)
+    {
+        spi_tx_buf = dma_buf_alloc(SPI_DMA_MAX_LENGTH, DMA_BUF_UNCACHED);
+        spi_rx_buf = dma_buf_alloc(SPI_DMA_MAX_LENGTH, DMA_BUF_UNCACHED);
+    }
+    
+    DCH0CON = 0;
+    DCH0ECON = 0;
+    DCH0INT = 0;
+    DCH0CONbits.CHPRI = 2;  // TX channel has priority 2
+    DCH0ECONbits.CHSIRQ = _SPI2_TX_VECTOR; // Transfer on the SPI2 TX request
+    DCH0ECONbits.SIRQEN = 1;
+    DCH0DSA = KVA_TO_PA(&SPI2BUF);
+    DCH0DSIZ = 1;
+    DCH0CSIZ = 1;           // One byte per request
+    
+    DCH1CON = 0;
+    DCH1ECON = 0;
+    DCH1INT = 0;
+    DCH1CONbits.CHPRI = 3;  // RX channel has priority 3, it must keep up with the TX channel
+    DCH1ECONbits.CHSIRQ = _SPI2_RX_VECTOR; // Transfer on the SPI2 RX request
+    DCH1ECONbits.SIRQEN = 1;
+    DCH1SSA = KVA_TO_PA(&SPI2BUF);
+    DCH1SSIZ = 1;
+    DCH1CSIZ = 1;           // One byte per request
+    
+    //__builtin_enable_interrupts(); // Enable Global Interrupts once all peripherals are configured
+}
+
+// SPI_select() pulls the chip select low
+void SPI_select(void)
+{
+    pin_clear(SPI_CS_PIN);
+}
+
+// SPI_deselect() releases the chip select once the last byte has been shifted out
+void SPI_deselect(void)
+{
+    while(SPI2STATbits.SPIBUSY);
+    pin_set(SPI_CS_PIN);
+}
+
+// SPI_transfer() sends value and returns the byte received at the same time 
+uint8_t SPI_transfer(uint8_t value)
+{
+    SPI2BUF = value;                    // Send the byte
+    while(SPI2STATbits.SPIRBE);         // Wait until the received byte is in the buffer
+    return SPI2BUF;                     // Retrieve the received byte
+}
+
+/*Function to start a DMA driven transfer of [length] bytes from tx. 
+ * The CPU is free during the transfer, poll SPI_DMA_complete() to get the received bytes*/
+void SPI_DMA_start(const uint8_t *tx, uint16_t length)
+{
+    uint16_t i;
+    
+    if(length > SPI_DMA_MAX_LENGTH)
+        length = SPI_DMA_MAX_LENGTH;
+    for(i = 0; i < length; ++i)
+        spi_tx_buf[i] = tx[i];
+    spi_dma_length = length;
+    
+    DCH0SSA = dma_buf_phys(spi_tx_buf);
+    DCH0SSIZ = length;
+    DCH1DSA = dma_buf_phys(spi_rx_buf);
+    DCH1DSIZ = length;
+    DCH0INTCLR = 0xFF;      // Clear the flags of both channels
+    DCH1INTCLR = 0xFF;
+    
+    SPI_select();
+    DCH1CONbits.CHEN = 1;   // Arm the RX channel first so that no byte is missed
+    DCH0CONbits.CHEN = 1;   // The TX channel starts right away as the TX buffer is empty
+}
+
+/*Function returning 1 once the DMA transfer is done, the received bytes are copied to rx*/
+uint8_t SPI_DMA_complete(uint8_t *rx)
+{
+    uint16_t i;
+    
+    if(!DCH1INTbits.CHBCIF)
+        return 0;                       // RX channel has not received all bytes yet
+    
+    SPI_deselect();
+    for(i = 0; i < spi_dma_length; ++i)
+        rx[i] = spi_rx_buf[i];
+    return 1;
+}
@@ -0,0 +1,50 @@
+/* SPI.h
+ 
+  @Author
+ Aniket Mazumder
+ Department of Robotics
+ a.mazumder@rug.nl
+ 
+  @Company
+ Universiy of Groningen
+ 
+  @File Name
+ SPI.h
+
+  @Summary
+ Header file containing all methods for the SPI2 bus of the PIC32 MZ
+ 
+ @Description
+ SPI2 is used as a master in mode 3 (CKP=1, CKE=0) with a software controlled chip select.
+ * SCK2 - RG6
+ * SDO2 - RPG8
+ * SDI2 - RPG7
+ * CS   - RG9
+ * Check table 12-1 and 12-2 of the data sheet for other Peripheral Pin Select options
+ */
+
+#ifndef _SPI_H    /* Guard against multiple inclusion */
+#define _SPI_H
+
+#include <xc.h>
+#include "reg.h"
+
+/*Peripheral Pin Select values for SPI2*/
+#define SPI_SDI_PPS 0b0001      // SDI2R value to map SDI2 to RPG7
+#define SPI_SDO_PPS 0b0110      // RPG8R value to map SDO2 to RPG8
+#define SPI_CS_PIN  REG_PIN(G, 9)   // chip select, switched with LATGSET/LATGCLR
+
+#define SPI_DMA_MAX_LENGTH 16   // Largest burst that fits in the enhanced buffers of SPI2
+
+/*Methods for the SPI bus*/
+void SPI_init(uint32_t frequency);      // Initialize SPI2 as a master at [frequency]Hz
+void SPI_set_frequency(uint32_t frequency); // Change the clock frequency of SPI2 on the fly
+void SPI_select(void);                  // Pull the chip select low
+void SPI_deselect(void);                // Release the chip select
+uint8_t SPI_transfer(uint8_t value);    // Send a byte and return the byte received at the same time
+// Start a DMA driven transfer of length bytes, chip select is pulled low and released by SPI_DMA_complete()
+void SPI_DMA_start(const uint8_t *tx, uint16_t length);
+// Returns 1 and copies the received bytes to rx once the DMA transfer is done, 0 while it is still running
+uint8_t SPI_DMA_complete(uint8_t *rx);
+
+#endif /* _SPI_H */
@@ -20,9 +20,9 @@
  * to be used for proper voltage level conversions. 
  * RPD10 us configured as TX 
  * RPD15 is configured as RX  
- * Timer8 has been set up to send data at regular intervals to data buffer.
+ * telemetry_task() is run by the scheduler to send data at regular intervals to data buffer.
  * Functions ReadUART and WriteUART can be used to send/receive data by using a circular buffer called data_buf[BUFLEN]
- * There are also functions for delay and printf that may be utilized in the code.
+ * _mon_putc() lets printf write to UART1; the delay functions are in systime.c.
  * Check section 21 UART of the data sheet for more details
  * https://microchipdeveloper.com/32bit:mz-osc-sysclk   
  
@@ -34,17 +34,25 @@
 #include "header.h"
 #include <proc/p32mz2048efm100.h>
 #include "UART.h"
+#include "hal.h"
+#include "systime.h"
+#include "stream.h"
+#include "isr_profile.h"
 #include <stdio.h>
+#include <string.h>
+
+/*Frames received from the host, see UART.h*/
+CLOCK_ASSERT_UART(UART_BAUD, 10000);   // within 1% of UART_BAUD
+
+static uart_frame_t frame_queue[UART_FRAME_QUEUE];
+static volatile uint8_t frame_head = 0, frame_tail = 0;
+volatile uint32_t uart_frame_errors = 0;
 
 /* Function to initialize peripheral UART 1 */
 void UART_Init()
 {
-    asm volatile("di"); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
+    __builtin_disable_interrupts(); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
     /**************************************************************************/
-    uint32_t pbClk2;//variable to store the value of clock speed used by UART module
-    pbClk2 = SYS_FREQ / 2; // Our PBCLK2 divider was set to 1, so PBCLK2 is exactly half the speed of the system clock, or 100Mhz
-    
-    /*************************************************************************/
 	// Set up Peripheral Pin Select for UART 1
     U1RXR = 0b0011; // RPD10 = U1RX
     TRISDbits.TRISD10=0b1; //set the uart RX pin as input
@@ -55,7 +63,7 @@ void UART_Init()
     //Set up baud rates and data stop bit configuration
     //U1MODE = off; // Set UART 1 off prior to setting it up
     U1MODEbits.BRGH =  STANDARD_SPEED_MODE;    
-    U1BRG = pbClk2 / (16 * 38400) - 1;// This is the formula straight from the data sheet, max value for UXBRG=2^16-1
+    U1BRG = CLOCK_UART_BRG(UART_BAUD);// PBCLK2/(16*UART_BAUD)-1 rounded, straight from the data sheet
     U1STA = clear; // Disable the TX and RX pins, clear all flags
     U1MODEbits.PDSEL = EIGHT_BIT_DATA_NO_PARITY;  // this is the default of 8-bit data, no parity bits that most terminals use
     U1MODEbits.STSEL = ONE_STOP_BIT ; // STSEL controls how many stop bits we use, let's use the default of 1
@@ -66,30 +74,19 @@ void UART_Init()
     U1STAbits.UTXEN = onn; // Enable the TX pin
     U1STAbits.URXEN = onn; // Enable the RX pin
     U1MODEbits.ON = onn; // Turn on the UART 1 peripheral
-    
-	/***************************************************************************/
-	//Enable timer8 to send data over circular buffer
-	T8CON=0X0;// Disable timer8 
-	TMR8=clear;//set timer counter to 0
-  	IEC1bits.T8IE=off;// Disable timer8 interrupt
-	
-	T8CONbits.TCKPS=0b101;//Pre-scaler of 32
-	PR8=UART_DATA_FREQUENCY_50;//select 50Hz for frequency	
-
-	//Enable timer interrupts for timer8
-	IFS1bits.T8IF=clear;//clear timer8 interrupt flag
-	IPC9bits.T8IP=2;//Interrupt priority=2
-	IPC9bits.T8IS=1;//Sub-priority 1
-	IEC1bits.T8IE=onn;//Enable timer8 interrupt
-
-    T8CONbits.ON=onn;//switch onn timer 8
-    
-    //asm volatile("ei"); // Enable Global Interrupts once all peripherals are configured
 
+    /***************************************************************************/
+    //Receive frames by interrupt, ReadUART can still poll until the interrupts are enabled
+    U1STAbits.URXISEL = 0;      // Interrupt while a byte is received
+    reg_clear(&IFS3, _IFS3_U1RXIF_MASK);        // Clear interrupt flag for UART1 RX
+    IPC28bits.U1RXIP = UART_RX_IPL; // Interrupt priority
+    IPC28bits.U1RXIS = 0;       // Sub-priority 0
+    IEC3bits.U1RXIE = 1;        // Enable UART1 RX interrupt
+    
 }
 
-/*ISR for Timer8; Use this to send whatever data has to sent*/
-void __attribute__((vector(_TIMER_8_VECTOR), interrupt(ipl2srs),nomips16)) data_transmit()
+/*Telemetry task of the scheduler; Use this to send whatever data has to sent*/
+void telemetry_task()
 {
     static uint16_t i=0;
     if(start)
@@ -99,11 +96,10 @@ void __attribute__((vector(_TIMER_8_VECTOR), interrupt(ipl2srs),nomips16)) data_
         buffer_write(ADC2);
         buffer_write(ADC3);
         buffer_write(accelZ);
+        buffer_write(stream_level());//setpoints buffered, the host paces the stream on it
         //buffer_write(i+30);
         ++i;
     }
-	IFS1bits.T8IF=clear;//clear timer8 interrupt flag
-    
 }
 
 
@@ -120,9 +116,9 @@ void ReadUART(char * message, uint16_t maxLength)
   //loop until you get a '\r' or '\n'
   while (!complete) 
   {
-    if (U1STAbits.URXDA) // if data is available
+    if (hal_uart_rx_available()) // if data is available
 	{ 
-      data = U1RXREG;// read the data
+      data = hal_uart_read();// read the data
       
       if ((data == '\n') || (data == '\r')) 
 	  {
@@ -146,16 +142,120 @@ void ReadUART(char * message, uint16_t maxLength)
 }
 
 
+/*Function to copy the oldest frame received from the host*/
+uint8_t UART_get_frame(uart_frame_t *frame)
+{
+    uint8_t index = frame_tail;
+    if(index == frame_head)
+        return 0;
+    memcpy(frame, &frame_queue[index & (UART_FRAME_QUEUE - 1)], sizeof(uart_frame_t));
+    frame_tail = index + 1;
+    return 1;
+}
+
+//hand a complete frame to its receiver
+static void UART_route_frame(const uart_frame_t *frame)
+{
+    int16_t setpoint[NUMBER_OF_JOINTS];
+    uint8_t i, joint, index = frame_head;
+
+    switch(frame->command)
+    {
+        case 'P':   //setpoints, one Q15 angle per joint little endian; no setpoints ends the stream
+            if(!frame->length)
+                stream_end();
+            for(i = 0; i + 2 * NUMBER_OF_JOINTS <= frame->length; )
+            {
+                for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint, i += 2)
+                    setpoint[joint] = (int16_t)(frame->payload[i] | frame->payload[i + 1] << 8);
+                stream_push(setpoint);
+            }
+            break;
+        case 'U':   //underrun policy of the stream
+            if(frame->length == 1)
+                stream_set_policy(frame->payload[0]);
+            break;
+        default:    //for the main loop
+            if((uint8_t)(index - frame_tail) >= UART_FRAME_QUEUE)
+            {
+                ++uart_frame_errors;
+                break;
+            }
+            memcpy(&frame_queue[index & (UART_FRAME_QUEUE - 1)], frame, sizeof(uart_frame_t));
+            frame_head = index + 1;
+    }
+}
+
+/*ISR for UART1 RX; collects the bytes of a frame*/
+void __attribute__((vector(_UART1_RX_VECTOR), interrupt(ipl2srs), nomips16)) UART_rx_isr()
+{
+    static uart_frame_t frame;
+    static uint8_t state = 0, index, sum;
+    static uint32_t last;
+    uint32_t now = systime_count();
+    uint8_t data;
+
+    ISR_PROFILE_ENTER(ISR_ID_UART_RX);
+    while(hal_uart_rx_available())
+    {
+        data = hal_uart_read();
+        if(now - last > UART_FRAME_GAP)
+            state = 0;      // resynchronize on the next byte after a pause
+        last = now;
+
+        switch(state)
+        {
+            case 0:         // command
+                frame.command = data;
+                sum = data;
+                state = 1;
+                break;
+            case 1:         // length
+                frame.length = data;
+                sum += data;
+                index = 0;
+                state = data ? 2 : 3;
+                if(data > UART_FRAME_MAX)
+                {
+                    ++uart_frame_errors;
+                    state = 0;
+                }
+                break;
+            case 2:         // payload
+                frame.payload[index++] = data;
+                sum += data;
+                if(index == frame.length)
+                    state = 3;
+                break;
+            case 3:         // checksum
+                if(data == sum)
+                    UART_route_frame(&frame);
+                else
+                    ++uart_frame_errors;
+                state = 0;
+                break;
+        }
+    }
+    if(hal_uart_overrun())
+    {
+        hal_uart_clear_overrun(); // a byte was lost
+        ++uart_frame_errors;
+        state = 0;
+    }
+    hal_uart_clear_rx_flag();    // Clear interrupt flag for UART1 RX
+    ISR_PROFILE_EXIT(ISR_ID_UART_RX);
+}
+
 /*Function to write a character array to UART*/
 void WriteUART(const char * string)
 {
   while (*string != '\0') 
   {
-    while (U1STAbits.UTXBF) 
+    while (hal_uart_tx_full()) 
 	{
       ; // wait until tx buffer isn't full
     }
-    U1TXREG = *string;
+    hal_uart_write(*string);
     ++string;
   }
 }
@@ -211,38 +311,6 @@ void buffer_write(int16_t data)
 /* Function to enable use of printf instead of _mon_putc()*/
 void _mon_putc (char c)
 {
-   while (U1STAbits.UTXBF); // Wait till current transmission is complete
-   U1TXREG = c;
-}
-
-/*Delay functions
-
-  ********************************************
-   *********************************************/
-void delay_us(unsigned int us)
-{
-    // Convert microseconds us into how many clock ticks it will take
-	us *= SYS_FREQ / 1000000 / 2; // Core Timer updates every 2 ticks
-       
-    _CP0_SET_COUNT(0); // Set Core Timer count to 0
-    
-    while (us > _CP0_GET_COUNT()); // Wait until Core Timer count reaches the number we calculated earlier
-}
-
-void delay_ms(int ms)
-{
-    delay_us(ms * 1000);
+   while (hal_uart_tx_full()); // Wait till current transmission is complete
+   hal_uart_write(c);
 }
-
-/*function to reset value of core timer to a desired value*/
-void setTicks(uint32_t value)
-{
-    _CP0_SET_COUNT(value);
-}
-
-/*function to get time elapsed since last reset*/
-void getTicks(double *dt)
-{
-    uint32_t tickvalue =_CP0_GET_COUNT();
-    *dt=(double)tickvalue*0.00000001;
-}
\ No newline at end of file
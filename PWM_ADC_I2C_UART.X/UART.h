@@ -18,7 +18,7 @@ University of Groningen
  Header file for to set UART1 peripheral. 
 
 @Description
- This file sets up the function prototypes for the UART along with the delay functions for the PIC.
+ This file sets up the function prototypes for the UART; the delay functions are in systime.h.
 /***************************************************************************************/
 #ifndef _UART_H    
 #define _UART_H
@@ -44,13 +44,35 @@ University of Groningen
 
 #define BUFLEN   1024// length of the buffer
 
+#define UART_BAUD   38400   // higher speeds are not reliable, UxBRG from clock_config.h
+
+/*Frames from the host: command(1) length(1) payload(length) checksum(1)
+ * The checksum is the sum of the bytes from command to the end of the payload.
+ * 'P' frames carry setpoints for stream.c and are handled by the RX interrupt,
+ * other frames are queued for the main loop (UART_get_frame()).*/
+#define UART_FRAME_MAX      160     // largest payload
+#define UART_FRAME_QUEUE    4       // frames waiting for the main loop, a power of 2
+#define UART_FRAME_GAP      SYSTIME_MS(20)      // a pause of 20ms between bytes starts a new frame, in core timer counts
+#define UART_RX_IPL         2       // priority of the RX interrupt
+
+typedef struct
+{
+    uint8_t command;
+    uint8_t length;
+    uint8_t payload[UART_FRAME_MAX];
+} uart_frame_t;
+
+extern volatile uint32_t uart_frame_errors;// frames lost to a wrong checksum, a full queue or an overrun
+
 extern volatile int16_t data_buf[BUFLEN];// array that stores the data
 extern volatile int16_t read , write ; // circular buf indexes
 extern volatile uint8_t start;// set to start recording
 
 /*prototypes in UART.c*/
-void UART_Init();//Function enables UART and timer 8 to send data using circular buffer ISR
-void ReadUART(char *, uint16_t);
+void UART_Init();//Function enables UART1
+void telemetry_task();//Task of the scheduler that writes the data to the circular buffer
+void ReadUART(char *, uint16_t);//polls UART1, use before the interrupts are enabled
+uint8_t UART_get_frame(uart_frame_t *frame);//copies the oldest frame from the host, returns 0 if there is none
 void WriteUART(const char *);
 uint8_t buffer_empty();
 uint8_t buffer_full();
@@ -58,10 +80,6 @@ int16_t buffer_read();
 void buffer_write(int16_t data); 
 
 void _mon_putc (char c);
-void delay_us(unsigned int us);
-void delay_ms(int ms);
-void setTicks(uint32_t value);
-void getTicks(double *dt);
 
 #endif 
 
@@ -0,0 +1,263 @@
+/* ************************************************************************** */
+/** autotune.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+autotune.c
+
+@Summary
+ Peripherals used:
+  * None, the relay is run by the current loop (control.c) on OC1RS/OC2RS through the PWM driver
+
+@Description
+ A cycle of the limit cycle starts when the relay switches to +h, i.e. when the
+ * current falls below -eps. That instant is interpolated between the two samples
+ * around the crossing in 1/256 of a sample; the peak to peak current is the range
+ * of the samples of the cycle.
+ *
+ * Payload of the 'A' frames from the host (see UART.h), numbers are little endian:
+ *  'S' joint(1) [relay(2) hysteresis(2)]  start tuning, the defaults of autotune.h
+ *                                         are used without the last two
+ *  'X' joint(1)                           stop tuning
+ *  'Q'                                    results of both joints
+ * Every frame is answered by a line: OK, ERR or the results.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include <math.h>
+#include "header.h"
+#include "autotune.h"
+#include "control.h"
+#include "waveform.h"
+#include "UART.h"
+
+/*Measurement of a joint, written by the current loop while it is tuned*/
+typedef struct
+{
+    int16_t relay, hysteresis;  // h and eps
+    int8_t output;              // +1 or -1
+    int16_t previous;           // current of the previous sample
+    int16_t max, min;           // of the current cycle
+    uint16_t idle;              // samples since the last switch
+    uint8_t cycles;             // switches to +h
+    uint32_t time, start;       // 1/256 sample, start of the current cycle
+    uint32_t period_sum;        // 1/256 sample
+    int32_t peak_sum;           // peak to peak current
+} autotune_t;
+
+static autotune_t tuning[NUMBER_OF_JOINTS];
+static volatile autotune_result_t result[NUMBER_OF_JOINTS];
+static volatile uint8_t report[NUMBER_OF_JOINTS];
+
+
+/*Function to start the relay of a joint, the PI controller of the joint stops*/
+uint8_t autotune_start(uint8_t joint, int16_t relay, int16_t hysteresis)
+{
+    autotune_t *tune;
+
+    if(joint >= NUMBER_OF_JOINTS || relay <= 0 || hysteresis < 0 || waveform_playing())
+        return 0;
+    tune = &tuning[joint];
+    result[joint].state = AUTOTUNE_IDLE;    // the current loop leaves the measurement alone
+    tune->relay = relay;
+    tune->hysteresis = hysteresis;
+    tune->output = 1;
+    tune->previous = 0;
+    tune->max = INT16_MIN;
+    tune->min = INT16_MAX;
+    tune->idle = 0;
+    tune->cycles = 0;
+    tune->time = tune->start = 0;
+    tune->period_sum = 0;
+    tune->peak_sum = 0;
+    result[joint].failure = 0;
+    result[joint].ku = result[joint].tu = result[joint].amplitude = 0;
+    result[joint].kp = result[joint].ki = 0;
+    result[joint].state = AUTOTUNE_RUNNING;
+    return 1;
+}
+
+void autotune_stop(uint8_t joint)
+{
+    if(joint >= NUMBER_OF_JOINTS || result[joint].state != AUTOTUNE_RUNNING)
+        return;
+    PID_reset(&current_pid[joint], 0);      // before the current loop takes the joint back
+    result[joint].state = AUTOTUNE_IDLE;
+}
+
+RAMFUNC uint8_t autotune_running(uint8_t joint)
+{
+    uint8_t i;
+
+    if(joint < NUMBER_OF_JOINTS)
+        return result[joint].state == AUTOTUNE_RUNNING;
+    for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+        if(result[i].state == AUTOTUNE_RUNNING)
+            return 1;
+    return 0;
+}
+
+const autotune_result_t *autotune_result(uint8_t joint)
+{
+    return (const autotune_result_t *)&result[joint];
+}
+
+
+//Ziegler-Nichols PI gains from the measured cycles, applied to the current controller
+static void autotune_finish(uint8_t joint)
+{
+    autotune_t *tune = &tuning[joint];
+    float amplitude = (float)tune->peak_sum / (2 * AUTOTUNE_CYCLES);
+    float period = (float)tune->period_sum / (256.0f * AUTOTUNE_CYCLES);     // samples
+    float ki;
+
+    result[joint].amplitude = amplitude / 32768.0f;
+    result[joint].tu = period / CURRENT_LOOP_FS;
+    if(amplitude <= tune->hysteresis)
+    {
+        result[joint].failure = AUTOTUNE_NO_CYCLE;  // no limit cycle above the noise
+        result[joint].state = AUTOTUNE_FAILED;
+    }
+    else if(period < AUTOTUNE_MIN_PERIOD)
+    {
+        result[joint].failure = AUTOTUNE_TOO_FAST;  // the cycle follows the sample rate, not the motor
+        result[joint].state = AUTOTUNE_FAILED;
+    }
+    else
+    {
+        result[joint].ku = 4.0f * tune->relay / (3.14159265f * sqrtf(amplitude * amplitude -
+                           (float)tune->hysteresis * tune->hysteresis));
+        result[joint].kp = 0.45f * result[joint].ku;
+        ki = result[joint].kp * 1.2f / period;  // Kp / Ti per sample
+        result[joint].ki = ki * CURRENT_LOOP_FS;
+        PID_init(&current_pid[joint], PID_GAIN(result[joint].kp), PID_GAIN(ki), 0, 0,
+                 PID_FILTER_NONE, -CURRENT_LIMIT, CURRENT_LIMIT);
+        result[joint].state = AUTOTUNE_DONE;
+    }
+    PID_reset(&current_pid[joint], 0);
+    report[joint] = 1;
+}
+
+/*Function of the current loop, one relay update per sample*/
+int16_t autotune_update(uint8_t joint, int16_t current)
+{
+    autotune_t *tune = &tuning[joint];
+    uint32_t instant;
+
+    if(result[joint].state != AUTOTUNE_RUNNING)
+        return 0;
+    tune->time += 256;
+    if(current > tune->max)
+        tune->max = current;
+    if(current < tune->min)
+        tune->min = current;
+
+    if(tune->output > 0 && current > tune->hysteresis)
+    {
+        tune->output = -1;
+        tune->idle = 0;
+    }
+    else if(tune->output < 0 && current < -tune->hysteresis)
+    {
+        /*end of a cycle, the crossing of -eps lies between the previous sample and this one*/
+        instant = tune->time - (((int32_t)-tune->hysteresis - current) << 8) / ((int32_t)tune->previous - current);
+        if(tune->cycles > AUTOTUNE_SETTLE)
+        {
+            tune->period_sum += instant - tune->start;
+            tune->peak_sum += tune->max - tune->min;
+        }
+        tune->start = instant;
+        tune->max = tune->min = current;
+        tune->output = 1;
+        tune->idle = 0;
+        if(++tune->cycles > AUTOTUNE_SETTLE + AUTOTUNE_CYCLES)
+        {
+            autotune_finish(joint);
+            return 0;
+        }
+    }
+    else if(++tune->idle > AUTOTUNE_TIMEOUT)
+    {
+        PID_reset(&current_pid[joint], 0);
+        result[joint].failure = AUTOTUNE_NO_SWITCH;
+        result[joint].state = AUTOTUNE_FAILED;
+        report[joint] = 1;
+        return 0;
+    }
+    tune->previous = current;
+    return tune->output * tune->relay;
+}
+
+
+/*Serial link*/
+//one line per joint with the result of its last tuning
+static void autotune_write_result(uint8_t joint)
+{
+    static const char *const names[] = {"idle", "running", "done", "failed"};
+    static const char *const failures[] = {"", "the relay does not switch, lower the hysteresis",
+                                           "no limit cycle above the hysteresis",
+                                           "the limit cycle is too short, the relay has to run faster than the current loop"};
+    char msg[128];
+
+    sprintf(msg, "TUNE joint %u %s Ku %.3f Tu %.2f ms a %.4f Kp %.3f Ki %.1f /s\r\n", joint,
+            names[result[joint].state], result[joint].ku, result[joint].tu * 1000.0f,
+            result[joint].amplitude, result[joint].kp, result[joint].ki);
+    WriteUART(msg);
+    if(result[joint].state == AUTOTUNE_FAILED)
+    {
+        sprintf(msg, "TUNE joint %u %s\r\n", joint, failures[result[joint].failure]);
+        WriteUART(msg);
+    }
+}
+
+void autotune_report()
+{
+    uint8_t joint;
+
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+        if(report[joint])
+        {
+            report[joint] = 0;
+            autotune_write_result(joint);
+        }
+}
+
+/*Function to execute the payload of an 'A' frame*/
+void autotune_command(const uint8_t *payload, uint8_t length)
+{
+    uint8_t ok = 0, joint;
+
+    if(!length)
+        return;
+    switch(payload[0])
+    {
+        case 'S':
+            if(length == 2)
+                ok = autotune_start(payload[1], AUTOTUNE_RELAY, AUTOTUNE_HYSTERESIS);
+            else if(length == 6)
+                ok = autotune_start(payload[1], (int16_t)(payload[2] | payload[3] << 8),
+                                    (int16_t)(payload[4] | payload[5] << 8));
+            break;
+        case 'X':
+            if(length == 2 && payload[1] < NUMBER_OF_JOINTS)
+            {
+                autotune_stop(payload[1]);
+                ok = 1;
+            }
+            break;
+        case 'Q':
+            for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+                autotune_write_result(joint);
+            return;
+    }
+    WriteUART(ok ? "OK\r\n" : "ERR\r\n");
+}
@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/** autotune.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+autotune.h
+
+@Summary
+ Relay feedback tuning of the PI current loop
+
+@Description
+ While a joint is tuned the current loop drives its motor with a relay instead of
+ * the PI controller: the duty cycle is 50% + h while the current is below +eps and
+ * 50% - h once it is above, until it drops below -eps again. The motor current
+ * settles in a limit cycle whose amplitude a and period Tu give the ultimate gain
+ *  Ku = 4h / (pi * sqrt(a^2 - eps^2))
+ * and the PI gains follow Ziegler-Nichols: Kp = 0.45 Ku, Ti = Tu / 1.2.
+ * The first AUTOTUNE_SETTLE cycles are skipped, a and Tu are averaged over the next
+ * AUTOTUNE_CYCLES. The switching instants are interpolated between the samples of
+ * the current loop, so periods of a few samples are still measured. A limit cycle of
+ * fewer than 4 samples (AUTOTUNE_MIN_PERIOD) is set by the delay of the loop rather than by
+ * the motor, e.g. 2 samples when the current settles within a sample; the tuning then
+ * fails, the relay has to run in a faster loop than the current loop for that motor.
+ * The gains are applied to the current controller of the joint as soon as they are
+ * computed and the main loop reports them with autotune_report(). Each update costs a
+ * few comparisons; the gains are computed once, at the end, in the tick of the last
+ * cycle.
+ * The relay runs whether the controllers are enabled or not, the joint should be free
+ * to move or blocked while it is tuned. Waveform playback and tuning exclude each other.
+ * Serial link: 'A' frames from the host, see autotune.c.
+ */
+/* ************************************************************************** */
+
+#ifndef _AUTOTUNE_H    /* Guard against multiple inclusion */
+#define _AUTOTUNE_H
+
+#include <stdint.h>
+#include "control.h"
+
+#define AUTOTUNE_RELAY      Q15(0.2)    // default h, Q15 output of the current loop (20% of the duty cycle)
+#define AUTOTUNE_HYSTERESIS Q15(0.01)   // default eps, Q15 current, above the noise of the ADC
+#define AUTOTUNE_SETTLE     3           // cycles skipped before the measurement
+#define AUTOTUNE_CYCLES     8           // cycles measured
+#define AUTOTUNE_TIMEOUT    (CURRENT_LOOP_FS / 2)   // ticks without a switch of the relay before giving up
+#define AUTOTUNE_MIN_PERIOD 3.5f        // samples, a cycle of 4 less half a sample for the interpolated instants
+
+/*States of a joint*/
+#define AUTOTUNE_IDLE       0
+#define AUTOTUNE_RUNNING    1
+#define AUTOTUNE_DONE       2           // gains applied
+#define AUTOTUNE_FAILED     3           // no limit cycle, the gains are unchanged
+
+/*Causes of AUTOTUNE_FAILED*/
+#define AUTOTUNE_NO_SWITCH  1           // the relay is too weak for the hysteresis
+#define AUTOTUNE_NO_CYCLE   2           // the amplitude is within the hysteresis
+#define AUTOTUNE_TOO_FAST   3           // the period is shorter than AUTOTUNE_MIN_PERIOD samples
+
+/*Result of the last tuning of a joint*/
+typedef struct
+{
+    uint8_t state;
+    uint8_t failure;        // cause of AUTOTUNE_FAILED
+    float ku;               // ultimate gain, Q15 output per Q15 current
+    float tu;               // ultimate period in s
+    float amplitude;        // a, Q15 current
+    float kp, ki;           // PI gains, ki per second
+} autotune_result_t;
+
+/*Methods for the tuning
+ *******************************************************************
+ .................*/
+/*Start tuning a joint with relay amplitude h and hysteresis eps (Q15). Returns 0 while a
+ * waveform plays*/
+uint8_t autotune_start(uint8_t joint, int16_t relay, int16_t hysteresis);
+
+/*Stop tuning a joint, the gains are unchanged*/
+void autotune_stop(uint8_t joint);
+
+/*1 while a joint is tuned, for any joint if joint is NUMBER_OF_JOINTS*/
+RAMFUNC uint8_t autotune_running(uint8_t joint);
+
+/*Current loop: relay output (Q15, see CURRENT_LOOP_DUTY) for the measured current of a tuned joint*/
+FARCALL int16_t autotune_update(uint8_t joint, int16_t current);
+
+/*Result of the last tuning of a joint*/
+const autotune_result_t *autotune_result(uint8_t joint);
+
+/*Main loop: send the results of tunings that ended since the last call*/
+void autotune_report();
+
+/*Execute the payload of an 'A' frame from the host*/
+void autotune_command(const uint8_t *payload, uint8_t length);
+
+#endif /* _AUTOTUNE_H */
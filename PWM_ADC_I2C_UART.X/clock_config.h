@@ -0,0 +1,124 @@
+/* ************************************************************************** */
+/** clock_config.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+clock_config.h
+
+@Summary
+ Clocks of the system and the peripheral buses, and the timer settings derived from them
+
+@Description
+ The system clock is the System PLL fed by the 24MHz external clock on OSC1:
+ * SYS_FREQ = 24MHz / FPLLIDIV * FPLLMULT / FPLLODIV. Build with CLOCK_PROFILE set to
+ * 200 (default) or 252 (the rated maximum of the EF parts); the profile selects the PLL
+ * configuration bits in config.h, the divisors of the peripheral buses and the flash
+ * wait states written by set_performance_mode(). Every frequency, prescaler and period
+ * register of the project is derived from the macros below at compile time:
+ * - CLOCK_TIMER_PRESCALER(rate): smallest prescaler of Timer2-9 for which a period of
+ *   rate Hz fits PR in 16 bits, CLOCK_TCKPS() its TCKPS value
+ * - CLOCK_TIMER_PR(rate, prescaler): the period register for rate Hz
+ * - CLOCK_ASSERT_TIMER(rate, prescaler, ppm): fails the build if the period does not
+ *   fit or the rate is off by more than ppm parts per million
+ * - CLOCK_UART_BRG(baud): UxBRG with BRGH = 0, CLOCK_ASSERT_UART() checks the error
+ * The limits are those of the PIC32MZ EF data sheet: PLL input 5-64MHz, VCO 350-700MHz,
+ * at most 100MHz on the peripheral buses except PBCLK7 (CPU), and the wait states of
+ * the flash per SYSCLK range.
+ */
+/* ************************************************************************** */
+
+#ifndef _CLOCK_CONFIG_H    /* Guard against multiple inclusion */
+#define _CLOCK_CONFIG_H
+
+#ifndef CLOCK_PROFILE
+#define CLOCK_PROFILE   200
+#endif
+
+#define CLOCK_POSC_FREQ 24000000        // external clock on OSC1, POSCMOD = EC
+
+/*PLL (DEVCFG2 in config.h) and divisors of the peripheral buses (PBxDIV + 1)*/
+#if CLOCK_PROFILE == 200
+#define CLOCK_PLL_IDIV  3
+#define CLOCK_PLL_MULT  50
+#define CLOCK_PLL_ODIV  2
+#define CLOCK_PB1_DIV   2               // WDT, RTC, PPS
+#define CLOCK_PB2_DIV   2               // I2C, UART, SPI
+#define CLOCK_PB3_DIV   2               // ADC, timers, OC, IC
+#define CLOCK_PB4_DIV   2               // ports
+#define CLOCK_PB5_DIV   2               // Ethernet, CAN, USB
+#define CLOCK_PB7_DIV   1               // CPU
+#define CLOCK_PB8_DIV   2               // EBI
+#elif CLOCK_PROFILE == 252
+#define CLOCK_PLL_IDIV  3
+#define CLOCK_PLL_MULT  63
+#define CLOCK_PLL_ODIV  2
+#define CLOCK_PB1_DIV   3
+#define CLOCK_PB2_DIV   3
+#define CLOCK_PB3_DIV   3
+#define CLOCK_PB4_DIV   3
+#define CLOCK_PB5_DIV   3
+#define CLOCK_PB7_DIV   1
+#define CLOCK_PB8_DIV   3
+#else
+#error "CLOCK_PROFILE has to be 200 or 252"
+#endif
+
+#define CLOCK_PLL_INPUT (CLOCK_POSC_FREQ / CLOCK_PLL_IDIV)     // FPLLRNG = RANGE_5_10_MHZ
+#define CLOCK_PLL_VCO   (CLOCK_PLL_INPUT * CLOCK_PLL_MULT)
+#define SYS_FREQ        (CLOCK_PLL_VCO / CLOCK_PLL_ODIV)
+
+#define PBCLK1_FREQ     (SYS_FREQ / CLOCK_PB1_DIV)
+#define PBCLK2_FREQ     (SYS_FREQ / CLOCK_PB2_DIV)
+#define PBCLK3_FREQ     (SYS_FREQ / CLOCK_PB3_DIV)
+#define PBCLK4_FREQ     (SYS_FREQ / CLOCK_PB4_DIV)
+#define PBCLK5_FREQ     (SYS_FREQ / CLOCK_PB5_DIV)
+#define PBCLK7_FREQ     (SYS_FREQ / CLOCK_PB7_DIV)
+#define PBCLK8_FREQ     (SYS_FREQ / CLOCK_PB8_DIV)
+
+/*Wait states of the flash (PRECON.PFMWS) for SYSCLK*/
+#define CLOCK_PFMWS     (SYS_FREQ <= 60000000 ? 0 : SYS_FREQ <= 120000000 ? 1 : SYS_FREQ <= 200000000 ? 2 : 4)
+
+_Static_assert(CLOCK_PLL_INPUT >= 5000000 && CLOCK_PLL_INPUT <= 10000000, "PLL input outside of FPLLRNG (5-10MHz)");
+_Static_assert(CLOCK_PLL_VCO >= 350000000 && CLOCK_PLL_VCO <= 700000000, "PLL VCO outside of 350-700MHz");
+_Static_assert(SYS_FREQ <= 252000000, "SYSCLK above 252MHz");
+_Static_assert(PBCLK1_FREQ <= 100000000 && PBCLK2_FREQ <= 100000000 && PBCLK3_FREQ <= 100000000 &&
+               PBCLK4_FREQ <= 100000000 && PBCLK5_FREQ <= 100000000 && PBCLK8_FREQ <= 100000000,
+               "peripheral bus clock above 100MHz");
+
+/*Timer2-9, clocked by PBCLK3*/
+#define CLOCK_TIMER_FITS(rate, prescaler)   (PBCLK3_FREQ / (prescaler) / (rate) <= 0x10000)
+#define CLOCK_TIMER_PRESCALER(rate) \
+    (CLOCK_TIMER_FITS(rate, 1) ? 1 : CLOCK_TIMER_FITS(rate, 2) ? 2 : CLOCK_TIMER_FITS(rate, 4) ? 4 : \
+     CLOCK_TIMER_FITS(rate, 8) ? 8 : CLOCK_TIMER_FITS(rate, 16) ? 16 : CLOCK_TIMER_FITS(rate, 32) ? 32 : \
+     CLOCK_TIMER_FITS(rate, 64) ? 64 : 256)
+#define CLOCK_TCKPS(prescaler) \
+    ((prescaler) == 1 ? 0 : (prescaler) == 2 ? 1 : (prescaler) == 4 ? 2 : (prescaler) == 8 ? 3 : \
+     (prescaler) == 16 ? 4 : (prescaler) == 32 ? 5 : (prescaler) == 64 ? 6 : 7)
+#define CLOCK_TIMER_FREQ(prescaler)         (PBCLK3_FREQ / (prescaler))
+#define CLOCK_TIMER_PR(rate, prescaler)     ((CLOCK_TIMER_FREQ(prescaler) + (rate) / 2) / (rate) - 1)
+
+/*Difference of the rate from the request in parts per million*/
+#define CLOCK_TIMER_ERROR_PPM(rate, prescaler) \
+    ((long long)CLOCK_TIMER_FREQ(prescaler) * 1000000 / (CLOCK_TIMER_PR(rate, prescaler) + 1) / (rate) - 1000000)
+#define CLOCK_ASSERT_TIMER(rate, prescaler, ppm) \
+    _Static_assert(CLOCK_TIMER_PR(rate, prescaler) >= 1 && CLOCK_TIMER_PR(rate, prescaler) <= 0xFFFF, \
+                   "period of " #rate " does not fit PR"); \
+    _Static_assert(CLOCK_TIMER_ERROR_PPM(rate, prescaler) <= (ppm) && CLOCK_TIMER_ERROR_PPM(rate, prescaler) >= -(ppm), \
+                   "rate of " #rate " is off by more than " #ppm " ppm")
+
+/*UART, BRGH = 0: baud = PBCLK2/(16*(UxBRG+1))*/
+#define CLOCK_UART_BRG(baud)        ((PBCLK2_FREQ + 8 * (baud)) / (16 * (baud)) - 1)
+#define CLOCK_UART_ERROR_PPM(baud)  ((long long)PBCLK2_FREQ * 1000000 / (16 * (CLOCK_UART_BRG(baud) + 1)) / (baud) - 1000000)
+#define CLOCK_ASSERT_UART(baud, ppm) \
+    _Static_assert(CLOCK_UART_BRG(baud) <= 0xFFFF, "BRG of " #baud " does not fit"); \
+    _Static_assert(CLOCK_UART_ERROR_PPM(baud) <= (ppm) && CLOCK_UART_ERROR_PPM(baud) >= -(ppm), \
+                   "baud rate " #baud " is off by more than " #ppm " ppm")
+
+#endif /* _CLOCK_CONFIG_H */
@@ -24,6 +24,8 @@
 #ifndef _CONFIG_H    /* Guard against multiple inclusion */
 #define _CONFIG_H
 
+#include "clock_config.h"
+
 
 //////New Configuration
 
@@ -38,10 +40,15 @@
 #pragma config FUSBIDIO = OFF           // USB USBID Selection (Controlled by Port Function)
 
 // DEVCFG2
+// SYSCLK = 24MHz / FPLLIDIV * FPLLMULT / FPLLODIV, keep in line with the profile in clock_config.h
 #pragma config FPLLIDIV = DIV_3         // System PLL Input Divider (3x Divider)
 #pragma config FPLLRNG = RANGE_5_10_MHZ // System PLL Input Range (5-10 MHz Input)
 #pragma config FPLLICLK = PLL_POSC      // System PLL Input Clock Selection (POSC is input to the System PLL)
-#pragma config FPLLMULT = MUL_50        // System PLL Multiplier (PLL Multiply by 50)
+#if CLOCK_PROFILE == 252
+#pragma config FPLLMULT = MUL_63        // System PLL Multiplier (PLL Multiply by 63), 252MHz
+#else
+#pragma config FPLLMULT = MUL_50        // System PLL Multiplier (PLL Multiply by 50), 200MHz
+#endif
 #pragma config FPLLODIV = DIV_2         // System PLL Output Clock Divider (2x Divider)
 #pragma config UPLLFSEL = FREQ_24MHZ    // USB PLL Input Frequency Selection (USB PLL input is 24 MHz)
 
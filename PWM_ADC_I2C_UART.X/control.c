@@ -15,7 +15,7 @@ control.c
 
 @Summary
  Peripherals used:
-  * Timer6 & Timer7 - Current and position control loops. Timer3 and timer5 have been used left out as they can be used for ADC triggering
+  * None, the current and position control loops are tasks of the scheduler (Timer6)
  
 @Description
    This file is used to change values for the gains of up the current and the position control loops that can be used to 
@@ -28,23 +28,169 @@ control.c
 #include <proc/p32mz2048efm100.h>
 #include"mpu9250.h"
 #include"AS5600L.h"
+#include"control.h"
+#include"stream.h"
+#include"trajectory.h"
+#include"autotune.h"
+#include"ADC.h"
+#include"perf.h"
+#include"waveform.h"
+#include"UART.h"
 
+/*Requests of the host, carried out by the position loop*/
+#define CONTROL_REQUEST_NONE    0
+#define CONTROL_REQUEST_START   1
+#define CONTROL_REQUEST_STOP    2
 
 
-/*Interrupt service routines for timers 6 and 7 that control the looping speeds
- These timers have been set in motorDriver.c */
+
+/*Shared variables of the control loops, see control.h*/
+volatile uint8_t control_enabled = 0;
+volatile int16_t position_reference[NUMBER_OF_JOINTS];
+volatile int16_t current_feed_forward[NUMBER_OF_JOINTS];
+volatile int16_t current_reference[NUMBER_OF_JOINTS];
+traj_t trajectory[NUMBER_OF_JOINTS];
+traj_point_t trajectory_point[NUMBER_OF_JOINTS];
+pid_controller_t current_pid[NUMBER_OF_JOINTS], position_pid[NUMBER_OF_JOINTS];
+
+static volatile uint8_t control_request = CONTROL_REQUEST_NONE;
+
+
+/*Function to set the gains of the current and position controllers of both joints*/
+void control_init()
+{
+    uint8_t joint;
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+    {
+        PID_init(&current_pid[joint], CURRENT_KP, CURRENT_KI, 0, 0,
+                 PID_FILTER_NONE, -CURRENT_LIMIT, CURRENT_LIMIT);
+        PID_init(&position_pid[joint], POSITION_KP, POSITION_KI, POSITION_KD, POSITION_KFF,
+                 POSITION_D_FILTER, -POSITION_CURRENT_LIMIT, POSITION_CURRENT_LIMIT);
+        position_reference[joint] = 0;
+        current_feed_forward[joint] = 0;
+        current_reference[joint] = 0;
+    }
+}
+
+/*Function to start the controllers without a step, the joints hold their current angle.
+ * The encoders are read first, then the state is set with interrupts disabled, so a running 
+ * current loop keeps the duty cycle and takes the new state at its next sample*/
+void control_start()
+{
+    uint16_t angle[NUMBER_OF_JOINTS];
+    uint8_t joint;
+    uint32_t status;
+    
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+        encoderGetAngle(joint, &angle[joint]);
+    status = __builtin_disable_interrupts();
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+    {
+        position_reference[joint] = ANGLE_TO_Q15(angle[joint]);
+        current_reference[joint] = 0;
+        trajectory_init(&trajectory[joint], ANGLE_TO_Q15(angle[joint]), TRAJECTORY_STEPS, CURRENT_LOOP_FS);
+        trajectory_step(&trajectory[joint], &trajectory_point[joint]);
+        PID_reset(&position_pid[joint], ANGLE_TO_Q15(angle[joint]));
+        PID_reset(&current_pid[joint], 0);
+    }
+    control_enabled = 1;
+    __builtin_mtc0(12, 0, status);
+}
+
+/*Function to stop the controllers, the integrators and references are cleared for the next start*/
+void control_stop()
+{
+    uint8_t joint;
+
+    control_enabled = 0;
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+    {
+        current_reference[joint] = 0;
+        PID_reset(&position_pid[joint], 0);
+        PID_reset(&current_pid[joint], 0);
+    }
+}
+
+/*Function to execute the payload of a 'C' frame*/
+void control_command(const uint8_t *payload, uint8_t length)
+{
+    uint8_t ok = 0;
+
+    if(length != 1)
+        return;
+    switch(payload[0])
+    {
+        case 'S':   //the duty cycle belongs to one of the current loop and the DMA
+            if(!waveform_playing())
+            {
+                control_request = CONTROL_REQUEST_START;
+                ok = 1;
+            }
+            break;
+        case 'X':
+            control_request = CONTROL_REQUEST_STOP;
+            ok = 1;
+            break;
+    }
+    WriteUART(ok ? "OK\r\n" : "ERR\r\n");
+}
+
+
+//current reference of the position loop plus the feed forward of the interpolated reference
+static RAMFUNC int16_t current_loop_reference(uint8_t joint)
+{
+    int32_t reference = current_reference[joint] +
+            (int32_t)(((int64_t)trajectory_point[joint].velocity * TRAJECTORY_KV +
+                       (int64_t)trajectory_point[joint].acceleration * TRAJECTORY_KA) >> 16);
+
+    if(reference > POSITION_CURRENT_LIMIT)
+        return POSITION_CURRENT_LIMIT;
+    if(reference < -POSITION_CURRENT_LIMIT)
+        return -POSITION_CURRENT_LIMIT;
+    return (int16_t)reference;
+}
+
+
+/*Tasks of the current and position control loops
+ The looping speeds are set in the task table of scheduler.c */
 
 /*Current control function that tries to get the current up to the desired current based on the 
      measured and reference current. This function generated duty cycle that is assigned to the Motor*/
-void __attribute__((vector(_TIMER_6_VECTOR), interrupt(ipl3srs), nomips16)) current_control_loop()
+RAMFUNC void current_control_task()
 {
  //Loop runs at 1000 Hz   
-    LATDbits.LATD9^=1;//Flip bits to check for looping frequency on RD9
+    uint8_t joint;
+    
+    PERF_ENTER(PERF_CURRENT_LOOP);
+    pin_toggle(REG_PIN(D, 9));//Flip bits to check for looping frequency on RD9
     
     flag_ankle_current=1;
+    PERF_ENTER(PERF_ADC);
     getADC(&ADC1,&ADC2,&ADC3);
+    PERF_EXIT(PERF_ADC);
     
-    IFS0bits.T6IF = 0;  // Clear interrupt flag for timer 6   
+    if(control_enabled)
+    {
+        //reference between the position samples
+        PERF_ENTER(PERF_TRAJECTORY);
+        for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+            trajectory_step(&trajectory[joint], &trajectory_point[joint]);
+        PERF_EXIT(PERF_TRAJECTORY);
+    }
+    //PI control of the motor currents to the references of the position loop, a relay while a joint is tuned
+    PERF_ENTER(PERF_PID);
+    if(autotune_running(KNEE_JOINT))
+        PWM_set_duty16(PWM_CHANNEL_M1, CURRENT_LOOP_DUTY(autotune_update(KNEE_JOINT, CURRENT_TO_Q15(ADC1))));
+    else if(control_enabled)
+        PWM_set_duty16(PWM_CHANNEL_M1, CURRENT_LOOP_DUTY(PID_update(&current_pid[KNEE_JOINT],
+                        current_loop_reference(KNEE_JOINT), CURRENT_TO_Q15(ADC1), 0)));
+    if(autotune_running(ANKLE_JOINT))
+        PWM_set_duty16(PWM_CHANNEL_M2, CURRENT_LOOP_DUTY(autotune_update(ANKLE_JOINT, CURRENT_TO_Q15(ADC2))));
+    else if(control_enabled)
+        PWM_set_duty16(PWM_CHANNEL_M2, CURRENT_LOOP_DUTY(PID_update(&current_pid[ANKLE_JOINT],
+                        current_loop_reference(ANKLE_JOINT), CURRENT_TO_Q15(ADC2), 0)));
+    PERF_EXIT(PERF_PID);
+    PERF_EXIT(PERF_CURRENT_LOOP);
 }
 
 
@@ -52,36 +198,45 @@ void __attribute__((vector(_TIMER_6_VECTOR), interrupt(ipl3srs), nomips16)) curr
      reach the reference position. This function generates current/torque command that is passed on to the
      current control function
      */
-void __attribute__((vector(_TIMER_7_VECTOR), interrupt(ipl4srs), nomips16)) position_control_loop()
+void position_control_task()
 {
     //Loop runs at 100Hz
-    //uint32_t timeloop=0;
-    //_CP0_SET_COUNT(0);
+    int16_t accel[3], gyro[3];
+    uint16_t angle;
+    uint8_t joint, request;
+    uint32_t status;
         
-    IMUReadBytes(IMU_ADDRESS, ACCEL_XOUT_H,ACCEL_BIAS_X, &accelX);
-    LATDbits.LATD12^=1;//Flip bits to check for looping frequency on RD12
-    //IMUReadBytes(IMU_ADDRESS, ACCEL_YOUT_H,ACCEL_BIAS_Y, &accelY);
+    PERF_ENTER(PERF_POSITION_LOOP);
+    status = __builtin_disable_interrupts();//take the request of the host
+    request = control_request;
+    control_request = CONTROL_REQUEST_NONE;
+    __builtin_mtc0(12, 0, status);
+    if(request == CONTROL_REQUEST_START)
+        control_start();//reads the encoders, which share the bus with the IMU read below
+    else if(request == CONTROL_REQUEST_STOP)
+        control_stop();
+    
+    PERF_ENTER(PERF_IMU_READ);
+    IMUReadMotion(accel, gyro);//accelerometer and gyro in one burst
+    PERF_EXIT(PERF_IMU_READ);
+    accelX=accel[0]; accelY=accel[1]; accelZ=accel[2];
+    gyroX=gyro[0]; gyroY=gyro[1]; gyroZ=gyro[2];
+    pin_toggle(REG_PIN(D, 12));//Flip bits to check for looping frequency on RD12
     flag_ankle_encoder=1;
-    //IMUReadBytes(IMU_ADDRESS, ACCEL_ZOUT_H,ACCEL_BIAS_Z, &accelZ);
-
     
-    IFS1bits.T7IF = 0;  // Clear interrupt flag for timer 7
-
-    //timeloop=_CP0_GET_COUNT();
+    if(control_enabled)
+    {
+        stream_next(position_reference);//setpoints streamed by the host, if any
+        //PID control of the joint angles to the interpolated reference, the output is the current reference of the current loop
+        for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+        {
+            encoderGetAngle(joint, &angle);
+            current_reference[joint] = PID_update(&position_pid[joint], trajectory_point[joint].position,
+                                                  ANGLE_TO_Q15(angle), current_feed_forward[joint]);
+            status = __builtin_disable_interrupts();//the current loop preempts the deferred position loop mid segment
+            trajectory_push(&trajectory[joint], position_reference[joint]);//next segment of the current loop
+            __builtin_mtc0(12, 0, status);
+        }
+    }
+    PERF_EXIT(PERF_POSITION_LOOP);
 }
-
-
-
-/*Functions to set the duty cycles to motor1 and motor2*/
-void set_dutycycleM1(uint16_t dutyCycle1)
-{
-    /*This function is used to set dutyCycle to Motor1 on the fly*/ 
-    OC1RS=dutyCycle1;
-}
-
-
-void set_dutycycleM2(uint16_t dutyCycle2)
-{
-    /*This function is used to set dutyCycle to Motor1 on the fly*/ 
-    OC2RS=dutyCycle2;
-}
\ No newline at end of file
@@ -0,0 +1,108 @@
+/* ************************************************************************** */
+/** control.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control.h
+
+@Summary
+ Gains, scaling and shared variables of the cascaded current and position loops
+
+@Description
+ The position loop (100Hz) runs a PID controller per joint on the encoder
+ * angle and passes its output as the current reference to the current loop
+ * (1KHz), which runs a PI controller per joint on the measured current and
+ * sets the duty cycle of the motor. All signals are Q15, see PID.h for the numeric
+ * type the controllers run in.
+ * The position references are interpolated (trajectory.h): at every tick the
+ * current loop takes a smooth position, velocity and acceleration between them
+ * and adds the velocity and acceleration feed forward to its reference, the
+ * position loop follows the interpolated position, which reaches
+ * position_reference two position samples (20ms) later.
+ * Joint KNEE_JOINT drives motor1 (OC1) and measures its current on ADC1,
+ * joint ANKLE_JOINT drives motor2 (OC2) and measures its current on ADC2.
+ * Serial link: control_command() executes the 'C' frames of the host, 'S' starts the
+ * controllers and 'X' stops them. The position loop owns the bus of the encoders, so
+ * it carries out the request at its next sample.
+ */
+/* ************************************************************************** */
+
+#ifndef _CONTROL_H    /* Guard against multiple inclusion */
+#define _CONTROL_H
+
+#include "PID.h"
+#include "AS5600L.h"
+#include "PWM.h"
+#include "trajectory.h"
+
+/*Sample frequencies of the loops, set by the periods of the tasks in scheduler.c*/
+#define CURRENT_LOOP_FS  1000
+#define POSITION_LOOP_FS 100
+
+/*Gains of the current loop, PI; the current settles within a sample (L/R < 1ms), so Kp stays well
+ * below the inverse of the gain from duty cycle to current (2.0 at 24V and 1.2 Ohm) and the
+ * integrator removes the error in a few samples*/
+#define CURRENT_KP      PID_GAIN(0.25)
+#define CURRENT_KI      PID_GAIN(400.0 / CURRENT_LOOP_FS)
+#define CURRENT_LIMIT   Q15(1.0)                    // duty cycle limit, see CURRENT_LOOP_DUTY
+
+/*Gains of the position loop, PID; Kd/Kp is long enough to brake the knee in time at POSITION_CURRENT_LIMIT*/
+#define POSITION_KP     PID_GAIN(15.0)
+#define POSITION_KI     PID_GAIN(100.0 / POSITION_LOOP_FS)
+#define POSITION_KD_S   1.0                         // s, derivative gain Kd
+#define POSITION_KD     PID_GAIN(POSITION_KD_S * POSITION_LOOP_FS)
+#define POSITION_KFF    PID_GAIN(1.0)               // gain of the current feed forward, e.g. gravity compensation
+#define POSITION_D_FILTER PID_FILTER(10, POSITION_LOOP_FS)
+#define POSITION_CURRENT_LIMIT Q15(0.5)             // largest current reference
+
+/*Interpolation of the position reference*/
+#define TRAJECTORY_STEPS    (CURRENT_LOOP_FS / POSITION_LOOP_FS)    // ticks of the current loop per position reference
+#define TRAJECTORY_FF(x)    ((int32_t)((x) * 65536.0))
+/*current (1.0 is full scale) per Q15 angle of 1.0 per s (0.5 turn/s); the derivative of the measurement
+ * brakes a joint that follows the reference, the velocity feed forward of the same gain makes up for it*/
+#define TRAJECTORY_KV       TRAJECTORY_FF(POSITION_KD_S)
+#define TRAJECTORY_KA       TRAJECTORY_FF(0.0)      // current per Q15 angle of 1.0 per s^2, inertia of the joint
+
+/*Scaling of the measurements to Q15*/
+#define ANGLE_TO_Q15(angle)     ((int16_t)(((int32_t)(angle) - 2048) << 4))    // 0-4095 encoder counts to -0.5 ... 0.5 turn
+#define CURRENT_TO_Q15(adc)     ((int16_t)(((int32_t)(adc) - 2048) << 4))      // 12 bit ADC, zero current at mid scale
+/*Output of the current loop to the 16 bit duty cycle of PWM_set_duty16(), locked anti-phase: -1.0 is 0%, 0 is 50% and 1.0 is 100%*/
+#define CURRENT_LOOP_DUTY(out)  ((uint16_t)((int32_t)(out) + 32768))
+
+/*Shared variables of the loops, indexed by joint*/
+extern volatile uint8_t control_enabled;                        // set to run the controllers, the duty cycle is left alone while 0
+extern volatile int16_t position_reference[NUMBER_OF_JOINTS];   // Q15 angle, see ANGLE_TO_Q15
+extern volatile int16_t current_feed_forward[NUMBER_OF_JOINTS]; // Q15 current added to the output of the position loop
+extern volatile int16_t current_reference[NUMBER_OF_JOINTS];    // Q15 current, output of the position loop
+extern traj_t trajectory[NUMBER_OF_JOINTS];                     // interpolators of the position references
+extern traj_point_t trajectory_point[NUMBER_OF_JOINTS];         // interpolated reference of the last tick of the current loop
+extern pid_controller_t current_pid[NUMBER_OF_JOINTS], position_pid[NUMBER_OF_JOINTS];
+
+/*Methods for the control loops
+ *******************************************************************
+ .................*/
+/*Set the gains of the controllers, call before enabling the interrupts*/
+void control_init();
+
+/*Start the controllers from the current measurements, the position reference is set to the current angle.
+ * Restarts running controllers without releasing the duty cycle*/
+void control_start();
+
+/*Stop the controllers and clear their state, the duty cycle is left to main() again*/
+void control_stop();
+
+/*Execute the payload of a 'C' frame: 'S' to start, 'X' to stop at the next sample of the position loop*/
+void control_command(const uint8_t *payload, uint8_t length);
+
+/*Tasks of the loops, run by the scheduler*/
+RAMFUNC void current_control_task();
+void position_control_task();
+
+#endif /* _CONTROL_H */
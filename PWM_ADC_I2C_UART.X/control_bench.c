@@ -0,0 +1,145 @@
+/* ************************************************************************** */
+/** control_bench.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_bench.c
+
+@Summary
+ Benchmark of the controller and filter kernels in Q31 and float
+
+@Description
+ The input sequence is a sine reference with a lagging, noisy measurement and a
+ * cosine feed forward, so the controller passes through its linear range and
+ * into saturation. The inputs are converted to each type before the timing starts.
+ * The double precision kernels used as the reference are compiled in this file.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <math.h>
+#include "header.h"
+#include "control_kernels.h"
+#include "control_bench.h"
+#include "systime.h"
+
+/*Kernels in double precision, the reference of the benchmark*/
+#define CTRL_SUFFIX f64
+#define CTRL_IMPLEMENTATION
+#include "control_kernel_template.h"
+#undef CTRL_IMPLEMENTATION
+#undef CTRL_SUFFIX
+
+/*Parameters of the kernels under test: a position loop at 1KHz*/
+#define BENCH_KP        2.0
+#define BENCH_KI        0.02
+#define BENCH_KD        0.5
+#define BENCH_KFF       1.0
+#define BENCH_D_FILTER  0.3859      // 100Hz at 1KHz
+#define BENCH_LIMIT     0.9
+#define BENCH_LOWPASS   0.0591      // 10Hz at 1KHz
+
+static double reference[CONTROL_BENCH_SAMPLES], measurement[CONTROL_BENCH_SAMPLES], feed_forward[CONTROL_BENCH_SAMPLES];
+static double pid_expected[CONTROL_BENCH_SAMPLES], lowpass_expected[CONTROL_BENCH_SAMPLES];
+
+/*Buffers of the type under test, large enough for either type*/
+static union { ctrl_q31_t q31[CONTROL_BENCH_SAMPLES]; ctrl_f32_t f32[CONTROL_BENCH_SAMPLES]; } in_r, in_m, in_ff, out_pid, out_lowpass;
+
+//input sequence and the outputs of the double precision kernels
+static void bench_reference(void)
+{
+    pid_f64_t pid;
+    lowpass_f64_t lowpass;
+    uint32_t seed = 12345, i;
+
+    for(i = 0; i < CONTROL_BENCH_SAMPLES; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;     /* noise of +-0.01 */
+        reference[i] = 0.6 * sin(6.2831853 * i / 250.0);
+        measurement[i] = 0.55 * sin(6.2831853 * (i - 20) / 250.0) + 0.01 * ((int32_t)seed / 2147483648.0);
+        feed_forward[i] = 0.1 * cos(6.2831853 * i / 250.0);
+    }
+
+    pid_init_f64(&pid, CTRL_GAIN_F64(BENCH_KP), CTRL_GAIN_F64(BENCH_KI), CTRL_GAIN_F64(BENCH_KD), CTRL_GAIN_F64(BENCH_KFF),
+                 CTRL_COEF_F64(BENCH_D_FILTER), -BENCH_LIMIT, BENCH_LIMIT);
+    pid_reset_f64(&pid, measurement[0]);
+    lowpass_init_f64(&lowpass, CTRL_COEF_F64(BENCH_LOWPASS), measurement[0]);
+    for(i = 0; i < CONTROL_BENCH_SAMPLES; ++i)
+    {
+        pid_expected[i] = pid_update_f64(&pid, reference[i], measurement[i], feed_forward[i]);
+        lowpass_expected[i] = lowpass_update_f64(&lowpass, measurement[i]);
+    }
+}
+
+//largest and rms difference of the outputs with the double precision kernels
+static void bench_error(const double *expected, double actual, uint32_t i, double *max, double *sum)
+{
+    double error = fabs(actual - expected[i]);
+    if(error > *max)
+        *max = error;
+    *sum += error * error;
+}
+
+/*Benchmark of one numeric type, the same code for every type*/
+#define CONTROL_BENCH_TYPE(sfx, GAIN, COEF)                                                                     \
+static void bench_##sfx(uint32_t (*clock)(void), control_bench_result_t *result)                               \
+{                                                                                                               \
+    pid_##sfx##_t pid;                                                                                          \
+    lowpass_##sfx##_t lowpass;                                                                                  \
+    double pid_sum = 0, lowpass_sum = 0;                                                                        \
+    uint32_t start, i;                                                                                          \
+                                                                                                                \
+    for(i = 0; i < CONTROL_BENCH_SAMPLES; ++i)                                                                  \
+    {                                                                                                           \
+        in_r.sfx[i] = ctrl_from_double_##sfx(reference[i]);                                                     \
+        in_m.sfx[i] = ctrl_from_double_##sfx(measurement[i]);                                                   \
+        in_ff.sfx[i] = ctrl_from_double_##sfx(feed_forward[i]);                                                 \
+    }                                                                                                           \
+    pid_init_##sfx(&pid, GAIN(BENCH_KP), GAIN(BENCH_KI), GAIN(BENCH_KD), GAIN(BENCH_KFF), COEF(BENCH_D_FILTER), \
+                   ctrl_from_double_##sfx(-BENCH_LIMIT), ctrl_from_double_##sfx(BENCH_LIMIT));                  \
+    pid_reset_##sfx(&pid, in_m.sfx[0]);                                                                         \
+    lowpass_init_##sfx(&lowpass, COEF(BENCH_LOWPASS), in_m.sfx[0]);                                             \
+                                                                                                                \
+    start = clock();                                                                                            \
+    for(i = 0; i < CONTROL_BENCH_SAMPLES; ++i)                                                                  \
+        out_pid.sfx[i] = pid_update_##sfx(&pid, in_r.sfx[i], in_m.sfx[i], in_ff.sfx[i]);                        \
+    result->pid_time = (clock() - start) / CONTROL_BENCH_SAMPLES;                                               \
+    start = clock();                                                                                            \
+    for(i = 0; i < CONTROL_BENCH_SAMPLES; ++i)                                                                  \
+        out_lowpass.sfx[i] = lowpass_update_##sfx(&lowpass, in_m.sfx[i]);                                       \
+    result->lowpass_time = (clock() - start) / CONTROL_BENCH_SAMPLES;                                           \
+                                                                                                                \
+    result->name = #sfx;                                                                                        \
+    result->pid_max_error = result->lowpass_max_error = 0;                                                      \
+    for(i = 0; i < CONTROL_BENCH_SAMPLES; ++i)                                                                  \
+    {                                                                                                           \
+        bench_error(pid_expected, ctrl_to_double_##sfx(out_pid.sfx[i]), i, &result->pid_max_error, &pid_sum);   \
+        bench_error(lowpass_expected, ctrl_to_double_##sfx(out_lowpass.sfx[i]), i, &result->lowpass_max_error, &lowpass_sum); \
+    }                                                                                                           \
+    result->pid_rms_error = sqrt(pid_sum / CONTROL_BENCH_SAMPLES);                                              \
+    result->lowpass_rms_error = sqrt(lowpass_sum / CONTROL_BENCH_SAMPLES);                                      \
+}
+
+CONTROL_BENCH_TYPE(q31, CTRL_GAIN_Q31, CTRL_COEF_Q31)
+CONTROL_BENCH_TYPE(f32, CTRL_GAIN_F32, CTRL_COEF_F32)
+
+//run the kernels of every type on the same inputs
+void control_benchmark(uint32_t (*clock)(void), control_bench_result_t result[CONTROL_BENCH_TYPES])
+{
+    bench_reference();
+    bench_q31(clock, &result[0]);
+    bench_f32(clock, &result[1]);
+}
+
+//CPU cycles from the core timer
+uint32_t control_bench_cycles(void)
+{
+    return 2 * systime_count();
+}
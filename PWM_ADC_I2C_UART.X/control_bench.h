@@ -0,0 +1,55 @@
+/* ************************************************************************** */
+/** control_bench.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_bench.h
+
+@Summary
+ Benchmark of the controller and filter kernels in Q31 and float
+
+@Description
+ Runs the PID and low pass kernels of control_kernels.h in every numeric type on
+ * the same input sequence and compares their outputs with the kernels in double
+ * precision. The time of an update is measured with the clock passed to the
+ * benchmark, on target this is control_bench_cycles() (CPU cycles from the core timer).
+ * Code size is not measured at run time, it is the size of the text section of
+ * control_q31.o and control_f32.o (xc32-size on target, size on the PC).
+ */
+/* ************************************************************************** */
+
+#ifndef _CONTROL_BENCH_H    /* Guard against multiple inclusion */
+#define _CONTROL_BENCH_H
+
+#include <stdint.h>
+
+#define CONTROL_BENCH_SAMPLES 500   // updates per kernel
+
+/*Result of a kernel in one numeric type*/
+typedef struct
+{
+    const char *name;
+    uint32_t pid_time;          // clock ticks per PID update
+    uint32_t lowpass_time;      // clock ticks per low pass update
+    double pid_max_error;       // largest difference with the double kernel, full scale is 1.0
+    double pid_rms_error;
+    double lowpass_max_error;
+    double lowpass_rms_error;
+} control_bench_result_t;
+
+#define CONTROL_BENCH_TYPES 2       // q31 and f32
+
+/*Run the benchmark, result[0] is q31 and result[1] is f32*/
+void control_benchmark(uint32_t (*clock)(void), control_bench_result_t result[CONTROL_BENCH_TYPES]);
+
+/*Clock of the benchmark on target: CPU cycles, the core timer counts at SYS_FREQ/2*/
+uint32_t control_bench_cycles(void);
+
+#endif /* _CONTROL_BENCH_H */
@@ -0,0 +1,27 @@
+/* ************************************************************************** */
+/** control_f32.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_f32.c
+
+@Summary
+ Controller and filter kernels in single precision float
+
+@Description
+ Compiles control_kernel_template.h for the f32 type of control_numeric.h.
+ */
+/* ************************************************************************** */
+
+#include "control_numeric.h"
+
+#define CTRL_SUFFIX f32
+#define CTRL_IMPLEMENTATION
+#include "control_kernel_template.h"
@@ -0,0 +1,166 @@
+/* ************************************************************************** */
+/** control_kernel_template.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_kernel_template.h
+
+@Summary
+ Controller and filter kernels, written once for all numeric types
+
+@Description
+ Included once per numeric type with CTRL_SUFFIX set to the suffix of the type
+ * (see control_kernels.h), e.g. with CTRL_SUFFIX q31 it declares pid_q31_t and
+ * pid_update_q31(). When CTRL_IMPLEMENTATION is defined the kernels are defined as well.
+ * There is no guard against multiple inclusion on purpose.
+ *
+ * PID: derivative on the measurement through a first order low pass filter,
+ * output saturation with anti-windup by conditional integration and by clamping
+ * the integrator to the output limits, feed forward added before the saturation.
+ * The integral gain includes the sample time (Ki*Ts), the derivative gain as well (Kd/Ts).
+ * Low pass: first order, y += coef*(x - y) with coef = wc*Ts/(1 + wc*Ts).
+ */
+/* ************************************************************************** */
+
+#ifndef CTRL_SUFFIX
+#error "CTRL_SUFFIX has to be set to the numeric type of the kernels"
+#endif
+
+#include "ramfunc.h"
+
+#ifndef CTRL_NAME
+#define CTRL_CAT_(a, b)     a##_##b
+#define CTRL_CAT(a, b)      CTRL_CAT_(a, b)
+#define CTRL_NAME(name)     CTRL_CAT(name, CTRL_SUFFIX)
+#endif
+
+#undef CTRL_T
+#undef CTRL_GAIN_T
+#undef CTRL_PID_T
+#undef CTRL_LOWPASS_T
+#define CTRL_T              CTRL_CAT(CTRL_NAME(ctrl), t)
+#define CTRL_GAIN_T         CTRL_CAT(CTRL_NAME(ctrl_gain), t)
+#define CTRL_PID_T          CTRL_CAT(CTRL_NAME(pid), t)
+#define CTRL_LOWPASS_T      CTRL_CAT(CTRL_NAME(lowpass), t)
+
+/*State and parameters of a PID controller*/
+typedef struct
+{
+    CTRL_GAIN_T kp;             // proportional gain
+    CTRL_GAIN_T ki;             // integral gain, Ki*Ts
+    CTRL_GAIN_T kd;             // derivative gain, Kd/Ts
+    CTRL_GAIN_T kff;            // feed forward gain
+    CTRL_T d_filter;            // coefficient of the derivative filter, 1.0 for no filter
+    CTRL_T out_min;             // output limits
+    CTRL_T out_max;
+    CTRL_T integrator;          // integral part of the output
+    CTRL_T derivative;          // filtered derivative part of the output
+    CTRL_T prev_measurement;    // measurement of the previous update
+    int8_t saturated;           // 1 when the last output was limited to out_max, -1 for out_min
+} CTRL_PID_T;
+
+/*State of a first order low pass filter*/
+typedef struct
+{
+    CTRL_T coef;
+    CTRL_T y;
+} CTRL_LOWPASS_T;
+
+void CTRL_NAME(pid_init)(CTRL_PID_T *pid, CTRL_GAIN_T kp, CTRL_GAIN_T ki, CTRL_GAIN_T kd, CTRL_GAIN_T kff,
+                         CTRL_T d_filter, CTRL_T out_min, CTRL_T out_max);
+void CTRL_NAME(pid_reset)(CTRL_PID_T *pid, CTRL_T measurement);
+RAMFUNC CTRL_T CTRL_NAME(pid_update)(CTRL_PID_T *pid, CTRL_T reference, CTRL_T measurement, CTRL_T feed_forward);
+void CTRL_NAME(lowpass_init)(CTRL_LOWPASS_T *filter, CTRL_T coef, CTRL_T initial);
+CTRL_T CTRL_NAME(lowpass_update)(CTRL_LOWPASS_T *filter, CTRL_T x);
+
+
+#ifdef CTRL_IMPLEMENTATION
+//set the gains and limits of a controller and clear its state
+void CTRL_NAME(pid_init)(CTRL_PID_T *pid, CTRL_GAIN_T kp, CTRL_GAIN_T ki, CTRL_GAIN_T kd, CTRL_GAIN_T kff,
+                         CTRL_T d_filter, CTRL_T out_min, CTRL_T out_max)
+{
+    pid->kp = kp;
+    pid->ki = ki;
+    pid->kd = kd;
+    pid->kff = kff;
+    pid->d_filter = d_filter;
+    pid->out_min = out_min;
+    pid->out_max = out_max;
+    CTRL_NAME(pid_reset)(pid, 0);
+}
+
+//clear the integrator and the derivative
+void CTRL_NAME(pid_reset)(CTRL_PID_T *pid, CTRL_T measurement)
+{
+    pid->integrator = 0;
+    pid->derivative = 0;
+    pid->prev_measurement = measurement;
+    pid->saturated = 0;
+}
+
+//compute the output of the controller for a new measurement
+RAMFUNC CTRL_T CTRL_NAME(pid_update)(CTRL_PID_T *pid, CTRL_T reference, CTRL_T measurement, CTRL_T feed_forward)
+{
+    CTRL_T error = CTRL_NAME(ctrl_sub)(reference, measurement);
+    CTRL_T out;
+
+    /*Integrate unless the output is saturated and the error would drive it further*/
+    if(!(pid->saturated == 1 && error > 0) && !(pid->saturated == -1 && error < 0))
+    {
+        pid->integrator = CTRL_NAME(ctrl_add)(pid->integrator, CTRL_NAME(ctrl_mul)(pid->ki, error));
+        if(pid->integrator > pid->out_max)
+            pid->integrator = pid->out_max;
+        else if(pid->integrator < pid->out_min)
+            pid->integrator = pid->out_min;
+    }
+
+    /*Derivative of the measurement through a first order low pass filter*/
+    if(pid->kd != 0)
+    {
+        CTRL_T derivative = CTRL_NAME(ctrl_mul)(pid->kd, CTRL_NAME(ctrl_sub)(pid->prev_measurement, measurement));
+        pid->derivative = CTRL_NAME(ctrl_add)(pid->derivative,
+                          CTRL_NAME(ctrl_coef)(pid->d_filter, CTRL_NAME(ctrl_sub)(derivative, pid->derivative)));
+        pid->prev_measurement = measurement;
+    }
+
+    out = CTRL_NAME(ctrl_add)(CTRL_NAME(ctrl_add)(CTRL_NAME(ctrl_mul)(pid->kp, error), pid->integrator),
+                              CTRL_NAME(ctrl_add)(pid->derivative, CTRL_NAME(ctrl_mul)(pid->kff, feed_forward)));
+
+    /*Output saturation*/
+    if(out > pid->out_max)
+    {
+        out = pid->out_max;
+        pid->saturated = 1;
+    }
+    else if(out < pid->out_min)
+    {
+        out = pid->out_min;
+        pid->saturated = -1;
+    }
+    else
+        pid->saturated = 0;
+
+    return out;
+}
+
+//set the coefficient of the filter and start it at initial
+void CTRL_NAME(lowpass_init)(CTRL_LOWPASS_T *filter, CTRL_T coef, CTRL_T initial)
+{
+    filter->coef = coef;
+    filter->y = initial;
+}
+
+//filter a new sample
+CTRL_T CTRL_NAME(lowpass_update)(CTRL_LOWPASS_T *filter, CTRL_T x)
+{
+    filter->y = CTRL_NAME(ctrl_add)(filter->y, CTRL_NAME(ctrl_coef)(filter->coef, CTRL_NAME(ctrl_sub)(x, filter->y)));
+    return filter->y;
+}
+#endif
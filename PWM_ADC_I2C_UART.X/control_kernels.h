@@ -0,0 +1,40 @@
+/* ************************************************************************** */
+/** control_kernels.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_kernels.h
+
+@Summary
+ Controller and filter kernels for Q31 and float
+
+@Description
+ The kernels in control_kernel_template.h are written once and compiled for
+ * every numeric type of control_numeric.h, e.g. pid_update_q31() and pid_update_f32().
+ * The q31 kernels are in control_q31.c and the f32 kernels in control_f32.c, so
+ * the code size of each can be read from its object file.
+ * This header declares the kernels of the q31 and the f32 type.
+ */
+/* ************************************************************************** */
+
+#ifndef _CONTROL_KERNELS_H    /* Guard against multiple inclusion */
+#define _CONTROL_KERNELS_H
+
+#include "control_numeric.h"
+
+/*Kernels of the q31 and f32 types*/
+#define CTRL_SUFFIX q31
+#include "control_kernel_template.h"
+#undef CTRL_SUFFIX
+#define CTRL_SUFFIX f32
+#include "control_kernel_template.h"
+#undef CTRL_SUFFIX
+
+#endif /* _CONTROL_KERNELS_H */
@@ -0,0 +1,105 @@
+/* ************************************************************************** */
+/** control_numeric.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_numeric.h
+
+@Summary
+ Numeric types and operations of the controller and filter kernels
+
+@Description
+ A type is named by a suffix that ends the name of every type and operation of it:
+ *  q31 - signals and coefficients Q31 (-1.0 ... 1.0), gains Q16.16, saturating
+ *  f32 - single precision float, done by the FPU of the PIC32MZ EF
+ *  f64 - double precision float, used as the reference of the benchmark
+ * Every type has the same operations, so control_kernel_template.h can be
+ * compiled for any of them.
+ */
+/* ************************************************************************** */
+
+#ifndef _CONTROL_NUMERIC_H    /* Guard against multiple inclusion */
+#define _CONTROL_NUMERIC_H
+
+#include <stdint.h>
+
+/*Conversion of constants, only for use at compile time as they expand to floating point*/
+#define CTRL_GAIN_Q31(x)    ((int32_t)((x) * 65536.0))
+#define CTRL_COEF_Q31(x)    ((int32_t)((x) >= 1.0 ? 0x7FFFFFFF : (x) * 2147483648.0))
+#define CTRL_GAIN_F32(x)    ((float)(x))
+#define CTRL_COEF_F32(x)    ((float)(x))
+#define CTRL_GAIN_F64(x)    ((double)(x))
+#define CTRL_COEF_F64(x)    ((double)(x))
+
+
+/*Q31
+ *******************************************************************
+ .................*/
+typedef int32_t ctrl_q31_t;         // signal or coefficient, Q31
+typedef int32_t ctrl_gain_q31_t;    // gain, Q16.16
+
+static inline ctrl_q31_t ctrl_sat_q31(int64_t x)
+{
+    if(x > 0x7FFFFFFF)
+        return 0x7FFFFFFF;
+    if(x < -0x7FFFFFFF - 1)
+        return -0x7FFFFFFF - 1;
+    return (ctrl_q31_t)x;
+}
+static inline ctrl_q31_t ctrl_add_q31(ctrl_q31_t a, ctrl_q31_t b) { return ctrl_sat_q31((int64_t)a + b); }
+static inline ctrl_q31_t ctrl_sub_q31(ctrl_q31_t a, ctrl_q31_t b) { return ctrl_sat_q31((int64_t)a - b); }
+static inline ctrl_q31_t ctrl_mul_q31(ctrl_gain_q31_t gain, ctrl_q31_t x) { return ctrl_sat_q31(((int64_t)gain * x) >> 16); }
+static inline ctrl_q31_t ctrl_coef_q31(ctrl_q31_t coef, ctrl_q31_t x) { return (ctrl_q31_t)(((int64_t)coef * x) >> 31); }
+static inline ctrl_q31_t ctrl_from_q15_q31(int16_t x) { return (ctrl_q31_t)x << 16; }
+static inline int16_t ctrl_to_q15_q31(ctrl_q31_t x) { return (int16_t)(x >> 16); }
+static inline ctrl_q31_t ctrl_from_double_q31(double x) { return x >= 1.0 ? 0x7FFFFFFF : (x < -1.0 ? -0x7FFFFFFF - 1 : (ctrl_q31_t)(x * 2147483648.0)); }
+static inline double ctrl_to_double_q31(ctrl_q31_t x) { return x / 2147483648.0; }
+
+
+/*Single precision float
+ *******************************************************************
+ .................*/
+typedef float ctrl_f32_t;
+typedef float ctrl_gain_f32_t;
+
+static inline ctrl_f32_t ctrl_add_f32(ctrl_f32_t a, ctrl_f32_t b) { return a + b; }
+static inline ctrl_f32_t ctrl_sub_f32(ctrl_f32_t a, ctrl_f32_t b) { return a - b; }
+static inline ctrl_f32_t ctrl_mul_f32(ctrl_gain_f32_t gain, ctrl_f32_t x) { return gain * x; }
+static inline ctrl_f32_t ctrl_coef_f32(ctrl_f32_t coef, ctrl_f32_t x) { return coef * x; }
+static inline ctrl_f32_t ctrl_from_q15_f32(int16_t x) { return x * (1.0f / 32768.0f); }
+static inline int16_t ctrl_to_q15_f32(ctrl_f32_t x)
+{
+    x *= 32768.0f;
+    return x >= 32767.0f ? 32767 : (x <= -32768.0f ? -32768 : (int16_t)x);
+}
+static inline ctrl_f32_t ctrl_from_double_f32(double x) { return (ctrl_f32_t)x; }
+static inline double ctrl_to_double_f32(ctrl_f32_t x) { return x; }
+
+
+/*Double precision float
+ *******************************************************************
+ .................*/
+typedef double ctrl_f64_t;
+typedef double ctrl_gain_f64_t;
+
+static inline ctrl_f64_t ctrl_add_f64(ctrl_f64_t a, ctrl_f64_t b) { return a + b; }
+static inline ctrl_f64_t ctrl_sub_f64(ctrl_f64_t a, ctrl_f64_t b) { return a - b; }
+static inline ctrl_f64_t ctrl_mul_f64(ctrl_gain_f64_t gain, ctrl_f64_t x) { return gain * x; }
+static inline ctrl_f64_t ctrl_coef_f64(ctrl_f64_t coef, ctrl_f64_t x) { return coef * x; }
+static inline ctrl_f64_t ctrl_from_q15_f64(int16_t x) { return x / 32768.0; }
+static inline int16_t ctrl_to_q15_f64(ctrl_f64_t x)
+{
+    x *= 32768.0;
+    return x >= 32767.0 ? 32767 : (x <= -32768.0 ? -32768 : (int16_t)x);
+}
+static inline ctrl_f64_t ctrl_from_double_f64(double x) { return x; }
+static inline double ctrl_to_double_f64(ctrl_f64_t x) { return x; }
+
+#endif /* _CONTROL_NUMERIC_H */
@@ -0,0 +1,27 @@
+/* ************************************************************************** */
+/** control_q31.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+control_q31.c
+
+@Summary
+ Controller and filter kernels in Q31 fixed point
+
+@Description
+ Compiles control_kernel_template.h for the q31 type of control_numeric.h.
+ */
+/* ************************************************************************** */
+
+#include "control_numeric.h"
+
+#define CTRL_SUFFIX q31
+#define CTRL_IMPLEMENTATION
+#include "control_kernel_template.h"
@@ -0,0 +1,190 @@
+/* ************************************************************************** */
+/** defer.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+defer.c
+
+@Summary
+ Deferred work run by the core software interrupts
+
+@Description
+ Peripherals used:
+ * Core software interrupts 0 and 1 (CP0 Cause.IP0/IP1, IFS0.CS0IF/CS1IF)
+ * A queue has several writers at different priorities, a post takes the queue with
+ * interrupts disabled for a few instructions. The software interrupt clears its
+ * request before it empties the queue, so a post while it runs requests it again
+ * and is never lost.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include "header.h"
+#include "defer.h"
+#include "systime.h"
+#include "UART.h"
+#include "isr_profile.h"
+
+#define CAUSE_IP0   0x00000100      // Cause.IP0 requests core software interrupt 0, IP1 the next bit
+
+typedef struct
+{
+    defer_work_t work;
+    void *arg;
+    uint32_t posted;            // core timer at the post
+} defer_item_t;
+
+static volatile defer_item_t queue[DEFER_LEVELS][DEFER_QUEUE_LENGTH];
+static volatile uint8_t head[DEFER_LEVELS], tail[DEFER_LEVELS];     // free running, the index is masked
+static volatile defer_stats_t stats[DEFER_LEVELS];
+
+void defer_init()
+{
+    uint8_t level;
+
+    for(level = 0; level < DEFER_LEVELS; ++level)
+        head[level] = tail[level] = 0;
+    defer_reset_stats();
+
+    IEC0bits.CS0IE = 0;
+    IEC0bits.CS1IE = 0;
+    _CP0_BIC_CAUSE(CAUSE_IP0 | CAUSE_IP0 << 1);
+    reg_clear(&IFS0, _IFS0_CS0IF_MASK | _IFS0_CS1IF_MASK);
+    IPC0bits.CS0IP = DEFER_CS0_IPL;
+    IPC0bits.CS0IS = 0;
+    IPC0bits.CS1IP = DEFER_CS1_IPL;
+    IPC0bits.CS1IS = 0;
+    IEC0bits.CS0IE = 1;
+    IEC0bits.CS1IE = 1;
+}
+
+RAMFUNC uint8_t defer_post(uint8_t level, defer_work_t work, void *arg)
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint8_t index = head[level], depth = index - tail[level];
+    volatile defer_item_t *item;
+
+    if(depth >= DEFER_QUEUE_LENGTH)
+    {
+        ++stats[level].overflows;
+        __builtin_mtc0(12, 0, status);
+        return 0;
+    }
+    item = &queue[level][index & (DEFER_QUEUE_LENGTH - 1)];
+    item->work = work;
+    item->arg = arg;
+    item->posted = systime_count();
+    head[level] = index + 1;
+    ++stats[level].posted;
+    if((uint32_t)depth + 1 > stats[level].max_depth)
+        stats[level].max_depth = depth + 1;
+    _CP0_BIS_CAUSE(CAUSE_IP0 << level);     // the software interrupt runs once the priority drops below it
+    __builtin_mtc0(12, 0, status);
+    return 1;
+}
+
+//run the queued items of a software interrupt in the order they were posted
+static void defer_run(uint8_t level)
+{
+    volatile defer_stats_t *s = &stats[level];
+    defer_item_t item;
+    uint32_t status, latency;
+
+    _CP0_BIC_CAUSE(CAUSE_IP0 << level);    // the request first, then the flag that follows it
+    reg_clear(&IFS0, _IFS0_CS0IF_MASK << level);
+    while(1)
+    {
+        status = __builtin_disable_interrupts();
+        if(tail[level] == head[level])
+        {
+            __builtin_mtc0(12, 0, status);
+            break;
+        }
+        item = queue[level][tail[level] & (DEFER_QUEUE_LENGTH - 1)];
+        ++tail[level];
+        latency = systime_count() - item.posted;
+        ++s->run;
+        s->latency_sum += latency;
+        if(latency < s->latency_min)
+            s->latency_min = latency;
+        if(latency > s->latency_max)
+            s->latency_max = latency;
+        __builtin_mtc0(12, 0, status);
+
+        item.work(item.arg);
+    }
+}
+
+/*ISRs for the core software interrupts*/
+void __attribute__((vector(_CORE_SOFTWARE_0_VECTOR), interrupt(ipl1srs), nomips16)) defer_cs0_isr()
+{
+    ISR_PROFILE_ENTER(ISR_ID_DEFER_CS0);
+    defer_run(DEFER_CS0);
+    ISR_PROFILE_EXIT(ISR_ID_DEFER_CS0);
+}
+
+void __attribute__((vector(_CORE_SOFTWARE_1_VECTOR), interrupt(ipl2srs), nomips16)) defer_cs1_isr()
+{
+    ISR_PROFILE_ENTER(ISR_ID_DEFER_CS1);
+    defer_run(DEFER_CS1);
+    ISR_PROFILE_EXIT(ISR_ID_DEFER_CS1);
+}
+
+void defer_reset_stats()
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint8_t level;
+
+    for(level = 0; level < DEFER_LEVELS; ++level)
+    {
+        stats[level].posted = 0;
+        stats[level].run = 0;
+        stats[level].overflows = 0;
+        stats[level].max_depth = 0;
+        stats[level].latency_min = UINT32_MAX;
+        stats[level].latency_max = 0;
+        stats[level].latency_sum = 0;
+    }
+    __builtin_mtc0(12, 0, status);
+}
+
+void defer_get_stats(uint8_t level, defer_stats_t *copy)
+{
+    uint32_t status = __builtin_disable_interrupts();
+
+    copy->posted = stats[level].posted;
+    copy->run = stats[level].run;
+    copy->overflows = stats[level].overflows;
+    copy->max_depth = stats[level].max_depth;
+    copy->latency_min = stats[level].latency_min;
+    copy->latency_max = stats[level].latency_max;
+    copy->latency_sum = stats[level].latency_sum;
+    __builtin_mtc0(12, 0, status);
+}
+
+void defer_report()
+{
+    static const char *const names[DEFER_LEVELS] = {"CS0", "CS1"};
+    char msg[160];
+    defer_stats_t s;
+    uint8_t level;
+
+    for(level = 0; level < DEFER_LEVELS; ++level)
+    {
+        defer_get_stats(level, &s);
+        sprintf(msg, "%s posted %lu, run %lu, overflows %lu, max depth %lu, latency %lu/%lu/%lu cycles (min/mean/max)\r\n",
+                names[level], (unsigned long)s.posted, (unsigned long)s.run, (unsigned long)s.overflows,
+                (unsigned long)s.max_depth, (unsigned long)(s.run ? 2 * s.latency_min : 0),
+                (unsigned long)(s.run ? 2 * s.latency_sum / s.run : 0), (unsigned long)(2 * s.latency_max));
+        WriteUART(msg);
+    }
+    defer_reset_stats();
+}
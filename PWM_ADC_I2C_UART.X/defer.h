@@ -0,0 +1,83 @@
+/* ************************************************************************** */
+/** defer.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+defer.h
+
+@Summary
+ Deferred work run by the core software interrupts
+
+@Description
+ An ISR that has captured its data posts the processing as a work item (a function
+ * and its argument) instead of running it: the item is queued and the core software
+ * interrupt of the queue is requested through CP0 Cause.IP0/IP1. The software
+ * interrupt runs the queued items in order at a low priority, where the hard ISRs
+ * (Timer2 dither, scheduler tick, encoder captures, UART1 RX) preempt it:
+ *  - DEFER_CS0: core software interrupt 0 at priority 1, for long work such as the
+ *    blocking I2C transfers of the position loop
+ *  - DEFER_CS1: core software interrupt 1 at priority 2, for short work that should
+ *    run before the main loop and the CS0 work
+ * Every queue holds DEFER_QUEUE_LENGTH items; a post to a full queue is dropped and
+ * counted. The latency from the post to the start of an item is measured with the
+ * core timer. The tasks of the scheduler with a DEFER_CS0/CS1 level in the task table
+ * are posted by the tick instead of run in it (scheduler.c).
+ * 'd' frames over UART1 report and reset the measurements.
+ */
+/* ************************************************************************** */
+
+#ifndef _DEFER_H    /* Guard against multiple inclusion */
+#define _DEFER_H
+
+#include <stdint.h>
+#include "ramfunc.h"
+
+#define DEFER_CS0           0       // core software interrupt 0
+#define DEFER_CS1           1       // core software interrupt 1
+#define DEFER_LEVELS        2
+#define DEFER_NONE          0xFF    // run in place, for the task table of the scheduler
+#define DEFER_CS0_IPL       1       // priorities of the software interrupts
+#define DEFER_CS1_IPL       2
+#define DEFER_QUEUE_LENGTH  8       // work items per software interrupt, a power of 2
+
+typedef void (*defer_work_t)(void *arg);
+
+/*Measurements of a software interrupt, times in core timer counts (SYS_FREQ/2)*/
+typedef struct
+{
+    uint32_t posted;
+    uint32_t run;
+    uint32_t overflows;         // posts dropped as the queue was full
+    uint32_t max_depth;         // most items waiting at once
+    uint32_t latency_min;       // from the post to the start of the item
+    uint32_t latency_max;
+    uint64_t latency_sum;
+} defer_stats_t;
+
+/*Methods for the deferred work
+ *******************************************************************
+ .................*/
+/*Empty the queues and setup the priorities of the software interrupts*/
+void defer_init();
+
+/*Queue work on a software interrupt, from any ISR or the main loop. Returns 0 if the
+ * queue is full and the work is dropped. In RAM, the scheduler tick posts from RAM*/
+RAMFUNC uint8_t defer_post(uint8_t level, defer_work_t work, void *arg);
+
+/*Clear the measurements*/
+void defer_reset_stats();
+
+/*Copy of the measurements of a software interrupt*/
+void defer_get_stats(uint8_t level, defer_stats_t *stats);
+
+/*Write the measurements over UART1 and reset them*/
+void defer_report();
+
+#endif /* _DEFER_H */
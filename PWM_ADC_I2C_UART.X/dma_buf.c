@@ -0,0 +1,182 @@
+/* ************************************************************************** */
+/** dma_buf.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+dma_buf.c
+
+@Summary
+ Pool of the DMA buffers and the maintenance of their cache lines
+
+@Description
+ Peripherals used:
+ * L1 data cache (CACHE instruction), DMA4 and the core timer for the benchmark
+ * The pool is ordinary KSEG0 RAM aligned to a cache line. A buffer is written back
+ * and invalidated when it is handed out, so no dirty line of the startup code can be
+ * evicted over it later, whichever alias it is used through.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <string.h>
+#include "header.h"
+#include "dma_buf.h"
+#include "systime.h"
+#include "SPI.h"
+#include "waveform.h"
+
+/*Users of the pool*/
+#define SPI_BUFFERS         (2 * DMA_BUF_SIZE(SPI_DMA_MAX_LENGTH))     // TX and RX of SPI.c
+#define WAVE_BUFFERS        DMA_BUF_SIZE(WAVE_CHANNELS * WAVE_LENGTH * sizeof(uint16_t))
+#ifdef DMA_BUF_BENCHMARK
+#define BENCH_BUFFERS       (2 * DMA_BUF_SIZE(DMA_BUF_BENCH_SIZE))
+#else
+#define BENCH_BUFFERS       0
+#endif
+#define DMA_BUF_POOL_SIZE   (SPI_BUFFERS + WAVE_BUFFERS + BENCH_BUFFERS)
+
+static uint8_t __attribute__((aligned(DMA_BUF_LINE))) pool[DMA_BUF_POOL_SIZE];
+static uint32_t pool_used = 0;
+
+/*CACHE instruction on the data cache*/
+#define HIT_INVALIDATE_D            0x11
+#define HIT_WRITEBACK_INVALIDATE_D  0x15
+#define HIT_WRITEBACK_D             0x19
+
+//cache_lines() applies a CACHE operation to every line of [size] bytes from buffer
+#ifdef _SIM_XC_H
+#define cache_lines(op, buffer, size)   ((void)(buffer), (void)(size))  // no cache on the PC
+#else
+#define cache_lines(op, buffer, size) \
+    do { \
+        uintptr_t line = (uintptr_t)(buffer) & ~(uintptr_t)(DMA_BUF_LINE - 1); \
+        uintptr_t end = (uintptr_t)(buffer) + (size); \
+        for(; line < end; line += DMA_BUF_LINE) \
+            __asm__ volatile("cache %0, 0(%1)" : : "i"(op), "r"(line) : "memory"); \
+        __asm__ volatile("sync" : : : "memory"); \
+    } while(0)
+#endif
+
+void *dma_buf_alloc(uint32_t size, dma_buf_mode_t mode)
+{
+    uint8_t *buffer;
+
+    size = DMA_BUF_SIZE(size);
+    if(!size || size > DMA_BUF_POOL_SIZE - pool_used)
+        return 0;
+    buffer = &pool[pool_used];
+    pool_used += size;
+    cache_lines(HIT_WRITEBACK_INVALIDATE_D, buffer, size);
+    return mode == DMA_BUF_UNCACHED ? (void *)KVA0_TO_KVA1((uintptr_t)buffer) : (void *)buffer;
+}
+
+uint32_t dma_buf_used(void)
+{
+    return pool_used;
+}
+
+uint32_t dma_buf_phys(const volatile void *buffer)
+{
+    return KVA_TO_PA(buffer);
+}
+
+void dma_buf_writeback(const volatile void *buffer, uint32_t size)
+{
+    cache_lines(HIT_WRITEBACK_D, buffer, size);
+}
+
+void dma_buf_invalidate(const volatile void *buffer, uint32_t size)
+{
+    cache_lines(HIT_INVALIDATE_D, buffer, size);
+}
+
+
+#ifdef DMA_BUF_BENCHMARK
+#define BENCH_WORDS (DMA_BUF_BENCH_SIZE / 4)
+
+//copy() moves the source to the destination with DMA4 and waits for the end of the block
+static void copy(const volatile uint32_t *source, volatile uint32_t *destination)
+{
+    DMACONbits.ON = 1;
+    DCH4CON = 0;
+    DCH4ECON = 0;
+    DCH4INT = 0;
+    DCH4SSA = dma_buf_phys(source);
+    DCH4DSA = dma_buf_phys(destination);
+    DCH4SSIZ = DMA_BUF_BENCH_SIZE;
+    DCH4DSIZ = DMA_BUF_BENCH_SIZE;
+    DCH4CSIZ = DMA_BUF_BENCH_SIZE;      // the whole block in one cell
+    DCH4CONbits.CHEN = 1;
+    DCH4ECONbits.CFORCE = 1;            // start without a request
+    while(!DCH4INTbits.CHBCIF);
+}
+
+/*Function to copy the same pair of buffers in both flavours; the third run skips the
+ * maintenance of the cached buffers to show the stale data the helpers prevent*/
+void dma_buf_benchmark(dma_buf_bench_t result[DMA_BUF_BENCH_RUNS])
+{
+    static uint32_t *source = 0, *destination = 0;
+    static const char *const names[DMA_BUF_BENCH_RUNS] = {"uncached", "cached", "cached, no maintenance"};
+    volatile uint32_t *src, *dst;
+    uint32_t run, i, start, status;
+
+    if(!source)
+    {
+        source = dma_buf_alloc(DMA_BUF_BENCH_SIZE, DMA_BUF_CACHED);
+        destination = dma_buf_alloc(DMA_BUF_BENCH_SIZE, DMA_BUF_CACHED);
+    }
+    status = __builtin_disable_interrupts();
+    for(run = 0; run < DMA_BUF_BENCH_RUNS; ++run)
+    {
+        dma_buf_bench_t *r = &result[run];
+        uint8_t cached = run != 0, maintained = run != 2;
+
+        memset(r, 0, sizeof(*r));
+        r->name = names[run];
+        src = cached ? source : (uint32_t *)KVA0_TO_KVA1((uintptr_t)source);
+        dst = cached ? destination : (uint32_t *)KVA0_TO_KVA1((uintptr_t)destination);
+
+        /*start from clean lines, with the destination of the last run in the cache*/
+        cache_lines(HIT_WRITEBACK_INVALIDATE_D, source, DMA_BUF_BENCH_SIZE);
+        for(i = 0; i < BENCH_WORDS; ++i)
+            destination[i] = 0;
+        cache_lines(HIT_WRITEBACK_D, destination, DMA_BUF_BENCH_SIZE);
+
+        start = systime_count();
+        for(i = 0; i < BENCH_WORDS; ++i)
+            src[i] = 0x9E3779B9u * (i + run + 1);
+        r->fill = systime_count() - start;
+
+        if(cached && maintained)
+        {
+            start = systime_count();
+            dma_buf_writeback(src, DMA_BUF_BENCH_SIZE);
+            r->maintenance = systime_count() - start;
+        }
+
+        start = systime_count();
+        copy(src, dst);
+        r->transfer = systime_count() - start;
+
+        if(cached && maintained)
+        {
+            start = systime_count();
+            dma_buf_invalidate(dst, DMA_BUF_BENCH_SIZE);
+            r->maintenance += systime_count() - start;
+        }
+
+        start = systime_count();
+        for(i = 0; i < BENCH_WORDS; ++i)
+            r->errors += dst[i] != 0x9E3779B9u * (i + run + 1);
+        r->check = systime_count() - start;
+    }
+    __builtin_mtc0(12, 0, status);
+}
+#endif
@@ -0,0 +1,76 @@
+/* ************************************************************************** */
+/** dma_buf.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+dma_buf.h
+
+@Summary
+ Buffers shared by the CPU and the DMA, from a static pool of cache lines
+
+@Description
+ set_performance_mode() makes KSEG0 cacheable, write-back: a sample the CPU writes
+ * may stay in the data cache while the DMA reads the old one from RAM, and a byte
+ * the DMA writes to RAM is not seen by the CPU while the line is in the cache.
+ * dma_buf_alloc() hands out buffers that start on a cache line and take whole lines,
+ * so maintenance of one buffer never touches the data of another, in two flavours:
+ *  DMA_BUF_UNCACHED - the KSEG1 alias of the buffer, every CPU access goes to RAM.
+ *                     Nothing to do around a transfer; best for small buffers and
+ *                     for tables the CPU writes while the DMA is playing them.
+ *  DMA_BUF_CACHED   - the KSEG0 address; dma_buf_writeback() before the DMA reads
+ *                     the buffer, dma_buf_invalidate() before the CPU reads what the
+ *                     DMA wrote. The CPU must not write a buffer the DMA is writing.
+ * Buffers are allocated at init and never freed. The pool (dma_buf.c) is sized for
+ * the buffers of SPI.c and waveform.c; add the size of a new user to DMA_BUF_POOL_SIZE.
+ * Define DMA_BUF_BENCHMARK to check both flavours with a memory to memory transfer
+ * of DMA4 and print their cost at boot.
+ */
+/* ************************************************************************** */
+
+#ifndef _DMA_BUF_H    /* Guard against multiple inclusion */
+#define _DMA_BUF_H
+
+#include <stdint.h>
+
+#define DMA_BUF_LINE            16      // bytes in a line of the L1 data cache
+#define DMA_BUF_SIZE(bytes)     (((bytes) + DMA_BUF_LINE - 1) & ~(DMA_BUF_LINE - 1))
+
+typedef enum
+{
+    DMA_BUF_UNCACHED,
+    DMA_BUF_CACHED,
+} dma_buf_mode_t;
+
+/*Methods for the buffers
+ *******************************************************************
+ .................*/
+void *dma_buf_alloc(uint32_t size, dma_buf_mode_t mode);   // 0 once the pool is used up
+uint32_t dma_buf_used(void);                                // bytes handed out
+uint32_t dma_buf_phys(const volatile void *buffer);         // physical address for DCHxSSA/DCHxDSA
+void dma_buf_writeback(const volatile void *buffer, uint32_t size);    // cache to RAM, before the DMA reads
+void dma_buf_invalidate(const volatile void *buffer, uint32_t size);   // drop the cached lines, before the CPU reads
+
+/*Cost and errors of a memory to memory transfer, core timer counts (cycles = 2 * counts)*/
+typedef struct
+{
+    const char *name;
+    uint32_t fill;              // CPU writes the source
+    uint32_t maintenance;       // write back and invalidate
+    uint32_t transfer;          // DMA4 copies the source to the destination
+    uint32_t check;             // CPU reads the destination
+    uint32_t errors;            // words of the destination that differ from the source
+} dma_buf_bench_t;
+
+#define DMA_BUF_BENCH_SIZE      2048    // bytes per transfer
+#define DMA_BUF_BENCH_RUNS      3       // uncached, cached, cached without maintenance
+
+void dma_buf_benchmark(dma_buf_bench_t result[DMA_BUF_BENCH_RUNS]);
+
+#endif /* _DMA_BUF_H */
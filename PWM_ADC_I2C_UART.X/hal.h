@@ -0,0 +1,149 @@
+/* ************************************************************************** */
+/** hal.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+hal.h
+
+@Summary
+ Run time access of the drivers to UART1, I2C1, the ADC, Timer2/Timer6 with the
+ Output Compares and the core timer
+
+@Description
+ The drivers poll and write these peripherals through the functions below while
+ * they run; the setup of the peripherals in the *_init() functions stays on the
+ * registers. On the target every function is an always inlined access of the
+ * register itself, bits that change at run time are set and cleared with single
+ * stores to its SET/CLR register (reg.h), so there is nothing between a driver and
+ * its registers (at -O1 and above, compare xc32-objdump -d of the object files).
+ * With HAL_MOCK defined (on a PC, with sim first on the include path) the functions
+ * are those of sim/hal_mock.c: they record every access with the simulated time and
+ * return the values a test injected before they fall back on the register models
+ * of sim/. The register accesses of the target are kept as hal_target_*() for them.
+ */
+/* ************************************************************************** */
+
+#ifndef _HAL_H    /* Guard against multiple inclusion */
+#define _HAL_H
+
+#include <xc.h>
+#include <stdint.h>
+#include "reg.h"
+
+#ifdef HAL_MOCK
+#define HAL_NAME(name)  hal_target_##name
+#else
+#define HAL_NAME(name)  hal_##name
+#endif
+#define HAL_INLINE      static inline __attribute__((always_inline))
+
+/*Core timer, counts at SYS_FREQ/2 and is never written (systime.h)*/
+HAL_INLINE uint32_t HAL_NAME(core_count)(void)              { return _CP0_GET_COUNT(); }
+
+/*UART1*/
+HAL_INLINE uint8_t HAL_NAME(uart_tx_full)(void)             { return U1STAbits.UTXBF; }
+HAL_INLINE void HAL_NAME(uart_write)(uint8_t data)          { U1TXREG = data; }
+HAL_INLINE uint8_t HAL_NAME(uart_rx_available)(void)        { return U1STAbits.URXDA; }
+HAL_INLINE uint8_t HAL_NAME(uart_read)(void)                { return U1RXREG; }
+HAL_INLINE uint8_t HAL_NAME(uart_overrun)(void)             { return U1STAbits.OERR; }
+HAL_INLINE void HAL_NAME(uart_clear_overrun)(void)          { reg_clear(&U1STA, _U1STA_OERR_MASK); }    // restarts the reception
+HAL_INLINE void HAL_NAME(uart_clear_rx_flag)(void)          { reg_clear(&IFS3, _IFS3_U1RXIF_MASK); }
+
+/*I2C1, a condition or reception is pending until the hardware clears its bit*/
+HAL_INLINE uint8_t HAL_NAME(i2c_sequence_pending)(void)     { return I2C1CON & 0x1F; }  // SEN, RSEN, PEN, RCEN or ACKEN
+HAL_INLINE uint8_t HAL_NAME(i2c_transmitting)(void)         { return I2C1STATbits.TRSTAT; }
+HAL_INLINE void HAL_NAME(i2c_start)(void)                   { reg_set(&I2C1CON, _I2C1CON_SEN_MASK); }
+HAL_INLINE uint8_t HAL_NAME(i2c_start_pending)(void)        { return I2C1CONbits.SEN; }
+HAL_INLINE void HAL_NAME(i2c_restart)(void)                 { reg_set(&I2C1CON, _I2C1CON_RSEN_MASK); }
+HAL_INLINE uint8_t HAL_NAME(i2c_restart_pending)(void)      { return I2C1CONbits.RSEN; }
+HAL_INLINE void HAL_NAME(i2c_stop)(void)                    { reg_set(&I2C1CON, _I2C1CON_PEN_MASK); }
+HAL_INLINE void HAL_NAME(i2c_receive)(void)                 { reg_set(&I2C1CON, _I2C1CON_RCEN_MASK); }
+HAL_INLINE uint8_t HAL_NAME(i2c_receive_pending)(void)      { return I2C1CONbits.RCEN; }
+HAL_INLINE void HAL_NAME(i2c_acknowledge)(uint8_t nack)
+{
+    reg_write_bits(&I2C1CON, _I2C1CON_ACKDT_MASK, nack);
+    reg_set(&I2C1CON, _I2C1CON_ACKEN_MASK);
+}
+HAL_INLINE uint8_t HAL_NAME(i2c_acknowledge_pending)(void)  { return I2C1CONbits.ACKEN; }
+HAL_INLINE void HAL_NAME(i2c_write)(uint8_t data)           { I2C1TRN = data; }
+HAL_INLINE uint8_t HAL_NAME(i2c_tx_full)(void)              { return I2C1STATbits.TBF; }
+HAL_INLINE uint8_t HAL_NAME(i2c_nacked)(void)               { return I2C1STATbits.ACKSTAT; }
+HAL_INLINE uint8_t HAL_NAME(i2c_rx_full)(void)              { return I2C1STATbits.RBF; }
+HAL_INLINE uint8_t HAL_NAME(i2c_read)(void)                 { return I2C1RCV; }
+
+/*ADC, the software triggered inputs AN2 ... AN4 of ADC.c; the input is a constant in the drivers*/
+HAL_INLINE void HAL_NAME(adc_trigger)(void)                 { reg_set(&ADCCON3, _ADCCON3_GSWTRG_MASK); }
+HAL_INLINE uint8_t HAL_NAME(adc_ready)(uint8_t input)
+{
+    switch(input)
+    {
+        case 2: return ADCDSTAT1bits.ARDY2;
+        case 3: return ADCDSTAT1bits.ARDY3;
+        case 4: return ADCDSTAT1bits.ARDY4;
+    }
+    return 0;
+}
+HAL_INLINE uint16_t HAL_NAME(adc_result)(uint8_t input)
+{
+    switch(input)
+    {
+        case 2: return ADCDATA2;
+        case 3: return ADCDATA3;
+        case 4: return ADCDATA4;
+    }
+    return 0;
+}
+
+/*Timer2 (PWM time base) and its Output Compares, Timer6 (scheduler tick)*/
+HAL_INLINE uint32_t HAL_NAME(timer2_count)(void)            { return TMR2; }
+HAL_INLINE void HAL_NAME(timer2_clear_flag)(void)           { reg_clear(&IFS0, _IFS0_T2IF_MASK); }
+HAL_INLINE void HAL_NAME(oc_write)(volatile uint32_t *reg, uint32_t compare) { *reg = compare; }   // OCxR or OCxRS
+HAL_INLINE uint8_t HAL_NAME(timer6_flag)(void)              { return IFS0bits.T6IF; }
+HAL_INLINE void HAL_NAME(timer6_clear_flag)(void)           { reg_clear(&IFS0, _IFS0_T6IF_MASK); }
+
+#ifdef HAL_MOCK
+/*Methods of the mock back end, sim/hal_mock.c
+ *******************************************************************
+ .................*/
+uint32_t hal_core_count(void);
+uint8_t hal_uart_tx_full(void);
+void hal_uart_write(uint8_t data);
+uint8_t hal_uart_rx_available(void);
+uint8_t hal_uart_read(void);
+uint8_t hal_uart_overrun(void);
+void hal_uart_clear_overrun(void);
+void hal_uart_clear_rx_flag(void);
+uint8_t hal_i2c_sequence_pending(void);
+uint8_t hal_i2c_transmitting(void);
+void hal_i2c_start(void);
+uint8_t hal_i2c_start_pending(void);
+void hal_i2c_restart(void);
+uint8_t hal_i2c_restart_pending(void);
+void hal_i2c_stop(void);
+void hal_i2c_receive(void);
+uint8_t hal_i2c_receive_pending(void);
+void hal_i2c_acknowledge(uint8_t nack);
+uint8_t hal_i2c_acknowledge_pending(void);
+void hal_i2c_write(uint8_t data);
+uint8_t hal_i2c_tx_full(void);
+uint8_t hal_i2c_nacked(void);
+uint8_t hal_i2c_rx_full(void);
+uint8_t hal_i2c_read(void);
+void hal_adc_trigger(void);
+uint8_t hal_adc_ready(uint8_t input);
+uint16_t hal_adc_result(uint8_t input);
+uint32_t hal_timer2_count(void);
+void hal_timer2_clear_flag(void);
+void hal_oc_write(volatile uint32_t *reg, uint32_t compare);
+uint8_t hal_timer6_flag(void);
+void hal_timer6_clear_flag(void);
+#endif
+
+#endif /* _HAL_H */
@@ -25,13 +25,13 @@ University of Groningen
 #ifndef _HEADER_H    /* Guard against multiple inclusion */
 #define _HEADER_H
 
-#define SYS_FREQ 200000000              // Running at 200MHz
-#define PWM_FREQ_20 624                 //Value of Period register for 20KHz PWM
-#define PWM_FREQ_10 1249                //Value of Period register for 10KHz PWM
+#include "reg.h"
 
-#define CURRENT_CONTOL_FREQ_1000 6249        //Value of Period register for 1000Hz speed of current control, 50MHz and Prescaler of 8
-#define POSITION_CONTROL_FREQ_100 15624     //Value of Period register for 200Hz speed of positon control 50MHz and Prescaler of 8
-#define UART_DATA_FREQUENCY_50 31249 //Value of Period Register for 100 Hz frequency for, 50MHz clock and prescaler of 32 
+#include "clock_config.h"      // SYS_FREQ and the clocks of the peripheral buses, 200MHz by default
+/*The frequency and resolution of the motor PWM are set in PWM.h*/
+
+/*The looping speeds of the current control (1000Hz), position control (100Hz) and telemetry (50Hz)
+ * are set in the task table of scheduler.c*/
 
 
 /*******************************************************************************/
@@ -43,19 +43,23 @@ University of Groningen
 
 /***************************************************************************/
 /*The RGB LED's are pulled UP by default hence, needs to be set 
-in order to turn them off and vice versa*/
-#define RED_RGB_LED LATBbits.LATB5=0, LATBSET=0b11;//set bits 0 and 1 and clear bit 5 to get red RGB
-#define BLUE_RGB_LED LATBbits.LATB0=0, LATBSET=0b100010;// set bits 1 and 5 and clear bit 0 to get blue RGB
-#define GREEN_RGB_LED LATBbits.LATB1=0, LATBSET=0b100001;//set bits 0 and 5 abd clear bit 1 to get green
-#define RGB_LED_OFF LATBSET=0b100011;//set bits 0,1 and 5 to switch off the RGB
+in order to turn them off and vice versa. The LED's are switched with single
+LATxSET/LATxCLR writes (reg.h), which can not disturb the other pins of the port*/
+#define RED_RGB_LED reg_clear(&LATB, 0b100000), reg_set(&LATB, 0b11);//set bits 0 and 1 and clear bit 5 to get red RGB
+#define BLUE_RGB_LED reg_clear(&LATB, 0b1), reg_set(&LATB, 0b100010);// set bits 1 and 5 and clear bit 0 to get blue RGB
+#define GREEN_RGB_LED reg_clear(&LATB, 0b10), reg_set(&LATB, 0b100001);//set bits 0 and 5 abd clear bit 1 to get green
+#define RGB_LED_OFF reg_set(&LATB, 0b100011);//set bits 0,1 and 5 to switch off the RGB
 
 /*Unlike the RGB LED, the user LED's are pulled LOW by default*/
-#define RED_LED_ON LATEbits.LATE3=1;
-#define RED_LED_OFF LATEbits.LATE3=0;
-#define GREEN_LED_ON LATEbits.LATE4=1;
-#define GREEN_LED_OFF LATEbits.LATE4=0;
-#define YELLOW_LED_ON LATEbits.LATE6=1;
-#define YELLOW_LED_OFF LATEbits.LATE6=0; 
+#define RED_LED     REG_PIN(E, 3)
+#define GREEN_LED   REG_PIN(E, 4)
+#define YELLOW_LED  REG_PIN(E, 6)
+#define RED_LED_ON pin_set(RED_LED);
+#define RED_LED_OFF pin_clear(RED_LED);
+#define GREEN_LED_ON pin_set(GREEN_LED);
+#define GREEN_LED_OFF pin_clear(GREEN_LED);
+#define YELLOW_LED_ON pin_set(YELLOW_LED);
+#define YELLOW_LED_OFF pin_clear(YELLOW_LED);
 
 /*defines for Pre fetch Cache */
 #define PREFETCH_ANY_ADDRESS 0b11
@@ -72,5 +76,6 @@ in order to turn them off and vice versa*/
 extern volatile uint8_t flag_ankle_IMU,flag_ankle_encoder,flag_ankle_current,flag_print; //variables utilized to flag interrupts
 extern volatile uint16_t ADC1,ADC2,ADC3;//variables for ADC
 extern volatile int16_t  accelX,accelY,accelZ;//variables for IMU
+extern volatile int16_t  gyroX,gyroY,gyroZ;//variables for IMU
 
 #endif /* _HEADER_H */
@@ -12,7 +12,7 @@
  InitialSetup.c
 
   @Summary
- Source file to initialize the microcontroller at 200MHz and set all pins as digital outputs with low.
+ Source file to initialize the microcontroller at SYS_FREQ (clock_config.h) and set all pins as digital outputs with low.
  The set_performance_mode and set_digital functions needs to be called at the beginning of the main loop in the program above any other loop.
  
  * Check the following website for more details:
@@ -30,43 +30,43 @@ void set_performance_mode()
 	unsigned int cp0;
 	
     // Unlock Sequence
-    asm volatile("di"); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
+    __builtin_disable_interrupts(); // Disable all interrupts. Don't enable global interrupts before all peripherals are configured.
     SYSKEY = 0xAA996655;
     SYSKEY = 0x556699AA;  
 
     // PB1DIV... Controls WDT, RTC, CFG, PPS, DMT
     // Peripheral Bus 1 cannot be turned off, so there's no need to turn it on
-    PB1DIVbits.PBDIV = 1; // Peripheral Bus 1 Clock Divisor Control (PBCLK1 is SYSCLK divided by 2)
+    PB1DIVbits.PBDIV = CLOCK_PB1_DIV - 1; // Peripheral Bus 1 Clock Divisor Control (PBCLK1 is SYSCLK / CLOCK_PB1_DIV, clock_config.h)
 
     // PB2DIV....Controls I2C,UART, SPI
     PB2DIVbits.ON = 1; // Peripheral Bus 2 Output Clock Enable (Output clock is enabled)
-    PB2DIVbits.PBDIV = 1; // Peripheral Bus 2 Clock Divisor Control (PBCLK2 is SYSCLK divided by 2)
+    PB2DIVbits.PBDIV = CLOCK_PB2_DIV - 1; // Peripheral Bus 2 Clock Divisor Control (PBCLK2 is SYSCLK / CLOCK_PB2_DIV, clock_config.h)
 
     // PB3DIV... Controls ADC, Timers, OC, IC,Comparators
     PB3DIVbits.ON = 1; // Peripheral Bus 3 Output Clock Enable (Output clock is enabled)
-    PB3DIVbits.PBDIV = 1; // Peripheral Bus 3 Clock Divisor Control (PBCLK3 is SYSCLK divided by 2)
+    PB3DIVbits.PBDIV = CLOCK_PB3_DIV - 1; // Peripheral Bus 3 Clock Divisor Control (PBCLK3 is SYSCLK / CLOCK_PB3_DIV, clock_config.h)
 
     // PB4DIV... Controls the Digital IO ports A through to K
     PB4DIVbits.ON = 1; // Peripheral Bus 4 Output Clock Enable (Output clock is enabled)
     while (!PB4DIVbits.PBDIVRDY); // Wait until it is ready to write to
-    PB4DIVbits.PBDIV = 1; // Peripheral Bus 4 Clock Divisor Control (PBCLK4 is SYSCLK divided by 2)
+    PB4DIVbits.PBDIV = CLOCK_PB4_DIV - 1; // Peripheral Bus 4 Clock Divisor Control (PBCLK4 is SYSCLK / CLOCK_PB4_DIV, clock_config.h)
 
     // PB5DIV...Controls Ethernet, CAN and HS USB
     PB5DIVbits.ON = 1; // Peripheral Bus 5 Output Clock Enable (Output clock is enabled)
-    PB5DIVbits.PBDIV = 1; // Peripheral Bus 5 Clock Divisor Control (PBCLK5 is SYSCLK divided by 2)
+    PB5DIVbits.PBDIV = CLOCK_PB5_DIV - 1; // Peripheral Bus 5 Clock Divisor Control (PBCLK5 is SYSCLK / CLOCK_PB5_DIV, clock_config.h)
 
     // PB7DIV
     PB7DIVbits.ON = 1; // Peripheral Bus 7 Output Clock Enable (Output clock is enabled)
-    PB7DIVbits.PBDIV = 0; // Peripheral Bus 7 Clock Divisor Control (PBCLK7 is SYSCLK divided by 1)
+    PB7DIVbits.PBDIV = CLOCK_PB7_DIV - 1; // Peripheral Bus 7 Clock Divisor Control (PBCLK7 is SYSCLK / CLOCK_PB7_DIV, clock_config.h)
 
     // PB8DIV
     PB8DIVbits.ON = 1; // Peripheral Bus 8 Output Clock Enable (Output clock is enabled)
-    PB8DIVbits.PBDIV = 1; // Peripheral Bus 8 Clock Divisor Control (PBCLK8 is SYSCLK divided by 2)
+    PB8DIVbits.PBDIV = CLOCK_PB8_DIV - 1; // Peripheral Bus 8 Clock Divisor Control (PBCLK8 is SYSCLK / CLOCK_PB8_DIV, clock_config.h)
 
     // PRECON - Set up prefetch
     PRECONbits.PFMSECEN = 0; // Flash SEC Interrupt Enable (Do not generate an interrupt when the PFMSEC bit is set)
     PRECONbits.PREFEN = 0b11; // Predictive Prefetch Enable (Enable predictive prefetch for any address)
-    PRECONbits.PFMWS = 0b010; // PFM Access Time Defined in Terms of SYSCLK Wait States (Two wait states)
+    PRECONbits.PFMWS = CLOCK_PFMWS; // PFM Access Time Defined in Terms of SYSCLK Wait States (2 at 200MHz, 4 at 252MHz)
 
     // Set up caching
     cp0 = _mfc0(16, 0);
@@ -90,7 +90,7 @@ void set_performance_mode()
     PRISSbits.PRI6SS = 6;
     PRISSbits.PRI7SS = 7;
     
-    //asm volatile("ei"); // Enable Global Interrupts once all peripherals are configured
+    //__builtin_enable_interrupts(); // Enable Global Interrupts once all peripherals are configured
 
 }
 void set_digital()
@@ -0,0 +1,198 @@
+/* ************************************************************************** */
+/** isr_profile.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+isr_profile.c
+
+@Summary
+ Execution time, jitter and CPU load measurements of the interrupt service routines
+
+@Description
+ Nested ISRs are tracked on a stack with one entry per nesting level. At the exit of
+ * an ISR its total time is added to the time of the ISR it preempted, which subtracts
+ * it from its own time. Entry and exit run with interrupts disabled for a few
+ * instructions so the stack stays consistent.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include "header.h"
+#include "isr_profile.h"
+#include "systime.h"
+#include "UART.h"
+
+/*Names and priority levels of the ISRs, in the order of isr_id_t*/
+static const struct
+{
+    const char *name;
+    uint8_t level;
+} isr_table[ISR_NUMBER_OF_IDS] =
+{
+    {"scheduler tick", 3},
+    {"knee capture",   5},
+    {"ankle capture",  5},
+    {"PWM dither",     4},
+    {"UART1 RX",       2},
+    {"waveform DMA2",  2},
+    {"deferred CS0",   1},
+    {"deferred CS1",   2},
+};
+
+static volatile isr_profile_t profiles[ISR_NUMBER_OF_IDS];
+static volatile uint64_t busy[ISR_PROFILE_LEVELS];     // time per priority level
+static volatile uint64_t window_start;      // systime_now(), reports can be more than a wrap apart
+
+/*Stack of the ISRs that are running, one entry per nesting level*/
+static volatile uint8_t depth = 0;
+static volatile uint32_t entry_time[ISR_PROFILE_LEVELS];
+static volatile uint32_t preempted_time[ISR_PROFILE_LEVELS];
+
+
+//timestamp the entry of an ISR
+void isr_profile_enter(isr_id_t id)
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint32_t now = systime_count();
+    volatile isr_profile_t *p = &profiles[id];
+
+    if(depth < ISR_PROFILE_LEVELS - 1)
+        ++depth;
+    entry_time[depth] = now;
+    preempted_time[depth] = 0;
+
+    /*period jitter*/
+    if(p->count)
+    {
+        uint32_t period = now - p->last_entry;
+        if(p->count > 1)
+        {
+            uint32_t jitter = period > p->last_period ? period - p->last_period : p->last_period - period;
+            uint8_t bin = jitter < 2 ? 0 : 31 - __builtin_clz(jitter);
+            if(bin >= ISR_PROFILE_BINS)
+                bin = ISR_PROFILE_BINS - 1;
+            ++p->jitter[bin];
+        }
+        p->last_period = period;
+    }
+    p->last_entry = now;
+    __builtin_mtc0(12, 0, status);
+}
+
+//timestamp the exit of an ISR
+void isr_profile_exit(isr_id_t id)
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint32_t total = systime_count() - entry_time[depth];
+    uint32_t own = total - preempted_time[depth];
+    volatile isr_profile_t *p = &profiles[id];
+
+    if(!p->count || own < p->min)
+        p->min = own;
+    if(own > p->max)
+        p->max = own;
+    p->sum += own;
+    ++p->count;
+    busy[isr_table[id].level] += own;
+
+    if(depth)
+        --depth;
+    preempted_time[depth] += total;     // not counted for the preempted ISR
+    __builtin_mtc0(12, 0, status);
+}
+
+//clear the measurements
+void isr_profile_reset()
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint8_t i, j;
+
+    for(i = 0; i < ISR_NUMBER_OF_IDS; ++i)
+    {
+        profiles[i].count = 0;
+        profiles[i].min = 0;
+        profiles[i].max = 0;
+        profiles[i].sum = 0;
+        for(j = 0; j < ISR_PROFILE_BINS; ++j)
+            profiles[i].jitter[j] = 0;
+    }
+    for(i = 0; i < ISR_PROFILE_LEVELS; ++i)
+        busy[i] = 0;
+    window_start = systime_now();
+    __builtin_mtc0(12, 0, status);
+}
+
+//copy of the measurements of an ISR, consistent as interrupts are disabled while copying
+void isr_profile_get(isr_id_t id, isr_profile_t *profile)
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint8_t j;
+
+    profile->count = profiles[id].count;
+    profile->min = profiles[id].min;
+    profile->max = profiles[id].max;
+    profile->sum = profiles[id].sum;
+    profile->last_entry = profiles[id].last_entry;
+    profile->last_period = profiles[id].last_period;
+    for(j = 0; j < ISR_PROFILE_BINS; ++j)
+        profile->jitter[j] = profiles[id].jitter[j];
+    __builtin_mtc0(12, 0, status);
+}
+
+//CPU load of a priority level in 0.1%
+uint16_t isr_profile_load(uint8_t level)
+{
+    uint32_t status;
+    uint64_t time, window;
+
+    if(level >= ISR_PROFILE_LEVELS)
+        return 0;
+    status = __builtin_disable_interrupts();   // the 64 bit sum is updated by the ISRs
+    time = busy[level];
+    window = systime_now() - window_start;
+    __builtin_mtc0(12, 0, status);
+    if(!window)
+        return 0;
+    return (uint16_t)(time * 1000 / window);
+}
+
+//send the measurements over UART1
+void isr_profile_report()
+{
+    char msg[100];
+    isr_profile_t p;
+    uint8_t i, j;
+
+    for(i = 0; i < ISR_NUMBER_OF_IDS; ++i)
+    {
+        isr_profile_get(i, &p);
+        sprintf(msg, "%s (ipl%u): %lu runs, min %lu max %lu mean %lu cycles\r\n", isr_table[i].name, isr_table[i].level,
+                (unsigned long)p.count, (unsigned long)(2 * p.min), (unsigned long)(2 * p.max),
+                (unsigned long)(p.count ? 2 * p.sum / p.count : 0));
+        WriteUART(msg);
+        WriteUART("  period jitter per bin of 2^n counts:");
+        for(j = 0; j < ISR_PROFILE_BINS; ++j)
+        {
+            sprintf(msg, " %lu", (unsigned long)p.jitter[j]);
+            WriteUART(msg);
+        }
+        WriteUART("\r\n");
+    }
+    WriteUART("CPU load per ipl (%):");
+    for(i = 1; i < ISR_PROFILE_LEVELS; ++i)
+    {
+        uint16_t load = isr_profile_load(i);
+        sprintf(msg, " %u.%u", load / 10, load % 10);
+        WriteUART(msg);
+    }
+    WriteUART("\r\n");
+    isr_profile_reset();
+}
@@ -0,0 +1,94 @@
+/* ************************************************************************** */
+/** isr_profile.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+isr_profile.h
+
+@Summary
+ Execution time, jitter and CPU load measurements of the interrupt service routines
+
+@Description
+ Build with ISR_PROFILING defined to enable the measurements, otherwise
+ * ISR_PROFILE_ENTER() and ISR_PROFILE_EXIT() expand to nothing.
+ * Put ISR_PROFILE_ENTER(id) at the start and ISR_PROFILE_EXIT(id) at the end of
+ * every ISR, the entry and exit are timestamped with the core timer. Time spent in
+ * an ISR of a higher priority that preempts the ISR is not counted for the ISR, so
+ * the execution times and the load per priority level do not overlap.
+ * For every ISR:
+ *  - minimum, maximum and mean execution time
+ *  - histogram of the period jitter, the difference between two consecutive periods,
+ *    in bins of powers of 2 core timer counts: bin 0 is 0-1 counts, bin n is 2^n ... 2^(n+1)-1
+ * For every priority level the CPU load since the last reset.
+ * The core timer wraps after 42.9s, reset the measurements at least that often.
+ */
+/* ************************************************************************** */
+
+#ifndef _ISR_PROFILE_H    /* Guard against multiple inclusion */
+#define _ISR_PROFILE_H
+
+#include <stdint.h>
+
+/*ISRs that are measured, keep in the order of the table in isr_profile.c*/
+typedef enum
+{
+    ISR_ID_SCHEDULER_TICK,
+    ISR_ID_KNEE_CAPTURE,
+    ISR_ID_ANKLE_CAPTURE,
+    ISR_ID_PWM_DITHER,
+    ISR_ID_UART_RX,
+    ISR_ID_WAVEFORM_DMA,
+    ISR_ID_DEFER_CS0,
+    ISR_ID_DEFER_CS1,
+    ISR_NUMBER_OF_IDS
+} isr_id_t;
+
+#define ISR_PROFILE_BINS     16     // bins of the jitter histogram
+#define ISR_PROFILE_LEVELS   8      // priority levels 0 (main) ... 7
+
+#ifdef ISR_PROFILING
+#define ISR_PROFILE_ENTER(id)   isr_profile_enter(id)
+#define ISR_PROFILE_EXIT(id)    isr_profile_exit(id)
+#else
+#define ISR_PROFILE_ENTER(id)
+#define ISR_PROFILE_EXIT(id)
+#endif
+
+/*Measurements of an ISR, times in core timer counts (SYS_FREQ/2)*/
+typedef struct
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t last_entry;        // timestamp of the last entry
+    uint32_t last_period;
+    uint32_t jitter[ISR_PROFILE_BINS];
+} isr_profile_t;
+
+/*Methods for the measurements
+ *******************************************************************
+ .................*/
+void isr_profile_enter(isr_id_t id);
+void isr_profile_exit(isr_id_t id);
+
+/*Clear the measurements and start a new window for the CPU load*/
+void isr_profile_reset();
+
+/*Copy of the measurements of an ISR*/
+void isr_profile_get(isr_id_t id, isr_profile_t *profile);
+
+/*CPU load of a priority level since the reset, in 0.1%*/
+uint16_t isr_profile_load(uint8_t level);
+
+/*Write the measurements over UART1 and reset them*/
+void isr_profile_report();
+
+#endif /* _ISR_PROFILE_H */
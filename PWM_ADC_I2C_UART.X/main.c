@@ -16,7 +16,8 @@
  This file is the main file for the PIC32 software.
  It does the following:
  * Sets up 20KHz PWM at RE8 and RF2
- * Control loops of 200 and 2000Hz at RD9 and RD12
+ * Control loops of 100 and 1000Hz at RD12 and RD9, run by the scheduler on Timer6
+ * The position loop runs deferred on core software interrupt 0, below the tick (defer.c)
  * UART1 TX at RD10
  * UART1 RX at RD15
  * ADC at RB2, RB3 and RPB4
@@ -34,6 +35,19 @@
 #include"I2C.h"
 #include"mpu9250.h"
 #include"AS5600L.h"
+#include"PWM.h"
+#include"control.h"
+#include"control_bench.h"
+#include"scheduler.h"
+#include"defer.h"
+#include"isr_profile.h"
+#include"waveform.h"
+#include"dma_buf.h"
+#include"ramfunc.h"
+#include"perf.h"
+#include"pc_sample.h"
+#include"stream.h"
+#include"autotune.h"
 
 #include"UART.h"
 
@@ -45,6 +59,8 @@
  volatile uint16_t  ADC1=0,ADC2=0,ADC3=0;
  /*variables to store the accelerometer values*/
  volatile int16_t  accelX=0,accelY=0,accelZ=0;
+ /*variables to store the gyro values*/
+ volatile int16_t  gyroX=0,gyroY=0,gyroZ=0;
 
  //global variables of UART
 volatile int16_t data_buf[BUFLEN]; // array that stores the data as 16bit integer
@@ -58,47 +74,160 @@ int main()
 {
     
     /*variables controlling duty cycle*/
-    uint16_t dc1=100, dc2=100;
+    int16_t dc1=PWM_DUTY(0.16), dc2=PWM_DUTY(0.16);
+    uint32_t status;
     
     set_performance_mode();//sets peripheral clock frequencies and disables interrupts
     set_digital();//sets all ports to digital output
     
     char msg[100] = {};// char array to hold the intermediate data to read/write to/from terminal
+    uart_frame_t frame;// frame from the host
 
     RED_RGB_LED; 
     
     /* setups for peripherals go here */
     Motor_driver_init();
+    waveform_init();//DMA playback of duty cycle tables on the motor PWM, see waveform.c
+    control_init();//gains of the current and position controllers, started with a 'C' frame
+    stream_init(STREAM_POLICY_DEFAULT);//setpoints from the host for the position loop
     ADC_init();
     UART_Init();
-    I2C_init(100000);// initialize i2c at 100KHz
+    I2C_init(400000);// initialize i2c at 400KHz, the IMU and encoder reads of the position loop take a quarter of the time of 100KHz
+#ifdef ENCODER_PWM
+    encoderSetSource(KNEE_JOINT, ENCODER_SOURCE_PWM);//angles decoded from the PWM output of the encoders, see AS5600L.c
+    encoderSetSource(ANKLE_JOINT, ENCODER_SOURCE_PWM);
+#endif
     
+    IMU_init();//setup the bus to the IMU, I2C1 or SPI2 depending on IMU_TRANSPORT
     setIMU_sensitivity();//choose IMU sensitivity, power mode and data filtration rate
+    if(!IMULoadAccelCalibration())//use the calibration stored in flash, calibrate if there is none
+        IMUCalibrateAccel(IMU_CALIBRATION_SAMPLES, IMU_CALIBRATION_PERSIST);//keep the board still
     
     ReadUART(msg,sizeof(msg));  // wait for the user to press enter before continuing
    	sprintf(msg, "%s\r\n", "STREAMING"); //add the string "STREAMING" to char array 'msg'
    	WriteUART(msg);// send char array to terminal via UART
     
+#ifdef PID_BENCHMARK
+    sprintf(msg, "PID_update: %u cycles\r\n", PID_benchmark(1000));//cost of one controller update
+    WriteUART(msg);
+#endif
+#ifdef CONTROL_BENCHMARK
+    {
+        control_bench_result_t result[CONTROL_BENCH_TYPES];//Q31 and float kernels against double
+        uint8_t i;
+        control_benchmark(control_bench_cycles, result);
+        for(i = 0; i < CONTROL_BENCH_TYPES; ++i)
+        {
+            sprintf(msg, "%s: PID %u cycles, error %.1e; low pass %u cycles, error %.1e\r\n", result[i].name,
+                    result[i].pid_time, result[i].pid_max_error, result[i].lowpass_time, result[i].lowpass_max_error);
+            WriteUART(msg);
+        }
+    }
+#endif
+#ifdef REG_BENCHMARK
+    {
+        reg_bench_t result;//bit field read-modify-write against a single SET/CLR/INV store
+        reg_benchmark(1000, &result);
+        sprintf(msg, "pin toggle: bit field %.1f, INV %.1f cycles; flag clear: bit field %.1f, CLR %.1f cycles\r\n",
+                2.0 * result.toggle_bitfield / 1000, 2.0 * result.toggle_atomic / 1000,
+                2.0 * result.clear_bitfield / 1000, 2.0 * result.clear_atomic / 1000);
+        WriteUART(msg);
+    }
+#endif
+#ifdef DMA_BUF_BENCHMARK
+    {
+        dma_buf_bench_t result[DMA_BUF_BENCH_RUNS];//DMA4 copies of DMA_BUF_BENCH_SIZE bytes through both aliases
+        uint8_t i;
+        dma_buf_benchmark(result);
+        for(i = 0; i < DMA_BUF_BENCH_RUNS; ++i)
+        {
+            sprintf(msg, "%s: fill %lu, maintenance %lu, transfer %lu, check %lu cycles, %lu errors\r\n", result[i].name,
+                    2ul * result[i].fill, 2ul * result[i].maintenance, 2ul * result[i].transfer,
+                    2ul * result[i].check, (unsigned long)result[i].errors);
+            WriteUART(msg);
+        }
+    }
+#endif
+#ifdef RAMFUNC_BENCHMARK
+    {
+        ramfunc_bench_t result[RAMFUNC_BENCH_RUNS];//the same ISR kernel from flash and from RAM
+        uint8_t i;
+        ramfunc_benchmark(result);
+        for(i = 0; i < RAMFUNC_BENCH_RUNS; ++i)
+        {
+            sprintf(msg, "%s: latency %u-%u, response %u-%u (mean %u, jitter %u) Timer7 ticks\r\n", result[i].name,
+                    result[i].latency_min, result[i].latency_max, result[i].response_min, result[i].response_max,
+                    result[i].response_sum / (RAMFUNC_BENCH_SAMPLES - 1), result[i].response_max - result[i].response_min);
+            WriteUART(msg);
+        }
+    }
+#endif
+    
 	start = 1;//start streaming data
       
     
      
-    asm volatile("ei"); // Enable Global Interrupts once all peripherals are configured
+    defer_init();//software interrupts for the deferred work, before the tick posts any
+    scheduler_init();//tick for the control loops and the telemetry, the tasks run once interrupts are enabled
+#ifdef ISR_PROFILING
+    isr_profile_reset();
+#endif
+#ifdef PERF_PROFILING
+    perf_init(PERF_DEFAULT_EVENT0, PERF_DEFAULT_EVENT1);//instructions and instruction cache misses per region
+#endif
+#ifdef PC_SAMPLING
+    pc_sample_init(PC_SAMPLE_RATE);//Timer8 samples the interrupted addresses, see pc_sample.h
+#endif
+    __builtin_enable_interrupts(); // Enable Global Interrupts once all peripherals are configured
     GREEN_RGB_LED;//system ready
 
     
     while(1)
     {
-        set_dutycycleM1(dc1);
-        set_dutycycleM2(dc2);
+        status = __builtin_disable_interrupts();//a start between the test and the write would be overwritten
+        if(!control_enabled && !waveform_playing() && !autotune_running(NUMBER_OF_JOINTS))//the current loop or the DMA sets the duty cycle once they run
+        {
+            PWM_set_duty(PWM_CHANNEL_M1, dc1);
+            PWM_set_duty(PWM_CHANNEL_M2, dc2);
+        }
+        __builtin_mtc0(12, 0, status);
         
         //ReadIMU
-        //IMUReadBytes(IMU_ADDRESS, ACCEL_XOUT_H,ACCEL_BIAS_X, &accelX);
-        //IMUReadBytes(IMU_ADDRESS, ACCEL_YOUT_H,ACCEL_BIAS_Y, &accelY);
-        //IMUReadBytes(IMU_ADDRESS, ACCEL_ZOUT_H,ACCEL_BIAS_Z, &accelZ);
+        //IMUReadBytes(IMU_ADDRESS, ACCEL_XOUT_H, &accelX);
+        //IMUReadBytes(IMU_ADDRESS, ACCEL_YOUT_H, &accelY);
+        //IMUReadBytes(IMU_ADDRESS, ACCEL_ZOUT_H, &accelZ);
                   
         //Nop();
                       
+        if(UART_get_frame(&frame))//frames from the host, setpoint frames go to the stream directly
+        {
+            if(frame.command == 'W')//waveform tables and playback, see waveform.c
+                waveform_command(frame.payload, frame.length);
+            if(frame.command == 'A')//tuning of the current loop, see autotune.c
+                autotune_command(frame.payload, frame.length);
+            if(frame.command == 'C')//start or stop the current and position controllers, see control.h
+                control_command(frame.payload, frame.length);
+            if(frame.command == 'd')//send the measurements of the deferred work, see defer.h
+                defer_report();
+            if(frame.command == 's')//send the run times, deadline misses and tick overruns of the tasks, see scheduler.h
+                scheduler_report();
+#ifdef ISR_PROFILING
+            if(frame.command == 'i')//send the ISR measurements
+                isr_profile_report();
+#endif
+#ifdef PERF_PROFILING
+            if(frame.command == 'p')//send the counts of the regions or set the events, see perf.h
+                perf_command(frame.payload, frame.length);
+#endif
+#ifdef PC_SAMPLING
+            if(frame.command == 'q')//send the histogram of the sampled addresses or set the sample rate
+                pc_sample_command(frame.payload, frame.length);
+#endif
+        }
+        autotune_report();//gains of the tunings that ended
+#ifdef PC_SAMPLING
+        pc_sample_task();//samples of the ring into the histogram
+#endif
         while(buffer_empty()) 
         { ;
         }// wait for data to be in the queue
@@ -1,5 +1,5 @@
 /* ************************************************************************** */
-h/** motorDriver.c
+/** motorDriver.h
 
 @Author
 Aniket Mazumder
@@ -15,19 +15,16 @@ motorDriver.h
 
 @Summary
  Function prototypes for motordriver.c 
+ */
 
 #ifndef _MOTOR_DRIVER_H    /* Guard against multiple inclusion */
 #define _MOTOR_DRIVER_H
 
 /*prototypes for motorDriver.c*/
-void PWM_init();
-void Control_loop_init();
 void Motor_driver_init();
-void set_dutycycleM1(uint16_t);
-void set_dutycycleM2(uint16_t);
 
 
-#endif /* _EXAMPLE_FILE_NAME_H */
+#endif /* _MOTOR_DRIVER_H */
 
 /* *****************************************************************************
  End of File
@@ -11,6 +11,8 @@
   
   @Description
  File contains the function definitions for the IMU 9250 
+ * All accesses go through IMUWriteRegister() and IMUReadRegisters() which talk 
+ * to the IMU over I2C1 or SPI2 depending on IMU_TRANSPORT.
  
 /* **************************************************************************
 
@@ -24,6 +26,158 @@
 #include "header.h"
 #include <proc/p32mz2048efm100.h>
 #include "mpu9250.h"
+#include "I2C.h"
+#include "SPI.h"
+#include "NVM.h"
+
+/*Page of flash that holds the accelerometer calibration, erased when programmed*/
+static const uint32_t __attribute__((space(prog), aligned(NVM_PAGE_SIZE))) 
+    imu_calibration_page[NVM_PAGE_SIZE / 4] = {[0 ... NVM_PAGE_SIZE / 4 - 1] = 0xFFFFFFFF};
+
+static const uint8_t accel_offset_register[3] = {XA_OFFSET_H, YA_OFFSET_H, ZA_OFFSET_H};
+
+/*Profiles of IMUConfigure(), see mpu9250.h for the filter bandwidths*/
+static const imu_profile_config_t imu_profiles[IMU_NUMBER_OF_PROFILES] =
+{
+    //ACCEL_CONFIG, ACCEL_CONFIG2, GYRO_CONFIG, MPU_CONFIG, SMPLRT_DIV, PWR_MGMT_2, delays(us), sensitivities
+    [IMU_PROFILE_LOW_LATENCY] = {0b00011000, 0b00000001, 0b00011000, 0b00000001, 0, 0b00000000, 1880, 2900, 2048, 164},
+    [IMU_PROFILE_BALANCED]    = {0b00011000, 0b00000010, 0b00010000, 0b00000010, 0, 0b00000000, 2880, 3900, 2048, 328},
+    [IMU_PROFILE_LOW_NOISE]   = {0b00011000, 0b00000100, 0b00001000, 0b00000100, 4, 0b00000000, 8870, 9900, 2048, 655},
+    [IMU_PROFILE_ACCEL_ONLY]  = {0b00011000, 0b00000011, 0b00000000, 0b00000000, 0, 0b00000111, 4880,    0, 2048,   0},
+};
+
+
+/*Methods for the bus to the IMU
+ ........................
+ *************************/
+//initialize the bus to the IMU
+void IMU_init()
+{
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    SPI_init(IMU_SPI_CONFIG_FREQ);
+    IMUWriteRegister(IMU_ADDRESS, USER_CTRL, IMU_I2C_IF_DIS);   // keep the IMU in SPI mode
+#endif
+}
+
+//write a single register of the IMU
+void IMUWriteRegister(uint8_t i2c_address, uint8_t data_address, uint8_t value)
+{
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    (void)i2c_address;                  /* the IMU is selected by its chip select */
+    SPI_select();
+    SPI_transfer(data_address);         /* Send the register address with the read bit cleared */
+    SPI_transfer(value);                /* Send the value to set it to */
+    SPI_deselect();
+#else
+    I2C_start();						/* Send start condition */  
+    I2C_write(i2c_address << 1, 1);     /* Send IMU's  address, read/write bit not set (AD + W) */  
+    I2C_write(data_address, 1);			/* Send the register address (RA) */  
+    I2C_write(value, 1);				/* Send the value to set it to */  
+    I2C_stop();    						/* Send stop condition */  
+#endif
+}
+
+//read [length] consecutive registers of the IMU, the address auto increments in the IMU
+void IMUReadRegisters(uint8_t i2c_address, uint8_t data_address, uint8_t *buffer, uint8_t length)
+{
+    uint8_t i;
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    (void)i2c_address;                  /* the IMU is selected by its chip select */
+    SPI_select();
+    SPI_transfer(data_address | IMU_SPI_READ);  /* Send the register address with the read bit set */
+    for(i = 0; i < length; ++i)
+        buffer[i] = SPI_transfer(0);    /* Clock out a dummy byte for every register */
+    SPI_deselect();
+#else
+    I2C_start();						/* Send start condition */  
+    I2C_write(i2c_address << 1, 1);     /* Send IMU's address, read/write bit not set (AD + W) */  
+    I2C_write(data_address, 1);			/* Send the register address (RA) */  
+    I2C_restart();						/* Send repeated start condition */
+    I2C_write(i2c_address << 1 | 1, 1);	/* Send IMU's address, read/write bit set (AD + R) */  
+    for(i = 0; i < length; ++i)
+        I2C_read(&buffer[i], i == length - 1); /* ACK every byte except the last one */
+    I2C_stop();    						/* Send stop condition */  
+#endif
+}
+
+//start a burst read of the accelerometer, temperature and gyro registers
+void IMUStartBurst()
+{
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    uint8_t tx[IMU_BURST_LENGTH + 1] = {ACCEL_XOUT_H | IMU_SPI_READ};   /* address followed by dummy bytes */
+    SPI_DMA_start(tx, sizeof(tx));
+#endif
+}
+
+//returns 1 and fills buffer with IMU_BURST_LENGTH bytes once the burst started by IMUStartBurst() is done
+uint8_t IMUBurstComplete(uint8_t *buffer)
+{
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    uint8_t rx[IMU_BURST_LENGTH + 1];
+    uint8_t i;
+    if(!SPI_DMA_complete(rx))
+        return 0;
+    for(i = 0; i < IMU_BURST_LENGTH; ++i)
+        buffer[i] = rx[i + 1];          /* first byte was received while sending the address */
+    return 1;
+#else
+    IMUReadRegisters(IMU_ADDRESS, ACCEL_XOUT_H, buffer, IMU_BURST_LENGTH);
+    return 1;
+#endif
+}
+
+//read the accelerometer, temperature and gyro registers in one burst
+void IMUReadBurst(uint8_t *buffer)
+{
+    IMUStartBurst();
+    while(!IMUBurstComplete(buffer));
+}
+
+//get the acceleration and angular rate out of the IMU_BURST_LENGTH bytes of a burst, the temperature is skipped
+void IMUDecodeBurst(const uint8_t *buffer, int16_t accel[3], int16_t gyro[3])
+{
+    uint8_t i;
+    for(i = 0; i < 3; ++i)
+    {
+        accel[i] = (buffer[2 * i] << 8) | buffer[2 * i + 1];
+        gyro[i] = (buffer[8 + 2 * i] << 8) | buffer[8 + 2 * i + 1];
+    }
+}
+
+//read the acceleration and angular rate in one burst
+void IMUReadMotion(int16_t accel[3], int16_t gyro[3])
+{
+    uint8_t buffer[IMU_BURST_LENGTH];
+    IMUReadBurst(buffer);
+    IMUDecodeBurst(buffer, accel, gyro);
+}
+
+//set the full scale ranges, filters and data rate of a profile
+void IMUConfigure(imu_profile_t profile)
+{
+    const imu_profile_config_t *config = &imu_profiles[profile];
+    
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    //configuration registers can only be written at the lower SPI clock
+    SPI_set_frequency(IMU_SPI_CONFIG_FREQ);
+#endif
+    IMUWriteRegister(IMU_ADDRESS, PWR_MGMT_2, config->pwr_mgmt_2);
+    IMUWriteRegister(IMU_ADDRESS, SMPLRT_DIV, config->smplrt_div);
+    IMUWriteRegister(IMU_ADDRESS, MPU_CONFIG, config->mpu_config);
+    IMUWriteRegister(IMU_ADDRESS, GYRO_CONFIG, config->gyro_config);
+    IMUWriteRegister(IMU_ADDRESS, ACCEL_CONFIG, config->accel_config);
+    IMUWriteRegister(IMU_ADDRESS, ACCEL_CONFIG2, config->accel_config2);
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    //configuration is done, the sensor registers can be read at the full speed of the IMU
+    SPI_set_frequency(IMU_SPI_READ_FREQ);
+#endif
+}
+
+//register values, group delays and sensitivities of a profile
+const imu_profile_config_t *IMUProfile(imu_profile_t profile)
+{
+    return &imu_profiles[profile];
+}
 
 //configure IMU, ie set sensitivity of the accelerometers
 void configIMUSensitivity(uint8_t i2c_address, uint8_t data_address,uint8_t value )
@@ -32,11 +186,7 @@ void configIMUSensitivity(uint8_t i2c_address, uint8_t data_address,uint8_t valu
      Reg 28[4:3]- 2g(00),4g(01),8g(10),16g(11)
      * value=0b0001100 for 16g resolution
      */
-    I2C_start();						/* Send start condition */  
-    I2C_write(i2c_address << 1, 1);     /* Send IMU's  address, read/write bit not set (AD + W) */  
-    I2C_write(data_address, 1);			/* Send the register address (RA) */  
-    I2C_write(value, 1);				/* Send the value to set it to */  
-    I2C_stop();    						/* Send stop condition */  
+    IMUWriteRegister(i2c_address, data_address, value);
 }
 //configure IMU power, ie disable the Gyroscope to save power
 void disableIMUGyro(uint8_t i2c_address, uint8_t data_address,uint8_t value )
@@ -44,11 +194,7 @@ void disableIMUGyro(uint8_t i2c_address, uint8_t data_address,uint8_t value )
     /*configure  IMU powermode
     * value=0b00000111 to keep only the accelerometers active.
      */      
-    I2C_start();						/* Send start condition */  
-    I2C_write(i2c_address << 1, 1);     /* Send IMU's  address, read/write bit not set (AD + W) */  
-    I2C_write(data_address, 1);			/* Send the register address (RA) */  
-    I2C_write(value, 1);				/* Send the value to set it to */  
-    I2C_stop();    						/* Send stop condition */  
+    IMUWriteRegister(i2c_address, data_address, value);
 }
 
 //configure Accelerometer data rate and data filter, 
@@ -57,43 +203,132 @@ void configAccelDataFilterRate(uint8_t i2c_address, uint8_t data_address,uint8_t
     /*configure Accelerometer datarate and the Filter to the 
     * value=0b00000010 to set a Lowpass filter of 92Hz bandwidth and data rate of 1KHz. delay of 7.8 ms and Noise density of 250ug/rtHz
      */      
-    I2C_start();						/* Send start condition */  
-    I2C_write(i2c_address << 1, 1);     /* Send IMU's  address, read/write bit not set (AD + W) */  
-    I2C_write(data_address, 1);			/* Send the register address (RA) */  
-    I2C_write(value, 1);				/* Send the value to set it to */  
-    I2C_stop();    						/* Send stop condition */  
+    IMUWriteRegister(i2c_address, data_address, value);
 }
 
 
 
 // Read 2 bytes to give the accelerationX
-void IMUReadBytes(uint8_t i2c_address, uint8_t data_address,int16_t bias, volatile int16_t *dataBytes)
+void IMUReadBytes(uint8_t i2c_address, uint8_t data_address, volatile int16_t *dataBytes)
 {
-    I2C_start();						/* Send start condition */  
-    I2C_write(i2c_address<< 1, 1);      /* Send IMU's address, read/write bit not set (AD + R) */  
-    I2C_write(data_address, 1);			/* Send the register address (RA) */  
-    I2C_restart();						/* Send repeated start condition */
-    I2C_write(i2c_address << 1 | 1, 1);	/* Send IMU's address, read/write bit set (AD + W) */  
-    
-    //read the i2c bus twice for 2 bytes of data and store in the variable angle
-    uint8_t temp=0;                     /* Temporary variable to store a byte of data*/
-    I2C_read(&temp, 0);                 /* Read a byte of data from the I2C bus and store it in variable value */  
-    *dataBytes=0;
-    *dataBytes=temp<<8;
-    I2C_read(&temp, 1);                 /* Read next byte of data from the I2C bus */  
-    *dataBytes|=temp;                   /* Combine the two reads to get the angle value form the sensor*/
-    *dataBytes=*dataBytes-bias;
-    //Stop the sequential read
-    I2C_stop();    						/* Send stop condition */  
+    uint8_t temp[2];                    /* Temporary variable to store the two bytes of data*/
+    IMUReadRegisters(i2c_address, data_address, temp, 2);
+    *dataBytes=(temp[0]<<8)|temp[1];    /* Combine the two reads to get the value form the sensor*/
 }
 
 //setup IMU sensitivity, power mode and data filtration rate
 void setIMU_sensitivity()
 {
-    //set IMU to a sensitivity of 16g
-    configIMUSensitivity(IMU_ADDRESS,ACCEL_CONFIG,0b0011000 );
-    //set IMU to accelerometer only mode to save power
-    disableIMUGyro(IMU_ADDRESS, PWR_MGMT_2,0b00000111 );
-    //configureIMU data rate to 1KHz and Low pass filter of 41Hz with a delay of 11.80 ms
-    configAccelDataFilterRate(IMU_ADDRESS,ACCEL_CONFIG2 ,0b00000011);
-}
\ No newline at end of file
+    IMUConfigure(IMU_PROFILE_DEFAULT);
+}
+
+
+/*Methods for the calibration of the accelerometer
+ ........................
+ *************************/
+//write the three offset registers of the accelerometer
+static void writeAccelOffsets(const uint16_t offset[3])
+{
+    uint8_t i;
+    for(i = 0; i < 3; ++i)
+    {
+        IMUWriteRegister(IMU_ADDRESS, accel_offset_register[i], offset[i] >> 8);
+        IMUWriteRegister(IMU_ADDRESS, accel_offset_register[i] + 1, offset[i] & 0xFF);
+    }
+}
+
+//measure the biases of the accelerometer and cancel them in the offset registers of the IMU
+void IMUCalibrateAccel(uint16_t samples, uint8_t persist)
+{
+    int32_t sum[3] = {0, 0, 0};
+    uint16_t offset[3];
+    uint8_t data[6];
+    uint8_t int_enable, status;
+    int32_t counts_per_g;
+    uint16_t n;
+    uint8_t i;
+    
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    //the offset and interrupt registers are written, stay at the lower SPI clock
+    SPI_set_frequency(IMU_SPI_CONFIG_FREQ);
+#endif
+    /*counts for 1g at the full scale range set in ACCEL_CONFIG[4:3]: 2g(16384) ... 16g(2048)*/
+    IMUReadRegisters(IMU_ADDRESS, ACCEL_CONFIG, data, 1);
+    counts_per_g = 16384 >> ((data[0] >> 3) & 0b11);
+    
+    /*start from the current (factory) offsets*/
+    for(i = 0; i < 3; ++i)
+    {
+        IMUReadRegisters(IMU_ADDRESS, accel_offset_register[i], data, 2);
+        offset[i] = (data[0] << 8) | data[1];
+    }
+    
+    /*average the samples, every sample is read once when the IMU flags new data*/
+    IMUReadRegisters(IMU_ADDRESS, INT_ENABLE, &int_enable, 1);
+    IMUWriteRegister(IMU_ADDRESS, INT_ENABLE, int_enable | IMU_DATA_RDY_EN);
+    IMUReadRegisters(IMU_ADDRESS, INT_STATUS, &status, 1);    /* discard a sample taken before the call */
+    for(n = 0; n < samples; ++n)
+    {
+        do
+        {
+            IMUReadRegisters(IMU_ADDRESS, INT_STATUS, &status, 1);
+        } while(!(status & IMU_DATA_RDY_EN));
+        IMUReadRegisters(IMU_ADDRESS, ACCEL_XOUT_H, data, 6);
+        for(i = 0; i < 3; ++i)
+            sum[i] += (int16_t)((data[2 * i] << 8) | data[2 * i + 1]);
+    }
+    IMUWriteRegister(IMU_ADDRESS, INT_ENABLE, int_enable);
+    
+    /*The offset registers count in steps of 1/2048 g, bit 0 is reserved and has to be kept.*/
+    for(i = 0; i < 3; ++i)
+    {
+        int32_t bias = sum[i] / samples;
+        if(i == IMU_GRAVITY_AXIS)
+            bias -= counts_per_g;       /* gravity is not a bias */
+        bias = bias * 2048 / counts_per_g;
+        offset[i] = ((offset[i] - bias) & ~1) | (offset[i] & 1);
+    }
+    writeAccelOffsets(offset);
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    SPI_set_frequency(IMU_SPI_READ_FREQ);
+#endif
+    
+    if(persist)
+    {
+        uint32_t record[4];
+        record[0] = IMU_CALIBRATION_MAGIC;
+        record[1] = offset[0] | ((uint32_t)offset[1] << 16);
+        record[2] = offset[2];
+        record[3] = ~(record[0] ^ record[1] ^ record[2]);   /* check word */
+        NVM_erase_page(imu_calibration_page);
+        NVM_write_quad_word(imu_calibration_page, record);
+    }
+}
+
+//load the calibration from flash into the offset registers of the IMU
+uint8_t IMULoadAccelCalibration()
+{
+    /*read through the uncached alias, the cache may still hold the page from before it was programmed*/
+    const volatile uint32_t *record = (const volatile uint32_t *)KVA0_TO_KVA1((uintptr_t)imu_calibration_page);
+    uint16_t offset[3];
+    
+    if(record[0] != IMU_CALIBRATION_MAGIC || record[3] != ~(record[0] ^ record[1] ^ record[2]))
+        return 0;
+    offset[0] = record[1] & 0xFFFF;
+    offset[1] = record[1] >> 16;
+    offset[2] = record[2] & 0xFFFF;
+#if IMU_TRANSPORT == IMU_TRANSPORT_SPI
+    SPI_set_frequency(IMU_SPI_CONFIG_FREQ);
+    writeAccelOffsets(offset);
+    SPI_set_frequency(IMU_SPI_READ_FREQ);
+#else
+    writeAccelOffsets(offset);
+#endif
+    return 1;
+}
+
+//erase the calibration in flash
+void IMUClearAccelCalibration()
+{
+    NVM_erase_page(imu_calibration_page);
+}
@@ -12,6 +12,8 @@
   
   @Description
  File contains the defines and the function prototypes for the IMU 9250 
+ * The IMU can be connected over I2C1 (default) or over SPI2, select the bus 
+ * by defining IMU_TRANSPORT in the project settings. Both buses use the same functions.
  
 /* ************************************************************************** */
 
@@ -24,12 +26,70 @@
 // #define AK8963_ADDRESS   0x0C
 #define IMU_ADDRESS      0x68
 
-/*define Accelerometer biases
- * Calculate the biases from the accelerometer and put these values here*/
-//Biases for the Given MPU 9150(Marked with tape))
-#define ACCEL_BIAS_X    50
-#define ACCEL_BIAS_Y    30
-#define ACCEL_BIAS_Z    80
+/*Buses over which the IMU can be read*/
+#define IMU_TRANSPORT_I2C 0
+#define IMU_TRANSPORT_SPI 1
+#ifndef IMU_TRANSPORT
+#define IMU_TRANSPORT IMU_TRANSPORT_I2C
+#endif
+
+/*The registers of the IMU can be written with a SPI clock up to 1MHz
+ *while the sensor and interrupt registers can be read up to 20MHz*/
+#define IMU_SPI_CONFIG_FREQ 1000000
+#define IMU_SPI_READ_FREQ   20000000
+#define IMU_SPI_READ        0x80    // bit set in the register address for a read over SPI
+#define IMU_I2C_IF_DIS      0x10    // bit in USER_CTRL that disables the I2C interface of the IMU
+
+#define IMU_BURST_LENGTH    14      // bytes from ACCEL_XOUT_H up to GYRO_ZOUT_L
+
+/*Configuration profiles of the IMU, set with IMUConfigure()
+ * Every profile sets the full scale ranges, the digital low pass filters (DLPF) and the
+ * output data rate together. A lower filter bandwidth gives less noise but a longer
+ * group delay, the delays are taken from the DLPF tables of the register map (rev 1.6).
+ *  profile                 accel      gyro        accel DLPF       gyro DLPF       ODR
+ *  IMU_PROFILE_LOW_LATENCY 16g        2000dps     218Hz  1.88ms    184Hz  2.9ms    1kHz
+ *  IMU_PROFILE_BALANCED    16g        1000dps      99Hz  2.88ms     92Hz  3.9ms    1kHz
+ *  IMU_PROFILE_LOW_NOISE   16g         500dps      21Hz  8.87ms     20Hz  9.9ms    200Hz
+ *  IMU_PROFILE_ACCEL_ONLY  16g         off         45Hz  4.88ms     -              1kHz
+ * IMU_PROFILE_ACCEL_ONLY is the setup used before the profiles, with the gyro off to save power*/
+typedef enum
+{
+    IMU_PROFILE_LOW_LATENCY,
+    IMU_PROFILE_BALANCED,
+    IMU_PROFILE_LOW_NOISE,
+    IMU_PROFILE_ACCEL_ONLY,
+    IMU_NUMBER_OF_PROFILES
+} imu_profile_t;
+
+/*Register values and properties of a profile*/
+typedef struct
+{
+    uint8_t accel_config;       // ACCEL_CONFIG, full scale range in [4:3]
+    uint8_t accel_config2;      // ACCEL_CONFIG2, accel DLPF in [2:0] with ACCEL_FCHOICE_B=0
+    uint8_t gyro_config;        // GYRO_CONFIG, full scale range in [4:3] with FCHOICE_B=00
+    uint8_t mpu_config;         // MPU_CONFIG, gyro DLPF in [2:0]
+    uint8_t smplrt_div;         // SMPLRT_DIV, output data rate = 1kHz/(1+SMPLRT_DIV)
+    uint8_t pwr_mgmt_2;         // PWR_MGMT_2, sensors that are switched off
+    uint16_t accel_delay_us;    // group delay of the accel DLPF
+    uint16_t gyro_delay_us;     // group delay of the gyro DLPF, 0 if the gyro is off
+    uint16_t accel_lsb_per_g;   // sensitivity at the full scale range
+    uint16_t gyro_lsb_per_dps_x10;  // sensitivity at the full scale range in LSB/dps x10
+} imu_profile_config_t;
+
+/*Profile set by setIMU_sensitivity()*/
+#ifndef IMU_PROFILE_DEFAULT
+#define IMU_PROFILE_DEFAULT IMU_PROFILE_BALANCED
+#endif
+
+/*Accelerometer calibration
+ * The biases are measured at boot with IMUCalibrateAccel() and written to the offset 
+ * registers of the IMU, so the values read from the IMU need no correction.
+ * The board has to be stationary with the gravity axis pointing up during calibration*/
+#define IMU_CALIBRATION_SAMPLES 256     // number of samples averaged per axis
+#define IMU_CALIBRATION_PERSIST 1       // keep the result in flash and load it at the next boot
+#define IMU_GRAVITY_AXIS        2       // axis that senses +1g during calibration, 0=X 1=Y 2=Z
+#define IMU_CALIBRATION_MAGIC   0x4C414341  // marks a valid calibration in flash ("ACAL")
+#define IMU_DATA_RDY_EN         0x01    // bit in INT_ENABLE and INT_STATUS for new sensor data
 
 #define AK8963_WHO_AM_I  0x00 // should return 0x48
 #define AK8963_INFO      0x01
@@ -193,6 +253,36 @@
 /*Methods for the IMU MPU9250
  *******************************************************************
  .................*/
+/*Initialize the bus to the IMU; for SPI it also disables the I2C interface of the IMU.
+ * I2C1 is shared with the encoders and has to be initialized with I2C_init()*/
+void IMU_init();
+
+/*Write a single register of the IMU, i2c_address is not used over SPI*/
+void IMUWriteRegister(uint8_t i2c_address, uint8_t data_address, uint8_t value);
+
+/*Read [length] consecutive registers of the IMU starting at data_address*/
+void IMUReadRegisters(uint8_t i2c_address, uint8_t data_address, uint8_t *buffer, uint8_t length);
+
+/*Read the accelerometer, temperature and gyro registers in one burst of IMU_BURST_LENGTH bytes.
+ * Over SPI the burst is moved by the DMA at IMU_SPI_READ_FREQ*/
+void IMUReadBurst(uint8_t *buffer);
+
+/*Start a burst read and return immediately (SPI only), poll IMUBurstComplete() for the result*/
+void IMUStartBurst();
+uint8_t IMUBurstComplete(uint8_t *buffer);
+
+/*Get the acceleration and angular rate out of a burst*/
+void IMUDecodeBurst(const uint8_t *buffer, int16_t accel[3], int16_t gyro[3]);
+
+/*Read the acceleration and angular rate in one burst*/
+void IMUReadMotion(int16_t accel[3], int16_t gyro[3]);
+
+/*Set the full scale ranges, filters and data rate of the profile*/
+void IMUConfigure(imu_profile_t profile);
+
+/*Register values, group delays and sensitivities of a profile*/
+const imu_profile_config_t *IMUProfile(imu_profile_t profile);
+
 /*configure  IMU sensitivity
 * value=0b0001100 for 16g resolution
 */   
@@ -204,7 +294,7 @@ void configIMUSensitivity(uint8_t i2c_address, uint8_t data_address,uint8_t valu
 void disableIMUGyro(uint8_t i2c_address, uint8_t data_address,uint8_t value );
 
 /*configure  Accelerometer datarate and the Filter to the 
-* value=0b00000010 to set a Lowpass filter of 92Hz bandwidth and data rate of 1KHz. delay of 7.8 ms and Noise density of 250ug/rtHz
+* value=0b00000010 to set a Lowpass filter of 99Hz bandwidth and data rate of 1KHz. delay of 2.88 ms and Noise density of 300ug/rtHz
 */      
 void configAccelDataFilterRate(uint8_t i2c_address, uint8_t data_address,uint8_t value );
 
@@ -217,11 +307,23 @@ void configAccelDataFilterRate(uint8_t i2c_address, uint8_t data_address,uint8_t
  *              GYRO_YOUT_H for Gyro Y
  *              GYRO_ZOUT_H for Gyro Z
  */  
-void IMUReadBytes(uint8_t i2c_address, uint8_t data_address,int16_t bias, volatile int16_t *dataBytes);
+void IMUReadBytes(uint8_t i2c_address, uint8_t data_address, volatile int16_t *dataBytes);
 
-/*Function to setup the sensitivity, power mode and filter rate of the IMU*/
+/*Function to setup the sensitivity, power mode and filter rate of the IMU with IMU_PROFILE_DEFAULT*/
 void setIMU_sensitivity();
 
+/*Function to measure the accelerometer biases over [samples] samples and write them 
+ * to the offset registers of the IMU. Set persist to keep the result in flash.
+ * Call after setIMU_sensitivity(), the board needs to be stationary.*/
+void IMUCalibrateAccel(uint16_t samples, uint8_t persist);
+
+/*Function to write the calibration stored in flash to the offset registers of the IMU.
+ * Returns 0 if no calibration has been stored*/
+uint8_t IMULoadAccelCalibration();
+
+/*Function to erase the calibration stored in flash, the next boot calibrates again*/
+void IMUClearAccelCalibration();
+
 #endif /* _EXAMPLE_FILE_NAME_H */
 
 /* *****************************************************************************
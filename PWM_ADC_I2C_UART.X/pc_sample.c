@@ -0,0 +1,190 @@
+/* ************************************************************************** */
+/** pc_sample.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+pc_sample.c
+
+@Summary
+ Statistical profiler that samples the program counter of the interrupted code
+
+@Description
+ Peripherals used:
+ * Timer8, interrupt at priority 7 with shadow register set 7
+ * The ISR is the only writer of the ring and the main loop the only reader, each owns
+ * one index. The histogram is an open addressed hash table of (address, level) that
+ * only the main loop touches. Bit 0 of EPC is the ISA mode (microMIPS) and is cleared.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include "header.h"
+#include "pc_sample.h"
+#include "UART.h"
+
+#define PC_SAMPLE_PRESCALER CLOCK_TIMER_PRESCALER(PC_SAMPLE_RATE_MIN)     // Timer8, PR8 fits the lowest rate
+#define SRSCTL_PSS_SHIFT    6
+#define SRSCTL_PSS_MASK     0xF
+
+typedef struct
+{
+    uint32_t pc;
+    uint32_t count;             // 0 for a free bin
+    uint8_t level;
+} pc_bin_t;
+
+CLOCK_ASSERT_TIMER(PC_SAMPLE_RATE_MIN, PC_SAMPLE_PRESCALER, 1000);
+CLOCK_ASSERT_TIMER(PC_SAMPLE_RATE_MAX, PC_SAMPLE_PRESCALER, 5000);
+
+static volatile uint32_t ring_pc[PC_SAMPLE_RING];
+static volatile uint8_t ring_level[PC_SAMPLE_RING];
+static volatile uint16_t ring_write = 0, ring_read = 0;
+static volatile uint32_t ring_overflows;
+
+static pc_bin_t bins[PC_SAMPLE_BINS];
+static pc_sample_stats_t stats;
+static uint16_t sample_rate;
+
+/*ISR for Timer8, the prologue of an IPL7 ISR leaves EPC and SRSCtl as the interrupt set them*/
+void __attribute__((vector(_TIMER_8_VECTOR), interrupt(ipl7srs), nomips16)) pc_sample_isr()
+{
+    uint32_t pc = _CP0_GET_EPC() & ~1u;
+    uint8_t level = (_CP0_GET_SRSCTL() >> SRSCTL_PSS_SHIFT) & SRSCTL_PSS_MASK;
+    uint16_t next = (ring_write + 1) & (PC_SAMPLE_RING - 1);
+
+    if(next != ring_read)
+    {
+        ring_pc[ring_write] = pc;
+        ring_level[ring_write] = level;
+        ring_write = next;
+    }
+    else
+        ++ring_overflows;
+    reg_clear(&IFS1, _IFS1_T8IF_MASK);
+}
+
+void pc_sample_init(uint16_t rate)
+{
+    T8CON = 0;              // stop Timer8 while it is set up
+    IEC1bits.T8IE = 0;
+    pc_sample_reset();
+    sample_rate = rate;
+    if(!rate)
+        return;
+    if(rate < PC_SAMPLE_RATE_MIN)
+        rate = PC_SAMPLE_RATE_MIN;
+    if(rate > PC_SAMPLE_RATE_MAX)
+        rate = PC_SAMPLE_RATE_MAX;
+    sample_rate = rate;
+
+    TMR8 = 0;
+    T8CONbits.TCKPS = CLOCK_TCKPS(PC_SAMPLE_PRESCALER);
+    PR8 = CLOCK_TIMER_FREQ(PC_SAMPLE_PRESCALER) / rate - 1;
+    reg_clear(&IFS1, _IFS1_T8IF_MASK);
+    IPC9bits.T8IP = 7;      // above every other interrupt, so EPC is never overwritten
+    IPC9bits.T8IS = 0;
+    IEC1bits.T8IE = 1;
+    T8CONbits.ON = 1;
+}
+
+//bin of an address, the first free one if it is not in the histogram yet; 0 if there is none
+static pc_bin_t *pc_sample_bin(uint32_t pc, uint8_t level)
+{
+    uint16_t index = ((pc >> 2) * 2654435761u >> 16) & (PC_SAMPLE_BINS - 1);    // multiplicative hash
+    uint8_t probe;
+
+    for(probe = 0; probe < PC_SAMPLE_PROBES; ++probe)
+    {
+        pc_bin_t *bin = &bins[(index + probe) & (PC_SAMPLE_BINS - 1)];
+        if(!bin->count || (bin->pc == pc && bin->level == level))
+            return bin;
+    }
+    return 0;
+}
+
+void pc_sample_task()
+{
+    uint16_t write = ring_write;    // the ISR may add samples meanwhile, they are taken on the next run
+
+    while(ring_read != write)
+    {
+        uint32_t pc = ring_pc[ring_read];
+        uint8_t level = ring_level[ring_read] & (PC_SAMPLE_LEVELS - 1);
+        pc_bin_t *bin = pc_sample_bin(pc, level);
+
+        ring_read = (ring_read + 1) & (PC_SAMPLE_RING - 1);
+        if(!bin)
+        {
+            ++stats.histogram_full;
+            continue;
+        }
+        bin->pc = pc;
+        bin->level = level;
+        ++bin->count;
+        ++stats.samples;
+        ++stats.per_level[level];
+    }
+}
+
+void pc_sample_reset()
+{
+    uint16_t i;
+
+    for(i = 0; i < PC_SAMPLE_BINS; ++i)
+        bins[i].count = 0;
+    stats.samples = 0;
+    stats.histogram_full = 0;
+    for(i = 0; i < PC_SAMPLE_LEVELS; ++i)
+        stats.per_level[i] = 0;
+    ring_overflows = 0;
+    ring_read = ring_write;         // drop the samples of the ring
+}
+
+void pc_sample_get_stats(pc_sample_stats_t *copy)
+{
+    *copy = stats;
+    copy->ring_overflows = ring_overflows;
+}
+
+void pc_sample_report()
+{
+    char msg[100];
+    uint16_t i;
+    uint8_t running = T8CONbits.ON;
+
+    T8CONbits.ON = 0;               // the report takes longer than the ring holds
+    pc_sample_task();
+    sprintf(msg, "pc samples: %lu at %u Hz, lost %lu (ring) %lu (histogram)\r\n", (unsigned long)stats.samples,
+            sample_rate, (unsigned long)ring_overflows, (unsigned long)stats.histogram_full);
+    WriteUART(msg);
+    for(i = 0; i < PC_SAMPLE_BINS; ++i)
+    {
+        if(!bins[i].count)
+            continue;
+        sprintf(msg, "%08lx %u %lu\r\n", (unsigned long)bins[i].pc, bins[i].level, (unsigned long)bins[i].count);
+        WriteUART(msg);
+    }
+    WriteUART("end\r\n");
+    pc_sample_reset();
+    T8CONbits.ON = running;
+}
+
+/*Serial link*/
+void pc_sample_command(const uint8_t *payload, uint8_t length)
+{
+    if(length >= 2)
+    {
+        pc_sample_init(payload[0] | (uint16_t)payload[1] << 8);
+        WriteUART("OK\r\n");
+    }
+    else
+        pc_sample_report();
+}
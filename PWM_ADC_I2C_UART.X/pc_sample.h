@@ -0,0 +1,80 @@
+/* ************************************************************************** */
+/** pc_sample.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+pc_sample.h
+
+@Summary
+ Statistical profiler that samples the program counter of the interrupted code
+
+@Description
+ Define PC_SAMPLING to build the profiler. The Timer8 ISR runs at priority 7, above
+ * every other interrupt, and puts the address it interrupted (EPC) and the priority
+ * level of the interrupted code in a ring. The level is the previous shadow register
+ * set (SRSCtl.PSS), set to the level by PRISS in set_performance_mode(): 0 is the main
+ * loop, 1 ... 6 the ISRs. The main loop moves the ring into a histogram of addresses
+ * (pc_sample_task()), so the ISR stays short and the histogram needs no locking.
+ * The overhead is one interrupt per sample, set by the sample rate. Keep the rate off
+ * multiples of the scheduler tick (1kHz), or the samples always land in the same
+ * place of the tick. Code that runs with interrupts disabled is never sampled, its
+ * time is counted for the instruction that enables them again.
+ * 'q' frames over UART1: without payload the histogram is written as lines of
+ * "address level samples" (hex, decimal, decimal) and reset; a payload of two bytes,
+ * little endian, sets the sample rate in Hz, 0 stops sampling.
+ * tools/pc_profile.py resolves the addresses against the symbols of the .elf or the
+ * .map file into a flat profile per function.
+ */
+/* ************************************************************************** */
+
+#ifndef _PC_SAMPLE_H    /* Guard against multiple inclusion */
+#define _PC_SAMPLE_H
+
+#include <stdint.h>
+
+#define PC_SAMPLE_RATE      997     // Hz, default sample rate, a prime off the 1kHz tick
+#define PC_SAMPLE_RATE_MIN  100     // sets the prescaler of Timer8, PR8 is 16 bits
+#define PC_SAMPLE_RATE_MAX  20000
+#define PC_SAMPLE_RING      256     // samples between two runs of pc_sample_task(), a power of 2
+#define PC_SAMPLE_BINS      512     // addresses in the histogram, a power of 2
+#define PC_SAMPLE_PROBES    16      // bins tried for an address before the sample is lost
+#define PC_SAMPLE_LEVELS    8       // priority levels 0 (main) ... 7
+
+/*Measurements since the last reset*/
+typedef struct
+{
+    uint32_t samples;           // samples in the histogram
+    uint32_t ring_overflows;    // samples lost as the ring was full
+    uint32_t histogram_full;    // samples lost as their address found no free bin
+    uint32_t per_level[PC_SAMPLE_LEVELS];
+} pc_sample_stats_t;
+
+/*Methods for the profiler
+ *******************************************************************
+ .................*/
+/*Setup Timer8 at priority 7 and start sampling at rate Hz, 0 stops it; clears the histogram*/
+void pc_sample_init(uint16_t rate);
+
+/*Main loop: move the samples of the ring into the histogram*/
+void pc_sample_task();
+
+/*Clear the histogram and the measurements*/
+void pc_sample_reset();
+
+/*Copy of the measurements*/
+void pc_sample_get_stats(pc_sample_stats_t *stats);
+
+/*Write the histogram over UART1 and reset it*/
+void pc_sample_report();
+
+/*Execute the payload of a 'q' frame from the host*/
+void pc_sample_command(const uint8_t *payload, uint8_t length);
+
+#endif /* _PC_SAMPLE_H */
@@ -0,0 +1,148 @@
+/* ************************************************************************** */
+/** perf.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+perf.c
+
+@Summary
+ Performance counters of the core per named code region
+
+@Description
+ Peripherals used:
+ * Core timer, performance counters 0 and 1 (CP0 register 25)
+ * The counters run freely; entry and exit take a snapshot of the core timer and both
+ * counters and add the difference to the region with interrupts disabled for a few
+ * instructions. The differences are taken modulo 2^32, a region must be shorter than
+ * 2^32 events (21s of cycles at 200MHz).
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include "header.h"
+#include "perf.h"
+#include "systime.h"
+#include "UART.h"
+#include "ramfunc.h"
+
+#define PERF_COUNT_KERNEL   0x3     // EXL and K: count in kernel mode, where all code of the project runs
+#define PERF_COUNT_USER     0x8     // U
+#define PERF_EVENT_SHIFT    5
+
+/*Names of the regions, in the order of perf_region_t*/
+static const char *const region_names[PERF_NUMBER_OF_REGIONS] =
+{
+    "current loop", "position loop", "ADC", "trajectory", "PID", "IMU read", "PWM dither",
+};
+
+static volatile perf_counts_t counts[PERF_NUMBER_OF_REGIONS];
+static uint32_t entry[PERF_NUMBER_OF_REGIONS][3];    // core timer, counter 0, counter 1 at the entry
+static uint8_t events[2] = {PERF_DEFAULT_EVENT0, PERF_DEFAULT_EVENT1};
+
+void perf_init(uint8_t event0, uint8_t event1)
+{
+    events[0] = event0;
+    events[1] = event1;
+    _mtc0(25, 0, ((uint32_t)event0 << PERF_EVENT_SHIFT) | PERF_COUNT_USER | PERF_COUNT_KERNEL);
+    _mtc0(25, 2, ((uint32_t)event1 << PERF_EVENT_SHIFT) | PERF_COUNT_USER | PERF_COUNT_KERNEL);
+    perf_reset();
+}
+
+//snapshot at the entry of a region
+RAMFUNC void perf_enter(perf_region_t id)
+{
+    uint32_t status = __builtin_disable_interrupts();
+
+    entry[id][0] = systime_count();
+    entry[id][1] = _mfc0(25, 1);
+    entry[id][2] = _mfc0(25, 3);
+    __builtin_mtc0(12, 0, status);
+}
+
+//add the counts since the entry to the region
+RAMFUNC void perf_exit(perf_region_t id)
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint32_t event1 = _mfc0(25, 3), event0 = _mfc0(25, 1);
+    uint32_t cycles = 2 * (systime_count() - entry[id][0]);   // the core timer counts at SYS_FREQ/2
+    volatile perf_counts_t *c = &counts[id];
+
+    ++c->calls;
+    c->cycles += cycles;
+    if(cycles > c->max_cycles)
+        c->max_cycles = cycles;
+    c->events[0] += event0 - entry[id][1];
+    c->events[1] += event1 - entry[id][2];
+    __builtin_mtc0(12, 0, status);
+}
+
+void perf_reset()
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint8_t i;
+
+    for(i = 0; i < PERF_NUMBER_OF_REGIONS; ++i)
+    {
+        counts[i].calls = 0;
+        counts[i].max_cycles = 0;
+        counts[i].cycles = 0;
+        counts[i].events[0] = 0;
+        counts[i].events[1] = 0;
+    }
+    __builtin_mtc0(12, 0, status);
+}
+
+//copy of the counts of a region, consistent as interrupts are disabled while copying
+void perf_get(perf_region_t id, perf_counts_t *copy)
+{
+    uint32_t status = __builtin_disable_interrupts();
+
+    copy->calls = counts[id].calls;
+    copy->max_cycles = counts[id].max_cycles;
+    copy->cycles = counts[id].cycles;
+    copy->events[0] = counts[id].events[0];
+    copy->events[1] = counts[id].events[1];
+    __builtin_mtc0(12, 0, status);
+}
+
+void perf_report()
+{
+    char msg[120];
+    perf_counts_t c;
+    uint8_t i;
+
+    sprintf(msg, "per call: cycles (max), event %u, event %u, event %u per 100 cycles\r\n", events[0], events[1], events[0]);
+    WriteUART(msg);
+    for(i = 0; i < PERF_NUMBER_OF_REGIONS; ++i)
+    {
+        perf_get(i, &c);
+        if(!c.calls)
+            continue;
+        sprintf(msg, "%s: %lu calls, %lu (%lu), %lu, %lu, %lu\r\n", region_names[i], (unsigned long)c.calls,
+                (unsigned long)(c.cycles / c.calls), (unsigned long)c.max_cycles,
+                (unsigned long)(c.events[0] / c.calls), (unsigned long)(c.events[1] / c.calls),
+                (unsigned long)(c.cycles ? 100 * c.events[0] / c.cycles : 0));
+        WriteUART(msg);
+    }
+    perf_reset();
+}
+
+/*Serial link*/
+void perf_command(const uint8_t *payload, uint8_t length)
+{
+    if(length >= 2)
+    {
+        perf_init(payload[0], payload[1]);
+        WriteUART("OK\r\n");
+    }
+    else
+        perf_report();
+}
@@ -0,0 +1,113 @@
+/* ************************************************************************** */
+/** perf.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+perf.h
+
+@Summary
+ Cycles, instructions and cache misses of named code regions from the performance
+ counters of the core
+
+@Description
+ The microAptiv core has two performance counters (CP0 register 25, select 1 and 3)
+ * that count the event set in their control registers (select 0 and 2). Each counter
+ * has its own list of events; the numbers below are those of the microAptiv UP
+ * software user's manual, the same number often counts a different event on the
+ * other counter (9: accesses of the instruction cache on counter 0, misses on counter 1).
+ * Define PERF_PROFILING to measure the regions, otherwise PERF_ENTER() and PERF_EXIT()
+ * expand to nothing. A region accumulates the calls, the cycles (core timer) and both
+ * counters between PERF_ENTER(id) and PERF_EXIT(id). The counts are inclusive: an ISR
+ * that preempts a region and a region nested in it are counted for it as well, and a
+ * region must not be entered again before it is left (e.g. from an ISR).
+ * Few instructions per cycle with many misses means a region waits for memory (move
+ * it to RAM, see ramfunc.h, or its data to the cache), many instructions per cycle
+ * means it is compute bound.
+ * 'p' frames over UART1: without payload the regions are reported and reset, a payload
+ * of two bytes sets the events of counter 0 and 1 and resets the regions.
+ */
+/* ************************************************************************** */
+
+#ifndef _PERF_H    /* Guard against multiple inclusion */
+#define _PERF_H
+
+#include <stdint.h>
+#include "ramfunc.h"
+
+/*Regions that are measured, keep in the order of the table in perf.c*/
+typedef enum
+{
+    PERF_CURRENT_LOOP,
+    PERF_POSITION_LOOP,
+    PERF_ADC,
+    PERF_TRAJECTORY,
+    PERF_PID,
+    PERF_IMU_READ,
+    PERF_PWM_DITHER,
+    PERF_NUMBER_OF_REGIONS
+} perf_region_t;
+
+/*Events of counter 0*/
+#define PERF0_CYCLES            0
+#define PERF0_INSTRUCTIONS      1
+#define PERF0_BRANCHES          2
+#define PERF0_ICACHE_ACCESSES   9
+#define PERF0_DCACHE_ACCESSES   10
+#define PERF0_STALLS            18
+/*Events of counter 1*/
+#define PERF1_CYCLES            0
+#define PERF1_INSTRUCTIONS      1
+#define PERF1_ICACHE_MISSES     9
+#define PERF1_DCACHE_WRITEBACKS 10
+#define PERF1_DCACHE_MISSES     11
+
+#define PERF_DEFAULT_EVENT0     PERF0_INSTRUCTIONS
+#define PERF_DEFAULT_EVENT1     PERF1_ICACHE_MISSES
+
+#ifdef PERF_PROFILING
+#define PERF_ENTER(id)  perf_enter(id)
+#define PERF_EXIT(id)   perf_exit(id)
+#else
+#define PERF_ENTER(id)
+#define PERF_EXIT(id)
+#endif
+
+/*Counts of a region, cycles are CPU cycles*/
+typedef struct
+{
+    uint32_t calls;
+    uint32_t max_cycles;
+    uint64_t cycles;
+    uint64_t events[2];         // counter 0 and counter 1
+} perf_counts_t;
+
+/*Methods for the counters
+ *******************************************************************
+ .................*/
+/*Set the events of the two counters, start them and reset the regions*/
+void perf_init(uint8_t event0, uint8_t event1);
+
+/*In RAM, the regions include code in RAM*/
+RAMFUNC void perf_enter(perf_region_t id);
+RAMFUNC void perf_exit(perf_region_t id);
+
+/*Clear the counts of all regions*/
+void perf_reset();
+
+/*Copy of the counts of a region*/
+void perf_get(perf_region_t id, perf_counts_t *counts);
+
+/*Write the counts per call of every region over UART1 and reset them*/
+void perf_report();
+
+/*Execute the payload of a 'p' frame from the host*/
+void perf_command(const uint8_t *payload, uint8_t length);
+
+#endif /* _PERF_H */
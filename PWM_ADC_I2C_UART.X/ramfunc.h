@@ -0,0 +1,69 @@
+/* ************************************************************************** */
+/** ramfunc.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+ramfunc.h
+
+@Summary
+ Placement of the hot code and its constant tables in RAM
+
+@Description
+ The flash runs with CLOCK_PFMWS wait states (clock_config.h); code that is not
+ * in the prefetch or instruction cache waits for it, so the latency of an ISR depends
+ * on what ran before it. RAM has no wait states.
+ * RAMFUNC puts a function in the .ramfunc section, which the startup code of XC32
+ * copies to RAM. Flash and RAM are more than 256MB apart, so calls between them can
+ * not use jal: a RAMFUNC is called with long calls (its prototype must carry RAMFUNC
+ * as well) and a RAMFUNC may only call other RAMFUNCs, inline functions, functions
+ * through pointers and FARCALL functions. A jal that does not reach is an error of the
+ * linker (relocation truncated to fit: R_MIPS_26), never a silent fault.
+ * The vector of an ISR stays in flash: the ISR is a short wrapper that calls its
+ * RAMFUNC body. RAMDATA keeps a const table in RAM instead of flash.
+ * Build with RAMFUNC_IN_FLASH defined to keep everything in flash, e.g. to compare the
+ * measurements of isr_profile.c; tools/ram_report.py lists what landed in RAM from
+ * the map file of a build. Define RAMFUNC_BENCHMARK to print the response time of the
+ * same kernel in flash and in RAM at boot (ramfunc_bench.c).
+ */
+/* ************************************************************************** */
+
+#ifndef _RAMFUNC_H    /* Guard against multiple inclusion */
+#define _RAMFUNC_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#if defined(_SIM_XC_H) || defined(RAMFUNC_IN_FLASH)
+#define RAMFUNC
+#define RAMDATA
+#define FARCALL
+#else
+#define RAMFUNC     __attribute__((ramfunc, long_call, noinline))
+#define RAMDATA     __attribute__((space(data)))
+#define FARCALL     __attribute__((long_call))      // in flash, called from a RAMFUNC
+#endif
+
+/*Response of the Timer7 ISR of the benchmark, Timer7 ticks (PBCLK3) from the match of PR7*/
+typedef struct
+{
+    const char *name;
+    uint32_t latency_min, latency_max;      // at the entry of the ISR
+    uint32_t response_min, response_max;    // at the end of the kernel, the jitter is max - min
+    uint32_t response_sum;
+} ramfunc_bench_t;
+
+#define RAMFUNC_BENCH_SAMPLES   1000    // interrupts per run
+#define RAMFUNC_BENCH_RUNS      4       // flash and RAM, each with a warm and a cold instruction cache
+
+/*Run the kernel from flash and from RAM in the Timer7 ISR (priority 6); with a cold cache
+ * the instruction cache is invalidated after every interrupt, which is the worst case*/
+void ramfunc_benchmark(ramfunc_bench_t result[RAMFUNC_BENCH_RUNS]);
+
+#endif /* _RAMFUNC_H */
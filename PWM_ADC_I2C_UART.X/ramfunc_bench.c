@@ -0,0 +1,121 @@
+/* ************************************************************************** */
+/** ramfunc_bench.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+ramfunc_bench.c
+
+@Summary
+ Response time of the same ISR kernel in flash and in RAM
+
+@Description
+ Peripherals used:
+ * Timer7 (free), interrupt at priority 6, and the L1 instruction cache
+ * The kernel is straight line code like the body of a control ISR, compiled twice
+ * from the same macro: once in flash and once as a RAMFUNC. The ISR reads TMR7 at its
+ * entry and after the kernel, so the times count from the match of PR7 and include
+ * the entry of the ISR. The vector and the entry stay in flash in both runs.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include "ramfunc.h"
+
+#define BENCH_PERIOD    20000       // PR7, Timer7 ticks between the interrupts
+#define ICACHE_SIZE     16384       // bytes of the instruction cache, 4 ways of 16 byte lines
+#define INDEX_INVALIDATE_I  0x00    // CACHE operation
+
+static volatile int32_t state[16];
+static volatile uint32_t samples;
+static volatile uint8_t run;
+static ramfunc_bench_t *current;
+
+/*16 multiply-accumulates with constants, unrolled like the code of a control ISR*/
+#define STEP(i, c)  acc += (int32_t)(((int64_t)state[i] * (c)) >> 31); state[i] = acc ^ x;
+#define KERNEL_BODY \
+    { \
+        int32_t acc = x; \
+        STEP(0, 0x1A2B3C4D) STEP(1, 0x2B3C4D5E) STEP(2, 0x3C4D5E6F) STEP(3, 0x4D5E6F70) \
+        STEP(4, 0x5E6F7081) STEP(5, 0x6F708192) STEP(6, 0x708192A3) STEP(7, 0x0192A3B4) \
+        STEP(8, 0x12A3B4C5) STEP(9, 0x23B4C5D6) STEP(10, 0x34C5D6E7) STEP(11, 0x45D6E7F8) \
+        STEP(12, 0x56E7F809) STEP(13, 0x67F8091A) STEP(14, 0x78091A2B) STEP(15, 0x091A2B3C) \
+        return acc; \
+    }
+
+static int32_t __attribute__((noinline)) kernel_flash(int32_t x) KERNEL_BODY
+static RAMFUNC int32_t kernel_ram(int32_t x) KERNEL_BODY
+
+//invalidate every line of the instruction cache, the index operations select way and set
+static void icache_invalidate()
+{
+    uint32_t address;
+
+    for(address = 0x80000000; address < 0x80000000 + ICACHE_SIZE; address += 16)
+        __asm__ volatile("cache %0, 0(%1)" : : "i"(INDEX_INVALIDATE_I), "r"(address) : "memory");
+    __asm__ volatile("sync; ehb" : : : "memory");
+}
+
+/*ISR for Timer7, the runs are 0: flash warm, 1: RAM warm, 2: flash cold, 3: RAM cold*/
+void __attribute__((vector(_TIMER_7_VECTOR), interrupt(ipl6srs), nomips16)) ramfunc_bench_isr()
+{
+    uint32_t entry = TMR7, end;
+
+    if(run & 1)
+        kernel_ram((int32_t)entry);
+    else
+        kernel_flash((int32_t)entry);
+    end = TMR7;
+    reg_clear(&IFS1, _IFS1_T7IF_MASK);
+
+    if(samples++)       // the first interrupt of a run warms the cache
+    {
+        if(entry < current->latency_min)
+            current->latency_min = entry;
+        if(entry > current->latency_max)
+            current->latency_max = entry;
+        if(end < current->response_min)
+            current->response_min = end;
+        if(end > current->response_max)
+            current->response_max = end;
+        current->response_sum += end;
+    }
+    if(run >= 2)
+        icache_invalidate();
+}
+
+void ramfunc_benchmark(ramfunc_bench_t result[RAMFUNC_BENCH_RUNS])
+{
+    static const char *const names[RAMFUNC_BENCH_RUNS] = {"flash, warm", "RAM, warm", "flash, cold", "RAM, cold"};
+    uint32_t status = __builtin_disable_interrupts();
+
+    T7CON = 0;              // prescaler 1, PBCLK3
+    PR7 = BENCH_PERIOD - 1;
+    IPC8bits.T7IP = 6;
+    IPC8bits.T7IS = 0;
+    for(run = 0; run < RAMFUNC_BENCH_RUNS; ++run)
+    {
+        current = &result[run];
+        current->name = names[run];
+        current->latency_min = current->response_min = UINT32_MAX;
+        current->latency_max = current->response_max = current->response_sum = 0;
+        samples = 0;
+        TMR7 = 0;
+        reg_clear(&IFS1, _IFS1_T7IF_MASK);
+        IEC1bits.T7IE = 1;
+        T7CONbits.ON = 1;
+        __builtin_enable_interrupts();
+        while(samples <= RAMFUNC_BENCH_SAMPLES);
+        __builtin_disable_interrupts();
+        T7CONbits.ON = 0;
+        IEC1bits.T7IE = 0;
+    }
+    __builtin_mtc0(12, 0, status);
+}
@@ -0,0 +1,58 @@
+/* ************************************************************************** */
+/** reg.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+reg.c
+
+@Summary
+ Cost of the bit field and the atomic register accesses of reg.h
+
+@Description
+ Peripherals used:
+ * Core timer, RD9 (the current loop pin of control.c), the flag of Timer7 (free)
+ * The four loops run with interrupts disabled; their counts include the loop itself,
+ * so the difference of two counts is the difference of the accesses.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include "reg.h"
+#include "systime.h"
+
+void reg_benchmark(uint32_t iterations, reg_bench_t *result)
+{
+    uint32_t i, start, status;
+
+    status = __builtin_disable_interrupts();
+
+    start = systime_count();
+    for(i = 0; i < iterations; ++i)
+        LATDbits.LATD9 ^= 1;
+    result->toggle_bitfield = systime_count() - start;
+
+    start = systime_count();
+    for(i = 0; i < iterations; ++i)
+        pin_toggle(REG_PIN(D, 9));
+    result->toggle_atomic = systime_count() - start;
+
+    start = systime_count();
+    for(i = 0; i < iterations; ++i)
+        IFS1bits.T7IF = 0;
+    result->clear_bitfield = systime_count() - start;
+
+    start = systime_count();
+    for(i = 0; i < iterations; ++i)
+        reg_clear(&IFS1, _IFS1_T7IF_MASK);
+    result->clear_atomic = systime_count() - start;
+
+    __builtin_mtc0(12, 0, status);  // restore the interrupt enable of before
+}
@@ -0,0 +1,89 @@
+/* ************************************************************************** */
+/** reg.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+reg.h
+
+@Summary
+ Atomic set, clear and invert of register bits and port pins
+
+@Description
+ Every SFR of the PIC32MZ is followed by its CLR, SET and INV registers at +4, +8
+ * and +12 bytes: a write of a mask to them clears, sets or inverts those bits of the
+ * register in one store. A bit field write (LATDbits.LATD9 ^= 1, IFS0bits.T2IF = 0)
+ * is a load, an insert and a store instead, and a bit changed by an interrupt or by
+ * the hardware between the load and the store is lost. The functions below are
+ * always inlined; with a constant register and mask they are a single sw.
+ * Use them for pins and for the bits that change at run time; the masks are the
+ * _<REG>_<BIT>_MASK constants of the device header.
+ * Host builds (sim/xc.h) have no CLR/SET/INV registers, there the functions are a
+ * plain read-modify-write of the register.
+ * Define REG_BENCHMARK to print the cycles of the bit field and the atomic forms at boot.
+ */
+/* ************************************************************************** */
+
+#ifndef _REG_H    /* Guard against multiple inclusion */
+#define _REG_H
+
+#include <xc.h>
+#include <stdint.h>
+
+#define REG_INLINE      static inline __attribute__((always_inline))
+
+/*A port pin, its bit in LATx*/
+typedef struct
+{
+    volatile uint32_t *lat;
+    uint32_t mask;
+} reg_pin_t;
+
+#define REG_PIN(port, bit)  ((reg_pin_t){&LAT##port, 1u << (bit)})   // e.g. REG_PIN(D, 9) for RD9
+
+/*Methods for the registers
+ *******************************************************************
+ .................*/
+#ifdef _SIM_XC_H
+REG_INLINE void reg_clear(volatile uint32_t *reg, uint32_t mask)    { *reg &= ~mask; }
+REG_INLINE void reg_set(volatile uint32_t *reg, uint32_t mask)      { *reg |= mask; }
+REG_INLINE void reg_invert(volatile uint32_t *reg, uint32_t mask)   { *reg ^= mask; }
+#else
+REG_INLINE void reg_clear(volatile uint32_t *reg, uint32_t mask)    { reg[1] = mask; }   // REGCLR
+REG_INLINE void reg_set(volatile uint32_t *reg, uint32_t mask)      { reg[2] = mask; }   // REGSET
+REG_INLINE void reg_invert(volatile uint32_t *reg, uint32_t mask)   { reg[3] = mask; }   // REGINV
+#endif
+
+/*Set the bits of mask to value (0 or 1), one store for a constant value*/
+REG_INLINE void reg_write_bits(volatile uint32_t *reg, uint32_t mask, uint8_t value)
+{
+    if(value)
+        reg_set(reg, mask);
+    else
+        reg_clear(reg, mask);
+}
+
+/*Methods for the pins
+ *******************************************************************
+ .................*/
+REG_INLINE void pin_set(reg_pin_t pin)      { reg_set(pin.lat, pin.mask); }
+REG_INLINE void pin_clear(reg_pin_t pin)    { reg_clear(pin.lat, pin.mask); }
+REG_INLINE void pin_toggle(reg_pin_t pin)   { reg_invert(pin.lat, pin.mask); }
+
+/*Core timer counts of iterations of a bit field toggle of RD9 and of pin_toggle(), a
+ * bit field clear of the Timer7 flag and of reg_clear(); cycles = 2 * counts*/
+typedef struct
+{
+    uint32_t toggle_bitfield, toggle_atomic;
+    uint32_t clear_bitfield, clear_atomic;
+} reg_bench_t;
+
+void reg_benchmark(uint32_t iterations, reg_bench_t *result);
+
+#endif /* _REG_H */
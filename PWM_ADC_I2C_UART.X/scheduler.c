@@ -0,0 +1,209 @@
+/* ************************************************************************** */
+/** scheduler.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+scheduler.c
+
+@Summary
+ Peripherals used:
+  * Timer6 - scheduler tick
+
+@Description
+ The tasks run in the Timer6 ISR at priority 3. Interrupts of a higher priority
+ * (Input Capture of the encoders) still preempt the tasks, the tasks do not preempt
+ * each other. Times are measured with the core timer (systime.h).
+ * The position loop waits for its I2C transfers, it runs on core software interrupt 0
+ * at priority 1 (defer.c), below the tick, and may take several ticks.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include "header.h"
+#include <proc/p32mz2048efm100.h>
+#include "scheduler.h"
+#include "hal.h"
+#include "systime.h"
+#include "control.h"
+#include "UART.h"
+#include "isr_profile.h"
+#include "defer.h"
+#include "ramfunc.h"
+
+/*Task table
+ * The position loop runs in tick 1 of 10 and the telemetry in tick 5 of 20, so
+ * neither shares a tick with the other and the current loop always runs first.
+ * The position loop is deferred, it has to finish before its next run.
+ * systime counts the wraps of the core timer once a second, in a tick of its own.*/
+static const sched_task_t RAMDATA tasks[] =
+{
+    //name        function                period  offset  priority  deadline(us)  defer
+    {"current",   current_control_task,   1,      0,      0,        250,          DEFER_NONE},
+    {"position",  position_control_task,  10,     1,      1,        9000,         DEFER_CS0},
+    {"telemetry", telemetry_task,         20,     5,      2,        900,          DEFER_NONE},
+    {"systime",   systime_task,           1000,   7,      3,        900,          DEFER_NONE},
+};
+#define NUMBER_OF_TASKS (sizeof(tasks) / sizeof(tasks[0]))
+
+CLOCK_ASSERT_TIMER(SCHED_TICK_FREQ, SCHED_TICK_PRESCALER, 100);   // the tick is exact to 100ppm
+
+volatile sched_stats_t sched_stats[NUMBER_OF_TASKS];
+volatile uint32_t sched_ticks = 0, sched_tick_overruns = 0;
+static uint8_t order[NUMBER_OF_TASKS];     // task indexes by priority
+static volatile uint8_t RAMDATA pending[NUMBER_OF_TASKS];     // deferred task posted and not finished
+static volatile uint32_t RAMDATA posted_tick[NUMBER_OF_TASKS];   // start of the tick that posted it
+
+
+/*Function to setup the tick and the order of the tasks*/
+void scheduler_init()
+{
+    uint8_t i, j, task;
+
+    /*sort the tasks by priority*/
+    for(i = 0; i < NUMBER_OF_TASKS; ++i)
+    {
+        task = i;
+        for(j = i; j > 0 && tasks[order[j - 1]].priority > tasks[task].priority; --j)
+            order[j] = order[j - 1];
+        order[j] = task;
+    }
+    scheduler_reset_stats();
+
+    //Initialize timer6 for the tick
+    T6CON   = 0x0;      // Disable timer 6 when setting it up
+    TMR6    = 0;        // Set timer 6 counter to 0
+    IEC0bits.T6IE = 0;  // Disable Timer 6 Interrupt
+
+    T6CONbits.TCKPS=CLOCK_TCKPS(SCHED_TICK_PRESCALER);
+    PR6=SCHED_TICK_PR;//for a tick of SCHED_TICK_FREQ
+
+    reg_clear(&IFS0, _IFS0_T6IF_MASK);  // Clear interrupt flag for timer 6
+    IPC7bits.T6IP = 3;  // Interrupt priority 3
+    IPC7bits.T6IS = 1;  // Sub-priority 1
+    IEC0bits.T6IE = 1;  // Enable Timer 6 Interrupt
+
+    T6CONbits.TON   = 1;//Turn on Timer6
+}
+
+uint8_t scheduler_task_count()
+{
+    return NUMBER_OF_TASKS;
+}
+
+const sched_task_t *scheduler_task(uint8_t task)
+{
+    return &tasks[task];
+}
+
+/*Function to clear the measurements*/
+void scheduler_reset_stats()
+{
+    uint8_t i;
+    for(i = 0; i < NUMBER_OF_TASKS; ++i)
+    {
+        sched_stats[i].runs = 0;
+        sched_stats[i].deadline_misses = 0;
+        sched_stats[i].last_counts = 0;
+        sched_stats[i].wcet_counts = 0;
+        pending[i] = 0;
+    }
+    sched_tick_overruns = 0;
+}
+
+/*Function to send the measurements over UART1*/
+void scheduler_report()
+{
+    char msg[100];
+    uint8_t i;
+
+    sprintf(msg, "ticks %lu, tick overruns %lu\r\n", (unsigned long)sched_ticks, (unsigned long)sched_tick_overruns);
+    WriteUART(msg);
+    for(i = 0; i < NUMBER_OF_TASKS; ++i)
+    {
+        sprintf(msg, "%-10s runs %lu, last %lu us, wcet %lu us, deadline misses %lu\r\n", tasks[i].name,
+                (unsigned long)sched_stats[i].runs,
+                (unsigned long)(sched_stats[i].last_counts / SCHED_COUNTS_PER_US),
+                (unsigned long)(sched_stats[i].wcet_counts / SCHED_COUNTS_PER_US),
+                (unsigned long)sched_stats[i].deadline_misses);
+        WriteUART(msg);
+    }
+}
+
+
+/*Function to measure a run of a task*/
+static RAMFUNC void scheduler_account(uint8_t task, uint32_t tick_start, uint32_t start, uint32_t end)
+{
+    sched_stats[task].last_counts = end - start;
+    if(end - start > sched_stats[task].wcet_counts)
+        sched_stats[task].wcet_counts = end - start;
+    if(end - tick_start > (uint32_t)tasks[task].deadline_us * SCHED_COUNTS_PER_US)
+        ++sched_stats[task].deadline_misses;
+    ++sched_stats[task].runs;
+}
+
+/*Work item of a deferred task, runs on its software interrupt*/
+static void scheduler_run_deferred(void *arg)
+{
+    uint8_t task = (uint8_t)(uintptr_t)arg;
+    uint32_t start = systime_count();
+
+    tasks[task].run();
+    scheduler_account(task, posted_tick[task], start, systime_count());
+    pending[task] = 0;
+}
+
+/*Function to run the tasks that are due in this tick*/
+static RAMFUNC void scheduler_dispatch(uint32_t tick_start)
+{
+    uint32_t tick = sched_ticks;
+    uint32_t start, end;
+    uint8_t i, task;
+
+    hal_timer6_clear_flag();  // Clear interrupt flag for timer 6, it is set again if the tasks take longer than a tick
+
+    for(i = 0; i < NUMBER_OF_TASKS; ++i)
+    {
+        task = order[i];
+        if(tick < tasks[task].offset || (tick - tasks[task].offset) % tasks[task].period)
+            continue;
+        if(tasks[task].defer != DEFER_NONE)
+        {
+            if(pending[task])
+                ++sched_stats[task].deadline_misses;    // the last run is not finished, skip this one
+            else
+            {
+                pending[task] = 1;
+                posted_tick[task] = tick_start;
+                if(!defer_post(tasks[task].defer, scheduler_run_deferred, (void *)(uintptr_t)task))
+                    pending[task] = 0;                  // queue full, counted by defer.c
+            }
+            continue;
+        }
+        start = systime_count();
+        tasks[task].run();
+        end = systime_count();
+        scheduler_account(task, tick_start, start, end);
+    }
+
+    if(hal_timer6_flag())
+        ++sched_tick_overruns;  // the next tick is already due
+    sched_ticks = tick + 1;
+}
+
+/*ISR for Timer6, the vector stays in flash and calls the dispatch in RAM*/
+void __attribute__((vector(_TIMER_6_VECTOR), interrupt(ipl3srs), nomips16)) scheduler_tick()
+{
+    uint32_t tick_start = systime_count();
+
+    ISR_PROFILE_ENTER(ISR_ID_SCHEDULER_TICK);
+    scheduler_dispatch(tick_start);
+    ISR_PROFILE_EXIT(ISR_ID_SCHEDULER_TICK);
+}
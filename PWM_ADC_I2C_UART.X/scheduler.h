@@ -0,0 +1,88 @@
+/* ************************************************************************** */
+/** scheduler.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+scheduler.h
+
+@Summary
+ Time triggered cooperative scheduler for the control loops and the telemetry
+
+@Description
+ Timer6 generates a tick of SCHED_TICK_FREQ. On every tick the tasks that are due
+ * are run to completion in the Timer6 ISR, in order of priority. A task is due when
+ * (tick - offset) is a multiple of its period, the offsets keep tasks with a longer
+ * period out of the same tick. For every task the execution time and the worst case
+ * execution time are recorded, and a run that finishes later than its deadline
+ * (measured from the tick) is counted. A tick that starts while the tasks of the
+ * previous tick are still running is counted as a tick overrun.
+ * A task with a level of defer.h in the table is posted to that core software
+ * interrupt instead, so the tick stays short and the current loop is not delayed by
+ * it; its execution time then includes the ISRs that preempt it. A deferred task that
+ * is due while its last run has not finished is skipped and counted as a deadline miss.
+ * The task table is in scheduler.c. Timer7 is only used by the benchmarks at boot,
+ * Timer8 samples the program counter when PC_SAMPLING is defined (pc_sample.c).
+ */
+/* ************************************************************************** */
+
+#ifndef _SCHEDULER_H    /* Guard against multiple inclusion */
+#define _SCHEDULER_H
+
+#include <stdint.h>
+
+#define SCHED_TICK_FREQ 1000        // Hz
+/*Timer6 runs from PBCLK3 with the smallest prescaler that fits the tick (clock_config.h)*/
+#define SCHED_TICK_PRESCALER    CLOCK_TIMER_PRESCALER(SCHED_TICK_FREQ)
+#define SCHED_TICK_PR           CLOCK_TIMER_PR(SCHED_TICK_FREQ, SCHED_TICK_PRESCALER)
+
+/*Times are measured in core timer counts (systime.h), conversion to us*/
+#define SCHED_COUNTS_PER_US SYSTIME_TICKS_PER_US
+
+/*A task of the table*/
+typedef struct
+{
+    const char *name;
+    void (*run)(void);
+    uint16_t period;            // ticks between runs
+    uint16_t offset;            // tick of the first run, 0 ... period-1
+    uint8_t priority;           // tasks due in the same tick run in order of priority, 0 first
+    uint16_t deadline_us;       // latest end of a run after the start of the tick
+    uint8_t defer;              // DEFER_CS0/CS1 to run it on a software interrupt, DEFER_NONE in the tick
+} sched_task_t;
+
+/*Measurements of a task*/
+typedef struct
+{
+    uint32_t runs;
+    uint32_t deadline_misses;
+    uint32_t last_counts;       // execution time of the last run in core timer counts
+    uint32_t wcet_counts;       // worst case execution time in core timer counts
+} sched_stats_t;
+
+extern volatile sched_stats_t sched_stats[];
+extern volatile uint32_t sched_ticks, sched_tick_overruns;
+
+/*Methods for the scheduler
+ *******************************************************************
+ .................*/
+/*Setup Timer6 for the tick and sort the tasks by priority, the tasks run once interrupts are enabled*/
+void scheduler_init();
+
+/*Number of tasks in the table and a task of it*/
+uint8_t scheduler_task_count();
+const sched_task_t *scheduler_task(uint8_t task);
+
+/*Clear the measurements of all tasks*/
+void scheduler_reset_stats();
+
+/*Write the measurements of all tasks over UART1*/
+void scheduler_report();
+
+#endif /* _SCHEDULER_H */
@@ -0,0 +1,231 @@
+/* ************************************************************************** */
+/** encoder_check.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ encoder_check.c
+
+  @Summary
+ Host check of the decoding of the PWM output of the AS5600L encoders
+
+  @Description
+ Selects ENCODER_SOURCE_PWM with encoderSetSource() on the AS5600L models and feeds
+ * the edges of their PWM output to the Input Capture model (sim_regs.c), timestamped
+ * with Timer3, then runs the capture ISR of the joint. The angle of every frame is
+ * different, so edges paired with the wrong frame give a wrong angle. Checked:
+ *  0. encoderSetSource() changes only PWMF and OUTS of CONF_L
+ *  1. Every edge: the ISR runs after each edge, at the nominal 920Hz and at the
+ *     tolerance of the oscillator of the encoder
+ *  2. Queued edges: the ISR runs late, after 2, 3 and 4 edges
+ *  3. Overflow: now and then the ISR runs after 6 edges, the buffer overflows
+ *  4. Lost edge: a falling edge is not captured
+ *  5. Start while the output is high
+ * The angle of the encoder has to be that of the last complete frame within 1 LSB
+ * while the edges are in step. After an overflow or a lost edge no wrong angle may
+ * be returned and the decoding has to be back within 3 frames of the run of the ISR
+ * that found the edges out of step.
+ *
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -O2 -Isim -I. -o encoder_check sim/encoder_check.c sim/sim_regs.c sim/sim_i2c.c
+ *     sim/sim_as5600l.c AS5600L.c I2C.c -lm && ./encoder_check
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <xc.h>
+#include "header.h"
+#include "I2C.h"
+#include "AS5600L.h"
+#include "sim_i2c.h"
+#include "sim_as5600l.h"
+
+#define SIM_FRAMES      200     // frames per check
+#define SIM_RECOVERY    3       // frames after which the decoding is back
+#define SIM_OVERFLOW    20      // runs of the ISR between two overflows
+#define SIM_CONF_L      0b01011101  // analog output, hysteresis and power mode set
+#define TIMER3_FREQ     ((double)CLOCK_TIMER_FREQ(ENCODER_CAPTURE_PRESCALER))
+
+/*Globals of main.c used by the drivers*/
+volatile uint8_t flag_ankle_IMU=0,flag_ankle_encoder=0,flag_ankle_current=0,flag_print=0;
+volatile uint16_t ADC1=0,ADC2=0,ADC3=0;
+volatile int16_t accelX=0,accelY=0,accelZ=0;
+volatile int16_t gyroX=0,gyroY=0,gyroZ=0;
+
+void knee_encoder_capture();
+void ankle_encoder_capture();
+
+/*PWM output of an encoder*/
+typedef struct
+{
+    sim_as5600l_t enc;
+    uint8_t joint;
+    double frequency;           // of the oscillator of the encoder, 920Hz nominal
+    double frame_frequency;     // of the frame being sent, a new frequency starts with a frame
+    double time;                // Timer3 ticks of the next edge
+    uint8_t level;              // of the output
+    uint32_t frame;             // frames started
+    int32_t complete;           // angle of the last complete frame, -1 before the first
+    uint16_t angle;             // angle of the frame being sent
+    uint8_t decoding;           // an angle has been decoded
+} output_t;
+
+static output_t output[NUMBER_OF_JOINTS];
+static int failures = 0;
+
+//a different angle for every frame, far from the previous one
+static uint16_t frame_angle(uint32_t frame)
+{
+    return (frame * 1499 + 17) % 4096;
+}
+
+static void set_pin(output_t *out)
+{
+    if(out->joint == KNEE_JOINT)
+        PORTDbits.RD0 = out->level;
+    else
+        PORTBbits.RB8 = out->level;
+}
+
+/*Next edge of the output, captured unless lost*/
+static void edge(output_t *out, uint8_t lost)
+{
+    double period;
+
+    out->level = !out->level;
+    if(out->level)
+    {
+        out->frame_frequency = out->frequency;
+        if(out->frame)
+            out->complete = out->angle;
+        out->angle = frame_angle(out->frame++);
+        sim_as5600l_set_angle(&out->enc, out->angle);
+    }
+    period = TIMER3_FREQ / out->frame_frequency;
+    set_pin(out);
+    if(!lost)
+        sim_ic_capture(out->joint, (uint16_t)(uint32_t)llround(out->time), out->level);
+    if(out->level)
+        out->time += period * sim_as5600l_pwm_high_clocks(&out->enc) / ENCODER_PWM_FRAME_CLOCKS;
+    else
+        out->time += period * (ENCODER_PWM_FRAME_CLOCKS - sim_as5600l_pwm_high_clocks(&out->enc)) /
+                     ENCODER_PWM_FRAME_CLOCKS;
+}
+
+static void isr(output_t *out)
+{
+    if(out->joint == KNEE_JOINT)
+        knee_encoder_capture();
+    else
+        ankle_encoder_capture();
+}
+
+static uint16_t angle(output_t *out)
+{
+    uint16_t value;
+    encoderGetAngle(out->joint, &value);
+    return value;
+}
+
+//the angle of a frame that was sent, within 1 LSB
+static uint8_t sent(uint16_t value, uint32_t frames)
+{
+    uint32_t i;
+
+    for(i = 0; i < frames; ++i)
+        if(abs((int)value - frame_angle(i)) <= 1)
+            return 1;
+    return 0;
+}
+
+/*Runs the ISR after every late-th edge, after 6 edges every SIM_OVERFLOW-th run if
+ * overflow is set, and every lost-th frame loses its falling edge.
+ * Counted are the angles that were never sent and the longest time in frames the angle
+ * was not that of the last complete frame after the run of the ISR that found it old,
+ * from the first frame that was decoded*/
+static void check(const char *name, output_t *out, double frequency, uint8_t late, uint8_t overflow,
+                  uint32_t lost)
+{
+    uint32_t wrong = 0, old = 0, longest = 0, n, allowed = lost || overflow ? SIM_RECOVERY : 0;
+    uint8_t i, edges, stale = 0;
+    uint16_t value;
+
+    out->frequency = frequency;
+    for(n = 0; n < SIM_FRAMES; ++n)
+    {
+        edges = overflow && n % SIM_OVERFLOW == SIM_OVERFLOW - 1 ? 6 : late;
+        for(i = 0; i < edges; ++i)
+            edge(out, lost && out->level && out->frame % lost == 0);
+        isr(out);
+        value = angle(out);
+        if(out->complete >= 0 && abs((int)value - out->complete) <= 1)
+        {
+            out->decoding = 1;
+            old = stale = 0;
+        }
+        else if(out->decoding)
+        {
+            wrong += !sent(value, out->frame);
+            old += stale ? edges : 0;   // from the run that found the edges out of step
+            stale = 1;
+            if(old > longest)
+                longest = old;
+        }
+    }
+    longest /= 2;
+    printf("  %-26s %4.0f Hz  wrong angles %u, frames with an old angle %u  %s\n", name, frequency, wrong,
+           longest, wrong || longest > allowed || !out->decoding ? "FAIL" : "ok");
+    failures += wrong || longest > allowed || !out->decoding;
+}
+
+int main()
+{
+    uint8_t i;
+
+    sim_i2c_reset();
+    for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+    {
+        output[i].joint = i;
+        output[i].complete = -1;
+        sim_as5600l_init(&output[i].enc, i == KNEE_JOINT ? KNEE_ENCODER_ADDRESS : ANKLE_ENCODER_ADDRESS);
+    }
+    I2C_init(400000);
+
+    /*5. the output is high when the capture starts, its falling edge is not captured*/
+    output[KNEE_JOINT].level = 1;
+    set_pin(&output[KNEE_JOINT]);
+    output[KNEE_JOINT].frame = 1;
+    output[KNEE_JOINT].angle = frame_angle(0);
+    sim_as5600l_set_angle(&output[KNEE_JOINT].enc, output[KNEE_JOINT].angle);
+    output[KNEE_JOINT].frame_frequency = 920;
+    output[KNEE_JOINT].time = 12345;
+    for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+    {
+        output[i].enc.reg[ENCODER_CONF_L_REG] = SIM_CONF_L;
+        encoderSetSource(i, ENCODER_SOURCE_PWM);
+        if(output[i].enc.reg[ENCODER_CONF_L_REG] != ((SIM_CONF_L & ~ENCODER_CONF_L_OUTPUT_MASK) | ENCODER_CONF_L_PWM_920HZ))
+        {
+            printf("encoderSetSource: CONF_L %02X FAIL\n", output[i].enc.reg[ENCODER_CONF_L_REG]);
+            ++failures;
+        }
+    }
+
+    printf("PWM output of the AS5600L, Timer3 at %.0f Hz:\n", TIMER3_FREQ);
+    check("knee, every edge", &output[KNEE_JOINT], 920, 1, 0, 0);
+    check("knee, every edge", &output[KNEE_JOINT], ENCODER_PWM_FREQ_MIN, 1, 0, 0);
+    check("knee, every edge", &output[KNEE_JOINT], 1040, 1, 0, 0);
+    check("knee, 2 edges queued", &output[KNEE_JOINT], 920, 2, 0, 0);
+    check("knee, 3 edges queued", &output[KNEE_JOINT], 920, 3, 0, 0);
+    check("knee, 4 edges queued", &output[KNEE_JOINT], 920, 4, 0, 0);
+    check("knee, overflow", &output[KNEE_JOINT], 920, 1, 1, 0);
+    check("knee, overflow, 3 queued", &output[KNEE_JOINT], 920, 3, 1, 0);
+    check("knee, lost falling edge", &output[KNEE_JOINT], 920, 1, 0, 7);
+    check("knee, lost edge, 3 queued", &output[KNEE_JOINT], 920, 3, 0, 7);
+    check("ankle, every edge", &output[ANKLE_JOINT], 920, 1, 0, 0);
+    check("ankle, 3 edges queued", &output[ANKLE_JOINT], 920, 3, 0, 0);
+    check("ankle, overflow", &output[ANKLE_JOINT], 920, 2, 1, 0);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,280 @@
+/* ************************************************************************** */
+/** hal_check.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ hal_check.c
+
+  @Summary
+ Host checks of the driver logic through the mock back end of hal.h
+
+  @Description
+ The drivers are compiled with HAL_MOCK, so their peripheral accesses are recorded
+ * and the values they poll can be scripted (sim/hal_mock.h):
+ * 1. UART: frames fed byte by byte to the RX interrupt, setpoints reach the stream,
+ *    other frames the main loop queue, a wrong checksum and an overrun are counted;
+ *    WriteUART waits while the transmit buffer is full.
+ * 2. I2C: the sequence of an encoder read against the AS5600L model, and a device
+ *    that does not acknowledge at once.
+ * 3. ADC: getADC waits for each result and returns the injected conversions.
+ * 4. PWM: the mean of the compare values written by the dithering interrupt is the
+ *    16 bit duty cycle, counted with the hook of the mock.
+ * 5. Cost: time of the RX interrupt per byte on the PC, with the recording.
+ *
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -O2 -DHAL_MOCK -Isim -I. -o hal_check sim/hal_check.c sim/hal_mock.c sim/sim_regs.c
+ *     sim/sim_i2c.c sim/sim_as5600l.c sim/sim_mpu9250.c sim/sim_adc.c UART.c stream.c I2C.c AS5600L.c
+ *     ADC.c PWM.c -lm && ./hal_check
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xc.h>
+#include "header.h"
+#include "hal.h"
+#include "UART.h"
+#include "stream.h"
+#include "I2C.h"
+#include "AS5600L.h"
+#include "PWM.h"
+#include "ADC.h"
+#include "hal_mock.h"
+#include "sim_i2c.h"
+#include "sim_as5600l.h"
+
+/*Globals of main.c used by the drivers*/
+volatile uint8_t flag_ankle_IMU=0,flag_ankle_encoder=0,flag_ankle_current=0,flag_print=0;
+volatile uint16_t ADC1=0,ADC2=0,ADC3=0;
+volatile int16_t accelX=0,accelY=0,accelZ=0;
+volatile int16_t gyroX=0,gyroY=0,gyroZ=0;
+volatile int16_t data_buf[BUFLEN];
+volatile int16_t read = 0, write = 0;
+volatile uint8_t start = 0;
+
+void UART_rx_isr();
+void PWM_dither_isr();
+
+static int failures = 0;
+
+static void result(const char *name, int ok, const char *detail)
+{
+    printf("  %-28s %s%s%s\n", name, ok ? "ok" : "FAIL", *detail ? "  " : "", detail);
+    failures += !ok;
+}
+
+//queue a frame for the RX interrupt, the checksum is wrong if spoil is set
+static void inject_frame(uint8_t command, const uint8_t *payload, uint8_t length, uint8_t spoil)
+{
+    uint8_t i, sum = command + length;
+
+    hal_mock_inject(HAL_UART_RX_AVAILABLE, 0, 1);
+    hal_mock_inject(HAL_UART_READ, 0, command);
+    hal_mock_inject(HAL_UART_RX_AVAILABLE, 0, 1);
+    hal_mock_inject(HAL_UART_READ, 0, length);
+    for(i = 0; i < length; ++i)
+    {
+        sum += payload[i];
+        hal_mock_inject(HAL_UART_RX_AVAILABLE, 0, 1);
+        hal_mock_inject(HAL_UART_READ, 0, payload[i]);
+    }
+    hal_mock_inject(HAL_UART_RX_AVAILABLE, 0, 1);
+    hal_mock_inject(HAL_UART_READ, 0, sum + spoil);
+}
+
+//accesses of an id since access number from, the values in order
+static uint32_t values_of(hal_access_id_t id, uint32_t from, uint32_t *values, uint32_t max)
+{
+    const hal_access_t *access;
+    uint32_t count = 0;
+
+    for(; from < hal_mock_count; ++from)
+        if((access = hal_mock_access(from)) && access->id == id && count < max)
+            values[count++] = access->value;
+    return count;
+}
+
+
+/*1. UART*/
+static void check_uart(void)
+{
+    static const uint8_t setpoints[] = {0x00, 0x10, 0x00, 0xF0}, query[] = {'Q'};
+    uart_frame_t frame;
+    uint32_t errors, from, written[16], n;
+    uint16_t level;
+    char detail[80];
+    const char *text = "OK\r\n";
+
+    stream_init(STREAM_POLICY_DEFAULT);
+    hal_mock_reset();
+    level = stream_level();
+    inject_frame('P', setpoints, sizeof(setpoints), 0);
+    inject_frame('A', query, sizeof(query), 0);
+    UART_rx_isr();
+    sprintf(detail, "%u setpoint, frame '%c'", stream_level() - level, UART_get_frame(&frame) ? frame.command : '-');
+    result("UART frames", stream_level() == level + 1 && frame.command == 'A' && frame.length == 1 &&
+           frame.payload[0] == 'Q' && !UART_get_frame(&frame) &&
+           hal_mock_count_of(HAL_UART_CLEAR_RX_FLAG, 0) == 1, detail);
+
+    errors = uart_frame_errors;
+    inject_frame('A', query, sizeof(query), 1);
+    UART_rx_isr();
+    hal_mock_inject(HAL_UART_OVERRUN, 0, 1);
+    UART_rx_isr();
+    sprintf(detail, "%lu errors", (unsigned long)(uart_frame_errors - errors));
+    result("UART checksum and overrun", uart_frame_errors == errors + 2 && !UART_get_frame(&frame) &&
+           hal_mock_count_of(HAL_UART_CLEAR_OVERRUN, 0) == 1, detail);
+
+    from = hal_mock_count;
+    hal_mock_inject(HAL_UART_TX_FULL, 0, 1);
+    hal_mock_inject(HAL_UART_TX_FULL, 0, 1);
+    WriteUART(text);
+    n = values_of(HAL_UART_WRITE, from, written, 16);
+    sprintf(detail, "%lu polls for %lu bytes", (unsigned long)hal_mock_count_of(HAL_UART_TX_FULL, from), (unsigned long)n);
+    result("UART transmit", n == strlen(text) && written[0] == 'O' && written[3] == '\n' &&
+           hal_mock_count_of(HAL_UART_TX_FULL, from) == strlen(text) + 2, detail);
+}
+
+/*2. I2C*/
+static void check_i2c(void)
+{
+    static const hal_access_id_t sequence[] = {HAL_I2C_START, HAL_I2C_WRITE, HAL_I2C_WRITE, HAL_I2C_RESTART,
+        HAL_I2C_WRITE, HAL_I2C_RECEIVE, HAL_I2C_READ, HAL_I2C_ACKNOWLEDGE, HAL_I2C_RECEIVE, HAL_I2C_READ,
+        HAL_I2C_ACKNOWLEDGE, HAL_I2C_STOP};
+    static sim_as5600l_t encoder;
+    const hal_access_t *access;
+    uint32_t n, k = 0, wrong = 0, writes[3], from;
+    uint16_t angle;
+    char detail[80];
+
+    sim_i2c_reset();
+    sim_as5600l_init(&encoder, KNEE_ENCODER_ADDRESS);
+    sim_as5600l_set_angle(&encoder, 1234);
+    I2C_init(400000);
+    hal_mock_reset();
+    encoderRead(KNEE_ENCODER_ADDRESS, ENCODER_ANGLE_REG, &angle);
+
+    /*the conditions and bytes in order, the polls in between are left out*/
+    for(n = 0; n < hal_mock_count; ++n)
+    {
+        access = hal_mock_access(n);
+        if(access->id == HAL_I2C_START || access->id == HAL_I2C_RESTART || access->id == HAL_I2C_STOP ||
+           access->id == HAL_I2C_WRITE || access->id == HAL_I2C_RECEIVE || access->id == HAL_I2C_READ ||
+           access->id == HAL_I2C_ACKNOWLEDGE)
+            wrong += k >= sizeof(sequence) / sizeof(sequence[0]) || access->id != sequence[k++];
+    }
+    values_of(HAL_I2C_WRITE, 0, writes, 3);
+    wrong += k != sizeof(sequence) / sizeof(sequence[0]) || writes[0] != KNEE_ENCODER_ADDRESS << 1 ||
+             writes[1] != ENCODER_ANGLE_REG || writes[2] != (KNEE_ENCODER_ADDRESS << 1 | 1);
+    sprintf(detail, "angle %u, %lu accesses, %.1f us", angle, (unsigned long)hal_mock_count,
+            (hal_mock_access(hal_mock_count - 1)->time_ns - hal_mock_access(0)->time_ns) / 1e3);
+    result("I2C encoder read", !wrong && angle == sim_as5600l_angle(&encoder) && !sim_i2c_stats.errors, detail);
+
+    /*the ACK of the address comes after three polls*/
+    from = hal_mock_count;
+    hal_mock_inject(HAL_I2C_NACKED, 0, 1);
+    hal_mock_inject(HAL_I2C_NACKED, 0, 1);
+    hal_mock_inject(HAL_I2C_NACKED, 0, 1);
+    I2C_start();
+    I2C_write(KNEE_ENCODER_ADDRESS << 1, 1);
+    I2C_stop();
+    sprintf(detail, "%lu polls of ACKSTAT", (unsigned long)hal_mock_count_of(HAL_I2C_NACKED, from));
+    result("I2C late acknowledge", hal_mock_count_of(HAL_I2C_NACKED, from) == 4, detail);
+}
+
+/*3. ADC*/
+static void check_adc(void)
+{
+    uint16_t a, b, c;
+    char detail[80];
+
+    hal_mock_reset();
+    hal_mock_inject(HAL_ADC_READY, 2, 0);
+    hal_mock_inject(HAL_ADC_READY, 2, 0);
+    hal_mock_inject(HAL_ADC_READY, 2, 1);
+    hal_mock_inject(HAL_ADC_READY, 3, 1);
+    hal_mock_inject(HAL_ADC_READY, 4, 1);
+    hal_mock_inject(HAL_ADC_RESULT, 2, 100);
+    hal_mock_inject(HAL_ADC_RESULT, 3, 2000);
+    hal_mock_inject(HAL_ADC_RESULT, 4, 4095);
+    getADC(&a, &b, &c);
+    sprintf(detail, "%u %u %u after %lu polls", a, b, c, (unsigned long)hal_mock_count_of(HAL_ADC_READY, 0));
+    result("ADC conversions", a == 100 && b == 2000 && c == 4095 && hal_mock_count_of(HAL_ADC_TRIGGER, 0) == 1 &&
+           hal_mock_count_of(HAL_ADC_READY, 0) == 5, detail);
+}
+
+/*4. PWM*/
+static uint64_t compare_sum;
+static uint32_t compare_count, clear_count;
+
+static void sum_compares(const hal_access_t *access)
+{
+    clear_count += access->id == HAL_TIMER2_CLEAR_FLAG;
+    if(access->id == HAL_OC_WRITE && access->index == 1)
+    {
+        compare_sum += access->value;
+        ++compare_count;
+    }
+}
+
+static void check_pwm(void)
+{
+    uint16_t duty = 0x4567;
+    uint32_t n;
+    double mean, expected;
+    char detail[80];
+
+    T2CON = 0;
+    PWM_init(PWM_FREQUENCY, PWM_RESOLUTION);
+    PWM_set_dither(PWM_CHANNEL_M1, 1);
+    PWM_set_duty16(PWM_CHANNEL_M1, duty);
+    hal_mock_reset();
+    compare_sum = compare_count = clear_count = 0;
+    hal_mock_hook = sum_compares;
+    for(n = 0; n < 65536; ++n)
+        PWM_dither_isr();
+    hal_mock_hook = 0;
+    mean = (double)compare_sum / compare_count;
+    expected = (double)duty * PWM_period() / 65536;
+    sprintf(detail, "mean %.5f, duty %.5f counts", mean, expected);
+    result("PWM dither", compare_count == 65536 && mean - expected < 1e-6 && expected - mean < 1e-6 &&
+           clear_count == 65536, detail);
+}
+
+/*5. cost*/
+static void check_cost(void)
+{
+    uint8_t payload[UART_FRAME_MAX];
+    uart_frame_t frame;
+    struct timespec t0, t1;
+    uint32_t k;
+    double ns = 0;
+
+    memset(payload, 0x5A, sizeof(payload));
+    for(k = 0; k < 1000; ++k)
+    {
+        hal_mock_reset();
+        inject_frame('W', payload, 60, 0);     // below HAL_MOCK_INJECTED
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        UART_rx_isr();
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        ns += (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+        UART_get_frame(&frame);
+    }
+    printf("  %-28s %.1f ns per byte on this PC, with the recording\n", "UART RX interrupt", ns / 1000 / 63);
+}
+
+int main(void)
+{
+    printf("Driver logic through the mock of hal.h:\n");
+    check_uart();
+    check_i2c();
+    check_adc();
+    check_pwm();
+    check_cost();
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
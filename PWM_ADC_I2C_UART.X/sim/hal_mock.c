@@ -0,0 +1,211 @@
+/* ************************************************************************** */
+/** hal_mock.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ hal_mock.c
+
+  @Summary
+ Mock back end of hal.h for host builds of the drivers
+
+  @Description
+ Each hal_*() function records its access and forwards it to hal_target_*(), i.e. to
+ * the registers of sim/xc.h, unless a value was injected for a read. Injected values
+ * are kept in a ring per access (and per ADC input), so a test can script a sequence
+ * of status bits and data, e.g. three polls of a busy flag followed by a byte.
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <xc.h>
+#include "header.h"
+#include "hal.h"
+#include "hal_mock.h"
+
+#define INJECT_SLOTS (HAL_MOCK_NUMBER_OF_ACCESSES + 6)  // ADC_READY and ADC_RESULT have a ring per input 2 ... 4
+
+hal_access_t hal_mock_log[HAL_MOCK_LOG];
+uint32_t hal_mock_count = 0;
+void (*hal_mock_hook)(const hal_access_t *access) = 0;
+
+static struct
+{
+    uint32_t value[HAL_MOCK_INJECTED];
+    uint8_t head, tail;
+} injected[INJECT_SLOTS];
+
+#define HAL_MOCK_STRING(name) #name,
+static const char *const names[HAL_MOCK_NUMBER_OF_ACCESSES] = {HAL_MOCK_ACCESSES(HAL_MOCK_STRING)};
+
+void hal_mock_reset(void)
+{
+    uint8_t i;
+
+    hal_mock_count = 0;
+    hal_mock_hook = 0;
+    for(i = 0; i < INJECT_SLOTS; ++i)
+        injected[i].head = injected[i].tail = 0;
+}
+
+//ring of the injected values of an access
+static uint8_t slot(hal_access_id_t id, uint8_t index)
+{
+    if(id == HAL_ADC_READY && index >= 2 && index <= 4)
+        return HAL_MOCK_NUMBER_OF_ACCESSES + index - 2;
+    if(id == HAL_ADC_RESULT && index >= 2 && index <= 4)
+        return HAL_MOCK_NUMBER_OF_ACCESSES + 3 + index - 2;
+    return id;
+}
+
+uint8_t hal_mock_inject(hal_access_id_t id, uint8_t index, uint32_t value)
+{
+    uint8_t s = slot(id, index);
+
+    if((uint8_t)(injected[s].head - injected[s].tail) >= HAL_MOCK_INJECTED)
+        return 0;
+    injected[s].value[injected[s].head++ % HAL_MOCK_INJECTED] = value;
+    return 1;
+}
+
+const hal_access_t *hal_mock_access(uint32_t n)
+{
+    if(n >= hal_mock_count || hal_mock_count - n > HAL_MOCK_LOG)
+        return 0;
+    return &hal_mock_log[n % HAL_MOCK_LOG];
+}
+
+uint32_t hal_mock_count_of(hal_access_id_t id, uint32_t from)
+{
+    uint32_t n, count = 0;
+
+    if(hal_mock_count > HAL_MOCK_LOG && from < hal_mock_count - HAL_MOCK_LOG)
+        from = hal_mock_count - HAL_MOCK_LOG;
+    for(n = from; n < hal_mock_count; ++n)
+        count += hal_mock_log[n % HAL_MOCK_LOG].id == id;
+    return count;
+}
+
+const char *hal_mock_name(hal_access_id_t id)
+{
+    return id < HAL_MOCK_NUMBER_OF_ACCESSES ? names[id] : "?";
+}
+
+void hal_mock_print(uint32_t from)
+{
+    const hal_access_t *access;
+
+    for(; from < hal_mock_count; ++from)
+        if((access = hal_mock_access(from)))
+            printf("  %8lu  %10.3f us  %-24s %u  0x%08x\n", (unsigned long)from, access->time_ns / 1e3,
+                   hal_mock_name(access->id), access->index, access->value);
+}
+
+//append an access to the log and call the hook
+static uint32_t record(hal_access_id_t id, uint8_t index, uint32_t value)
+{
+    hal_access_t *access = &hal_mock_log[hal_mock_count++ % HAL_MOCK_LOG];
+
+    access->time_ns = sim_time_ns;
+    access->id = id;
+    access->index = index;
+    access->value = value;
+    if(hal_mock_hook)
+        hal_mock_hook(access);
+    return value;
+}
+
+//injected value of a read if there is one
+static uint8_t take(hal_access_id_t id, uint8_t index, uint32_t *value)
+{
+    uint8_t s = slot(id, index);
+
+    if(injected[s].head == injected[s].tail)
+        return 0;
+    *value = injected[s].value[injected[s].tail++ % HAL_MOCK_INJECTED];
+    return 1;
+}
+
+/*Reads and writes of hal.h*/
+#define MOCK_READ(type, name, id, index, target) \
+    type hal_##name(void) \
+    { \
+        uint32_t value; \
+        if(!take(id, index, &value)) \
+            value = target; \
+        return (type)record(id, index, value); \
+    }
+#define MOCK_WRITE(name, id, target) \
+    void hal_##name(void) \
+    { \
+        target; \
+        record(id, 0, 1); \
+    }
+
+MOCK_READ(uint32_t, core_count, HAL_CORE_COUNT, 0, hal_target_core_count())
+
+MOCK_READ(uint8_t, uart_tx_full, HAL_UART_TX_FULL, 0, hal_target_uart_tx_full())
+void hal_uart_write(uint8_t data)
+{
+    hal_target_uart_write(data);
+    record(HAL_UART_WRITE, 0, data);
+}
+MOCK_READ(uint8_t, uart_rx_available, HAL_UART_RX_AVAILABLE, 0, hal_target_uart_rx_available())
+MOCK_READ(uint8_t, uart_read, HAL_UART_READ, 0, hal_target_uart_read())
+MOCK_READ(uint8_t, uart_overrun, HAL_UART_OVERRUN, 0, hal_target_uart_overrun())
+MOCK_WRITE(uart_clear_overrun, HAL_UART_CLEAR_OVERRUN, hal_target_uart_clear_overrun())
+MOCK_WRITE(uart_clear_rx_flag, HAL_UART_CLEAR_RX_FLAG, hal_target_uart_clear_rx_flag())
+
+MOCK_READ(uint8_t, i2c_sequence_pending, HAL_I2C_SEQUENCE_PENDING, 0, hal_target_i2c_sequence_pending())
+MOCK_READ(uint8_t, i2c_transmitting, HAL_I2C_TRANSMITTING, 0, hal_target_i2c_transmitting())
+MOCK_WRITE(i2c_start, HAL_I2C_START, hal_target_i2c_start())
+MOCK_READ(uint8_t, i2c_start_pending, HAL_I2C_START_PENDING, 0, hal_target_i2c_start_pending())
+MOCK_WRITE(i2c_restart, HAL_I2C_RESTART, hal_target_i2c_restart())
+MOCK_READ(uint8_t, i2c_restart_pending, HAL_I2C_RESTART_PENDING, 0, hal_target_i2c_restart_pending())
+MOCK_WRITE(i2c_stop, HAL_I2C_STOP, hal_target_i2c_stop())
+MOCK_WRITE(i2c_receive, HAL_I2C_RECEIVE, hal_target_i2c_receive())
+MOCK_READ(uint8_t, i2c_receive_pending, HAL_I2C_RECEIVE_PENDING, 0, hal_target_i2c_receive_pending())
+void hal_i2c_acknowledge(uint8_t nack)
+{
+    hal_target_i2c_acknowledge(nack);
+    record(HAL_I2C_ACKNOWLEDGE, 0, nack);
+}
+MOCK_READ(uint8_t, i2c_acknowledge_pending, HAL_I2C_ACKNOWLEDGE_PENDING, 0, hal_target_i2c_acknowledge_pending())
+void hal_i2c_write(uint8_t data)
+{
+    hal_target_i2c_write(data);
+    record(HAL_I2C_WRITE, 0, data);
+}
+MOCK_READ(uint8_t, i2c_tx_full, HAL_I2C_TX_FULL, 0, hal_target_i2c_tx_full())
+MOCK_READ(uint8_t, i2c_nacked, HAL_I2C_NACKED, 0, hal_target_i2c_nacked())
+MOCK_READ(uint8_t, i2c_rx_full, HAL_I2C_RX_FULL, 0, hal_target_i2c_rx_full())
+MOCK_READ(uint8_t, i2c_read, HAL_I2C_READ, 0, hal_target_i2c_read())
+
+MOCK_WRITE(adc_trigger, HAL_ADC_TRIGGER, hal_target_adc_trigger())
+uint8_t hal_adc_ready(uint8_t input)
+{
+    uint32_t value;
+    if(!take(HAL_ADC_READY, input, &value))
+        value = hal_target_adc_ready(input);
+    return (uint8_t)record(HAL_ADC_READY, input, value);
+}
+uint16_t hal_adc_result(uint8_t input)
+{
+    uint32_t value;
+    if(!take(HAL_ADC_RESULT, input, &value))
+        value = hal_target_adc_result(input);
+    return (uint16_t)record(HAL_ADC_RESULT, input, value);
+}
+
+MOCK_READ(uint32_t, timer2_count, HAL_TIMER2_COUNT, 0, hal_target_timer2_count())
+MOCK_WRITE(timer2_clear_flag, HAL_TIMER2_CLEAR_FLAG, hal_target_timer2_clear_flag())
+void hal_oc_write(volatile uint32_t *reg, uint32_t compare)
+{
+    uint8_t index = reg == &OC1RS || reg == &OC1R ? 1 : reg == &OC2RS || reg == &OC2R ? 2 :
+                    reg == &OC3RS || reg == &OC3R ? 3 : reg == &OC4RS || reg == &OC4R ? 4 : 0;
+    hal_target_oc_write(reg, compare);
+    record(HAL_OC_WRITE, index, compare);
+}
+MOCK_READ(uint8_t, timer6_flag, HAL_TIMER6_FLAG, 0, hal_target_timer6_flag())
+MOCK_WRITE(timer6_clear_flag, HAL_TIMER6_CLEAR_FLAG, hal_target_timer6_clear_flag())
@@ -0,0 +1,82 @@
+/* ************************************************************************** */
+/** hal_mock.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ hal_mock.h
+
+  @Summary
+ Mock back end of hal.h: records the peripheral accesses of the drivers and injects
+ the values they read
+
+  @Description
+ Compile the drivers and sim/hal_mock.c with HAL_MOCK defined. Every call of a hal_*()
+ * function is appended to hal_mock_log with the simulated time, its argument (ADC
+ * input, Output Compare) and the value written or read. A read returns the oldest
+ * value injected for it with hal_mock_inject() if there is one, otherwise the value of
+ * the register models of sim/, as hal_target_*() does without the mock. hal_mock_hook
+ * is called after every access, e.g. to raise a flag after a number of polls or to
+ * advance the simulated time.
+ */
+/* ************************************************************************** */
+
+#ifndef _HAL_MOCK_H    /* Guard against multiple inclusion */
+#define _HAL_MOCK_H
+
+#include <stdint.h>
+
+#define HAL_MOCK_LOG        4096    // accesses kept, the oldest are overwritten
+#define HAL_MOCK_INJECTED   64      // values waiting per access
+
+/*Accesses of hal.h, one per function*/
+#define HAL_MOCK_ACCESSES(X) \
+    X(CORE_COUNT) \
+    X(UART_TX_FULL) X(UART_WRITE) X(UART_RX_AVAILABLE) X(UART_READ) X(UART_OVERRUN) \
+    X(UART_CLEAR_OVERRUN) X(UART_CLEAR_RX_FLAG) \
+    X(I2C_SEQUENCE_PENDING) X(I2C_TRANSMITTING) X(I2C_START) X(I2C_START_PENDING) X(I2C_RESTART) \
+    X(I2C_RESTART_PENDING) X(I2C_STOP) X(I2C_RECEIVE) X(I2C_RECEIVE_PENDING) X(I2C_ACKNOWLEDGE) \
+    X(I2C_ACKNOWLEDGE_PENDING) X(I2C_WRITE) X(I2C_TX_FULL) X(I2C_NACKED) X(I2C_RX_FULL) X(I2C_READ) \
+    X(ADC_TRIGGER) X(ADC_READY) X(ADC_RESULT) \
+    X(TIMER2_COUNT) X(TIMER2_CLEAR_FLAG) X(OC_WRITE) X(TIMER6_FLAG) X(TIMER6_CLEAR_FLAG)
+
+#define HAL_MOCK_ENUM(name) HAL_##name,
+typedef enum { HAL_MOCK_ACCESSES(HAL_MOCK_ENUM) HAL_MOCK_NUMBER_OF_ACCESSES } hal_access_id_t;
+
+/*A recorded access*/
+typedef struct
+{
+    uint64_t time_ns;       // simulated time
+    uint8_t id;             // hal_access_id_t
+    uint8_t index;          // ADC input, Output Compare 1 ... 4 (0 for another register), else 0
+    uint32_t value;         // written or read
+} hal_access_t;
+
+extern hal_access_t hal_mock_log[HAL_MOCK_LOG];
+extern uint32_t hal_mock_count;                             // accesses since hal_mock_reset(), hal_mock_log wraps
+extern void (*hal_mock_hook)(const hal_access_t *access);   // called after every access if set
+
+/*Methods of the mock
+ *******************************************************************
+ .................*/
+/*Clear the log, the injected values and the hook*/
+void hal_mock_reset(void);
+
+/*Value returned by a later read of the access (a read only function of hal.h), for
+ * ADC_READY and ADC_RESULT of the given input. Returns 0 if too many are waiting*/
+uint8_t hal_mock_inject(hal_access_id_t id, uint8_t index, uint32_t value);
+
+/*Recorded access number n (0 is the first since hal_mock_reset()), 0 if it was overwritten*/
+const hal_access_t *hal_mock_access(uint32_t n);
+
+/*Number of accesses of an id from access number from on*/
+uint32_t hal_mock_count_of(hal_access_id_t id, uint32_t from);
+
+/*Name of an access, e.g. "I2C_START"*/
+const char *hal_mock_name(hal_access_id_t id);
+
+/*Print the accesses from number from to the end of the log*/
+void hal_mock_print(uint32_t from);
+
+#endif /* _HAL_MOCK_H */
@@ -0,0 +1,196 @@
+/* ************************************************************************** */
+/** i2c_bench.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ i2c_bench.c
+
+  @Summary
+ Host benchmark of the IMU and encoder drivers on the simulated I2C bus
+
+  @Description
+ Runs mpu9250.c, AS5600L.c and I2C.c against the models of the MPU9250 and two 
+ * AS5600L encoders at the I2C speeds the bus supports. Every transaction is checked 
+ * against the registers of the models and the bus traffic is checked for protocol 
+ * errors. For every transaction the time the bus is busy is reported; as the driver 
+ * polls the bus, this is also the time the CPU is blocked.
+ * The accelerometer calibration is checked against a bias set in the IMU model.
+ * 
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -Isim -I. -o i2c_bench sim/i2c_bench.c sim/sim_i2c.c sim/sim_regs.c 
+ *     sim/sim_mpu9250.c sim/sim_as5600l.c I2C.c mpu9250.c AS5600L.c NVM.c -lm && ./i2c_bench
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <xc.h>
+#include "header.h"
+#include "I2C.h"
+#include "mpu9250.h"
+#include "AS5600L.h"
+#include "sim_i2c.h"
+#include "sim_mpu9250.h"
+#include "sim_as5600l.h"
+
+#define REPETITIONS 1000
+
+/*Globals of main.c used by the drivers*/
+volatile uint8_t flag_ankle_IMU=0,flag_ankle_encoder=0,flag_ankle_current=0,flag_print=0;
+volatile uint16_t ADC1=0,ADC2=0,ADC3=0;
+volatile int16_t accelX=0,accelY=0,accelZ=0;
+volatile int16_t gyroX=0,gyroY=0,gyroZ=0;
+
+static sim_mpu9250_t imu;
+static sim_as5600l_t knee, ankle;
+static uint32_t failures = 0;
+
+/*Transactions under test, each returns the number of wrong values it read*/
+static uint32_t read_accel_x(uint32_t i)
+{
+    volatile int16_t value;
+    (void)i;
+    IMUReadBytes(IMU_ADDRESS, ACCEL_XOUT_H, &value);
+    return value != sim_mpu9250_register16(&imu, ACCEL_XOUT_H);
+}
+
+static uint32_t read_accel_y(uint32_t i)
+{
+    volatile int16_t value;
+    (void)i;
+    IMUReadBytes(IMU_ADDRESS, ACCEL_YOUT_H, &value);
+    return value != sim_mpu9250_register16(&imu, ACCEL_YOUT_H);
+}
+
+static uint32_t read_accel_z(uint32_t i)
+{
+    volatile int16_t value;
+    (void)i;
+    IMUReadBytes(IMU_ADDRESS, ACCEL_ZOUT_H, &value);
+    return value != sim_mpu9250_register16(&imu, ACCEL_ZOUT_H);
+}
+
+/*three separate reads may return values of different samples, every value is checked right after its read*/
+static uint32_t read_accel_xyz(uint32_t i)
+{
+    return read_accel_x(i) + read_accel_y(i) + read_accel_z(i);
+}
+
+static uint32_t read_burst(uint32_t i)
+{
+    uint8_t buffer[IMU_BURST_LENGTH];
+    uint32_t wrong = 0;
+    uint8_t j;
+    (void)i;
+    IMUReadBurst(buffer);
+    for(j = 0; j < IMU_BURST_LENGTH; ++j)
+        wrong += buffer[j] != imu.reg[ACCEL_XOUT_H + j];
+    return wrong;
+}
+
+static uint32_t read_motion(uint32_t i)
+{
+    int16_t accel[3], gyro[3];
+    uint32_t wrong = 0;
+    uint8_t j;
+    (void)i;
+    IMUReadMotion(accel, gyro);
+    for(j = 0; j < 3; ++j)
+    {
+        wrong += accel[j] != sim_mpu9250_register16(&imu, ACCEL_XOUT_H + 2 * j);
+        wrong += gyro[j] != sim_mpu9250_register16(&imu, GYRO_XOUT_H + 2 * j);
+    }
+    return wrong;
+}
+
+static uint32_t read_encoders(uint32_t i)
+{
+    uint16_t knee_angle, ankle_angle;
+    sim_as5600l_set_angle(&knee, i * 7);
+    sim_as5600l_set_angle(&ankle, 4095 - i * 3);
+    encoderRead(KNEE_ENCODER_ADDRESS, ENCODER_ANGLE_REG, &knee_angle);
+    encoderRead(ANKLE_ENCODER_ADDRESS, ENCODER_ANGLE_REG, &ankle_angle);
+    return (knee_angle != sim_as5600l_angle(&knee)) + (ankle_angle != sim_as5600l_angle(&ankle));
+}
+
+static void bench(const char *name, uint32_t (*transaction)(uint32_t))
+{
+    uint64_t start = sim_time_ns;
+    uint32_t wrong = 0;
+    uint32_t i;
+    double us;
+    
+    sim_i2c_reset_stats();
+    for(i = 0; i < REPETITIONS; ++i)
+    {
+        double accel[3] = {0.001 * (i % 100), -0.5, 1.0};
+        double gyro[3] = {10.0, -20.0, 0.1 * i};
+        sim_mpu9250_set_motion(&imu, accel, gyro);
+        wrong += transaction(i);
+    }
+    us = (sim_time_ns - start) / 1000.0 / REPETITIONS;
+    printf("  %-22s %8.1f us %9.0f /s %6.1f bytes %s\n", name, us, 1e6 / us,
+           (double)(sim_i2c_stats.bytes_written + sim_i2c_stats.bytes_read) / REPETITIONS,
+           (wrong || sim_i2c_stats.errors || sim_i2c_stats.nacks) ? "FAIL" : "ok");
+    if(wrong || sim_i2c_stats.errors || sim_i2c_stats.nacks)
+    {
+        printf("    %u wrong values, %u protocol errors, %u NACKs\n", wrong, sim_i2c_stats.errors, sim_i2c_stats.nacks);
+        ++failures;
+    }
+}
+
+/*Calibrate with the board lying flat and report the acceleration read afterwards*/
+static void calibrate(void)
+{
+    static const double bias_g[3] = {0.045, -0.030, 0.080};
+    static const double flat[3] = {0.0, 0.0, 1.0}, still[3] = {0.0, 0.0, 0.0};
+    volatile int16_t value[3];
+    double residual_mg[3];
+    uint64_t start = sim_time_ns;
+    uint8_t i;
+    
+    for(i = 0; i < 3; ++i)
+        imu.accel_bias_g[i] = bias_g[i];
+    sim_mpu9250_set_motion(&imu, flat, still);
+    IMUCalibrateAccel(IMU_CALIBRATION_SAMPLES, 0);
+    start = sim_time_ns - start;
+    sim_advance(20000000);          /* the new offsets are applied from the next sample */
+    IMUReadBytes(IMU_ADDRESS, ACCEL_XOUT_H, &value[0]);
+    IMUReadBytes(IMU_ADDRESS, ACCEL_YOUT_H, &value[1]);
+    IMUReadBytes(IMU_ADDRESS, ACCEL_ZOUT_H, &value[2]);
+    for(i = 0; i < 3; ++i)
+        residual_mg[i] = 1000.0 * value[i] / 2048 - 1000.0 * flat[i];  /* 16g full scale */
+    printf("  %-22s %8.1f ms  residual %5.1f %5.1f %5.1f mg %s\n", "accel calibration",
+           start / 1e6, residual_mg[0], residual_mg[1], residual_mg[2],
+           (fabs(residual_mg[0]) > 2 || fabs(residual_mg[1]) > 2 || fabs(residual_mg[2]) > 2) ? "FAIL" : "ok");
+    if(fabs(residual_mg[0]) > 2 || fabs(residual_mg[1]) > 2 || fabs(residual_mg[2]) > 2)
+        ++failures;
+}
+
+int main()
+{
+    static const uint32_t frequencies[] = {100000, 400000, 1000000};
+    uint8_t f;
+    
+    for(f = 0; f < sizeof(frequencies) / sizeof(frequencies[0]); ++f)
+    {
+        sim_i2c_reset();
+        sim_mpu9250_init(&imu, IMU_ADDRESS);
+        sim_as5600l_init(&knee, KNEE_ENCODER_ADDRESS);
+        sim_as5600l_init(&ankle, ANKLE_ENCODER_ADDRESS);
+        I2C_init(frequencies[f]);
+        setIMU_sensitivity();
+        
+        printf("I2C_init(%u): SCL %u Hz      time/transaction  rate  bus traffic\n", frequencies[f], sim_i2c_scl_frequency());
+        bench("IMU accel X", read_accel_x);
+        bench("IMU accel X,Y,Z", read_accel_xyz);
+        bench("IMU 14 byte burst", read_burst);
+        bench("IMU accel + gyro", read_motion);
+        bench("knee + ankle encoder", read_encoders);
+        calibrate();
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+/* ************************************************************************** */
+/** kernel_bench.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ kernel_bench.c
+
+  @Summary
+ Host run of the benchmark of the controller and filter kernels
+
+  @Description
+ Runs control_benchmark() of control_bench.c on the PC and reports the time of
+ * an update in ns and the error of the Q31 and float kernels against the double
+ * kernels. The errors are the same as on target; the times only compare the types
+ * on the PC, the cycles on target are printed at boot with CONTROL_BENCHMARK defined.
+ * 
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -O2 -Isim -I. -o kernel_bench sim/kernel_bench.c sim/sim_regs.c control_bench.c 
+ *     control_q31.c control_f32.c -lm && ./kernel_bench
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <time.h>
+#include <xc.h>
+#include "control_bench.h"
+
+static uint32_t host_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000000000ull + now.tv_nsec);
+}
+
+int main()
+{
+    control_bench_result_t result[CONTROL_BENCH_TYPES];
+    uint8_t i;
+    
+    control_benchmark(host_ns, result);
+    printf("type   PID update  low pass   PID error max/rms      low pass error max/rms\n");
+    for(i = 0; i < CONTROL_BENCH_TYPES; ++i)
+        printf("%-5s %8u ns %8u ns   %.2e / %.2e    %.2e / %.2e\n", result[i].name,
+               result[i].pid_time, result[i].lowpass_time,
+               result[i].pid_max_error, result[i].pid_rms_error,
+               result[i].lowpass_max_error, result[i].lowpass_rms_error);
+    return 0;
+}
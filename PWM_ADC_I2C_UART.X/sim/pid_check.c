@@ -0,0 +1,152 @@
+/* ************************************************************************** */
+/** pid_check.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ pid_check.c
+
+  @Summary
+ Host check of the PID controller of PID.c
+
+  @Description
+ Runs PID_update() in the numeric type selected with CONTROL_NUMERIC against the
+ * same controller in double precision:
+ * 1. Saturation: the output follows kp*error plus the feed forward within 2 LSB and
+ *    never leaves the limits, for errors and feed forwards over the full Q15 range.
+ *    The q31 type saturates every term and sum at full scale (control_numeric.h),
+ *    the reference does the same for that type.
+ * 2. Anti-windup: while the proportional part holds the output at a limit the
+ *    integrator stops, so the output leaves the limit at once when the error goes to
+ *    zero; an integrator that ran into the limit is clamped to it and leaves the
+ *    limit at the first sample of an error of the other sign.
+ * 3. Derivative filter: a ramp of the measurement gives the response of the first
+ *    order filter of PID_FILTER() within 2 LSB, a step of the reference gives no
+ *    derivative kick.
+ *
+ * Build and run from the project directory, for the float kernels with
+ * -DCONTROL_NUMERIC=CONTROL_FLOAT as well:
+ * gcc -std=gnu99 -O2 -Isim -I. -o pid_check sim/pid_check.c sim/sim_regs.c PID.c control_q31.c control_f32.c -lm
+ *     && ./pid_check
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "PID.h"
+
+#define SIM_FS          100     // the position loop
+#define SIM_LIMIT       0.5     // output limits
+#define SIM_LSB         (1.0 / 32768)
+
+static int failures = 0;
+
+static double q15(int16_t x)
+{
+    return x / 32768.0;
+}
+
+static double clamp(double x, double min, double max)
+{
+    return x > max ? max : x < min ? min : x;
+}
+
+//a term or sum of the controller, saturated at full scale in Q31
+static double term(double x)
+{
+    return CONTROL_NUMERIC == CONTROL_FLOAT ? x : clamp(x, -1.0, 1.0);
+}
+
+static void result(const char *name, double error, double tolerance, int wrong)
+{
+    uint8_t ok = error <= tolerance && !wrong;
+
+    printf("  %-22s error %5.1f LSB  %s\n", name, error / SIM_LSB, ok ? "ok" : "FAIL");
+    failures += !ok;
+}
+
+/*1. the output is kp*error + feed forward, held at the limits*/
+static void check_saturation(void)
+{
+    pid_controller_t pid;
+    double error = 0;
+    int16_t out;
+    int32_t reference, feed_forward;
+    int wrong = 0;
+
+    PID_init(&pid, PID_GAIN(4.0), 0, 0, PID_GAIN(1.0), PID_FILTER_NONE, Q15(-SIM_LIMIT), Q15(SIM_LIMIT));
+    for(feed_forward = -32768; feed_forward < 32768; feed_forward += 8192)
+        for(reference = -32768; reference < 32768; reference += 256)
+        {
+            out = PID_update(&pid, (int16_t)reference, 0, (int16_t)feed_forward);
+            error = fmax(error, fabs(q15(out) - clamp(term(term(4.0 * q15(reference)) + q15(feed_forward)),
+                                                           -SIM_LIMIT, SIM_LIMIT)));
+            wrong += out > Q15(SIM_LIMIT) || out < Q15(-SIM_LIMIT);
+        }
+    result("saturation", error, 2 * SIM_LSB, wrong);
+}
+
+/*2. the integrator does not wind up at the limits*/
+static void check_anti_windup(void)
+{
+    pid_controller_t pid;
+    double ki = 1.0 / SIM_FS, error = 0;
+    int16_t out = 0;
+    int n, wrong = 0;
+
+    /*the proportional part saturates, the integrator keeps the sum of the first sample only*/
+    PID_init(&pid, PID_GAIN(2.0), PID_GAIN(ki), 0, 0, PID_FILTER_NONE, Q15(-SIM_LIMIT), Q15(SIM_LIMIT));
+    for(n = 0; n < 10 * SIM_FS; ++n)
+        wrong += PID_update(&pid, Q15(0.5), 0, 0) != Q15(SIM_LIMIT);
+    out = PID_update(&pid, 0, 0, 0);
+    error = fabs(q15(out) - ki * 0.5);
+    result("conditional integration", error, 2 * SIM_LSB, wrong);
+
+    /*the integrator alone runs into the limit, a reversed error brings the output back at its rate*/
+    PID_init(&pid, 0, PID_GAIN(ki), 0, 0, PID_FILTER_NONE, Q15(-SIM_LIMIT), Q15(SIM_LIMIT));
+    for(n = 0; n < 10 * SIM_FS; ++n)
+        out = PID_update(&pid, Q15(0.2), 0, 0);
+    wrong = out != Q15(SIM_LIMIT);
+    error = 0;
+    for(n = 1; n <= SIM_FS; ++n)
+    {
+        out = PID_update(&pid, Q15(-0.2), 0, 0);
+        error = fmax(error, fabs(q15(out) - (SIM_LIMIT - n * ki * 0.2)));
+    }
+    result("integrator clamp", error, 0.2 * ki + 2 * SIM_LSB, wrong);
+}
+
+/*3. first order response of the derivative of the measurement*/
+static void check_derivative(void)
+{
+    pid_controller_t pid;
+    double kd = 0.05 * SIM_FS, coef = (2 * M_PI * 10 / SIM_FS) / (1 + 2 * M_PI * 10 / SIM_FS);
+    double derivative = 0, error = 0;
+    int16_t measurement = 0, out;
+    int n, wrong = 0;
+
+    PID_init(&pid, 0, 0, PID_GAIN(kd), 0, PID_FILTER(10, SIM_FS), Q15(-1.0), Q15(1.0));
+    for(n = 0; n < 3 * SIM_FS; ++n)
+    {
+        if(n < SIM_FS)
+            measurement -= 33;      // a ramp for 1s, then held
+        out = PID_update(&pid, 0, measurement, 0);
+        derivative += coef * (kd * (n < SIM_FS ? 33 * SIM_LSB : 0) - derivative);
+        error = fmax(error, fabs(q15(out) - derivative));
+    }
+    /*the derivative of the reference is not used*/
+    for(n = 0; n < SIM_FS; ++n)
+        wrong += PID_update(&pid, n < SIM_FS / 2 ? Q15(0.5) : Q15(-0.5), measurement, 0) != 0;
+    result("derivative filter", error, 2 * SIM_LSB, wrong);
+}
+
+int main(void)
+{
+    printf("PID_update() in %s against double precision:\n", CONTROL_NUMERIC == CONTROL_FLOAT ? "float" : "Q31");
+    check_saturation();
+    check_anti_windup();
+    check_derivative();
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,605 @@
+/* ************************************************************************** */
+/** plant_sim.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ plant_sim.c
+
+  @Summary
+ Closed loop simulation of the firmware controllers with the knee and ankle joints
+
+  @Description
+ The firmware (control.c, scheduler.c, the PID, trajectory, stream and autotune
+ * code, and the PWM, ADC, I2C, encoder and IMU drivers) runs unchanged against the
+ * register models of sim/. The models are coupled to two joints (sim_plant.c):
+ *  - OC1R/OC2R set the motor voltages, locked anti-phase from SIM_VBUS, and are
+ *    latched from OC1RS/OC2RS at the end of every PWM period
+ *  - the current sensors drive AN2/AN3 of the ADC model
+ *  - the angles drive the AS5600L models, the knee link carries the MPU9250 model
+ * Timer2 and Timer6 set their interrupt flags at the end of their periods in
+ * simulated time, the deferred position loop sets the flag of core software
+ * interrupt 0, and the interrupts are dispatched by priority from IFS0/IEC0/IPC,
+ * also while a lower priority ISR waits on the I2C bus. The simulated time only
+ * advances while a driver waits on a peripheral and at the entry and exit of an ISR,
+ * so the execution times measured by the scheduler are the peripheral waits and the
+ * latency of the deferred work is the exit of the tick and the entry of software
+ * interrupt 0; the time of the code itself is measured on the PC. Runs are deterministic and faster than real time.
+ * Benchmarks:
+ *  1. step: 0.05 turn step of the knee reference, rise time, overshoot, settling
+ *  2. stream: 0.5Hz sines streamed at 100Hz to both joints, tracking errors
+ *  3. autotune: relay tuning of the knee current loop, the joint free: rejected for the
+ *     knee motor, whose limit cycle is set by the sample rate, and done with an inductor
+ *     in series, followed by a current step with the tuned gains
+ * Each benchmark reports the scheduler measurements (scheduler_report()); missed
+ * deadlines, I2C errors and benchmarks that do not reach their target make the exit
+ * status non zero. The targets of the step and the stream are the STEP_* and STREAM_*
+ * limits, a result outside them is marked FAIL.
+ *
+ * Build and run from the project directory, optionally with the I2C frequency (400KHz):
+ * gcc -std=gnu99 -O2 -Isim -I. -o plant_sim sim/plant_sim.c sim/sim_plant.c sim/sim_adc.c
+ *     sim/sim_i2c.c sim/sim_regs.c sim/sim_mpu9250.c sim/sim_as5600l.c control.c scheduler.c
+ *     systime.c defer.c PID.c control_q31.c trajectory.c stream.c autotune.c PWM.c ADC.c motorDriver.c I2C.c
+ *     mpu9250.c AS5600L.c NVM.c -lm && ./plant_sim [400000]
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <xc.h>
+#include "header.h"
+#include "I2C.h"
+#include "mpu9250.h"
+#include "AS5600L.h"
+#include "PWM.h"
+#include "control.h"
+#include "scheduler.h"
+#include "defer.h"
+#include "stream.h"
+#include "autotune.h"
+#include "motordriver.h"
+#include "ADC.h"
+#include "sim_i2c.h"
+#include "sim_adc.h"
+#include "sim_mpu9250.h"
+#include "sim_as5600l.h"
+#include "sim_plant.h"
+
+#define SIM_VBUS            24.0        // V of the H-bridges
+#define SIM_T6_CLOCK        PBCLK3_FREQ // clock of Timer6, see clock_config.h
+#define SIM_IMU_RADIUS      0.2         // m from the knee to the IMU
+#define SIM_SAMPLE_NS       1000000     // the benchmarks sample every 1ms
+#define SIM_ISR_ENTRY_NS    (25 * 1000000000ull / SYS_FREQ)   // vector, shadow set and prologue of an ISR
+#define SIM_ISR_EXIT_NS     (15 * 1000000000ull / SYS_FREQ)   // epilogue and eret
+#define SIM_Q15_TO_AMPERE   (SIM_CURRENT_SENSOR_OFFSET / SIM_CURRENT_SENSOR_GAIN / 32768.0)  // CURRENT_TO_Q15 of the sensor
+
+/*Globals of main.c used by the drivers*/
+volatile uint8_t flag_ankle_IMU=0,flag_ankle_encoder=0,flag_ankle_current=0,flag_print=0;
+volatile uint16_t ADC1=0,ADC2=0,ADC3=0;
+volatile int16_t accelX=0,accelY=0,accelZ=0;
+volatile int16_t gyroX=0,gyroY=0,gyroZ=0;
+
+/*Parts of the firmware that are not simulated*/
+void telemetry_task() {}
+void WriteUART(const char *string) { fputs(string, stdout); }
+uint8_t waveform_playing() { return 0; }
+void PWM_dither_isr();
+void scheduler_tick();
+void defer_cs0_isr();
+void defer_cs1_isr();
+
+/*Shank and foot of a leg, maxon flat motors behind 100:1 and 80:1 gearboxes*/
+static const sim_joint_params_t params[NUMBER_OF_JOINTS] =
+{
+    /*R    L        Kt      J rotor  N    eta  J link m    com   b    c*/
+    {1.2, 0.56e-3, 0.0335, 1.8e-5, 100, 0.8, 0.30, 4.0, 0.25, 0.5, 0.5},    // knee
+    {1.2, 0.56e-3, 0.0335, 1.8e-5, 80,  0.8, 0.012, 1.2, 0.08, 0.2, 0.3},   // ankle
+};
+
+static sim_joint_t joint[NUMBER_OF_JOINTS];
+static sim_mpu9250_t imu;
+static sim_as5600l_t encoder[NUMBER_OF_JOINTS];
+static uint32_t i2c_frequency = 400000;     // as in main()
+
+static uint64_t plant_ns, next_pwm_ns, next_tick_ns;
+static uint8_t ipl = 0, interrupts_enabled = 0;
+static uint64_t tick_host_ns, ticks;
+static int failures = 0;
+
+
+/*Coupling of the models
+ *******************************************************************
+ .................*/
+static double adc_input(uint8_t input)
+{
+    if(input == 2)
+        return sim_joint_current_sensor(&joint[KNEE_JOINT]);
+    if(input == 3)
+        return sim_joint_current_sensor(&joint[ANKLE_JOINT]);
+    return SIM_CURRENT_SENSOR_OFFSET;
+}
+
+//period of a type B timer in ns
+static uint64_t timer_period_ns(volatile sim_TxCON_t *con, uint32_t pr, uint32_t clock)
+{
+    static const uint16_t prescaler[8] = {1, 2, 4, 8, 16, 32, 64, 256};
+    return (uint64_t)(pr + 1) * prescaler[con->TCKPS] * 1000000000ull / clock;
+}
+
+static double motor_voltage(uint32_t compare)
+{
+    return (2.0 * compare / (PR2 + 1) - 1.0) * SIM_VBUS;
+}
+
+static uint64_t host_ns(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t)t.tv_sec * 1000000000ull + t.tv_nsec;
+}
+
+//run the pending interrupts above the running priority, highest first. The entry and
+//exit of an ISR take simulated time, so a deferred item starts after the ISR that posted it
+static void dispatch(void)
+{
+    uint8_t saved = ipl;
+    uint64_t start;
+
+    while(interrupts_enabled)
+    {
+        if(IFS0bits.T2IF && IEC0bits.T2IE && IPC2bits.T2IP > ipl)
+        {
+            ipl = IPC2bits.T2IP;
+            sim_advance(SIM_ISR_ENTRY_NS);
+            PWM_dither_isr();
+        }
+        else if(IFS0bits.T6IF && IEC0bits.T6IE && IPC7bits.T6IP > ipl)
+        {
+            ipl = IPC7bits.T6IP;
+            sim_advance(SIM_ISR_ENTRY_NS);
+            start = host_ns();
+            scheduler_tick();
+            tick_host_ns += host_ns() - start;
+            ++ticks;
+        }
+        else if(IFS0bits.CS1IF && IEC0bits.CS1IE && IPC0bits.CS1IP > ipl)
+        {
+            ipl = IPC0bits.CS1IP;
+            sim_advance(SIM_ISR_ENTRY_NS);
+            defer_cs1_isr();
+        }
+        else if(IFS0bits.CS0IF && IEC0bits.CS0IE && IPC0bits.CS0IP > ipl)
+        {
+            ipl = IPC0bits.CS0IP;
+            sim_advance(SIM_ISR_ENTRY_NS);
+            defer_cs0_isr();
+        }
+        else
+            break;
+        sim_advance(SIM_ISR_EXIT_NS);
+        ipl = saved;
+    }
+}
+
+/*Hook of sim_advance(): the plant follows the simulated time from event to event*/
+static void follow(void)
+{
+    uint64_t event;
+    double accel[3], gyro[3];
+    uint8_t i;
+
+    while((event = next_pwm_ns < next_tick_ns ? next_pwm_ns : next_tick_ns) <= sim_time_ns)
+    {
+        sim_joint_step(&joint[KNEE_JOINT], motor_voltage(OC1R), event - plant_ns);
+        sim_joint_step(&joint[ANKLE_JOINT], motor_voltage(OC2R), event - plant_ns);
+        plant_ns = event;
+        if(event == next_pwm_ns)
+        {
+            OC1R = OC1RS;   // the compare values of the next period
+            OC2R = OC2RS;
+            if(T2CONbits.ON)
+                IFS0bits.T2IF = 1;
+            next_pwm_ns += timer_period_ns(&sim_T2CON, PR2, PWM_TIMER_CLOCK);
+        }
+        if(event == next_tick_ns)
+        {
+            if(T6CONbits.ON)
+                IFS0bits.T6IF = 1;
+            next_tick_ns += timer_period_ns(&sim_T6CON, PR6, SIM_T6_CLOCK);
+        }
+        for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+            sim_as5600l_set_angle(&encoder[i], sim_joint_encoder(&joint[i]));
+        sim_joint_imu(&joint[KNEE_JOINT], SIM_IMU_RADIUS, accel, gyro);
+        sim_mpu9250_set_motion(&imu, accel, gyro);
+        dispatch();
+    }
+}
+
+/*Reset of the board and the start of main(), with the joints at the given angles (rad)*/
+static void boot(double knee, double ankle)
+{
+    sim_time_hook = 0;
+    interrupts_enabled = 0;
+    ipl = 0;
+    T2CON = 0;
+    T6CON = 0;
+    IFS0bits.w = 0;
+    IEC0bits.w = 0;
+    OC1R = OC2R = OC1RS = OC2RS = 0;
+
+    sim_plant_seed(1);
+    sim_joint_init(&joint[KNEE_JOINT], &params[KNEE_JOINT], knee);
+    sim_joint_init(&joint[ANKLE_JOINT], &params[ANKLE_JOINT], ankle);
+    sim_i2c_reset();
+    sim_mpu9250_init(&imu, IMU_ADDRESS);
+    sim_as5600l_init(&encoder[KNEE_JOINT], KNEE_ENCODER_ADDRESS);
+    sim_as5600l_init(&encoder[ANKLE_JOINT], ANKLE_ENCODER_ADDRESS);
+    sim_as5600l_set_angle(&encoder[KNEE_JOINT], sim_joint_encoder(&joint[KNEE_JOINT]));
+    sim_as5600l_set_angle(&encoder[ANKLE_JOINT], sim_joint_encoder(&joint[ANKLE_JOINT]));
+    sim_adc_reset();
+    sim_adc_connect(adc_input);
+
+    /*main()*/
+    Motor_driver_init();
+    control_init();
+    stream_init(STREAM_POLICY_DEFAULT);
+    ADC_init();
+    I2C_init(i2c_frequency);
+    setIMU_sensitivity();
+    PWM_set_duty16(PWM_CHANNEL_M1, 0x8000);     // no voltage until the controllers run
+    PWM_set_duty16(PWM_CHANNEL_M2, 0x8000);
+    OC1R = OC1RS;
+    OC2R = OC2RS;
+    sched_ticks = 0;
+    defer_init();
+    scheduler_init();
+
+    plant_ns = sim_time_ns;
+    next_pwm_ns = plant_ns + timer_period_ns(&sim_T2CON, PR2, PWM_TIMER_CLOCK);
+    next_tick_ns = plant_ns + timer_period_ns(&sim_T6CON, PR6, SIM_T6_CLOCK);
+    sim_time_hook = follow;
+    tick_host_ns = ticks = 0;
+}
+
+static void enable_interrupts(void)
+{
+    interrupts_enabled = 1;
+    dispatch();
+}
+
+/*Idle main loop for the given time, sample() is called every SIM_SAMPLE_NS*/
+static void run(double seconds, void (*sample)(void))
+{
+    uint64_t end = sim_time_ns + (uint64_t)(seconds * 1e9);
+
+    uint64_t next_sample = sim_time_ns + SIM_SAMPLE_NS, next;
+
+    while(sim_time_ns < end)
+    {
+        /*to the next event only, a longer step would let the ISRs start late*/
+        next = next_pwm_ns < next_tick_ns ? next_pwm_ns : next_tick_ns;
+        next = next < next_sample ? next : next_sample;
+        sim_advance(next - sim_time_ns);
+        while(sim_time_ns >= next_sample)    // the main loop was held up by the ISRs
+        {
+            next_sample += SIM_SAMPLE_NS;
+            if(sample)
+                sample();
+        }
+    }
+}
+
+static double turns(int16_t q15)
+{
+    return q15 / 65536.0;
+}
+
+static double joint_turns(uint8_t i)
+{
+    return joint[i].angle / (2 * M_PI);
+}
+
+//scheduler measurements and the time of the code on the PC
+static void report(double seconds, uint64_t host_start)
+{
+    double host = (host_ns() - host_start) * 1e-9;
+    defer_stats_t deferred;
+    uint8_t i;
+
+    defer_get_stats(DEFER_CS0, &deferred);
+    scheduler_report();
+    defer_report();
+    printf("  scheduler tick %.2f us on this PC, %.0fx faster than real time, I2C protocol errors %u\n",
+           ticks ? tick_host_ns / 1e3 / ticks : 0.0, seconds / host, sim_i2c_stats.errors);
+    if(sim_i2c_stats.errors)
+        ++failures;
+    if(deferred.run != deferred.posted || (deferred.run && !deferred.latency_min))
+    {
+        printf("  CS0 ran %u of %u posts, min latency %u counts\n", deferred.run, deferred.posted,
+               deferred.latency_min);
+        ++failures;
+    }
+    for(i = 0; i < scheduler_task_count(); ++i)
+        if(sched_stats[i].deadline_misses)
+        {
+            printf("  %s misses its deadline of %u us\n", scheduler_task(i)->name, scheduler_task(i)->deadline_us);
+            ++failures;
+        }
+}
+
+
+/*Benchmarks
+ *******************************************************************
+ .................*/
+#define STEP_TURNS      0.05
+#define STEP_SECONDS    1.5
+#define STEP_RISE_MAX       0.2     // s, 10% to 90%
+#define STEP_OVERSHOOT_MAX  0.3     // of the step, the knee brakes at POSITION_CURRENT_LIMIT
+#define STEP_SETTLING_MAX   0.8     // s to stay within 2%
+#define STEP_ERROR_MAX      0.02    // of the step, mean of the last 200ms
+
+static double step_start, step_time, step_peak, step_t10, step_t90, step_settled, step_final;
+static uint32_t step_samples, step_final_samples;
+
+static void step_sample(void)
+{
+    double t = (sim_time_ns - step_time) * 1e-9, x = (joint_turns(KNEE_JOINT) - step_start) / STEP_TURNS;
+
+    if(x > step_peak)
+        step_peak = x;
+    if(step_t10 < 0 && x >= 0.1)
+        step_t10 = t;
+    if(step_t90 < 0 && x >= 0.9)
+        step_t90 = t;
+    if(fabs(x - 1) > 0.02)
+        step_settled = -1;
+    else if(step_settled < 0)
+        step_settled = t;
+    if(t > STEP_SECONDS - 0.2)
+    {
+        step_final += x;
+        ++step_final_samples;
+    }
+    ++step_samples;
+}
+
+static void benchmark_step(void)
+{
+    uint64_t start = host_ns();
+    uint8_t ok;
+
+    printf("1. step: knee reference +%.2f turn\n", STEP_TURNS);
+    boot(0.3, 0.1);
+    enable_interrupts();
+    control_command((const uint8_t *)"S", 1);     // the 'C' frame of the host
+    run(0.5, NULL);
+    if(!control_enabled)
+    {
+        printf("  the position loop did not start the controllers FAIL\n");
+        ++failures;
+    }
+    step_start = turns(position_reference[KNEE_JOINT]);     // the step is measured from the reference
+    if(fabs(joint_turns(KNEE_JOINT) - step_start) > 0.02 * STEP_TURNS)
+    {
+        printf("  the knee holds %.4f turn instead of %.4f before the step FAIL\n", joint_turns(KNEE_JOINT), step_start);
+        ++failures;
+    }
+    step_time = sim_time_ns;
+    step_peak = step_final = 0;
+    step_t10 = step_t90 = step_settled = -1;
+    step_samples = step_final_samples = 0;
+    position_reference[KNEE_JOINT] += (int16_t)(STEP_TURNS * 65536);
+    run(STEP_SECONDS, step_sample);
+
+    step_final = 1 - step_final / step_final_samples;
+    ok = step_t90 >= 0 && step_t90 - step_t10 <= STEP_RISE_MAX && step_peak - 1 <= STEP_OVERSHOOT_MAX &&
+         step_settled >= 0 && step_settled <= STEP_SETTLING_MAX && fabs(step_final) <= STEP_ERROR_MAX;
+    printf("  rise time %.1f ms, overshoot %.1f%%, settling time (2%%) %s%.0f ms, error at the end %.2f%% %s\n",
+           (step_t90 - step_t10) * 1e3, (step_peak - 1) * 100, step_settled < 0 ? "> " : "",
+           (step_settled < 0 ? STEP_SECONDS : step_settled) * 1e3, step_final * 100, ok ? "ok" : "FAIL");
+    if(!ok)
+    {
+        printf("    limits: rise time %.0f ms, overshoot %.0f%%, settling time %.0f ms, error %.0f%%\n",
+               STEP_RISE_MAX * 1e3, STEP_OVERSHOOT_MAX * 100, STEP_SETTLING_MAX * 1e3, STEP_ERROR_MAX * 100);
+        ++failures;     // NaN fails as well
+    }
+    report(0.5 + STEP_SECONDS, start);
+}
+
+#define STREAM_SECONDS  5.0
+#define STREAM_RMS_MAX      1.0     // deg, tracking error of the interpolated reference
+#define STREAM_PEAK_MAX     2.0     // deg
+#define STREAM_CURRENT_MAX  0.2     // A rms, error of the current loop
+static const double stream_amplitude[NUMBER_OF_JOINTS] = {0.05, 0.03};    // turn
+static uint32_t stream_index, stream_samples;
+static double stream_sum[NUMBER_OF_JOINTS], stream_max[NUMBER_OF_JOINTS], current_sum[NUMBER_OF_JOINTS];
+static double stream_offset[NUMBER_OF_JOINTS];
+
+//reference of the current loop with the feed forward, as in control.c, in A
+static double current_loop_reference(uint8_t i)
+{
+    double reference = current_reference[i] + ((double)trajectory_point[i].velocity * TRAJECTORY_KV +
+                                               (double)trajectory_point[i].acceleration * TRAJECTORY_KA) / 65536;
+
+    if(reference > POSITION_CURRENT_LIMIT)
+        reference = POSITION_CURRENT_LIMIT;
+    if(reference < -POSITION_CURRENT_LIMIT)
+        reference = -POSITION_CURRENT_LIMIT;
+    return reference * SIM_Q15_TO_AMPERE;
+}
+
+static void stream_sample(void)
+{
+    int16_t setpoint[NUMBER_OF_JOINTS];
+    double error, current;
+    uint8_t i;
+
+    if(stream_index % 10 == 0)      // 100Hz from the host
+    {
+        for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+            setpoint[i] = (int16_t)lrint((stream_offset[i] + stream_amplitude[i] *
+                                          sin(2 * M_PI * 0.5 * stream_index / 1000.0)) * 65536);
+        stream_push(setpoint);
+    }
+    ++stream_index;
+    if(stream_index < 1000)
+        return;         // prefill and start of the motion
+    for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+    {
+        error = fabs(joint_turns(i) - turns(trajectory_point[i].position)) * 360;
+        current = current_loop_reference(i) - joint[i].current;
+        stream_sum[i] += error * error;
+        current_sum[i] += current * current;
+        if(error > stream_max[i])
+            stream_max[i] = error;
+    }
+    ++stream_samples;
+}
+
+static void benchmark_stream(void)
+{
+    static const char *const names[NUMBER_OF_JOINTS] = {"knee", "ankle"};
+    uint64_t start = host_ns();
+    double rms, current;
+    uint8_t i, ok;
+
+    printf("2. stream: 0.5Hz sines of %.2f and %.2f turn at 100Hz\n", stream_amplitude[0], stream_amplitude[1]);
+    boot(0.3, 0.1);
+    control_start();
+    enable_interrupts();
+    stream_index = stream_samples = 0;
+    for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+    {
+        stream_offset[i] = turns(position_reference[i]);
+        stream_sum[i] = stream_max[i] = current_sum[i] = 0;
+    }
+    run(STREAM_SECONDS, stream_sample);
+
+    for(i = 0; i < NUMBER_OF_JOINTS; ++i)
+    {
+        rms = sqrt(stream_sum[i] / stream_samples);
+        current = sqrt(current_sum[i] / stream_samples);
+        ok = rms <= STREAM_RMS_MAX && stream_max[i] <= STREAM_PEAK_MAX && current <= STREAM_CURRENT_MAX;
+        printf("  %-5s tracking error %.3f deg rms, %.3f deg max; current loop error %.3f A rms %s\n", names[i],
+               rms, stream_max[i], current, ok ? "ok" : "FAIL");
+        if(!ok)
+        {
+            printf("    limits: %.1f deg rms, %.1f deg max, %.2f A rms\n", STREAM_RMS_MAX, STREAM_PEAK_MAX,
+                   STREAM_CURRENT_MAX);
+            ++failures;
+        }
+    }
+    printf("  underruns %lu, overflows %lu\n", (unsigned long)stream_stats.underruns, (unsigned long)stream_stats.overflows);
+    report(STREAM_SECONDS, start);
+}
+
+#define TUNE_INDUCTANCE     10e-3   // H, the knee motor with an inductor in series
+#define TUNE_STEP           Q15(0.1)    // current step with the tuned gains, 1A
+#define TUNE_STEP_SECONDS   0.1
+#define TUNE_OVERSHOOT_MAX  0.3     // of the step
+#define TUNE_SETTLING_MAX   0.02    // s to stay within 5%
+#define TUNE_RIPPLE_MAX     0.1     // of the step, peak to peak in the last half of the step
+
+static double tune_peak, tune_settled, tune_min, tune_max;
+static uint32_t tune_samples;
+
+static void tune_sample(void)
+{
+    double t, x = joint[KNEE_JOINT].current / (TUNE_STEP * SIM_Q15_TO_AMPERE);
+
+    if(!control_enabled)
+        return;     // the position loop starts the controllers at its next sample
+    t = tune_samples++ * SIM_SAMPLE_NS * 1e-9;
+    if(x > tune_peak)
+        tune_peak = x;
+    if(fabs(x - 1) > 0.05)
+        tune_settled = -1;
+    else if(tune_settled < 0)
+        tune_settled = t;
+    if(t >= TUNE_STEP_SECONDS / 2)
+    {
+        tune_min = x < tune_min ? x : tune_min;
+        tune_max = x > tune_max ? x : tune_max;
+    }
+}
+
+//relay tuning of the knee current loop with the given motor inductance, the joint free
+static const autotune_result_t *tune(double inductance, double *seconds)
+{
+    boot(0.0, 0.0);
+    joint[KNEE_JOINT].p.inductance = inductance;
+    enable_interrupts();
+    autotune_start(KNEE_JOINT, AUTOTUNE_RELAY, AUTOTUNE_HYSTERESIS);
+    while(autotune_running(KNEE_JOINT) && *seconds < 2.0)
+    {
+        run(0.01, NULL);
+        *seconds += 0.01;
+    }
+    autotune_report();
+    return autotune_result(KNEE_JOINT);
+}
+
+static void benchmark_autotune(void)
+{
+    uint64_t start = host_ns();
+    double seconds = 0;
+    const autotune_result_t *result;
+    uint8_t ok;
+
+    printf("3. autotune: relay on the knee motor, h %.2f, eps %.3f\n", AUTOTUNE_RELAY / 32768.0,
+           AUTOTUNE_HYSTERESIS / 32768.0);
+    /*the current of the knee motor settles within a sample, the limit cycle is 2 samples*/
+    result = tune(params[KNEE_JOINT].inductance, &seconds);
+    ok = result->state == AUTOTUNE_FAILED && result->failure == AUTOTUNE_TOO_FAST;
+    printf("  L %.2f mH: rejected as too fast for the current loop %s\n", params[KNEE_JOINT].inductance * 1e3,
+           ok ? "ok" : "FAIL");
+    failures += !ok;
+
+    /*an inductor in series slows the current down to a cycle the loop can measure*/
+    result = tune(TUNE_INDUCTANCE, &seconds);
+    ok = result->state == AUTOTUNE_DONE && result->tu * CURRENT_LOOP_FS >= AUTOTUNE_MIN_PERIOD;
+    printf("  L %.2f mH: tuned %s\n", TUNE_INDUCTANCE * 1e3, ok ? "ok" : "FAIL");
+    if(!ok)
+    {
+        ++failures;
+        report(seconds, start);
+        return;
+    }
+
+    /*current step with the tuned gains: the position controller of the knee is held at the step*/
+    PID_init(&position_pid[KNEE_JOINT], 0, 0, 0, 0, PID_FILTER_NONE, TUNE_STEP, TUNE_STEP);
+    tune_peak = tune_max = 0;
+    tune_min = INFINITY;
+    tune_settled = -1;
+    tune_samples = 0;
+    control_command((const uint8_t *)"S", 1);
+    run(TUNE_STEP_SECONDS + 1.0 / POSITION_LOOP_FS, tune_sample);
+    seconds += TUNE_STEP_SECONDS + 1.0 / POSITION_LOOP_FS;
+    ok = tune_samples && tune_peak - 1 <= TUNE_OVERSHOOT_MAX && tune_settled >= 0 &&
+         tune_settled <= TUNE_SETTLING_MAX && tune_max - tune_min <= TUNE_RIPPLE_MAX;
+    printf("  current step of %.1f A with the tuned gains: overshoot %.1f%%, settling time (5%%) %s%.0f ms, "
+           "ripple %.1f%% %s\n", TUNE_STEP * SIM_Q15_TO_AMPERE, (tune_peak - 1) * 100, tune_settled < 0 ? "> " : "",
+           (tune_settled < 0 ? TUNE_STEP_SECONDS : tune_settled) * 1e3, (tune_max - tune_min) * 100, ok ? "ok" : "FAIL");
+    if(!ok)
+    {
+        printf("    limits: overshoot %.0f%%, settling time %.0f ms, ripple %.0f%%\n", TUNE_OVERSHOOT_MAX * 100,
+               TUNE_SETTLING_MAX * 1e3, TUNE_RIPPLE_MAX * 100);
+        ++failures;
+    }
+    report(seconds, start);
+}
+
+int main(int argc, char *argv[])
+{
+    if(argc > 1)
+        i2c_frequency = strtoul(argv[1], NULL, 0);
+    printf("Closed loop simulation, I2C at %u Hz, current loop %u Hz, position loop %u Hz\n",
+           i2c_frequency, CURRENT_LOOP_FS, POSITION_LOOP_FS);
+    benchmark_step();
+    benchmark_stream();
+    benchmark_autotune();
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,14 @@
+/* ************************************************************************** */
+/** p32mz2048efm100.h (host simulation)
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim/proc/p32mz2048efm100.h
+
+  @Summary
+ The registers of the device are declared in sim/xc.h for the host simulation
+ */
+/* ************************************************************************** */
+#include <xc.h>
@@ -0,0 +1,146 @@
+/* ************************************************************************** */
+/** pwm_dither_sim.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ pwm_dither_sim.c
+
+  @Summary
+ Host simulation of the duty cycle dithering of PWM.c
+
+  @Description
+ Runs PWM.c on the PC at the 20KHz, 12 bit setting of the motors. Output Compare 1 is
+ * modeled per period: the period uses OC1R, at its end OC1RS is copied to OC1R and the
+ * Timer2 interrupt (PWM_dither_isr) runs.
+ * 1. Resolution: the mean duty cycle over windows of 1 ... 256 periods is compared with
+ *    the 16 bit duty cycle for random duty cycles, with and without dithering.
+ * 2. Limit cycle: the PI current loop of control.h (PID.c, 1KHz) drives a motor
+ *    modeled as a first order lag of the mean voltage (L/R = 0.5ms), with a reference
+ *    between two steps of the PWM. The ripple of the current seen by the loop is
+ *    compared with and without dithering.
+ *
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -O2 -Isim -I. -o pwm_dither_sim sim/pwm_dither_sim.c sim/sim_regs.c PWM.c
+ *     PID.c control_q31.c -lm && ./pwm_dither_sim
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <math.h>
+#include <xc.h>
+#include "PWM.h"
+#include "control.h"
+
+#define SIM_DUTY_CYCLES     4096    // random duty cycles of the resolution test
+#define SIM_TAU             0.5e-3  // L/R of the motor in s
+#define SIM_SECONDS         2       // of the limit cycle test, the first half settles
+
+void PWM_dither_isr();
+
+//one period of OC1, returns the compare value that was used
+static uint32_t sim_period(void)
+{
+    uint32_t compare = OC1R;
+    OC1R = OC1RS;                   // latched at the end of the period
+    if(IEC0bits.T2IE)
+        PWM_dither_isr();
+    return compare;
+}
+
+//largest error of the mean duty cycle in timer counts over windows of the given length
+static double resolution(uint8_t dither, uint32_t window)
+{
+    uint32_t seed = 12345, i, n;
+    double max_error = 0;
+
+    PWM_set_dither(PWM_CHANNEL_M1, dither);
+    for(i = 0; i < SIM_DUTY_CYCLES; ++i)
+    {
+        uint16_t duty;
+        double ideal, sum = 0, error;
+
+        seed = seed * 1664525 + 1013904223;
+        duty = (uint16_t)(seed >> 16);
+        if(duty == PWM_DUTY16_MAX)
+            continue;
+        ideal = (double)duty * PWM_period() / 65536.0;
+
+        PWM_set_duty16(PWM_CHANNEL_M1, duty);
+        sim_period();
+        sim_period();               // OC1R uses the new duty cycle from here
+        for(n = 0; n < window; ++n)
+            sum += sim_period();
+        error = fabs(sum / window - ideal);
+        if(error > max_error)
+            max_error = error;
+    }
+    return max_error;
+}
+
+//peak to peak and rms error of the current at the samples of the current loop
+static void limit_cycle(uint8_t dither, double *peak_to_peak, double *rms)
+{
+    const uint32_t periods_per_sample = PWM_FREQUENCY / CURRENT_LOOP_FS;
+    const double decay = 1.0 - exp(-1.0 / (PWM_FREQUENCY * SIM_TAU));
+    const int16_t reference = 3280;     // 0.1001 of the largest current, between two steps
+    pid_controller_t pid;
+    double current = 0, min = 1, max = -1, sum = 0;
+    uint32_t n, samples = 0;
+
+    PWM_set_dither(PWM_CHANNEL_M1, dither);
+    PID_init(&pid, CURRENT_KP, CURRENT_KI, 0, 0, PID_FILTER_NONE, -CURRENT_LIMIT, CURRENT_LIMIT);
+    PID_reset(&pid, 0);
+    PWM_set_duty16(PWM_CHANNEL_M1, CURRENT_LOOP_DUTY(0));
+
+    for(n = 0; n < SIM_SECONDS * PWM_FREQUENCY; ++n)
+    {
+        if(n % periods_per_sample == 0)
+        {
+            int16_t measurement = (int16_t)lrint(current * 32768.0);
+            if(n >= SIM_SECONDS * PWM_FREQUENCY / 2)
+            {
+                double error = (measurement - reference) / 32768.0;
+                if(error < min)
+                    min = error;
+                if(error > max)
+                    max = error;
+                sum += error * error;
+                ++samples;
+            }
+            PWM_set_duty16(PWM_CHANNEL_M1, CURRENT_LOOP_DUTY(PID_update(&pid, reference, measurement, 0)));
+        }
+        /*locked anti-phase: the mean voltage of a period is 2*duty-1 of the supply*/
+        current += (2.0 * sim_period() / PWM_period() - 1.0 - current) * decay;
+    }
+    *peak_to_peak = max - min;
+    *rms = sqrt(sum / samples);
+}
+
+int main()
+{
+    static const uint32_t windows[] = {1, 8, 32, 256};
+    double plain, dithered, peak_to_peak, rms;
+    uint8_t i, bits;
+
+    bits = PWM_init(PWM_FREQUENCY, PWM_RESOLUTION);
+    printf("PWM: %u steps per period, %u bits\n", (unsigned)PWM_period(), bits);
+
+    printf("\nlargest error of the mean duty cycle against the 16 bit duty cycle (timer counts, bits)\n");
+    printf("window    no dithering         dithering\n");
+    for(i = 0; i < sizeof(windows) / sizeof(windows[0]); ++i)
+    {
+        plain = resolution(0, windows[i]);
+        dithered = resolution(1, windows[i]);
+        printf("%4u   %8.4f %5.1f bits   %8.4f %5.1f bits\n", (unsigned)windows[i],
+               plain, log2(PWM_period() / plain), dithered, log2(PWM_period() / dithered));
+    }
+
+    printf("\ncurrent loop at 1KHz, error of the current in %% of full scale\n");
+    limit_cycle(0, &peak_to_peak, &rms);
+    printf("no dithering: peak to peak %.4f%%, rms %.4f%%\n", 100 * peak_to_peak, 100 * rms);
+    limit_cycle(1, &peak_to_peak, &rms);
+    printf("dithering:    peak to peak %.4f%%, rms %.4f%%\n", 100 * peak_to_peak, 100 * rms);
+    return 0;
+}
@@ -0,0 +1,101 @@
+/* ************************************************************************** */
+/** sim_adc.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_adc.c
+
+  @Summary
+ Model of the ADC for host simulation
+
+  @Description
+ getADC() sets GSWTRG and then polls ARDYx before it reads each result. The model
+ * does the conversion at the next access of a register, like the I2C1 model, so
+ * the polling loops end on their first pass.
+ */
+/* ************************************************************************** */
+
+#include <string.h>
+#include <math.h>
+#include <xc.h>
+#include "sim_adc.h"
+
+/*configuration registers without a function in the model*/
+volatile uint32_t ADC0CFG, ADC1CFG, ADC2CFG, ADC3CFG, ADC4CFG, ADC7CFG;
+volatile uint32_t DEVADC0, DEVADC1, DEVADC2, DEVADC3, DEVADC4, DEVADC7;
+volatile uint32_t ADCGIRQEN1, ADCGIRQEN2, ADCCSS1, ADCCSS2, ADCEIEN1, ADCEIEN2;
+volatile uint32_t ADCCMPCON1, ADCCMPCON2, ADCCMPCON3, ADCCMPCON4, ADCCMPCON5, ADCCMPCON6;
+volatile uint32_t ADCFLTR1, ADCFLTR2, ADCFLTR3, ADCFLTR4, ADCFLTR5, ADCFLTR6;
+volatile sim_ADCxTIME_t sim_ADC2TIME, sim_ADC3TIME, sim_ADC4TIME;
+volatile sim_ADCTRGMODE_t sim_ADCTRGMODE;
+volatile sim_ADCIMCON1_t sim_ADCIMCON1;
+volatile sim_ADCTRGSNS_t sim_ADCTRGSNS;
+volatile sim_ADCTRG1_t sim_ADCTRG1;
+volatile sim_ADCTRG2_t sim_ADCTRG2;
+
+uint32_t sim_adc_conversions = 0;
+
+static sim_adc_regs_t regs;
+static uint32_t data[SIM_ADC_INPUTS];
+static sim_adc_input_t input_voltage = 0;
+
+//12 bit result of a voltage
+static uint32_t convert(double volts)
+{
+    double code = floor(volts / SIM_ADC_VREF * 4096);
+
+    return code < 0 ? 0 : code > 4095 ? 4095 : (uint32_t)code;
+}
+
+/*Catch up with the bits set by the driver*/
+static void step(void)
+{
+    uint32_t enabled;
+    uint8_t i;
+
+    if(!regs.con1.ON)
+        return;
+    regs.con2.BGVRRDY = 1;
+    regs.con2.REFFLT = 0;
+    regs.ancon.w = (regs.ancon.w & ~0xFF00u) | (regs.ancon.w & 0xFF) << 8;   // WKRDYx follows ANENx
+
+    if(regs.con3.GSWTRG)
+    {
+        regs.con3.GSWTRG = 0;
+        enabled = regs.con3.w >> 16 & 0x1F;     // DIGEN0 ... DIGEN4
+        for(i = 0; i < SIM_ADC_INPUTS; ++i)
+            if(enabled & 1u << i)
+                data[i] = convert(input_voltage ? input_voltage(i) : 0);
+        ++sim_adc_conversions;
+        sim_advance(SIM_ADC_CONVERSION_NS);
+        regs.dstat1.w |= enabled;
+    }
+}
+
+sim_adc_regs_t *sim_adc(void)
+{
+    step();
+    return &regs;
+}
+
+uint32_t sim_adc_data(uint8_t input)
+{
+    step();
+    regs.dstat1.w &= ~(1u << input);
+    return data[input];
+}
+
+void sim_adc_reset(void)
+{
+    memset(&regs, 0, sizeof(regs));
+    memset(data, 0, sizeof(data));
+    input_voltage = 0;
+    sim_adc_conversions = 0;
+}
+
+void sim_adc_connect(sim_adc_input_t input)
+{
+    input_voltage = input;
+}
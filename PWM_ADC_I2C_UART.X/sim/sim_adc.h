@@ -0,0 +1,39 @@
+/* ************************************************************************** */
+/** sim_adc.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_adc.h
+
+  @Summary
+ Model of the ADC for host simulation
+
+  @Description
+ The model takes the place of the ADC registers used by ADC.c. The reference and
+ * the analog circuits are ready as soon as they are turned on. A software trigger
+ * samples the voltages of the connected inputs at the simulated time, advances the
+ * time by the conversion and sets ARDYx of the enabled inputs; reading ADCDATAx
+ * clears ARDYx. Results are unsigned 12 bit of the AVDD reference.
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_ADC_H    /* Guard against multiple inclusion */
+#define _SIM_ADC_H
+
+#include <stdint.h>
+
+#define SIM_ADC_INPUTS          5       // AN0 ... AN4, the Class 1 inputs
+#define SIM_ADC_VREF            3.3     // AVDD in V
+#define SIM_ADC_CONVERSION_NS   1000    // software trigger to the last result
+
+/*Voltage of an input at the simulated time, provided by the simulation*/
+typedef double (*sim_adc_input_t)(uint8_t input);
+
+extern uint32_t sim_adc_conversions;
+
+void sim_adc_reset(void);                   // Clear the registers and disconnect the inputs
+void sim_adc_connect(sim_adc_input_t input);
+
+#endif /* _SIM_ADC_H */
@@ -0,0 +1,117 @@
+/* ************************************************************************** */
+/** sim_as5600l.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_as5600l.c
+
+  @Summary
+ Model of the AS5600L encoder on the simulated I2C bus
+
+  @Description
+ A write transfer starts with the register address followed by data bytes for 
+ * consecutive registers. A read transfer returns consecutive registers starting at 
+ * the last register address, except for ANGLE, RAW ANGLE and MAGNITUDE: after their 
+ * low byte the register address points back to the high byte, so these can be 
+ * read over and over without sending the register address again.
+ */
+/* ************************************************************************** */
+
+#include <string.h>
+#include <xc.h>
+#include "header.h"
+#include "AS5600L.h"
+#include "sim_as5600l.h"
+
+#define STATUS_MD 0x20      /* magnet detected */
+
+static void update(sim_as5600l_t *enc)
+{
+    uint16_t zpos = ((enc->reg[SIM_AS5600L_ZPOS_H] & 0x0F) << 8) | enc->reg[SIM_AS5600L_ZPOS_H + 1];
+    uint16_t angle = (enc->raw_angle - zpos) & 0x0FFF;
+    
+    enc->reg[SIM_AS5600L_RAW_ANGLE_H] = enc->raw_angle >> 8;
+    enc->reg[SIM_AS5600L_RAW_ANGLE_H + 1] = enc->raw_angle & 0xFF;
+    enc->reg[ENCODER_ANGLE_REG] = angle >> 8;
+    enc->reg[ENCODER_ANGLE_REG + 1] = angle & 0xFF;
+}
+
+uint16_t sim_as5600l_angle(sim_as5600l_t *enc)
+{
+    return (enc->reg[ENCODER_ANGLE_REG] << 8) | enc->reg[ENCODER_ANGLE_REG + 1];
+}
+
+uint16_t sim_as5600l_pwm_high_clocks(sim_as5600l_t *enc)
+{
+    return ENCODER_PWM_HEADER_CLOCKS + sim_as5600l_angle(enc);
+}
+
+/*Bus callbacks*/
+static void enc_start(sim_i2c_device_t *dev, uint8_t read)
+{
+    sim_as5600l_t *enc = dev->state;
+    enc->pointer_set = read;        /* a read uses the register address of the previous write */
+}
+
+static uint8_t enc_write(sim_i2c_device_t *dev, uint8_t value)
+{
+    sim_as5600l_t *enc = dev->state;
+    
+    if(!enc->pointer_set)
+    {
+        enc->pointer = value;
+        enc->pointer_set = 1;
+        return 1;
+    }
+    ++enc->register_writes;
+    if(enc->pointer < SIM_AS5600L_STATUS)
+        enc->reg[enc->pointer] = value;     /* only the configuration registers are writable */
+    ++enc->pointer;
+    update(enc);
+    return 1;
+}
+
+static uint8_t enc_read(sim_i2c_device_t *dev)
+{
+    sim_as5600l_t *enc = dev->state;
+    uint8_t value = enc->reg[enc->pointer];
+    
+    ++enc->register_reads;
+    if(enc->pointer == SIM_AS5600L_RAW_ANGLE_H + 1 || enc->pointer == ENCODER_ANGLE_REG + 1 ||
+       enc->pointer == SIM_AS5600L_MAGNITUDE_H + 1)
+        --enc->pointer;             /* back to the high byte */
+    else
+        ++enc->pointer;
+    return value;
+}
+
+static void enc_stop(sim_i2c_device_t *dev)
+{
+    sim_as5600l_t *enc = dev->state;
+    enc->pointer_set = 0;
+}
+
+void sim_as5600l_init(sim_as5600l_t *enc, uint8_t address)
+{
+    memset(enc, 0, sizeof(*enc));
+    enc->dev.address = address;
+    enc->dev.start = enc_start;
+    enc->dev.write = enc_write;
+    enc->dev.read = enc_read;
+    enc->dev.stop = enc_stop;
+    enc->dev.state = enc;
+    
+    enc->reg[SIM_AS5600L_STATUS] = STATUS_MD;
+    enc->reg[SIM_AS5600L_MAGNITUDE_H] = 0x06;
+    enc->reg[SIM_AS5600L_MAGNITUDE_H + 1] = 0x40;
+    update(enc);
+    sim_i2c_attach(&enc->dev);
+}
+
+void sim_as5600l_set_angle(sim_as5600l_t *enc, uint16_t raw_angle)
+{
+    enc->raw_angle = raw_angle & 0x0FFF;
+    update(enc);
+}
@@ -0,0 +1,49 @@
+/* ************************************************************************** */
+/** sim_as5600l.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_as5600l.h
+
+  @Summary
+ Model of the AS5600L encoder on the simulated I2C bus
+
+  @Description
+ The model holds the register file of the encoder. The angle of the magnet is set 
+ * with sim_as5600l_set_angle() and is reported in RAW ANGLE and, relative to ZPOS, 
+ * in ANGLE. sim_as5600l_pwm_high_clocks() gives the high time of the PWM output 
+ * that the encoder generates for the same angle.
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_AS5600L_H    /* Guard against multiple inclusion */
+#define _SIM_AS5600L_H
+
+#include <stdint.h>
+#include "sim_i2c.h"
+
+#define SIM_AS5600L_ZPOS_H      0x01
+#define SIM_AS5600L_STATUS      0x0B
+#define SIM_AS5600L_RAW_ANGLE_H 0x0C
+#define SIM_AS5600L_MAGNITUDE_H 0x1B
+
+typedef struct
+{
+    sim_i2c_device_t dev;
+    uint8_t reg[256];               /* register file */
+    uint8_t pointer;                /* register address of the next access */
+    uint8_t pointer_set;            /* the register address has been received in this write */
+    uint16_t raw_angle;             /* angle of the magnet, 0-4095 */
+    uint32_t register_writes;
+    uint32_t register_reads;
+} sim_as5600l_t;
+
+/*Methods for the encoder model*/
+void sim_as5600l_init(sim_as5600l_t *enc, uint8_t address);    // Reset the registers and put the encoder on the bus
+void sim_as5600l_set_angle(sim_as5600l_t *enc, uint16_t raw_angle);
+uint16_t sim_as5600l_angle(sim_as5600l_t *enc);                 // ANGLE register as the driver should read it
+uint16_t sim_as5600l_pwm_high_clocks(sim_as5600l_t *enc);       // high time of the 4351 clock PWM frame
+
+#endif /* _SIM_AS5600L_H */
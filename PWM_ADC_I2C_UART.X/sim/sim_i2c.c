@@ -0,0 +1,234 @@
+/* ************************************************************************** */
+/** sim_i2c.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_i2c.c
+
+  @Summary
+ Model of the I2C1 peripheral in master mode for host simulation
+
+  @Description
+ The driver in I2C.c sets a control bit (SEN, RSEN, PEN, RCEN, ACKEN) or writes
+ * I2C1TRN and then polls the registers until the hardware is done. The model does
+ * the work of the hardware at the next access of a register: the bus event is passed
+ * to the addressed device, the simulated time advances by the duration of the event
+ * on the bus and the control bit is cleared, so the polling loop of the driver ends.
+ * Durations in SCL periods: start, restart, stop and ACK/NACK take 1, a written
+ * byte takes 9 (8 bits and the ACK of the device) and a read byte takes 8.
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+#include "header.h"
+#include "sim_i2c.h"
+
+#define SIM_I2C_STUCK_POLLS 1000000     // polls without any bus event after which the driver is considered stuck
+
+/*Phase of the transfer on the bus*/
+#define PHASE_IDLE    0     // no start condition
+#define PHASE_ADDRESS 1     // next byte is the address of the device
+#define PHASE_WRITE   2     // master writes to the device
+#define PHASE_READ    3     // master reads from the device
+
+sim_i2c_stats_t sim_i2c_stats;
+
+static sim_i2c_regs_t regs;
+static sim_i2c_device_t *devices[SIM_I2C_MAX_DEVICES];
+static sim_i2c_device_t *current;
+static uint8_t phase = PHASE_IDLE;
+static uint8_t trn_pending = 0;
+static uint32_t idle_polls = 0;
+
+/*SCL frequency that follows from I2C1BRG, inverse of the formula in I2C_init()*/
+uint32_t sim_i2c_scl_frequency(void)
+{
+    return 1000000000ull / (2 * ((uint64_t)(regs.brg + 2) * 1000000000ull / PBCLK2_FREQ + SIM_I2C_TPGD_NS));
+}
+
+/*Let the bus be busy for [periods] SCL periods*/
+static void bus_busy(uint32_t periods)
+{
+    uint64_t ns = (uint64_t)periods * 1000000000ull / sim_i2c_scl_frequency();
+    sim_i2c_stats.busy_ns += ns;
+    sim_advance(ns);
+}
+
+static void protocol_error(const char *what)
+{
+    ++sim_i2c_stats.errors;
+    fprintf(stderr, "sim_i2c: %s\n", what);
+}
+
+/*Byte written to I2C1TRN has been shifted out*/
+static void transmit(uint8_t value)
+{
+    uint8_t ack = 0;
+    uint8_t i;
+    
+    ++sim_i2c_stats.bytes_written;
+    if(phase == PHASE_ADDRESS)
+    {
+        current = NULL;
+        for(i = 0; i < SIM_I2C_MAX_DEVICES; ++i)
+        {
+            if(devices[i] && devices[i]->address == (value >> 1))
+                current = devices[i];
+        }
+        if(current)
+        {
+            current->start(current, value & 1);
+            ack = 1;
+        }
+        phase = (value & 1) ? PHASE_READ : PHASE_WRITE;
+    }
+    else if(phase == PHASE_WRITE)
+    {
+        ack = current ? current->write(current, value) : 0;
+    }
+    else
+    {
+        protocol_error("byte written to I2C1TRN while the bus is not addressed for a write");
+    }
+    
+    if(!ack)
+        ++sim_i2c_stats.nacks;
+    regs.stat.ACKSTAT = !ack;
+    bus_busy(9);
+    regs.stat.TBF = 0;
+    regs.stat.TRSTAT = 0;
+}
+
+/*Catch up with the bits set and the bytes written by the driver*/
+static void step(void)
+{
+    uint8_t event = 0;
+    
+    if(!regs.con.ON)
+        return;
+    
+    if(regs.con.SEN)
+    {
+        if(phase != PHASE_IDLE)
+            protocol_error("start condition while the bus is busy");
+        ++sim_i2c_stats.starts;
+        phase = PHASE_ADDRESS;
+        bus_busy(1);
+        regs.con.SEN = 0;
+        event = 1;
+    }
+    if(regs.con.RSEN)
+    {
+        if(phase == PHASE_IDLE)
+            protocol_error("repeated start condition without a start condition");
+        ++sim_i2c_stats.restarts;
+        phase = PHASE_ADDRESS;
+        bus_busy(1);
+        regs.con.RSEN = 0;
+        event = 1;
+    }
+    if(trn_pending)
+    {
+        trn_pending = 0;
+        transmit(regs.trn);
+        event = 1;
+    }
+    if(regs.con.RCEN)
+    {
+        if(phase != PHASE_READ)
+            protocol_error("receive enabled while the bus is not addressed for a read");
+        if(regs.stat.RBF)
+            regs.stat.I2COV = 1;
+        regs.rcv = (phase == PHASE_READ && current) ? current->read(current) : 0xFF;
+        ++sim_i2c_stats.bytes_read;
+        bus_busy(8);
+        regs.stat.RBF = 1;
+        regs.con.RCEN = 0;
+        event = 1;
+    }
+    if(regs.con.ACKEN)
+    {
+        bus_busy(1);
+        regs.con.ACKEN = 0;
+        event = 1;
+    }
+    if(regs.con.PEN)
+    {
+        if(current)
+            current->stop(current);
+        current = NULL;
+        ++sim_i2c_stats.stops;
+        phase = PHASE_IDLE;
+        bus_busy(1);
+        regs.con.PEN = 0;
+        event = 1;
+    }
+    
+    if(event)
+    {
+        idle_polls = 0;
+    }
+    else if(++idle_polls > SIM_I2C_STUCK_POLLS)
+    {
+        fprintf(stderr, "sim_i2c: driver is stuck polling I2C1 (ACKSTAT=%d), no device will answer\n", regs.stat.ACKSTAT);
+        exit(1);
+    }
+}
+
+sim_i2c_regs_t *sim_i2c1(void)
+{
+    step();
+    return &regs;
+}
+
+uint32_t *sim_i2c1_trn(void)
+{
+    step();
+    regs.stat.TBF = 1;
+    regs.stat.TRSTAT = 1;
+    trn_pending = 1;
+    return &regs.trn;
+}
+
+uint32_t sim_i2c1_rcv(void)
+{
+    step();
+    regs.stat.RBF = 0;
+    return regs.rcv & 0xFF;
+}
+
+void sim_i2c_attach(sim_i2c_device_t *dev)
+{
+    uint8_t i;
+    for(i = 0; i < SIM_I2C_MAX_DEVICES; ++i)
+    {
+        if(!devices[i])
+        {
+            devices[i] = dev;
+            return;
+        }
+    }
+    fprintf(stderr, "sim_i2c: no room for device 0x%02X\n", dev->address);
+    exit(1);
+}
+
+void sim_i2c_reset(void)
+{
+    memset(&regs, 0, sizeof(regs));
+    memset(devices, 0, sizeof(devices));
+    current = NULL;
+    phase = PHASE_IDLE;
+    trn_pending = 0;
+    idle_polls = 0;
+    sim_i2c_reset_stats();
+}
+
+void sim_i2c_reset_stats(void)
+{
+    memset(&sim_i2c_stats, 0, sizeof(sim_i2c_stats));
+}
@@ -0,0 +1,62 @@
+/* ************************************************************************** */
+/** sim_i2c.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_i2c.h
+
+  @Summary
+ Model of the I2C1 peripheral and of the devices on the bus for host simulation
+
+  @Description
+ The model takes the place of the I2C1 registers used by I2C.c. Every start,
+ * restart, stop, byte and ACK/NACK sent by the driver is passed to the device
+ * addressed on the bus and advances the simulated time by the number of SCL
+ * periods it takes at the baud rate set in I2C1BRG.
+ * The counters in sim_i2c_stats can be used to check the traffic generated by a driver.
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_I2C_H    /* Guard against multiple inclusion */
+#define _SIM_I2C_H
+
+#include <stdint.h>
+
+#define SIM_I2C_MAX_DEVICES 4
+#define SIM_I2C_TPGD_NS 104         // Pulse gobbler delay used in the baud rate formula of the data sheet
+
+/*A device on the bus, implemented by sim_mpu9250.c and sim_as5600l.c*/
+typedef struct sim_i2c_device
+{
+    uint8_t address;                                        /* 7 bit address */
+    void (*start)(struct sim_i2c_device *dev, uint8_t read);/* device has been addressed */
+    uint8_t (*write)(struct sim_i2c_device *dev, uint8_t value); /* byte from the master, return 1 to ACK */
+    uint8_t (*read)(struct sim_i2c_device *dev);            /* byte to the master */
+    void (*stop)(struct sim_i2c_device *dev);               /* stop condition */
+    void *state;
+} sim_i2c_device_t;
+
+/*Traffic on the bus since the last call to sim_i2c_reset_stats()*/
+typedef struct
+{
+    uint32_t starts;
+    uint32_t restarts;
+    uint32_t stops;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    uint32_t nacks;             /* bytes that were not acknowledged by a device */
+    uint32_t errors;            /* protocol errors, e.g. a byte sent without a start condition */
+    uint64_t busy_ns;           /* time the bus was busy */
+} sim_i2c_stats_t;
+
+extern sim_i2c_stats_t sim_i2c_stats;
+
+/*Methods of the bus model*/
+void sim_i2c_attach(sim_i2c_device_t *dev);     // Put a device on the bus
+void sim_i2c_reset(void);                       // Remove all devices and clear the registers
+void sim_i2c_reset_stats(void);
+uint32_t sim_i2c_scl_frequency(void);           // SCL frequency that follows from I2C1BRG
+
+#endif /* _SIM_I2C_H */
@@ -0,0 +1,230 @@
+/* ************************************************************************** */
+/** sim_mpu9250.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_mpu9250.c
+
+  @Summary
+ Model of the MPU9250 IMU on the simulated I2C bus
+
+  @Description
+ A write transfer starts with the register address followed by data bytes for 
+ * consecutive registers. A read transfer returns consecutive registers starting at 
+ * the last register address. Reading FIFO_R_W pops a byte from the FIFO and does not 
+ * increment the register address.
+ * The accelerometer output follows the offset registers the same way as the IMU:
+ * the 15 bit offset (bit 0 is reserved) is in units of 0.98mg, i.e. one count of 
+ * the 16 bit register value equals one output count at the 16g full scale range.
+ */
+/* ************************************************************************** */
+
+#include <math.h>
+#include <string.h>
+#include <xc.h>
+#include "header.h"
+#include "mpu9250.h"
+#include "sim_mpu9250.h"
+
+#define FIFO_EN_TEMP  0x80
+#define FIFO_EN_GYRO  0x70
+#define FIFO_EN_ACCEL 0x08
+#define USER_CTRL_FIFO_EN  0x40
+#define USER_CTRL_FIFO_RST 0x04
+#define INT_STATUS_FIFO_OFLOW 0x10
+#define INT_STATUS_RAW_DATA_RDY 0x01
+
+static const uint8_t accel_offset_register[3] = {XA_OFFSET_H, YA_OFFSET_H, ZA_OFFSET_H};
+
+static void put16(sim_mpu9250_t *imu, uint8_t data_address, int32_t value)
+{
+    if(value > 32767)
+        value = 32767;
+    if(value < -32768)
+        value = -32768;
+    imu->reg[data_address] = (uint16_t)value >> 8;
+    imu->reg[data_address + 1] = (uint16_t)value & 0xFF;
+}
+
+int16_t sim_mpu9250_register16(sim_mpu9250_t *imu, uint8_t data_address)
+{
+    return (int16_t)((imu->reg[data_address] << 8) | imu->reg[data_address + 1]);
+}
+
+static void fifo_put(sim_mpu9250_t *imu, uint8_t value)
+{
+    if(imu->fifo_count == SIM_MPU9250_FIFO_SIZE)
+    {
+        /*FIFO is full, the oldest byte is overwritten*/
+        imu->fifo_head = (imu->fifo_head + 1) % SIM_MPU9250_FIFO_SIZE;
+        --imu->fifo_count;
+        imu->reg[INT_STATUS] |= INT_STATUS_FIFO_OFLOW;
+    }
+    imu->fifo[(imu->fifo_head + imu->fifo_count) % SIM_MPU9250_FIFO_SIZE] = value;
+    ++imu->fifo_count;
+}
+
+static void fifo_push(sim_mpu9250_t *imu, uint8_t data_address, uint8_t length)
+{
+    uint8_t i;
+    for(i = 0; i < length; ++i)
+        fifo_put(imu, imu->reg[data_address + i]);
+}
+
+/*Latch one sample of every sensor that is not switched off in PWR_MGMT_2*/
+static void take_sample(sim_mpu9250_t *imu)
+{
+    /*full scale range of 2,4,8,16g and 250,500,1000,2000dps*/
+    double accel_lsb = 16384.0 / (1 << ((imu->reg[ACCEL_CONFIG] >> 3) & 3));
+    double gyro_lsb = 131.0 / (1 << ((imu->reg[GYRO_CONFIG] >> 3) & 3));
+    uint8_t i;
+    
+    for(i = 0; i < 3; ++i)
+    {
+        if(!(imu->reg[PWR_MGMT_2] & (0x20 >> i)))
+        {
+            uint8_t r = accel_offset_register[i];
+            int32_t offset = (int16_t)((imu->reg[r] << 8) | (imu->reg[r + 1] & 0xFE)) - (int16_t)(imu->factory_trim[i] & 0xFFFE);
+            put16(imu, ACCEL_XOUT_H + 2 * i, lround((imu->accel_g[i] + imu->accel_bias_g[i]) * accel_lsb + offset * accel_lsb / 2048.0));
+        }
+        if(!(imu->reg[PWR_MGMT_2] & (0x04 >> i)))
+            put16(imu, GYRO_XOUT_H + 2 * i, lround(imu->gyro_dps[i] * gyro_lsb));
+    }
+    put16(imu, TEMP_OUT_H, lround((imu->temperature - 21.0) * 333.87));
+    imu->reg[INT_STATUS] |= INT_STATUS_RAW_DATA_RDY;
+    
+    if(imu->reg[USER_CTRL] & USER_CTRL_FIFO_EN)
+    {
+        /*the order in the FIFO follows the register order*/
+        if(imu->reg[FIFO_EN] & FIFO_EN_ACCEL)
+            fifo_push(imu, ACCEL_XOUT_H, 6);
+        if(imu->reg[FIFO_EN] & FIFO_EN_TEMP)
+            fifo_push(imu, TEMP_OUT_H, 2);
+        for(i = 0; i < 3; ++i)
+        {
+            if(imu->reg[FIFO_EN] & (0x40 >> i))
+                fifo_push(imu, GYRO_XOUT_H + 2 * i, 2);
+        }
+    }
+}
+
+void sim_mpu9250_sample(sim_mpu9250_t *imu)
+{
+    uint64_t period_ns = 1000000ull * (1 + imu->reg[SMPLRT_DIV]);
+    uint64_t due = sim_time_ns / period_ns;
+    
+    while(imu->samples < due)
+    {
+        take_sample(imu);
+        ++imu->samples;
+    }
+    imu->reg[FIFO_COUNTH] = imu->fifo_count >> 8;
+    imu->reg[FIFO_COUNTL] = imu->fifo_count & 0xFF;
+}
+
+/*Bus callbacks*/
+static void imu_start(sim_i2c_device_t *dev, uint8_t read)
+{
+    sim_mpu9250_t *imu = dev->state;
+    sim_mpu9250_sample(imu);
+    imu->pointer_set = read;        /* a read uses the register address of the previous write */
+}
+
+static uint8_t imu_write(sim_i2c_device_t *dev, uint8_t value)
+{
+    sim_mpu9250_t *imu = dev->state;
+    
+    if(!imu->pointer_set)
+    {
+        imu->pointer = value & 0x7F;
+        imu->pointer_set = 1;
+        return 1;
+    }
+    
+    ++imu->register_writes;
+    if(imu->pointer == FIFO_R_W)
+    {
+        fifo_put(imu, value);
+        return 1;
+    }
+    if(imu->pointer == WHO_AM_I_MPU9250)
+        return 1;                   /* read only */
+    imu->reg[imu->pointer] = value;
+    if(imu->pointer == USER_CTRL && (value & USER_CTRL_FIFO_RST))
+    {
+        imu->fifo_head = 0;
+        imu->fifo_count = 0;
+        imu->reg[USER_CTRL] &= ~USER_CTRL_FIFO_RST;
+    }
+    imu->pointer = (imu->pointer + 1) & 0x7F;
+    return 1;
+}
+
+static uint8_t imu_read(sim_i2c_device_t *dev)
+{
+    sim_mpu9250_t *imu = dev->state;
+    uint8_t value;
+    
+    ++imu->register_reads;
+    if(imu->pointer == FIFO_R_W)
+    {
+        if(!imu->fifo_count)
+            return 0xFF;
+        value = imu->fifo[imu->fifo_head];
+        imu->fifo_head = (imu->fifo_head + 1) % SIM_MPU9250_FIFO_SIZE;
+        --imu->fifo_count;
+        return value;
+    }
+    value = imu->reg[imu->pointer];
+    if(imu->pointer == INT_STATUS)
+        imu->reg[INT_STATUS] = 0;   /* cleared on read */
+    imu->pointer = (imu->pointer + 1) & 0x7F;
+    return value;
+}
+
+static void imu_stop(sim_i2c_device_t *dev)
+{
+    sim_mpu9250_t *imu = dev->state;
+    imu->pointer_set = 0;
+}
+
+void sim_mpu9250_init(sim_mpu9250_t *imu, uint8_t address)
+{
+    uint8_t i;
+    
+    memset(imu, 0, sizeof(*imu));
+    imu->dev.address = address;
+    imu->dev.start = imu_start;
+    imu->dev.write = imu_write;
+    imu->dev.read = imu_read;
+    imu->dev.stop = imu_stop;
+    imu->dev.state = imu;
+    
+    imu->reg[PWR_MGMT_1] = 0x01;
+    imu->reg[WHO_AM_I_MPU9250] = 0x71;
+    imu->factory_trim[0] = 0xE2A4;  /* factory trim differs for every part */
+    imu->factory_trim[1] = 0x1B62;
+    imu->factory_trim[2] = 0x2C1B;
+    for(i = 0; i < 3; ++i)
+    {
+        imu->reg[accel_offset_register[i]] = imu->factory_trim[i] >> 8;
+        imu->reg[accel_offset_register[i] + 1] = imu->factory_trim[i] & 0xFF;
+    }
+    imu->accel_g[2] = 1.0;          /* lying flat */
+    imu->temperature = 25.0;
+    imu->samples = sim_time_ns / 1000000ull;
+    sim_i2c_attach(&imu->dev);
+}
+
+void sim_mpu9250_set_motion(sim_mpu9250_t *imu, const double accel_g[3], const double gyro_dps[3])
+{
+    uint8_t i;
+    sim_mpu9250_sample(imu);        /* samples taken so far used the previous motion */
+    for(i = 0; i < 3; ++i)
+    {
+        imu->accel_g[i] = accel_g[i];
+        imu->gyro_dps[i] = gyro_dps[i];
+    }
+}
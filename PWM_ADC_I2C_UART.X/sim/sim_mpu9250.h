@@ -0,0 +1,55 @@
+/* ************************************************************************** */
+/** sim_mpu9250.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_mpu9250.h
+
+  @Summary
+ Model of the MPU9250 IMU on the simulated I2C bus
+
+  @Description
+ The model holds the register file of the IMU with auto incrementing register 
+ * address, the accelerometer offset registers and the FIFO. The sensor registers 
+ * are sampled at 1kHz/(1+SMPLRT_DIV) of the simulated time from the motion set 
+ * with sim_mpu9250_set_motion(), scaled with the full scale range in ACCEL_CONFIG 
+ * and GYRO_CONFIG.
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_MPU9250_H    /* Guard against multiple inclusion */
+#define _SIM_MPU9250_H
+
+#include <stdint.h>
+#include "sim_i2c.h"
+
+#define SIM_MPU9250_FIFO_SIZE 512
+
+typedef struct
+{
+    sim_i2c_device_t dev;
+    uint8_t reg[128];               /* register file */
+    uint8_t pointer;                /* register address of the next access */
+    uint8_t pointer_set;            /* the register address has been received in this write */
+    uint16_t factory_trim[3];       /* reset value of the accelerometer offset registers */
+    double accel_g[3];              /* acceleration sensed by the IMU in g */
+    double accel_bias_g[3];         /* bias of this board that is left after the factory trim */
+    double gyro_dps[3];             /* angular rate in degrees/s */
+    double temperature;             /* in degrees Celsius */
+    uint8_t fifo[SIM_MPU9250_FIFO_SIZE];
+    uint16_t fifo_head;
+    uint16_t fifo_count;
+    uint64_t samples;               /* number of samples taken so far */
+    uint32_t register_writes;
+    uint32_t register_reads;
+} sim_mpu9250_t;
+
+/*Methods for the IMU model*/
+void sim_mpu9250_init(sim_mpu9250_t *imu, uint8_t address);     // Reset the registers and put the IMU on the bus
+void sim_mpu9250_set_motion(sim_mpu9250_t *imu, const double accel_g[3], const double gyro_dps[3]);
+void sim_mpu9250_sample(sim_mpu9250_t *imu);                    // Take the samples that are due at the simulated time
+int16_t sim_mpu9250_register16(sim_mpu9250_t *imu, uint8_t data_address); // Big endian register pair as the driver should read it
+
+#endif /* _SIM_MPU9250_H */
@@ -0,0 +1,104 @@
+/* ************************************************************************** */
+/** sim_plant.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_plant.c
+
+  @Summary
+ Model of a joint of the exoskeleton: DC motor, gearbox and link, with its sensors
+
+  @Description
+ Over a step the back EMF is held, so the current follows its exact exponential
+ * response to the voltage; the link is integrated with semi-implicit Euler. The
+ * Coulomb friction only slows the link down to rest, so it sticks while the other
+ * torques stay below the friction torque.
+ * The noise is a fixed pseudo random sequence, runs are repeatable.
+ */
+/* ************************************************************************** */
+
+#include <math.h>
+#include "sim_plant.h"
+
+static uint32_t noise_state = 1;
+
+void sim_plant_seed(uint32_t seed)
+{
+    noise_state = seed ? seed : 1;
+}
+
+//normal distribution, sum of 4 uniform numbers
+static double noise(void)
+{
+    double sum = 0;
+    uint8_t i;
+
+    for(i = 0; i < 4; ++i)
+    {
+        noise_state = noise_state * 1664525u + 1013904223u;
+        sum += (noise_state >> 8) / 16777216.0;
+    }
+    return (sum - 2.0) * sqrt(3.0);
+}
+
+void sim_joint_init(sim_joint_t *joint, const sim_joint_params_t *params, double angle)
+{
+    joint->p = *params;
+    joint->current = 0;
+    joint->angle = angle;
+    joint->velocity = 0;
+    joint->acceleration = 0;
+}
+
+void sim_joint_step(sim_joint_t *joint, double voltage, uint64_t ns)
+{
+    const sim_joint_params_t *p = &joint->p;
+    double inertia = p->link_inertia + p->rotor_inertia * p->ratio * p->ratio;
+    double dt, target, torque, velocity, friction;
+
+    while(ns)
+    {
+        dt = (ns > SIM_PLANT_STEP_NS ? SIM_PLANT_STEP_NS : ns) * 1e-9;
+        ns -= ns > SIM_PLANT_STEP_NS ? SIM_PLANT_STEP_NS : ns;
+
+        /*motor*/
+        target = (voltage - p->torque_constant * p->ratio * joint->velocity) / p->resistance;
+        joint->current = target + (joint->current - target) * exp(-dt * p->resistance / p->inductance);
+
+        /*link*/
+        torque = p->efficiency * p->ratio * p->torque_constant * joint->current
+                 - p->mass * SIM_GRAVITY * p->com * sin(joint->angle) - p->viscous * joint->velocity;
+        velocity = joint->velocity + torque / inertia * dt;
+        friction = p->coulomb / inertia * dt;
+        if(fabs(velocity) <= friction)
+            velocity = 0;
+        else
+            velocity -= velocity > 0 ? friction : -friction;
+        joint->acceleration = (velocity - joint->velocity) / dt;
+        joint->velocity = velocity;
+        joint->angle += velocity * dt;
+    }
+}
+
+double sim_joint_current_sensor(const sim_joint_t *joint)
+{
+    return SIM_CURRENT_SENSOR_OFFSET + SIM_CURRENT_SENSOR_GAIN * joint->current + SIM_CURRENT_SENSOR_NOISE * noise();
+}
+
+uint16_t sim_joint_encoder(const sim_joint_t *joint)
+{
+    return (uint16_t)((long)floor(2048.5 + joint->angle / (2 * M_PI) * 4096) & 0x0FFF);
+}
+
+void sim_joint_imu(const sim_joint_t *joint, double radius, double accel_g[3], double gyro_dps[3])
+{
+    /*acceleration of the IMU minus gravity, in the frame of the link*/
+    accel_g[0] = (-radius * joint->velocity * joint->velocity) / SIM_GRAVITY - cos(joint->angle);
+    accel_g[1] = (radius * joint->acceleration) / SIM_GRAVITY + sin(joint->angle);
+    accel_g[2] = 0;
+    gyro_dps[0] = 0;
+    gyro_dps[1] = 0;
+    gyro_dps[2] = joint->velocity * 180.0 / M_PI;
+}
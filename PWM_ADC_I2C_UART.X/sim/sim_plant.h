@@ -0,0 +1,74 @@
+/* ************************************************************************** */
+/** sim_plant.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_plant.h
+
+  @Summary
+ Model of a joint of the exoskeleton: DC motor, gearbox and link, with its sensors
+
+  @Description
+ Motor: L di/dt = V - R i - Kt N w, the torque at the joint is eta N Kt i.
+ * Link: J dw/dt = eta N Kt i - m g r sin(angle) - b w - c sign(w), with the inertia
+ * of the rotor seen through the gearbox in J. The angle is 0 with the link hanging
+ * down. The state is integrated in steps of at most SIM_PLANT_STEP_NS.
+ * Sensors:
+ *  - current: Hall sensor around mid supply (SIM_CURRENT_SENSOR_*) with noise,
+ *    the voltage at the ADC input
+ *  - angle: raw 12 bit angle of an AS5600L, 2048 with the link hanging down
+ *  - IMU on the link at a distance from the joint: specific force in g (x along the
+ *    link away from the joint, y tangential, z the joint axis) and rate in dps
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_PLANT_H    /* Guard against multiple inclusion */
+#define _SIM_PLANT_H
+
+#include <stdint.h>
+
+#define SIM_PLANT_STEP_NS           5000    // largest integration step
+#define SIM_GRAVITY                 9.81
+#define SIM_CURRENT_SENSOR_OFFSET   1.65    // V at zero current
+#define SIM_CURRENT_SENSOR_GAIN     0.165   // V/A, +-10A over the ADC range
+#define SIM_CURRENT_SENSOR_NOISE    0.0008  // V rms, about one LSB of the ADC
+
+/*Parameters of a joint*/
+typedef struct
+{
+    double resistance;      // Ohm
+    double inductance;      // H
+    double torque_constant; // Nm/A, equal to the back EMF constant in Vs/rad
+    double rotor_inertia;   // kgm^2
+    double ratio;           // gearbox, motor turns per joint turn
+    double efficiency;
+    double link_inertia;    // kgm^2 about the joint
+    double mass;            // kg of the link
+    double com;             // m from the joint to the center of mass
+    double viscous;         // Nms/rad at the joint
+    double coulomb;         // Nm at the joint
+} sim_joint_params_t;
+
+/*State of a joint*/
+typedef struct
+{
+    sim_joint_params_t p;
+    double current;         // A
+    double angle;           // rad
+    double velocity;        // rad/s
+    double acceleration;    // rad/s^2
+} sim_joint_t;
+
+void sim_joint_init(sim_joint_t *joint, const sim_joint_params_t *params, double angle);
+void sim_joint_step(sim_joint_t *joint, double voltage, uint64_t ns);    // Integrate with the motor voltage held for ns
+
+/*Sensors*/
+double sim_joint_current_sensor(const sim_joint_t *joint);     // V at the ADC input
+uint16_t sim_joint_encoder(const sim_joint_t *joint);          // raw angle of the AS5600L
+void sim_joint_imu(const sim_joint_t *joint, double radius, double accel_g[3], double gyro_dps[3]);
+
+void sim_plant_seed(uint32_t seed);                              // Restart the noise
+
+#endif /* _SIM_PLANT_H */
@@ -0,0 +1,212 @@
+/* ************************************************************************** */
+/** sim_regs.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_regs.c
+
+  @Summary
+ Storage of the registers that are not modeled and the simulated time
+
+  @Description
+ The registers declared in sim/xc.h that do not belong to a modeled peripheral
+ * are plain memory defined here. The simulated time only advances when a model
+ * says so, e.g. while a byte is on the I2C bus. A simulation can follow the time
+ * with sim_time_hook, e.g. to run its own models and interrupts.
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <xc.h>
+#include "header.h"
+
+/*I/O ports*/
+volatile sim_ANSELA_t sim_ANSELA; volatile sim_ANSELB_t sim_ANSELB; volatile sim_ANSELC_t sim_ANSELC;
+volatile sim_ANSELD_t sim_ANSELD; volatile sim_ANSELE_t sim_ANSELE; volatile sim_ANSELF_t sim_ANSELF;
+volatile sim_ANSELG_t sim_ANSELG;
+volatile sim_TRISA_t sim_TRISA; volatile sim_TRISB_t sim_TRISB; volatile sim_TRISC_t sim_TRISC;
+volatile sim_TRISD_t sim_TRISD; volatile sim_TRISE_t sim_TRISE; volatile sim_TRISF_t sim_TRISF;
+volatile sim_TRISG_t sim_TRISG;
+volatile sim_PORTA_t sim_PORTA; volatile sim_PORTB_t sim_PORTB; volatile sim_PORTC_t sim_PORTC;
+volatile sim_PORTD_t sim_PORTD; volatile sim_PORTE_t sim_PORTE; volatile sim_PORTF_t sim_PORTF;
+volatile sim_PORTG_t sim_PORTG;
+volatile sim_LATA_t sim_LATA; volatile sim_LATB_t sim_LATB; volatile sim_LATC_t sim_LATC;
+volatile sim_LATD_t sim_LATD; volatile sim_LATE_t sim_LATE; volatile sim_LATF_t sim_LATF;
+volatile sim_LATG_t sim_LATG;
+
+volatile uint32_t RPG8R, SDI2R;
+void (*sim_latg_hook)(void) = 0;
+
+volatile uint32_t *sim_latg(void)
+{
+    if(sim_latg_hook)
+        sim_latg_hook();
+    return &sim_LATG.w;
+}
+
+/*Interrupt controller*/
+volatile sim_IFS0_t sim_IFS0;
+volatile sim_IEC0_t sim_IEC0;
+volatile sim_IFS1_t sim_IFS1;
+volatile sim_IEC1_t sim_IEC1;
+volatile sim_IPC0_t sim_IPC0;
+volatile sim_IPC1_t sim_IPC1;
+volatile sim_IPC2_t sim_IPC2;
+volatile sim_IPC7_t sim_IPC7;
+
+/*Timer2, Timer3, Timer6, Input Capture and Output Compare*/
+volatile sim_TxCON_t sim_T2CON;
+volatile uint32_t TMR2, PR2;
+volatile uint32_t OC1CON, OC2CON, OC3CON, OC4CON, OC1R, OC2R, OC3R, OC4R, OC1RS, OC2RS, OC3RS, OC4RS;
+volatile uint32_t RPE8R, RPF2R;
+volatile sim_TxCON_t sim_T3CON;
+volatile uint32_t TMR3, PR3, IC1R, IC2R;
+volatile sim_TxCON_t sim_T6CON;
+volatile uint32_t TMR6, PR6;
+
+/*UART1*/
+volatile sim_UxMODE_t sim_U1MODE;
+volatile sim_UxSTA_t sim_U1STA;
+volatile sim_IFS3_t sim_IFS3;
+volatile sim_IEC3_t sim_IEC3;
+volatile sim_IPC28_t sim_IPC28;
+volatile uint32_t U1BRG, U1TXREG, U1RXREG, U1RXR, RPD15R;
+
+/*DMA controller, the channels are modeled by sim_spi.c*/
+volatile sim_DMACON_t sim_DMACON;
+
+/*Flash controller*/
+volatile sim_NVMCON_t sim_NVMCON;
+volatile uint32_t NVMCONCLR, NVMCONSET, NVMKEY, NVMADDR, NVMDATA0, NVMDATA1, NVMDATA2, NVMDATA3;
+
+/*Simulated time and core timer*/
+uint64_t sim_time_ns = 0;
+void (*sim_time_hook)(void) = 0;
+static uint32_t core_count_offset = 0;
+
+void sim_advance(uint64_t ns)
+{
+    sim_time_ns += ns;
+    if(sim_time_hook)
+        sim_time_hook();
+}
+
+uint32_t sim_core_count(void)
+{
+    return (uint32_t)(sim_time_ns * (SYS_FREQ / 2 / 1000000) / 1000) + core_count_offset;
+}
+
+void sim_core_set_count(uint32_t count)
+{
+    core_count_offset = 0;
+    core_count_offset = count - sim_core_count();
+}
+
+/*Core software interrupts, the flag follows a request in Cause and is cleared by the ISR*/
+static uint32_t cause;
+
+void sim_cause_set(uint32_t mask)
+{
+    cause |= mask;
+    if(mask & 0x100)
+        sim_IFS0.CS0IF = 1;
+    if(mask & 0x200)
+        sim_IFS0.CS1IF = 1;
+}
+
+void sim_cause_clear(uint32_t mask)
+{
+    cause &= ~mask;
+}
+
+/*Input Capture 1 and 2*/
+#define SIM_IC_BUFFER   4
+
+static volatile sim_ICxCON_t ic_con[2];
+static uint16_t ic_buffer[2][SIM_IC_BUFFER];
+static uint8_t ic_head[2], ic_count[2], ic_first[2];
+
+//catch up with ON, a module that is off loses its captures and waits for its first edge
+static void ic_step(uint8_t module)
+{
+    if(!ic_con[module].ON)
+    {
+        ic_count[module] = 0;
+        ic_con[module].ICOV = 0;
+        ic_first[module] = 1;
+    }
+    ic_con[module].ICBNE = ic_count[module] != 0;
+}
+
+volatile sim_ICxCON_t *sim_ic_con(uint8_t module)
+{
+    ic_step(module);
+    return &ic_con[module];
+}
+
+uint32_t sim_ic_buf(uint8_t module)
+{
+    uint16_t value = ic_buffer[module][ic_head[module]];
+
+    ic_step(module);
+    if(ic_count[module])
+    {
+        ic_head[module] = (ic_head[module] + 1) % SIM_IC_BUFFER;
+        --ic_count[module];
+    }
+    ic_step(module);
+    return value;
+}
+
+void sim_ic_capture(uint8_t module, uint16_t timestamp, uint8_t rising)
+{
+    ic_step(module);
+    if(!ic_con[module].ON || ic_con[module].ICM != 0b110)
+        return;
+    if(ic_first[module] && rising != ic_con[module].FEDGE)
+        return;
+    ic_first[module] = 0;
+    if(ic_count[module] == SIM_IC_BUFFER)
+    {
+        ic_con[module].ICOV = 1;
+        return;
+    }
+    ic_buffer[module][(ic_head[module] + ic_count[module]) % SIM_IC_BUFFER] = timestamp;
+    ++ic_count[module];
+    ic_step(module);
+    if(module)
+        sim_IFS0.IC2IF = 1;
+    else
+        sim_IFS0.IC1IF = 1;
+}
+
+/*Physical addresses of the DMA: the host pointers are 64 bits, the registers 32. All
+ * buffers and registers handed to the DMA are static objects of the program, which
+ * lie in one 4GB region; the high half of their addresses is taken from the first one*/
+static uintptr_t pa_high;
+static uint8_t pa_high_set = 0;
+
+uint32_t sim_kva_to_pa(const volatile void *address)
+{
+    uintptr_t high = (uintptr_t)address & ~(uintptr_t)0xFFFFFFFFu;
+
+    if(!pa_high_set)
+    {
+        pa_high = high;
+        pa_high_set = 1;
+    }
+    if(high != pa_high)
+    {
+        fprintf(stderr, "sim_regs: %p is not in the 4GB region of the other DMA addresses\n", (const void *)address);
+        exit(1);
+    }
+    return (uint32_t)(uintptr_t)address;
+}
+
+void *sim_pa_to_kva(uint32_t address)
+{
+    return (void *)(pa_high | address);
+}
@@ -0,0 +1,277 @@
+/* ************************************************************************** */
+/** sim_spi.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_spi.c
+
+  @Summary
+ Model of SPI2 in master mode and of the DMA channels 0 and 1 for host simulation
+
+  @Description
+ Like sim_i2c.c the model does the work of the hardware at the next access of one of
+ * its registers: the chip select on RG9 is followed, bytes written to SPI2BUF are
+ * shifted out to the device at once and its answers are put in the receive buffer,
+ * then the enabled DMA channels move bytes while their requests are pending.
+ * SPI2BUF is read and written through the same address. Every access hands out a word
+ * with bit 31 set; a write of a byte clears it, so the next access tells a write from
+ * a read, and a read takes the byte out of the receive buffer.
+ * A byte is shifted as soon as it is written, the transmit buffer is never full: the
+ * TX request of the DMA (STXISEL) is pending while the channel has bytes left and the
+ * RX request (SRXISEL) while the receive buffer holds a byte.
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+#include "header.h"
+#include "sim_spi.h"
+
+#define SIM_SPI_CS_BIT      9           // RG9
+#define BUF_UNTOUCHED       0x80000000u // SPI2BUF as handed out, cleared by a write
+
+sim_spi_stats_t sim_spi_stats;
+
+static sim_spi_regs_t regs;
+static sim_dma_channel_t channels[2];
+static uint32_t moved[2];               // bytes of the block moved by a channel
+static uint8_t rx_fifo[SIM_SPI_FIFO];
+static uint8_t rx_head = 0, rx_count = 0;
+static uint8_t buf_pending = 0;         // SPI2BUF was handed out
+static sim_i2c_device_t *device = NULL;
+static uint8_t selected = 0, first_byte = 0, reading = 0;
+
+uint32_t sim_spi_sck_frequency(void)
+{
+    return PBCLK2_FREQ / (2 * (regs.brg + 1));
+}
+
+static void error(const char *what)
+{
+    ++sim_spi_stats.errors;
+    fprintf(stderr, "sim_spi: %s\n", what);
+}
+
+/*One byte on the bus, returns the byte of the device*/
+static uint8_t exchange(uint8_t value)
+{
+    uint8_t answer = 0xFF;
+    uint64_t ns;
+
+    if(!regs.con.ON || !regs.con.MSTEN)
+    {
+        error("byte written to SPI2BUF while SPI2 is not an enabled master");
+        return answer;
+    }
+    if(!selected)
+        error("byte shifted without chip select");
+    else if(device && first_byte)
+    {
+        device->start(device, 0);
+        device->write(device, value);   // the register address
+        reading = value & SIM_SPI_READ;
+        if(reading)
+            device->start(device, 1);   // reads from the address just written
+        first_byte = 0;
+    }
+    else if(device && reading)
+        answer = device->read(device);
+    else if(device)
+        device->write(device, value);
+
+    ++sim_spi_stats.bytes;
+    ns = 8ull * 1000000000ull / sim_spi_sck_frequency();
+    sim_spi_stats.busy_ns += ns;
+    sim_advance(ns);
+    return answer;
+}
+
+static void transmit(uint8_t value)
+{
+    uint8_t answer = exchange(value);
+
+    if(rx_count == SIM_SPI_FIFO)
+    {
+        regs.stat.SPIROV = 1;
+        error("receive buffer overflow");
+        return;
+    }
+    rx_fifo[(rx_head + rx_count) % SIM_SPI_FIFO] = answer;
+    ++rx_count;
+}
+
+static uint8_t receive(void)
+{
+    uint8_t value;
+
+    if(!rx_count)
+        return 0;
+    value = rx_fifo[rx_head];
+    rx_head = (rx_head + 1) % SIM_SPI_FIFO;
+    --rx_count;
+    return value;
+}
+
+/*Byte from or to an address of the DMA, SPI2BUF or memory*/
+static uint8_t dma_read(uint32_t address)
+{
+    if(address == KVA_TO_PA(&regs.buf))
+    {
+        ++sim_spi_stats.dma_bytes;
+        return receive();
+    }
+    return *(uint8_t *)sim_pa_to_kva(address);
+}
+
+static void dma_write(uint32_t address, uint8_t value)
+{
+    if(address == KVA_TO_PA(&regs.buf))
+    {
+        ++sim_spi_stats.dma_bytes;
+        transmit(value);
+        return;
+    }
+    *(uint8_t *)sim_pa_to_kva(address) = value;
+}
+
+//request of a channel from SPI2
+static uint8_t dma_request(uint8_t channel)
+{
+    sim_dma_channel_t *ch = &channels[channel];
+
+    if(!DMACONbits.ON || !ch->con.CHEN || !ch->econ.SIRQEN || !regs.con.ON)
+        return 0;
+    if(ch->econ.CHSIRQ == _SPI2_TX_VECTOR)
+        return 1;
+    if(ch->econ.CHSIRQ == _SPI2_RX_VECTOR)
+        return rx_count != 0;
+    return 0;
+}
+
+//one cell of a channel; at the end of the block the channel is disabled and CHBCIF set
+static void dma_cell(uint8_t channel)
+{
+    sim_dma_channel_t *ch = &channels[channel];
+    uint32_t block = ch->ssiz > ch->dsiz ? ch->ssiz : ch->dsiz;
+    uint32_t i;
+
+    for(i = 0; i < ch->csiz && moved[channel] < block; ++i)
+    {
+        dma_write(ch->dsa + ch->dptr, dma_read(ch->ssa + ch->sptr));
+        ch->sptr = (ch->sptr + 1) % ch->ssiz;
+        ch->dptr = (ch->dptr + 1) % ch->dsiz;
+        ++moved[channel];
+    }
+    ch->intr.CHCCIF = 1;
+    if(moved[channel] >= block)
+    {
+        ch->intr.CHBCIF = 1;
+        ch->con.CHEN = 0;
+        ch->sptr = ch->dptr = 0;
+        moved[channel] = 0;
+    }
+}
+
+/*Catch up with the chip select, SPI2BUF and the DMA requests*/
+static void step(void)
+{
+    uint8_t cs = (sim_LATG.w >> SIM_SPI_CS_BIT) & 1, channel, busy;
+
+    if(!cs && !selected)
+    {
+        selected = 1;
+        first_byte = 1;
+        ++sim_spi_stats.transactions;
+    }
+    else if(cs && selected)
+    {
+        selected = 0;
+        if(device)
+            device->stop(device);
+    }
+
+    if(buf_pending)
+    {
+        buf_pending = 0;
+        if(regs.buf & BUF_UNTOUCHED)
+            receive();
+        else
+            transmit(regs.buf & 0xFF);
+    }
+
+    for(channel = 0; channel < 2; ++channel)
+    {
+        channels[channel].intr.w &= ~channels[channel].intclr;
+        channels[channel].intclr = 0;
+    }
+    do
+    {
+        busy = 0;
+        for(channel = 2; channel-- > 0; )   // the RX channel first, it has the higher priority
+        {
+            if(dma_request(channel))
+            {
+                dma_cell(channel);
+                busy = 1;
+                break;
+            }
+        }
+    } while(busy);
+
+    regs.stat.SPIRBE = !rx_count;
+    regs.stat.SPIRBF = rx_count == SIM_SPI_FIFO;
+    regs.stat.RXBUFELM = rx_count;
+    regs.stat.SPITBE = 1;
+    regs.stat.SPITBF = 0;
+    regs.stat.TXBUFELM = 0;
+    regs.stat.SRMT = 1;
+    regs.stat.SPIBUSY = 0;
+}
+
+sim_spi_regs_t *sim_spi2(void)
+{
+    step();
+    return &regs;
+}
+
+volatile uint32_t *sim_spi2_buf(void)
+{
+    step();
+    regs.buf = BUF_UNTOUCHED | (rx_count ? rx_fifo[rx_head] : 0);
+    buf_pending = 1;
+    return &regs.buf;
+}
+
+sim_dma_channel_t *sim_dma(uint8_t channel)
+{
+    step();
+    return &channels[channel];
+}
+
+void sim_spi_attach(sim_i2c_device_t *dev)
+{
+    device = dev;
+}
+
+void sim_spi_reset(void)
+{
+    memset(&regs, 0, sizeof(regs));
+    memset(channels, 0, sizeof(channels));
+    memset(moved, 0, sizeof(moved));
+    rx_head = rx_count = 0;
+    buf_pending = 0;
+    device = NULL;
+    sim_LATG.w |= 1u << SIM_SPI_CS_BIT;
+    selected = first_byte = reading = 0;
+    sim_latg_hook = step;
+    sim_spi_reset_stats();
+}
+
+void sim_spi_reset_stats(void)
+{
+    memset(&sim_spi_stats, 0, sizeof(sim_spi_stats));
+}
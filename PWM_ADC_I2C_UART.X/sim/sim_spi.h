@@ -0,0 +1,51 @@
+/* ************************************************************************** */
+/** sim_spi.h
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim_spi.h
+
+  @Summary
+ Model of SPI2, the DMA channels 0 and 1 and a device on the bus for host simulation
+
+  @Description
+ The model takes the place of the SPI2 and DMA registers used by SPI.c. A device is
+ * selected by the chip select on RG9 and exchanges a byte for every byte SPI2 shifts
+ * out, the simulated time advances by 8 SCK periods at the clock set in SPI2BRG.
+ * The device uses the callbacks of sim_i2c_device_t, so the models of sim_i2c.h work
+ * on SPI as well: the first byte after the chip select is the register address, bit 7
+ * set for a read, the following bytes are written to or read from the device.
+ * The counters in sim_spi_stats can be used to check the traffic generated by a driver.
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_SPI_H    /* Guard against multiple inclusion */
+#define _SIM_SPI_H
+
+#include <stdint.h>
+#include "sim_i2c.h"
+
+#define SIM_SPI_FIFO    16          // depth of the enhanced buffers
+#define SIM_SPI_READ    0x80        // bit of the register address that selects a read
+
+/*Traffic on the bus since the last call to sim_spi_reset_stats()*/
+typedef struct
+{
+    uint32_t transactions;      /* chip selects */
+    uint32_t bytes;             /* bytes shifted, including the register address */
+    uint32_t dma_bytes;         /* bytes moved by the DMA channels to and from SPI2BUF */
+    uint32_t errors;            /* bytes without chip select or with SPI2 off, receive overflows */
+    uint64_t busy_ns;           /* time the bus was busy */
+} sim_spi_stats_t;
+
+extern sim_spi_stats_t sim_spi_stats;
+
+/*Methods of the bus model*/
+void sim_spi_attach(sim_i2c_device_t *dev);     // Put the device on the chip select
+void sim_spi_reset(void);                       // Remove the device and clear the registers
+void sim_spi_reset_stats(void);
+uint32_t sim_spi_sck_frequency(void);           // SCK frequency that follows from SPI2BRG
+
+#endif /* _SIM_SPI_H */
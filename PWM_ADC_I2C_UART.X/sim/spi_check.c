@@ -0,0 +1,182 @@
+/* ************************************************************************** */
+/** spi_check.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ spi_check.c
+
+  @Summary
+ Host check of the SPI2 transport of the IMU driver against the simulated register file
+
+  @Description
+ Runs mpu9250.c built with IMU_TRANSPORT=IMU_TRANSPORT_SPI, SPI.c and dma_buf.c against
+ * the models of SPI2, the DMA channels 0 and 1 and the MPU9250 (sim_spi.c). Checked:
+ *  - IMUWriteRegister(): the register file of the IMU holds the value, one chip select
+ *    of 2 bytes
+ *  - IMUReadRegisters(): the bytes read match the register file, with WHO_AM_I and the
+ *    sensor registers
+ *  - IMUStartBurst()/IMUBurstComplete(): the burst moved by the DMA matches the sensor
+ *    registers, the chip select is released at the end and the DMA moved every byte
+ * every access without protocol errors, at the configuration and the read clock.
+ *
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -DIMU_TRANSPORT=IMU_TRANSPORT_SPI -Isim -I. -o spi_check sim/spi_check.c sim/sim_spi.c
+ *     sim/sim_i2c.c sim/sim_regs.c sim/sim_mpu9250.c SPI.c dma_buf.c mpu9250.c I2C.c NVM.c -lm && ./spi_check
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <xc.h>
+#include "header.h"
+#include "SPI.h"
+#include "mpu9250.h"
+#include "sim_i2c.h"
+#include "sim_spi.h"
+#include "sim_mpu9250.h"
+
+#if IMU_TRANSPORT != IMU_TRANSPORT_SPI
+#error "build with -DIMU_TRANSPORT=IMU_TRANSPORT_SPI"
+#endif
+
+#define REPETITIONS 1000
+#define BURST_POLLS 1000        // polls of IMUBurstComplete() after which the DMA is considered stuck
+
+/*Globals of main.c used by the drivers*/
+volatile uint8_t flag_ankle_IMU=0,flag_ankle_encoder=0,flag_ankle_current=0,flag_print=0;
+volatile uint16_t ADC1=0,ADC2=0,ADC3=0;
+volatile int16_t accelX=0,accelY=0,accelZ=0;
+volatile int16_t gyroX=0,gyroY=0,gyroZ=0;
+
+static sim_mpu9250_t imu;
+static uint32_t failures = 0;
+
+/*Motion of the IMU for repetition i*/
+static void move(uint32_t i)
+{
+    double accel[3] = {0.001 * (i % 100), -0.5, 1.0};
+    double gyro[3] = {10.0, -20.0, 0.1 * i};
+    sim_mpu9250_set_motion(&imu, accel, gyro);
+}
+
+static void result(const char *name, uint64_t start, uint32_t wrong, uint32_t expected_transactions,
+                   uint32_t expected_bytes)
+{
+    double us = (sim_time_ns - start) / 1000.0 / REPETITIONS;
+    uint8_t fail = wrong || sim_spi_stats.errors || sim_spi_stats.transactions != expected_transactions ||
+                   sim_spi_stats.bytes != expected_bytes || !(LATG & (1u << 9));
+
+    printf("  %-22s %8.2f us %9.0f /s %6.1f bytes %s\n", name, us, 1e6 / us,
+           (double)sim_spi_stats.bytes / REPETITIONS, fail ? "FAIL" : "ok");
+    if(fail)
+    {
+        printf("    %u wrong values, %u errors, %u chip selects (%u expected), %u bytes (%u expected)\n",
+               wrong, sim_spi_stats.errors, sim_spi_stats.transactions, expected_transactions,
+               sim_spi_stats.bytes, expected_bytes);
+        ++failures;
+    }
+}
+
+static void check_write(void)
+{
+    uint64_t start = sim_time_ns;
+    uint32_t wrong = 0, i;
+
+    sim_spi_reset_stats();
+    for(i = 0; i < REPETITIONS; ++i)
+    {
+        IMUWriteRegister(IMU_ADDRESS, SMPLRT_DIV, i & 0xFF);
+        wrong += imu.reg[SMPLRT_DIV] != (i & 0xFF);
+    }
+    IMUWriteRegister(IMU_ADDRESS, SMPLRT_DIV, 0);
+    result("IMUWriteRegister", start, wrong, REPETITIONS + 1, 2 * (REPETITIONS + 1));
+}
+
+static void check_read(void)
+{
+    uint64_t start = sim_time_ns;
+    uint32_t wrong = 0, i;
+    uint8_t buffer[6], j;
+
+    sim_spi_reset_stats();
+    for(i = 0; i < REPETITIONS; ++i)
+    {
+        move(i);
+        IMUReadRegisters(IMU_ADDRESS, WHO_AM_I_MPU9250, buffer, 1);
+        wrong += buffer[0] != 0x71;
+        IMUReadRegisters(IMU_ADDRESS, ACCEL_XOUT_H, buffer, sizeof(buffer));
+        for(j = 0; j < sizeof(buffer); ++j)
+            wrong += buffer[j] != imu.reg[ACCEL_XOUT_H + j];
+    }
+    result("IMUReadRegisters", start, wrong, 2 * REPETITIONS, (2 + 7) * REPETITIONS);
+}
+
+static void check_burst(void)
+{
+    uint64_t start = sim_time_ns;
+    uint32_t wrong = 0, i, dma_bytes, polls;
+    uint8_t buffer[IMU_BURST_LENGTH], j;
+    int16_t accel[3], gyro[3];
+
+    sim_spi_reset_stats();
+    for(i = 0; i < REPETITIONS; ++i)
+    {
+        move(i);
+        IMUStartBurst();
+        for(polls = 0; !IMUBurstComplete(buffer); ++polls)
+            if(polls == BURST_POLLS)
+            {
+                printf("  IMUBurstComplete() does not complete FAIL\n");
+                ++failures;
+                return;
+            }
+        for(j = 0; j < IMU_BURST_LENGTH; ++j)
+            wrong += buffer[j] != imu.reg[ACCEL_XOUT_H + j];
+        IMUDecodeBurst(buffer, accel, gyro);
+        for(j = 0; j < 3; ++j)
+        {
+            wrong += accel[j] != sim_mpu9250_register16(&imu, ACCEL_XOUT_H + 2 * j);
+            wrong += gyro[j] != sim_mpu9250_register16(&imu, GYRO_XOUT_H + 2 * j);
+        }
+    }
+    dma_bytes = sim_spi_stats.dma_bytes;
+    if(dma_bytes != 2 * (IMU_BURST_LENGTH + 1) * REPETITIONS)
+    {
+        printf("    the DMA moved %u bytes, %u expected\n", dma_bytes, 2 * (IMU_BURST_LENGTH + 1) * REPETITIONS);
+        ++wrong;
+    }
+    result("IMUStartBurst + DMA", start, wrong, REPETITIONS, (IMU_BURST_LENGTH + 1) * REPETITIONS);
+}
+
+int main()
+{
+    sim_i2c_reset();
+    sim_spi_reset();
+    sim_mpu9250_init(&imu, IMU_ADDRESS);
+    sim_spi_attach(&imu.dev);
+
+    IMU_init();
+    if(imu.reg[USER_CTRL] != IMU_I2C_IF_DIS || !SPI2CONbits.CKP || SPI2CONbits.CKE || !SPI2CONbits.ENHBUF)
+    {
+        printf("IMU_init: USER_CTRL %02X, CKP %u CKE %u ENHBUF %u FAIL\n", imu.reg[USER_CTRL],
+               SPI2CONbits.CKP, SPI2CONbits.CKE, SPI2CONbits.ENHBUF);
+        ++failures;
+    }
+
+    printf("SPI_init(%u): SCK %u Hz      time/transaction  rate  bus traffic\n", IMU_SPI_CONFIG_FREQ,
+           sim_spi_sck_frequency());
+    if(sim_spi_sck_frequency() > IMU_SPI_CONFIG_FREQ)
+        ++failures;
+    check_write();
+    check_read();
+
+    SPI_set_frequency(IMU_SPI_READ_FREQ);
+    printf("SPI_set_frequency(%u): SCK %u Hz\n", IMU_SPI_READ_FREQ, sim_spi_sck_frequency());
+    if(sim_spi_sck_frequency() > IMU_SPI_READ_FREQ)
+        ++failures;
+    check_read();
+    check_burst();
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
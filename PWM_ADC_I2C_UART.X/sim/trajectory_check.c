@@ -0,0 +1,175 @@
+/* ************************************************************************** */
+/** trajectory_check.c
+
+  @Company
+ University of Groningen
+
+  @File Name
+ trajectory_check.c
+
+  @Summary
+ Host check of the fixed point interpolator of trajectory.c
+
+  @Description
+ Feeds setpoints to trajectory.c at the 100Hz of the position loop and reads the
+ * reference at the 1KHz of the current loop, in the order of the scheduler, and
+ * compares it with the same Catmull-Rom segments in double precision:
+ * 1. Setpoints: a random walk, a sine, steps and full scale steps that overshoot
+ *    the Q15 range. The position has to stay within 1 LSB, velocity and acceleration
+ *    within two steps of their resolution, and every segment has to start at its
+ *    setpoint.
+ * 2. Ramp: equal steps between the setpoints give a constant velocity and no
+ *    acceleration.
+ * 3. Hold: without new setpoints the end of the last segment is held at rest.
+ * 4. Cost: time of trajectory_step() on the PC; it has no loop, so its time on the
+ *    target is bounded as well.
+ *
+ * Build and run from the project directory:
+ * gcc -std=gnu99 -O2 -Isim -I. -o trajectory_check sim/trajectory_check.c trajectory.c -lm
+ *     && ./trajectory_check
+ */
+/* ************************************************************************** */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "trajectory.h"
+
+#define SIM_STEPS       10      // current loop ticks per setpoint
+#define SIM_FS          1000    // current loop
+#define SIM_RATE        (SIM_FS / SIM_STEPS)
+#define SIM_SETPOINTS   2000
+
+static int failures = 0;
+
+//Catmull-Rom segment from p1 to p2 in double precision, x = position, velocity, acceleration per second
+static void reference(double p0, double p1, double p2, double p3, double t, double x[3])
+{
+    double rate = SIM_RATE;
+    double m0 = (p2 - p0) / 2, m1 = (p3 - p1) / 2;
+    double a = 2 * p1 - 2 * p2 + m0 + m1, b = -3 * p1 + 3 * p2 - 2 * m0 - m1;
+
+    x[0] = ((a * t + b) * t + m0) * t + p1;
+    x[1] = ((3 * a * t + 2 * b) * t + m0) * rate;
+    x[2] = (6 * a * t + 2 * b) * rate * rate;
+}
+
+//runs the setpoints through the interpolator and prints the largest errors
+static void run(const char *name, const int16_t *setpoint, int count)
+{
+    traj_t traj;
+    traj_point_t point;
+    double x[3], error[3] = {0, 0, 0}, peak[3] = {0, 0, 0};
+    int k, n, starts = 0;
+    uint8_t ok;
+
+    trajectory_init(&traj, setpoint[0], SIM_STEPS, SIM_FS);
+    /*the setpoints before the first are taken equal to it, as after trajectory_init()*/
+    for(k = 0; k < count; ++k)
+    {
+        trajectory_push(&traj, setpoint[k]);
+        for(n = 0; n < SIM_STEPS; ++n)
+        {
+            trajectory_step(&traj, &point);
+            if(k < 2)
+                continue;   // the first segments start from rest
+            reference(setpoint[k < 3 ? 0 : k - 3], setpoint[k - 2], setpoint[k - 1], setpoint[k],
+                      (double)n / SIM_STEPS, x);
+            x[0] = x[0] > INT16_MAX ? INT16_MAX : x[0] < INT16_MIN ? INT16_MIN : x[0];
+            x[2] = x[2] > INT32_MAX ? INT32_MAX : x[2] < INT32_MIN ? INT32_MIN : x[2];
+            if(n == 0 && point.position != setpoint[k - 2])
+                ++starts;
+            error[0] = fmax(error[0], fabs(point.position - x[0]));
+            error[1] = fmax(error[1], fabs(point.velocity - x[1]));
+            error[2] = fmax(error[2], fabs(point.acceleration - x[2]));
+            peak[1] = fmax(peak[1], fabs(x[1]));
+            peak[2] = fmax(peak[2], fabs(x[2]));
+        }
+    }
+    /*a few steps of the velocity (rate/2) and acceleration (rate^2/2), see trajectory.c*/
+    ok = error[0] <= 1 && error[1] <= 2 * SIM_RATE / 2 + 1e-4 * peak[1] &&
+         error[2] <= 2 * SIM_RATE * SIM_RATE / 2 + 1e-4 * peak[2] && !starts;
+    printf("  %-12s position %4.1f LSB  velocity %6.0f of %9.0f /s  acceleration %8.0f of %11.0f /s^2  %s\n",
+           name, error[0], error[1], peak[1], error[2], peak[2], ok ? "ok" : "FAIL");
+    if(starts)
+        printf("    %d segments do not start at their setpoint\n", starts);
+    failures += !ok;
+}
+
+int main(void)
+{
+    static int16_t setpoint[SIM_SETPOINTS];
+    traj_t traj;
+    traj_point_t point;
+    int32_t walk = 0, velocity = 0;
+    uint32_t seed = 12345;
+    int k, n, wrong;
+    clock_t start;
+    volatile int32_t sink = 0;
+
+    printf("Interpolation of %d setpoints, %d steps each, against double precision (Q15 units):\n", SIM_SETPOINTS, SIM_STEPS);
+    for(k = 0; k < SIM_SETPOINTS; ++k)
+    {
+        seed = seed * 1103515245 + 12345;
+        velocity += (int32_t)(seed >> 16 & 0xFF) - 128;
+        velocity = velocity > 400 ? 400 : velocity < -400 ? -400 : velocity;
+        walk += velocity;
+        walk = walk > 30000 ? 30000 : walk < -30000 ? -30000 : walk;
+        setpoint[k] = (int16_t)walk;
+    }
+    run("random walk", setpoint, SIM_SETPOINTS);
+    for(k = 0; k < SIM_SETPOINTS; ++k)
+        setpoint[k] = (int16_t)lrint(16000 * sin(2 * M_PI * 0.5 * k / 100.0));   // 0.5Hz
+    run("sine", setpoint, SIM_SETPOINTS);
+    for(k = 0; k < SIM_SETPOINTS; ++k)
+        setpoint[k] = (k / 50 & 1) ? 8192 : -8192;
+    run("steps", setpoint, SIM_SETPOINTS);
+    for(k = 0; k < SIM_SETPOINTS; ++k)
+        setpoint[k] = (k & 1) ? 32767 : -32768;
+    run("full scale", setpoint, SIM_SETPOINTS);
+
+    /*2. ramp: 30 counts per setpoint is 3000 /s*/
+    trajectory_init(&traj, 0, SIM_STEPS, SIM_FS);
+    wrong = 0;
+    for(k = 1; k <= 100; ++k)
+    {
+        trajectory_push(&traj, (int16_t)(30 * k));
+        for(n = 0; n < SIM_STEPS; ++n)
+        {
+            trajectory_step(&traj, &point);
+            if(k >= 3)
+                wrong += point.velocity != 3000 || point.acceleration != 0 ||
+                         point.position != 30 * (k - 2) + 3 * n;
+        }
+    }
+    printf("  %-12s %d wrong ticks %s\n", "ramp", wrong, wrong ? "FAIL" : "ok");
+    failures += wrong != 0;
+
+    /*3. hold: two segments after the last setpoint the reference rests on it*/
+    trajectory_push(&traj, 3000);
+    for(n = 0; n < 5 * SIM_STEPS; ++n)
+        trajectory_step(&traj, &point);
+    wrong = point.position != 3000 || point.velocity != 0 || point.acceleration != 0;
+    trajectory_push(&traj, 3000);
+    trajectory_push(&traj, 3000);
+    for(n = 0; n < 5 * SIM_STEPS; ++n)
+        trajectory_step(&traj, &point);
+    wrong += point.position != 3000 || point.velocity != 0 || point.acceleration != 0;
+    printf("  %-12s %s\n", "hold", wrong ? "FAIL" : "ok");
+    failures += wrong != 0;
+
+    /*4. cost*/
+    start = clock();
+    for(k = 0; k < 1000000; ++k)
+    {
+        if(k % SIM_STEPS == 0)
+            trajectory_push(&traj, setpoint[k / SIM_STEPS % SIM_SETPOINTS]);
+        trajectory_step(&traj, &point);
+        sink += point.position;
+    }
+    printf("  %-12s %.1f ns per tick and joint on this PC, including a push per %d ticks\n", "cost",
+           (double)(clock() - start) / CLOCKS_PER_SEC * 1e9 / 1000000, SIM_STEPS);
+
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
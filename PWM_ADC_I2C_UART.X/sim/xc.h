@@ -0,0 +1,442 @@
+/* ************************************************************************** */
+/** xc.h (host simulation)
+
+  @Company
+ University of Groningen
+
+  @File Name
+ sim/xc.h
+
+  @Summary
+ Replacement for the XC32 <xc.h> used when the drivers are compiled on a PC.
+
+  @Description
+ Adding the sim directory to the include path in front of the XC32 headers makes
+ * the drivers compile with gcc on Linux. The Special Function Registers used by the
+ * drivers are declared here with the same names and bit fields as in
+ * p32mz2048efm100.h, so the driver sources are compiled without any change.
+ *
+ * Registers of modeled peripherals (I2C1, SPI2 and its DMA channels, ADC, Input Capture)
+ * are accessed through functions in sim_i2c.c, sim_spi.c, sim_adc.c and sim_regs.c, every
+ * access first lets the peripheral model catch up with what the driver wrote before. All other registers are plain memory.
+ * The layout of the bit fields follows the PIC32MZ EF data sheet.
+ */
+/* ************************************************************************** */
+
+#ifndef _SIM_XC_H    /* Guard against multiple inclusion */
+#define _SIM_XC_H
+
+#include <stdint.h>
+
+/*XC32 attributes that have no meaning on the PC*/
+#define vector(x)       used
+#define interrupt(x)    used
+#define nomips16        used
+#define space(x)        used
+
+/*XC32 builtins, interrupts are not simulated*/
+static inline uint32_t __builtin_disable_interrupts(void) { return 0; }
+#define __builtin_enable_interrupts()   ((void)0)
+#define __builtin_mtc0(reg, sel, value) ((void)(value))
+#define Nop()                           ((void)0)
+
+/*Address translation, the host has a single address space*/
+uint32_t sim_kva_to_pa(const volatile void *address);     /* the low 32 bits, see sim_regs.c */
+void *sim_pa_to_kva(uint32_t address);
+#define KVA_TO_PA(v)        sim_kva_to_pa((const volatile void *)(v))
+#define KVA0_TO_KVA1(v)     (v)
+
+/*Core timer, counts at SYS_FREQ/2 of the simulated time*/
+uint32_t sim_core_count(void);
+void sim_core_set_count(uint32_t count);
+#define _CP0_GET_COUNT()        sim_core_count()
+#define _CP0_SET_COUNT(c)       sim_core_set_count(c)
+
+/*Cause.IP0/IP1 request the core software interrupts, they set IFS0.CS0IF/CS1IF*/
+void sim_cause_set(uint32_t mask);
+void sim_cause_clear(uint32_t mask);
+#define _CP0_BIS_CAUSE(m)       sim_cause_set(m)
+#define _CP0_BIC_CAUSE(m)       sim_cause_clear(m)
+
+/*Simulated time in ns, advanced by the peripheral models*/
+extern uint64_t sim_time_ns;
+void sim_advance(uint64_t ns);
+extern void (*sim_time_hook)(void);     /* called after every advance of the time if set */
+
+/*Interrupt vectors*/
+#define _CORE_SOFTWARE_0_VECTOR 1
+#define _CORE_SOFTWARE_1_VECTOR 2
+#define _TIMER_2_VECTOR         9
+#define _TIMER_3_VECTOR         14
+#define _TIMER_6_VECTOR         28
+#define _TIMER_7_VECTOR         32
+#define _TIMER_8_VECTOR         36
+#define _INPUT_CAPTURE_1_VECTOR 6
+#define _INPUT_CAPTURE_2_VECTOR 11
+#define _UART1_RX_VECTOR        113
+#define _SPI2_RX_VECTOR         141
+#define _SPI2_TX_VECTOR         142
+
+
+/*I/O ports
+ *******************************************************************
+ .................*/
+#define SIM_PORT_BITS(p) struct { uint32_t p##0:1, p##1:1, p##2:1, p##3:1, p##4:1, p##5:1, p##6:1, p##7:1, \
+                                           p##8:1, p##9:1, p##10:1, p##11:1, p##12:1, p##13:1, p##14:1, p##15:1; }
+#define SIM_PORT(reg, p) typedef union { SIM_PORT_BITS(p); uint32_t w; } sim_##reg##_t; extern volatile sim_##reg##_t sim_##reg
+
+SIM_PORT(ANSELA, ANSA); SIM_PORT(ANSELB, ANSB); SIM_PORT(ANSELC, ANSC); SIM_PORT(ANSELD, ANSD);
+SIM_PORT(ANSELE, ANSE); SIM_PORT(ANSELF, ANSF); SIM_PORT(ANSELG, ANSG);
+SIM_PORT(TRISA, TRISA); SIM_PORT(TRISB, TRISB); SIM_PORT(TRISC, TRISC); SIM_PORT(TRISD, TRISD);
+SIM_PORT(TRISE, TRISE); SIM_PORT(TRISF, TRISF); SIM_PORT(TRISG, TRISG);
+SIM_PORT(PORTA, RA); SIM_PORT(PORTB, RB); SIM_PORT(PORTC, RC); SIM_PORT(PORTD, RD);
+SIM_PORT(PORTE, RE); SIM_PORT(PORTF, RF); SIM_PORT(PORTG, RG);
+SIM_PORT(LATA, LATA); SIM_PORT(LATB, LATB); SIM_PORT(LATC, LATC); SIM_PORT(LATD, LATD);
+SIM_PORT(LATE, LATE); SIM_PORT(LATF, LATF); SIM_PORT(LATG, LATG);
+
+#define ANSELA (sim_ANSELA.w)
+#define ANSELB (sim_ANSELB.w)
+#define ANSELC (sim_ANSELC.w)
+#define ANSELD (sim_ANSELD.w)
+#define ANSELE (sim_ANSELE.w)
+#define ANSELF (sim_ANSELF.w)
+#define ANSELG (sim_ANSELG.w)
+#define ANSELAbits sim_ANSELA
+#define ANSELBbits sim_ANSELB
+#define ANSELCbits sim_ANSELC
+#define ANSELDbits sim_ANSELD
+#define ANSELEbits sim_ANSELE
+#define ANSELFbits sim_ANSELF
+#define ANSELGbits sim_ANSELG
+#define TRISA (sim_TRISA.w)
+#define TRISB (sim_TRISB.w)
+#define TRISC (sim_TRISC.w)
+#define TRISD (sim_TRISD.w)
+#define TRISE (sim_TRISE.w)
+#define TRISF (sim_TRISF.w)
+#define TRISG (sim_TRISG.w)
+#define TRISAbits sim_TRISA
+#define TRISBbits sim_TRISB
+#define TRISCbits sim_TRISC
+#define TRISDbits sim_TRISD
+#define TRISEbits sim_TRISE
+#define TRISFbits sim_TRISF
+#define TRISGbits sim_TRISG
+#define PORTA (sim_PORTA.w)
+#define PORTB (sim_PORTB.w)
+#define PORTC (sim_PORTC.w)
+#define PORTD (sim_PORTD.w)
+#define PORTE (sim_PORTE.w)
+#define PORTF (sim_PORTF.w)
+#define PORTG (sim_PORTG.w)
+#define PORTAbits sim_PORTA
+#define PORTBbits sim_PORTB
+#define PORTCbits sim_PORTC
+#define PORTDbits sim_PORTD
+#define PORTEbits sim_PORTE
+#define PORTFbits sim_PORTF
+#define PORTGbits sim_PORTG
+#define LATA (sim_LATA.w)
+#define LATB (sim_LATB.w)
+#define LATC (sim_LATC.w)
+#define LATD (sim_LATD.w)
+#define LATE (sim_LATE.w)
+#define LATF (sim_LATF.w)
+volatile uint32_t *sim_latg(void);     /* calls sim_latg_hook first, the SPI2 model follows the chip select */
+extern void (*sim_latg_hook)(void);
+#define LATG (*sim_latg())
+#define LATAbits sim_LATA
+#define LATBbits sim_LATB
+#define LATCbits sim_LATC
+#define LATDbits sim_LATD
+#define LATEbits sim_LATE
+#define LATFbits sim_LATF
+#define LATGbits sim_LATG
+
+
+/*Interrupt controller, only the bits used by the drivers
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t :1, CS0IF:1, CS1IF:1, :3, IC1IF:1, :2, T2IF:1, :1, IC2IF:1, :16, T6IF:1; }; uint32_t w; } sim_IFS0_t;
+typedef union { struct { uint32_t :1, CS0IE:1, CS1IE:1, :3, IC1IE:1, :2, T2IE:1, :1, IC2IE:1, :16, T6IE:1; }; uint32_t w; } sim_IEC0_t;
+typedef union { struct { uint32_t T7IF:1, :3, T8IF:1; }; uint32_t w; } sim_IFS1_t;
+typedef union { struct { uint32_t T7IE:1, :3, T8IE:1; }; uint32_t w; } sim_IEC1_t;
+typedef union { struct { uint32_t :8, CS0IS:2, CS0IP:3, :3, CS1IS:2, CS1IP:3; }; uint32_t w; } sim_IPC0_t;
+typedef union { struct { uint32_t :16, IC1IS:2, IC1IP:3; }; uint32_t w; } sim_IPC1_t;
+typedef union { struct { uint32_t :8, T2IS:2, T2IP:3, :11, IC2IS:2, IC2IP:3; }; uint32_t w; } sim_IPC2_t;
+typedef union { struct { uint32_t T6IS:2, T6IP:3; }; uint32_t w; } sim_IPC7_t;
+extern volatile sim_IFS0_t sim_IFS0;
+extern volatile sim_IEC0_t sim_IEC0;
+extern volatile sim_IFS1_t sim_IFS1;
+extern volatile sim_IEC1_t sim_IEC1;
+extern volatile sim_IPC0_t sim_IPC0;
+extern volatile sim_IPC1_t sim_IPC1;
+extern volatile sim_IPC2_t sim_IPC2;
+extern volatile sim_IPC7_t sim_IPC7;
+#define IFS0 (sim_IFS0.w)
+#define IFS0bits sim_IFS0
+#define IEC0bits sim_IEC0
+#define IFS1 (sim_IFS1.w)
+#define IFS1bits sim_IFS1
+#define IEC1bits sim_IEC1
+#define IPC0bits sim_IPC0
+#define IPC1bits sim_IPC1
+#define IPC2bits sim_IPC2
+#define IPC7bits sim_IPC7
+#define _IFS0_CS0IF_MASK    0x00000002
+#define _IFS0_CS1IF_MASK    0x00000004
+#define _IFS0_IC1IF_MASK    0x00000040
+#define _IFS0_T2IF_MASK     0x00000200
+#define _IFS0_IC2IF_MASK    0x00000800
+#define _IFS0_T6IF_MASK     0x10000000
+#define _IFS1_T7IF_MASK     0x00000001
+
+
+/*Timer2, Timer3, Timer6, Input Capture 1 and 2 and Output Compare 1 ... 4
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t :1, TCS:1, :1, T32:1, TCKPS:3, TGATE:1, :5, SIDL:1, :1, ON:1; };
+                struct { uint32_t :15, TON:1; }; uint32_t w; } sim_TxCON_t;
+extern volatile sim_TxCON_t sim_T2CON;
+extern volatile uint32_t TMR2, PR2;
+#define T2CON       (sim_T2CON.w)
+#define T2CONbits   sim_T2CON
+extern volatile uint32_t OC1CON, OC2CON, OC3CON, OC4CON, OC1R, OC2R, OC3R, OC4R, OC1RS, OC2RS, OC3RS, OC4RS;
+extern volatile uint32_t RPE8R, RPF2R;
+
+/*Input Capture 1 and 2 are modeled in sim_regs.c: the 4 word buffer is filled by
+ * sim_ic_capture() in the capture every edge mode, starting with the edge set by FEDGE.
+ * A capture to a full buffer is lost and sets ICOV, turning the module off empties the
+ * buffer and clears ICOV*/
+typedef union { struct { uint32_t ICM:3, ICBNE:1, ICOV:1, ICI:2, ICTMR:1, C32:1, FEDGE:1, :3, SIDL:1, :1, ON:1; }; uint32_t w; } sim_ICxCON_t;
+extern volatile sim_TxCON_t sim_T3CON;
+extern volatile uint32_t TMR3, PR3, IC1R, IC2R;
+volatile sim_ICxCON_t *sim_ic_con(uint8_t module);     /* module 0 is IC1, catches up with ON */
+uint32_t sim_ic_buf(uint8_t module);                    /* a read takes the oldest capture */
+void sim_ic_capture(uint8_t module, uint16_t timestamp, uint8_t rising);
+#define T3CON       (sim_T3CON.w)
+#define T3CONbits   sim_T3CON
+#define IC1CON      (sim_ic_con(0)->w)
+#define IC1CONbits  (*sim_ic_con(0))
+#define IC1BUF      (sim_ic_buf(0))
+#define IC2CON      (sim_ic_con(1)->w)
+#define IC2CONbits  (*sim_ic_con(1))
+#define IC2BUF      (sim_ic_buf(1))
+extern volatile sim_TxCON_t sim_T6CON;
+extern volatile uint32_t TMR6, PR6;
+#define T6CON       (sim_T6CON.w)
+#define T6CONbits   sim_T6CON
+
+
+/*UART1, plain memory: nothing is received unless a test writes it
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t STSEL:1, PDSEL:2, BRGH:1, RXINV:1, ABAUD:1, LPBACK:1, WAKE:1,
+                                  UEN:2, :1, RTSMD:1, IREN:1, SIDL:1, :1, ON:1; }; uint32_t w; } sim_UxMODE_t;
+typedef union { struct { uint32_t URXDA:1, OERR:1, FERR:1, PERR:1, RIDLE:1, ADDEN:1, URXISEL:2,
+                                  TRMT:1, UTXBF:1, UTXEN:1, UTXBRK:1, URXEN:1, UTXINV:1, UTXISEL:2; }; uint32_t w; } sim_UxSTA_t;
+typedef union { struct { uint32_t :17, U1RXIF:1; }; uint32_t w; } sim_IFS3_t;
+typedef union { struct { uint32_t :17, U1RXIE:1; }; uint32_t w; } sim_IEC3_t;
+typedef union { struct { uint32_t :8, U1RXIS:2, U1RXIP:3; }; uint32_t w; } sim_IPC28_t;
+extern volatile sim_UxMODE_t sim_U1MODE;
+extern volatile sim_UxSTA_t sim_U1STA;
+extern volatile sim_IFS3_t sim_IFS3;
+extern volatile sim_IEC3_t sim_IEC3;
+extern volatile sim_IPC28_t sim_IPC28;
+extern volatile uint32_t U1BRG, U1TXREG, U1RXREG, U1RXR, RPD15R;
+#define U1MODE      (sim_U1MODE.w)
+#define U1MODEbits  sim_U1MODE
+#define U1STA       (sim_U1STA.w)
+#define U1STAbits   sim_U1STA
+#define IFS3        (sim_IFS3.w)
+#define IFS3bits    sim_IFS3
+#define IEC3bits    sim_IEC3
+#define IPC28bits   sim_IPC28
+#define _U1STA_OERR_MASK    0x00000002
+#define _IFS3_U1RXIF_MASK   0x00020000
+
+
+/*I2C1, modeled by sim_i2c.c
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t SEN:1, RSEN:1, PEN:1, RCEN:1, ACKEN:1, ACKDT:1, STREN:1, GCEN:1,
+                                  SMEN:1, DISSLW:1, A10M:1, STRICT:1, SCLREL:1, SIDL:1, :1, ON:1; }; uint32_t w; } sim_I2CxCON_t;
+typedef union { struct { uint32_t TBF:1, RBF:1, R_W:1, S:1, P:1, D_A:1, I2COV:1, IWCOL:1,
+                                  ADD10:1, GCSTAT:1, BCL:1, :3, TRSTAT:1, ACKSTAT:1; }; uint32_t w; } sim_I2CxSTAT_t;
+typedef struct
+{
+    sim_I2CxCON_t con;
+    sim_I2CxSTAT_t stat;
+    uint32_t brg;
+    uint32_t trn;
+    uint32_t rcv;
+} sim_i2c_regs_t;
+
+sim_i2c_regs_t *sim_i2c1(void);     /* lets the bus model catch up, then returns the registers */
+uint32_t *sim_i2c1_trn(void);       /* a write to I2C1TRN starts a transmission */
+uint32_t sim_i2c1_rcv(void);        /* a read of I2C1RCV clears RBF */
+
+#define I2C1CON         (sim_i2c1()->con.w)
+#define I2C1CONbits     (sim_i2c1()->con)
+#define I2C1STAT        (sim_i2c1()->stat.w)
+#define I2C1STATbits    (sim_i2c1()->stat)
+#define I2C1BRG         (sim_i2c1()->brg)
+#define I2C1TRN         (*sim_i2c1_trn())
+#define I2C1RCV         (sim_i2c1_rcv())
+#define _I2C1CON_SEN_MASK   0x00000001
+#define _I2C1CON_RSEN_MASK  0x00000002
+#define _I2C1CON_PEN_MASK   0x00000004
+#define _I2C1CON_RCEN_MASK  0x00000008
+#define _I2C1CON_ACKEN_MASK 0x00000010
+#define _I2C1CON_ACKDT_MASK 0x00000020
+
+/*SPI2 and the DMA channels 0 and 1, modeled by sim_spi.c
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t SRXISEL:2, STXISEL:2, DISSDI:1, MSTEN:1, CKP:1, SSEN:1, CKE:1, SMP:1,
+                                  MODE16:1, MODE32:1, DISSDO:1, SIDL:1, :1, ON:1, ENHBUF:1; }; uint32_t w; } sim_SPIxCON_t;
+typedef union { struct { uint32_t SPIRBF:1, SPITBF:1, :1, SPITBE:1, :1, SPIRBE:1, SPIROV:1, SRMT:1,
+                                  SPITUR:1, :2, SPIBUSY:1, FRMERR:1, :3, TXBUFELM:5, :3, RXBUFELM:5; }; uint32_t w; } sim_SPIxSTAT_t;
+typedef struct
+{
+    sim_SPIxCON_t con;
+    uint32_t con2;
+    sim_SPIxSTAT_t stat;
+    uint32_t brg;
+    uint32_t buf;
+} sim_spi_regs_t;
+
+sim_spi_regs_t *sim_spi2(void);     /* lets the SPI2 and DMA model catch up, then returns the registers */
+volatile uint32_t *sim_spi2_buf(void); /* SPI2BUF, the model tells a read from a write at the next access */
+
+#define SPI2CON         (sim_spi2()->con.w)
+#define SPI2CONbits     (sim_spi2()->con)
+#define SPI2CON2        (sim_spi2()->con2)
+#define SPI2STAT        (sim_spi2()->stat.w)
+#define SPI2STATbits    (sim_spi2()->stat)
+#define SPI2BRG         (sim_spi2()->brg)
+#define SPI2BUF         (*sim_spi2_buf())
+extern volatile uint32_t SDI2R, RPG8R;
+
+typedef union { struct { uint32_t CHPRI:2, CHEDET:1, :1, CHAEN:1, CHCHN:1, CHAED:1, CHEN:1, CHCHNS:1, :6, CHBUSY:1; }; uint32_t w; } sim_DCHxCON_t;
+typedef union { struct { uint32_t :3, AIRQEN:1, SIRQEN:1, PATEN:1, CABORT:1, CFORCE:1, CHSIRQ:8, CHAIRQ:8; }; uint32_t w; } sim_DCHxECON_t;
+typedef union { struct { uint32_t CHERIF:1, CHTAIF:1, CHCCIF:1, CHBCIF:1, CHDHIF:1, CHDDIF:1, CHSHIF:1, CHSDIF:1, :8,
+                                  CHERIE:1, CHTAIE:1, CHCCIE:1, CHBCIE:1, CHDHIE:1, CHDDIE:1, CHSHIE:1, CHSDIE:1; }; uint32_t w; } sim_DCHxINT_t;
+typedef union { struct { uint32_t :11, DMABUSY:1, SUSPEND:1, :2, ON:1; }; uint32_t w; } sim_DMACON_t;
+typedef struct
+{
+    sim_DCHxCON_t con;
+    sim_DCHxECON_t econ;
+    sim_DCHxINT_t intr;
+    uint32_t intclr;            /* bits written to DCHxINTCLR, cleared in DCHxINT at the next access */
+    uint32_t ssa, dsa, ssiz, dsiz, csiz;
+    uint32_t sptr, dptr;        /* bytes moved from the source and to the destination */
+} sim_dma_channel_t;
+
+sim_dma_channel_t *sim_dma(uint8_t channel);    /* lets the model catch up, then returns the channel */
+extern volatile sim_DMACON_t sim_DMACON;
+#define DMACONbits      sim_DMACON
+
+#define DCH0CON         (sim_dma(0)->con.w)
+#define DCH0CONbits     (sim_dma(0)->con)
+#define DCH0ECON        (sim_dma(0)->econ.w)
+#define DCH0ECONbits    (sim_dma(0)->econ)
+#define DCH0INT         (sim_dma(0)->intr.w)
+#define DCH0INTbits     (sim_dma(0)->intr)
+#define DCH0INTCLR      (sim_dma(0)->intclr)
+#define DCH0SSA         (sim_dma(0)->ssa)
+#define DCH0DSA         (sim_dma(0)->dsa)
+#define DCH0SSIZ        (sim_dma(0)->ssiz)
+#define DCH0DSIZ        (sim_dma(0)->dsiz)
+#define DCH0CSIZ        (sim_dma(0)->csiz)
+#define DCH1CON         (sim_dma(1)->con.w)
+#define DCH1CONbits     (sim_dma(1)->con)
+#define DCH1ECON        (sim_dma(1)->econ.w)
+#define DCH1ECONbits    (sim_dma(1)->econ)
+#define DCH1INT         (sim_dma(1)->intr.w)
+#define DCH1INTbits     (sim_dma(1)->intr)
+#define DCH1INTCLR      (sim_dma(1)->intclr)
+#define DCH1SSA         (sim_dma(1)->ssa)
+#define DCH1DSA         (sim_dma(1)->dsa)
+#define DCH1SSIZ        (sim_dma(1)->ssiz)
+#define DCH1DSIZ        (sim_dma(1)->dsiz)
+#define DCH1CSIZ        (sim_dma(1)->csiz)
+
+/*ADC, modeled by sim_adc.c: the Class 1 inputs AN2 ... AN4 with a software trigger
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t :15, ON:1; }; uint32_t w; } sim_ADCCON1_t;
+typedef union { struct { uint32_t :30, REFFLT:1, BGVRRDY:1; }; uint32_t w; } sim_ADCCON2_t;
+typedef union { struct { uint32_t ADINSEL:6, GSWTRG:1, GLSWTRG:1, RQCNVRT:1, SAMP:1, UPDRDY:1, UPDIEN:1,
+                                  TRGSUSP:1, VREFSEL:3, DIGEN0:1, DIGEN1:1, DIGEN2:1, DIGEN3:1, DIGEN4:1, :2,
+                                  DIGEN7:1, CONCLKDIV:6, ADCSEL:2; }; uint32_t w; } sim_ADCCON3_t;
+typedef union { struct { uint32_t ANEN0:1, ANEN1:1, ANEN2:1, ANEN3:1, ANEN4:1, :2, ANEN7:1,
+                                  WKRDY0:1, WKRDY1:1, WKRDY2:1, WKRDY3:1, WKRDY4:1, :2, WKRDY7:1,
+                                  WKIEN0:1, WKIEN1:1, WKIEN2:1, WKIEN3:1, WKIEN4:1, :2, WKIEN7:1,
+                                  WKUPCLKCNT:4; }; uint32_t w; } sim_ADCANCON_t;
+typedef union { struct { uint32_t SAMC:10, :6, ADCDIV:7, :1, SELRES:2, ADCEIS:3; }; uint32_t w; } sim_ADCxTIME_t;
+typedef union { struct { uint32_t :16, SH0ALT:2, SH1ALT:2, SH2ALT:2, SH3ALT:2, SH4ALT:2; }; uint32_t w; } sim_ADCTRGMODE_t;
+typedef union { struct { uint32_t SIGN0:1, DIFF0:1, SIGN1:1, DIFF1:1, SIGN2:1, DIFF2:1, SIGN3:1, DIFF3:1,
+                                  SIGN4:1, DIFF4:1; }; uint32_t w; } sim_ADCIMCON1_t;
+typedef union { struct { uint32_t LVL0:1, LVL1:1, LVL2:1, LVL3:1, LVL4:1; }; uint32_t w; } sim_ADCTRGSNS_t;
+typedef union { struct { uint32_t TRGSRC0:5, :3, TRGSRC1:5, :3, TRGSRC2:5, :3, TRGSRC3:5; }; uint32_t w; } sim_ADCTRG1_t;
+typedef union { struct { uint32_t TRGSRC4:5; }; uint32_t w; } sim_ADCTRG2_t;
+typedef union { struct { uint32_t ARDY0:1, ARDY1:1, ARDY2:1, ARDY3:1, ARDY4:1; }; uint32_t w; } sim_ADCDSTAT1_t;
+typedef struct
+{
+    sim_ADCCON1_t con1;
+    sim_ADCCON2_t con2;
+    sim_ADCCON3_t con3;
+    sim_ADCANCON_t ancon;
+    sim_ADCDSTAT1_t dstat1;
+} sim_adc_regs_t;
+
+sim_adc_regs_t *sim_adc(void);      /* lets the ADC model catch up, then returns the registers */
+uint32_t sim_adc_data(uint8_t input); /* a read of ADCDATAx clears ARDYx */
+
+#define ADCCON1         (sim_adc()->con1.w)
+#define ADCCON1bits     (sim_adc()->con1)
+#define ADCCON2         (sim_adc()->con2.w)
+#define ADCCON2bits     (sim_adc()->con2)
+#define ADCCON3         (sim_adc()->con3.w)
+#define ADCCON3bits     (sim_adc()->con3)
+#define _ADCCON3_GSWTRG_MASK 0x00000040
+#define ADCANCON        (sim_adc()->ancon.w)
+#define ADCANCONbits    (sim_adc()->ancon)
+#define ADCDSTAT1       (sim_adc()->dstat1.w)
+#define ADCDSTAT1bits   (sim_adc()->dstat1)
+#define ADCDATA2        (sim_adc_data(2))
+#define ADCDATA3        (sim_adc_data(3))
+#define ADCDATA4        (sim_adc_data(4))
+
+/*configuration registers without a function in the model*/
+extern volatile uint32_t ADC0CFG, ADC1CFG, ADC2CFG, ADC3CFG, ADC4CFG, ADC7CFG;
+extern volatile uint32_t DEVADC0, DEVADC1, DEVADC2, DEVADC3, DEVADC4, DEVADC7;
+extern volatile uint32_t ADCGIRQEN1, ADCGIRQEN2, ADCCSS1, ADCCSS2, ADCEIEN1, ADCEIEN2;
+extern volatile uint32_t ADCCMPCON1, ADCCMPCON2, ADCCMPCON3, ADCCMPCON4, ADCCMPCON5, ADCCMPCON6;
+extern volatile uint32_t ADCFLTR1, ADCFLTR2, ADCFLTR3, ADCFLTR4, ADCFLTR5, ADCFLTR6;
+extern volatile sim_ADCxTIME_t sim_ADC2TIME, sim_ADC3TIME, sim_ADC4TIME;
+extern volatile sim_ADCTRGMODE_t sim_ADCTRGMODE;
+extern volatile sim_ADCIMCON1_t sim_ADCIMCON1;
+extern volatile sim_ADCTRGSNS_t sim_ADCTRGSNS;
+extern volatile sim_ADCTRG1_t sim_ADCTRG1;
+extern volatile sim_ADCTRG2_t sim_ADCTRG2;
+#define ADC2TIMEbits    sim_ADC2TIME
+#define ADC3TIMEbits    sim_ADC3TIME
+#define ADC4TIMEbits    sim_ADC4TIME
+#define ADCTRGMODEbits  sim_ADCTRGMODE
+#define ADCIMCON1bits   sim_ADCIMCON1
+#define ADCTRGSNSbits   sim_ADCTRGSNS
+#define ADCTRG1bits     sim_ADCTRG1
+#define ADCTRG2bits     sim_ADCTRG2
+
+/*Flash controller, the flash itself is not modeled
+ *******************************************************************
+ .................*/
+typedef union { struct { uint32_t NVMOP:4, :8, LVDERR:1, WRERR:1, WREN:1, WR:1; }; uint32_t w; } sim_NVMCON_t;
+extern volatile sim_NVMCON_t sim_NVMCON;
+extern volatile uint32_t NVMCONCLR, NVMCONSET, NVMKEY, NVMADDR, NVMDATA0, NVMDATA1, NVMDATA2, NVMDATA3;
+#define NVMCON      (sim_NVMCON.w)
+#define NVMCONbits  sim_NVMCON
+
+#endif /* _SIM_XC_H */
@@ -0,0 +1,155 @@
+/* ************************************************************************** */
+/** stream.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+stream.c
+
+@Summary
+ Peripherals used:
+  * None, the ring is filled by the UART1 RX interrupt (UART.c) and read by the position loop
+
+@Description
+ head is only written by the writer and tail only by the reader. Both run free and are
+ * masked when indexing, head - tail is the level. A setpoint is stored before head is
+ * advanced and read before tail is advanced, so each side only sees complete setpoints.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include "stream.h"
+
+static volatile int16_t ring[STREAM_LENGTH][NUMBER_OF_JOINTS];
+static volatile uint16_t head = 0, tail = 0;
+static volatile uint8_t ending = 0, policy = STREAM_POLICY_DEFAULT;
+volatile stream_stats_t stream_stats;
+
+/*State of the reader*/
+static uint8_t state = STREAM_IDLE;
+static int16_t last[NUMBER_OF_JOINTS], step[NUMBER_OF_JOINTS];
+static uint8_t ramp;
+
+
+/*Function to empty the ring, call while the position loop does not run*/
+void stream_init(uint8_t underrun_policy)
+{
+    head = tail = 0;
+    ending = 0;
+    state = STREAM_IDLE;
+    policy = underrun_policy;
+    stream_stats.received = stream_stats.overflows = stream_stats.underruns = 0;
+}
+
+void stream_set_policy(uint8_t underrun_policy)
+{
+    policy = underrun_policy;
+}
+
+uint16_t stream_level()
+{
+    return (uint16_t)(head - tail);
+}
+
+uint8_t stream_state()
+{
+    return state;
+}
+
+
+/*Writer side*/
+uint8_t stream_push(const int16_t setpoint[NUMBER_OF_JOINTS])
+{
+    uint16_t index = head;
+    uint8_t joint;
+
+    if((uint16_t)(index - tail) >= STREAM_LENGTH)
+    {
+        ++stream_stats.overflows;
+        return 0;
+    }
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+        ring[index & (STREAM_LENGTH - 1)][joint] = setpoint[joint];
+    head = index + 1;   // publish the setpoint
+    ending = 0;
+    ++stream_stats.received;
+    return 1;
+}
+
+void stream_end()
+{
+    ending = 1;
+}
+
+
+/*Reader side, runs at the rate of the position loop*/
+uint8_t stream_next(volatile int16_t reference[NUMBER_OF_JOINTS])
+{
+    uint16_t index = tail, level = (uint16_t)(head - index);
+    uint8_t joint;
+
+    switch(state)
+    {
+        case STREAM_IDLE:
+            if(!level)
+                return 0;
+            state = STREAM_BUFFERING;
+            /* fall through */
+        case STREAM_BUFFERING:
+            if(level < STREAM_PREFILL && !ending)
+                return 0;
+            for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+            {
+                last[joint] = reference[joint];     // no step from the reference before the stream
+                step[joint] = 0;
+            }
+            state = STREAM_PLAYING;
+            break;
+        case STREAM_STARVED:
+            if(level >= STREAM_PREFILL || (ending && level))
+                state = STREAM_PLAYING;
+            break;
+    }
+
+    if(state == STREAM_PLAYING && !level)
+    {
+        if(ending)
+        {
+            ending = 0;
+            state = STREAM_IDLE;    // the reference keeps the last setpoint
+            return 1;
+        }
+        ++stream_stats.underruns;
+        state = STREAM_STARVED;
+        ramp = STREAM_RAMP_SAMPLES;
+    }
+
+    if(state == STREAM_PLAYING)
+    {
+        for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+        {
+            int16_t setpoint = ring[index & (STREAM_LENGTH - 1)][joint];
+            step[joint] = setpoint - last[joint];
+            last[joint] = setpoint;
+        }
+        tail = index + 1;   // free the setpoint
+    }
+    else if(policy == STREAM_RAMP_DOWN && ramp)
+    {
+        /*continue the last step, reduced linearly to 0*/
+        for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+            last[joint] += (int16_t)((int32_t)step[joint] * ramp / (STREAM_RAMP_SAMPLES + 1));
+        --ramp;
+    }
+
+    for(joint = 0; joint < NUMBER_OF_JOINTS; ++joint)
+        reference[joint] = last[joint];
+    return 1;
+}
@@ -0,0 +1,88 @@
+/* ************************************************************************** */
+/** stream.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+stream.h
+
+@Summary
+ Setpoint stream from the host to the position loop
+
+@Description
+ Setpoints (one Q15 angle per joint, see ANGLE_TO_Q15) received on UART1 are put in a
+ * ring by the UART1 RX interrupt and taken out by the position loop, one per run. The
+ * ring has a single writer and a single reader, each owning one index, so neither side
+ * disables interrupts. Playback starts once STREAM_PREFILL setpoints are buffered, the
+ * buffered setpoints absorb the jitter of the serial link.
+ * If the ring runs empty during playback (underrun) the reference follows the policy:
+ *  - STREAM_HOLD: the last setpoint is kept
+ *  - STREAM_RAMP_DOWN: the last step between setpoints is continued and reduced to 0
+ *    over STREAM_RAMP_SAMPLES runs, so the joints stop without a jump of the velocity
+ * and playback continues once STREAM_PREFILL setpoints are buffered again. An end of
+ * stream from the host lets the ring run empty without an underrun.
+ * The host paces itself on the level of the ring, sent with the telemetry.
+ */
+/* ************************************************************************** */
+
+#ifndef _STREAM_H    /* Guard against multiple inclusion */
+#define _STREAM_H
+
+#include <stdint.h>
+#include "AS5600L.h"
+
+#define STREAM_LENGTH       256     // setpoints in the ring, a power of 2; 2.56s at 100Hz
+#define STREAM_PREFILL      20      // setpoints buffered before playback, 200ms
+#define STREAM_RAMP_SAMPLES 25      // length of the ramp down
+
+/*Underrun policies*/
+#define STREAM_HOLD         0
+#define STREAM_RAMP_DOWN    1
+#define STREAM_POLICY_DEFAULT STREAM_RAMP_DOWN
+
+/*States of the stream*/
+#define STREAM_IDLE         0       // the reference is not changed by the stream
+#define STREAM_BUFFERING    1       // filling up to STREAM_PREFILL before playback
+#define STREAM_PLAYING      2
+#define STREAM_STARVED      3       // underrun, the policy sets the reference
+
+/*Measurements of the stream*/
+typedef struct
+{
+    uint32_t received;      // setpoints put in the ring
+    uint32_t overflows;     // setpoints lost as the ring was full
+    uint32_t underruns;
+} stream_stats_t;
+
+extern volatile stream_stats_t stream_stats;
+
+/*Methods for the stream
+ *******************************************************************
+ .................*/
+/*Empty the ring and set the underrun policy*/
+void stream_init(uint8_t policy);
+void stream_set_policy(uint8_t policy);
+
+/*Writer side, UART1 RX interrupt: add a setpoint, returns 0 if the ring is full*/
+uint8_t stream_push(const int16_t setpoint[NUMBER_OF_JOINTS]);
+
+/*Writer side: no more setpoints follow, the stream ends when the ring is empty*/
+void stream_end();
+
+/*Reader side, position loop: set the reference from the stream. Returns 1 if the stream
+ * sets the reference, 0 while it is idle or buffering*/
+uint8_t stream_next(volatile int16_t reference[NUMBER_OF_JOINTS]);
+
+/*Number of setpoints in the ring*/
+uint16_t stream_level();
+
+/*State of the stream, STREAM_IDLE ... STREAM_STARVED*/
+uint8_t stream_state();
+
+#endif /* _STREAM_H */
@@ -0,0 +1,116 @@
+/* ************************************************************************** */
+/** systime.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+systime.c
+
+@Summary
+ Monotonic time of the system from the core timer
+
+@Description
+ Peripherals used:
+ * Core timer, read only
+ * The last count read and the number of wraps are updated together with interrupts
+ * disabled for a few instructions, so an ISR that reads the time while the main loop
+ * does sees a consistent pair. A count lower than the last one is a wrap.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include "header.h"
+#include "systime.h"
+
+static uint32_t last_count = 0;
+static uint32_t wraps = 0;
+
+uint64_t systime_now()
+{
+    uint32_t status = __builtin_disable_interrupts();
+    uint32_t count = systime_count();
+    uint64_t now;
+
+    if(count < last_count)
+        ++wraps;
+    last_count = count;
+    now = (uint64_t)wraps << 32 | count;
+    __builtin_mtc0(12, 0, status);
+    return now;
+}
+
+void systime_task()
+{
+    systime_now();
+}
+
+/*Conversions: whole seconds and the remainder apart, so neither product overflows*/
+uint64_t systime_ticks_to_ns(uint64_t ticks)
+{
+    return ticks / SYSTIME_FREQ * 1000000000ull + ticks % SYSTIME_FREQ * 1000000000ull / SYSTIME_FREQ;
+}
+
+uint64_t systime_ticks_to_us(uint64_t ticks)
+{
+    return ticks / SYSTIME_FREQ * 1000000ull + ticks % SYSTIME_FREQ * 1000000ull / SYSTIME_FREQ;
+}
+
+uint64_t systime_ns_to_ticks(uint64_t ns)
+{
+    return ns / 1000000000ull * SYSTIME_FREQ + ns % 1000000000ull * SYSTIME_FREQ / 1000000000ull;
+}
+
+uint64_t systime_us_to_ticks(uint64_t us)
+{
+    return us / 1000000ull * SYSTIME_FREQ + us % 1000000ull * SYSTIME_FREQ / 1000000ull;
+}
+
+/*Deadlines and timeouts*/
+uint64_t systime_deadline(uint64_t ticks)
+{
+    return systime_now() + ticks;
+}
+
+uint64_t systime_deadline_us(uint32_t us)
+{
+    return systime_now() + systime_us_to_ticks(us);
+}
+
+uint8_t systime_expired(uint64_t deadline)
+{
+    return systime_now() >= deadline;
+}
+
+uint64_t systime_elapsed(uint64_t start)
+{
+    return systime_now() - start;
+}
+
+uint8_t systime_timed_out(uint64_t start, uint64_t timeout)
+{
+    return systime_elapsed(start) >= timeout;
+}
+
+/*Delay functions, the core timer keeps running for everyone else
+
+  ********************************************
+   *********************************************/
+void delay_us(uint32_t us)
+{
+    uint64_t deadline = systime_deadline_us(us);
+
+    while(!systime_expired(deadline));
+}
+
+void delay_ms(uint32_t ms)
+{
+    uint64_t deadline = systime_deadline(systime_us_to_ticks((uint64_t)ms * 1000));
+
+    while(!systime_expired(deadline));
+}
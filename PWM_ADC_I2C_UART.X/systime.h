@@ -0,0 +1,81 @@
+/* ************************************************************************** */
+/** systime.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+systime.h
+
+@Summary
+ Monotonic time of the system from the core timer
+
+@Description
+ The core timer (CP0 Count) counts at SYS_FREQ/2 and is never written: every module
+ * measures time from the same free running count, so a delay in one can not disturb
+ * the measurements of another.
+ * - systime_count(): the 32 bit count, for intervals shorter than a wrap (42.9s),
+ *   taken as the unsigned difference of two counts. Inlined, usable in RAMFUNCs.
+ * - systime_now(): 64 bit ticks since reset. The high word counts the wraps of the
+ *   count, it is kept up to date by every call and by systime_task() in the scheduler,
+ *   which runs more often than the count wraps.
+ * Deadlines and timeouts are 64 bit tick values and never wrap; delay_us() and
+ * delay_ms() busy wait on them. Conversions between ticks and ns/us/ms are integer.
+ */
+/* ************************************************************************** */
+
+#ifndef _SYSTIME_H    /* Guard against multiple inclusion */
+#define _SYSTIME_H
+
+#include <stdint.h>
+#include "header.h"
+#include "hal.h"
+
+#define SYSTIME_FREQ            (SYS_FREQ / 2)          // ticks per second
+#define SYSTIME_TICKS_PER_US    (SYSTIME_FREQ / 1000000)
+#define SYSTIME_TICKS_PER_MS    (SYSTIME_FREQ / 1000)
+#define SYSTIME_US(us)          ((uint32_t)(us) * SYSTIME_TICKS_PER_US)    // ticks of a constant interval
+#define SYSTIME_MS(ms)          ((uint32_t)(ms) * SYSTIME_TICKS_PER_MS)
+
+_Static_assert(SYSTIME_FREQ % 1000000 == 0, "the core timer does not count whole ticks per us");
+
+/*Count of the core timer, for short intervals*/
+static inline __attribute__((always_inline)) uint32_t systime_count(void)
+{
+    return hal_core_count();
+}
+
+/*Methods for the time
+ *******************************************************************
+ .................*/
+/*Ticks since reset*/
+uint64_t systime_now();
+
+/*Task of the scheduler, counts the wraps of the core timer*/
+void systime_task();
+
+/*Conversions, exact for intervals of any length*/
+uint64_t systime_ticks_to_ns(uint64_t ticks);
+uint64_t systime_ticks_to_us(uint64_t ticks);
+uint64_t systime_ns_to_ticks(uint64_t ns);
+uint64_t systime_us_to_ticks(uint64_t us);
+
+/*Deadlines: the time some ticks from now, and whether it has passed*/
+uint64_t systime_deadline(uint64_t ticks);
+uint64_t systime_deadline_us(uint32_t us);
+uint8_t systime_expired(uint64_t deadline);
+
+/*Timeouts: ticks since a start taken with systime_now(), and whether they exceed a timeout*/
+uint64_t systime_elapsed(uint64_t start);
+uint8_t systime_timed_out(uint64_t start, uint64_t timeout);
+
+/*Busy waits*/
+void delay_us(uint32_t us);
+void delay_ms(uint32_t ms);
+
+#endif /* _SYSTIME_H */
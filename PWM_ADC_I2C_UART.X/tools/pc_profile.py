@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""pc_profile.py
+
+Flat profile per function from the histograms of the PC sampling profiler (pc_sample.c).
+
+Capture the answers to 'q' frames from UART1 into a file, every report in it is added
+up. The addresses are resolved against the symbols of the .elf (with nm, xc32-nm by
+default) or of the .map file of the same build:
+
+    python3 tools/pc_profile.py capture.txt --elf dist/default/production/PWM_ADC_I2C_UART.X.production.elf
+    python3 tools/pc_profile.py capture.txt --map dist/default/production/PWM_ADC_I2C_UART.X.production.map
+
+The map file lists global symbols only, the samples of a static function are counted
+for the global symbol before it; the .elf has both.
+"""
+
+import argparse
+import bisect
+import re
+import subprocess
+import sys
+
+from ram_report import is_code, parse
+
+SAMPLE = re.compile(r'^([0-9a-fA-F]{8}) (\d) (\d+)\s*$')
+HEADER = re.compile(r'^pc samples: (\d+) at (\d+) Hz, lost (\d+) \(ring\) (\d+) \(histogram\)')
+NM = re.compile(r'^([0-9a-fA-F]+) (?:([0-9a-fA-F]+) )?([tTwW]) (\S+)$')
+LEVELS = ['main'] + ['IPL%d' % level for level in range(1, 8)]
+
+
+def read_samples(path):
+    """{(address, level): samples} and the samples lost, of all reports in the capture"""
+    samples = {}
+    lost = 0
+    with (sys.stdin if path == '-' else open(path, errors='replace')) as f:
+        for line in f:
+            line = line.strip()
+            match = HEADER.match(line)
+            if match:
+                lost += int(match.group(3)) + int(match.group(4))
+                continue
+            match = SAMPLE.match(line)
+            if match:
+                key = (int(match.group(1), 16), int(match.group(2)))
+                samples[key] = samples.get(key, 0) + int(match.group(3))
+    return samples, lost
+
+
+def elf_symbols(path, nm):
+    """(address, size or None, name) of the functions in the .elf"""
+    output = subprocess.run([nm, '-n', '-S', '--defined-only', path], check=True,
+                            stdout=subprocess.PIPE, universal_newlines=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        match = NM.match(line.strip())
+        if match:
+            symbols.append((int(match.group(1), 16), int(match.group(2), 16) if match.group(2) else None,
+                            match.group(4)))
+    return symbols
+
+
+def map_symbols(path):
+    """(address, size, name) of the symbols in the code sections of the .map file, a symbol
+    ends at the next one of its section or at the end of the section"""
+    symbols = []
+    for s in parse(path):
+        if not is_code(s['name']):
+            continue
+        ends = [address for address, _ in s['symbols'][1:]] + [s['address'] + s['size']]
+        symbols += [(address, end - address, name) for (address, name), end in zip(s['symbols'], ends)]
+    return symbols
+
+
+class Resolver:
+    def __init__(self, symbols):
+        self.symbols = sorted(set(symbols))
+        self.addresses = [address for address, _, _ in self.symbols]
+
+    def __call__(self, address):
+        i = bisect.bisect_right(self.addresses, address) - 1
+        if i < 0:
+            return None
+        start, size, name = self.symbols[i]
+        if size is not None and address >= start + size:
+            return None
+        if size is None and i + 1 == len(self.symbols):
+            return None     # past the last symbol, its end is unknown
+        return name
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[2])
+    parser.add_argument('capture', help="output of UART1 with the answers to 'q' frames, - for stdin")
+    symbols = parser.add_mutually_exclusive_group(required=True)
+    symbols.add_argument('--elf', help='elf file of the build')
+    symbols.add_argument('--map', help='map file of the build')
+    parser.add_argument('--nm', default='xc32-nm', help='nm of the toolchain (default xc32-nm)')
+    parser.add_argument('--levels', action='store_true', help='one line per function and priority level')
+    parser.add_argument('--top', type=int, default=40, help='lines of the profile (default 40)')
+    args = parser.parse_args()
+
+    samples, lost = read_samples(args.capture)
+    total = sum(samples.values())
+    if not total:
+        print('no samples in %s' % args.capture)
+        return 1
+    resolve = Resolver(elf_symbols(args.elf, args.nm) if args.elf else map_symbols(args.map))
+
+    profile = {}
+    per_level = [0] * len(LEVELS)
+    for (address, level), count in samples.items():
+        name = resolve(address) or '?? 0x%08x' % address
+        key = (name, level) if args.levels else name
+        profile[key] = profile.get(key, 0) + count
+        per_level[level] += count
+
+    print('%d samples, %d lost' % (total, lost))
+    print('  ' + ', '.join('%s %.1f%%' % (LEVELS[level], 100.0 * count / total)
+                           for level, count in enumerate(per_level) if count))
+    print('\n  %6s %8s  %s' % ('%', 'samples', 'function'))
+    for key, count in sorted(profile.items(), key=lambda item: -item[1])[:args.top]:
+        name = '%s (%s)' % (key[0], LEVELS[key[1]]) if args.levels else key
+        print('  %6.2f %8d  %s' % (100.0 * count / total, count, name))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+"""ram_report.py
+
+Report of the code and data that the linker placed in RAM, from the map file of a
+build (dist/default/production/PWM_ADC_I2C_UART.X.production.map).
+
+With --sources the functions marked RAMFUNC in these files are checked: a global one
+must be a symbol in RAM, a static one (not in the map) must leave RAM code in the
+object of its file. The exit code is 1 if one is missing, so the script can run as a
+post build step:
+
+    python3 tools/ram_report.py dist/default/production/PWM_ADC_I2C_UART.X.production.map --sources *.c
+"""
+
+import argparse
+import os
+import re
+import sys
+
+RAM = [(0x80000000, 0x80080000), (0xA0000000, 0xA0080000)]  # KSEG0 and KSEG1, 512KB
+
+SECTION = re.compile(r'^ (\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+))?$')
+CONTINUED = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(.+)$')
+SYMBOL = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+([A-Za-z_.$][\w.$]*)\s*$')
+RAMFUNC = re.compile(r'^(static\s+)?RAMFUNC\s+[\w\s\*]*?\b(\w+)\s*\([^;]*$')
+
+
+def in_ram(address):
+    return any(low <= address < high for low, high in RAM)
+
+
+def is_code(name):
+    return name.startswith('.ramfunc') or name.startswith('.text')
+
+
+def parse(path):
+    """input sections of the memory map with their symbols"""
+    sections = []
+    pending = None
+    with open(path, errors='replace') as f:
+        lines = f.read().splitlines()
+    try:
+        lines = lines[lines.index('Linker script and memory map'):]
+    except ValueError:
+        pass
+    for line in lines:
+        match = SECTION.match(line)
+        if match:
+            if match.group(2) is None:
+                pending = match.group(1)        # name too long, the rest is on the next line
+                continue
+            sections.append({'name': match.group(1), 'address': int(match.group(2), 16),
+                             'size': int(match.group(3), 16), 'object': match.group(4).strip(), 'symbols': []})
+            pending = None
+            continue
+        match = CONTINUED.match(line)
+        if match and pending:
+            sections.append({'name': pending, 'address': int(match.group(1), 16),
+                             'size': int(match.group(2), 16), 'object': match.group(3).strip(), 'symbols': []})
+            pending = None
+            continue
+        pending = None
+        match = SYMBOL.match(line)
+        if match and sections:
+            sections[-1]['symbols'].append((int(match.group(1), 16), match.group(2)))
+    return [s for s in sections if s['size']]
+
+
+def object_name(path):
+    return os.path.basename(path.replace('\\', '/'))
+
+
+def ramfuncs(paths):
+    """(file, function, static) of the RAMFUNC definitions"""
+    found = []
+    for path in paths:
+        with open(path, errors='replace') as f:
+            for line in f:
+                match = RAMFUNC.match(line.strip())
+                if match and not line.rstrip().endswith(';'):
+                    found.append((path, match.group(2), bool(match.group(1))))
+    return found
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[2])
+    parser.add_argument('map', help='map file of the build')
+    parser.add_argument('--sources', nargs='*', default=[], help='C files to check for RAMFUNC')
+    args = parser.parse_args()
+
+    sections = parse(args.map)
+    code = [s for s in sections if in_ram(s['address']) and is_code(s['name'])]
+    data = [s for s in sections if in_ram(s['address']) and not is_code(s['name'])]
+
+    print('Code in RAM')
+    print('  %-10s %6s  %-32s %s' % ('address', 'bytes', 'section/symbol', 'object'))
+    for s in sorted(code, key=lambda s: s['address']):
+        names = ', '.join(name for _, name in s['symbols']) or s['name']
+        print('  0x%08x %6d  %-32s %s' % (s['address'], s['size'], names, object_name(s['object'])))
+    print('  total %d bytes' % sum(s['size'] for s in code))
+
+    print('\nData in RAM, per object')
+    per_object = {}
+    for s in data:
+        per_object[object_name(s['object'])] = per_object.get(object_name(s['object']), 0) + s['size']
+    for name, size in sorted(per_object.items(), key=lambda item: -item[1]):
+        print('  %6d  %s' % (size, name))
+    print('  total %d bytes' % sum(per_object.values()))
+
+    missing = 0
+    if args.sources:
+        ram_symbols = {name for s in code for _, name in s['symbols']}
+        ram_objects = {object_name(s['object']) for s in code}
+        print('\nRAMFUNC check')
+        for path, function, static in ramfuncs(args.sources):
+            obj = os.path.splitext(os.path.basename(path))[0] + '.o'
+            ok = (obj in ram_objects) if static else (function in ram_symbols)
+            missing += not ok
+            print('  %-7s %-28s %s%s' % ('ok' if ok else 'MISSING', function, path, ' (static, by object)' if static else ''))
+    return 1 if missing else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
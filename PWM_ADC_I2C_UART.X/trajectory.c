@@ -0,0 +1,104 @@
+/* ************************************************************************** */
+/** trajectory.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+trajectory.c
+
+@Summary
+ Peripherals used:
+  * None, setpoints are added by the position loop and the reference is read by the current loop
+
+@Description
+ A segment from p0 to p1 with tangents m0 and m1 (per segment) is
+ *  p(t) = (2p0 - 2p1 + m0 + m1)t^3 + (-3p0 + 3p1 - 2m0 - m1)t^2 + m0 t + p0
+ * The tangents are halves of setpoint differences, so the coefficients are stored
+ * doubled to stay integers and the last shift of the evaluation halves them again.
+ * t is Q16 (n/steps, from 1/steps in Q24), the products are 32x32 to 64 bits and
+ * every partial result is rounded back to 32 bits, the coefficients need at most 20
+ * bits for Q15 positions. Velocity and acceleration come from the doubled integer
+ * coefficients, so they have steps of rate/2 and rate^2/2 (50 Q15/s and 5000 Q15/s^2
+ * at 100Hz).
+ */
+/* ************************************************************************** */
+
+#include "trajectory.h"
+
+
+/*Function to start at rest*/
+void trajectory_init(traj_t *traj, int16_t position, uint16_t steps, uint16_t fs)
+{
+    traj->p[0] = traj->p[1] = traj->p[2] = position;
+    traj->a = traj->b = traj->c = 0;
+    traj->d = position;
+    traj->steps = steps;
+    traj->dt = ((1 << 24) + steps / 2) / steps;
+    traj->rate = fs / steps;
+    traj->n = steps;        // hold until the first segment
+}
+
+/*Function to add a setpoint and start the segment from p[1] to p[2]*/
+void trajectory_push(traj_t *traj, int16_t setpoint)
+{
+    int32_t p0 = traj->p[1], p1 = traj->p[2];
+    int32_t m0 = p1 - traj->p[0];       // doubled tangents
+    int32_t m1 = setpoint - p0;
+
+    traj->a = 4 * (p0 - p1) + m0 + m1;  // doubled coefficients
+    traj->b = 6 * (p1 - p0) - 2 * m0 - m1;
+    traj->c = m0;
+    traj->d = p0;
+    traj->p[0] = traj->p[1];
+    traj->p[1] = traj->p[2];
+    traj->p[2] = setpoint;
+    traj->n = 0;
+}
+
+//clamp a 64 bit number to 32 bits
+static inline __attribute__((always_inline)) int32_t trajectory_saturate(int64_t x)
+{
+    if(x > INT32_MAX)
+        return INT32_MAX;
+    if(x < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)x;
+}
+
+/*Function to evaluate the segment at the next fast tick*/
+RAMFUNC void trajectory_step(traj_t *traj, traj_point_t *point)
+{
+    int32_t t, x;
+
+    if(traj->n >= traj->steps)
+    {
+        /*no setpoint followed, hold the end of the segment*/
+        point->position = traj->p[1];
+        point->velocity = 0;
+        point->acceleration = 0;
+        return;
+    }
+    t = (int32_t)((traj->n * traj->dt + 0x80) >> 8);
+    ++traj->n;
+
+    //position, Horner: ((a t + b) t + c) t / 2 + d, every product rounded
+    x = (int32_t)(((int64_t)traj->a * t + 0x8000) >> 16) + traj->b;
+    x = (int32_t)(((int64_t)x * t + 0x8000) >> 16) + traj->c;
+    x = traj->d + (int32_t)(((int64_t)x * t + 0x10000) >> 17);
+    point->position = x > INT16_MAX ? INT16_MAX : x < INT16_MIN ? INT16_MIN : (int16_t)x;  // overshoot of large steps
+
+    //velocity, (3a t + 2b) t + c per segment
+    x = (int32_t)(((int64_t)(3 * traj->a) * t + 0x8000) >> 16) + 2 * traj->b;
+    x = (int32_t)(((int64_t)x * t + 0x8000) >> 16) + traj->c;
+    point->velocity = trajectory_saturate(((int64_t)x * traj->rate) >> 1);
+
+    //acceleration, 6a t + 2b per segment^2
+    x = (int32_t)(((int64_t)(6 * traj->a) * t + 0x8000) >> 16) + 2 * traj->b;
+    point->acceleration = trajectory_saturate(((int64_t)x * traj->rate * traj->rate) >> 1);
+}
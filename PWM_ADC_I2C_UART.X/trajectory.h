@@ -0,0 +1,70 @@
+/* ************************************************************************** */
+/** trajectory.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+trajectory.h
+
+@Summary
+ Cubic Hermite interpolation of coarse setpoints for the fast loops
+
+@Description
+ Setpoints arrive at the rate of the position loop, the current loop runs [steps]
+ * times faster. Between two setpoints the reference follows a cubic Hermite segment
+ * with Catmull-Rom tangents, (p[k+1]-p[k-1])/2, so position and velocity are
+ * continuous at the setpoints and the segment passes through them. The tangent at
+ * the end of a segment needs the setpoint after it, so a setpoint is reached two
+ * setpoints after it is added: one period waiting for the next setpoint and one
+ * travelling the segment.
+ * All arithmetic is fixed point. trajectory_push() computes the polynomial of a
+ * segment once per setpoint, trajectory_step() evaluates it with three multiply-adds
+ * per output (Horner), neither has a loop or a division.
+ * Positions are Q15 angles (see ANGLE_TO_Q15) and must not wrap around.
+ */
+/* ************************************************************************** */
+
+#ifndef _TRAJECTORY_H    /* Guard against multiple inclusion */
+#define _TRAJECTORY_H
+
+#include <stdint.h>
+#include "ramfunc.h"
+
+/*Reference at a fast tick*/
+typedef struct
+{
+    int16_t position;       // Q15
+    int32_t velocity;       // Q15 per second
+    int32_t acceleration;   // Q15 per second^2
+} traj_point_t;
+
+/*Interpolator of one joint*/
+typedef struct
+{
+    int32_t a, b, c, d;     // p(t) = a*t^3 + b*t^2 + c*t + d, t = 0 ... 1 over a segment
+    int16_t p[3];           // last three setpoints, p[2] the newest
+    uint16_t n;             // fast ticks into the segment
+    uint16_t steps;         // fast ticks per setpoint
+    uint32_t dt;            // 1/steps in Q24
+    int32_t rate;           // setpoints per second
+} traj_t;
+
+/*Methods for the interpolation
+ *******************************************************************
+ .................*/
+/*Start at rest at position, with steps fast ticks of fs per setpoint*/
+void trajectory_init(traj_t *traj, int16_t position, uint16_t steps, uint16_t fs);
+
+/*Add a setpoint, starts the segment to the setpoint before it*/
+void trajectory_push(traj_t *traj, int16_t setpoint);
+
+/*Reference of the next fast tick. The end of the segment is held if no setpoint follows*/
+RAMFUNC void trajectory_step(traj_t *traj, traj_point_t *point);
+
+#endif /* _TRAJECTORY_H */
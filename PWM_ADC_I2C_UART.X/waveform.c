@@ -0,0 +1,259 @@
+/* ************************************************************************** */
+/** waveform.c
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+waveform.c
+
+@Summary
+ Peripherals used:
+  * DMA2 - table of the knee motor to OC1RS on the Timer2 request
+  * DMA3 - table of the ankle motor to OC2RS on the Timer2 request
+
+@Description
+ Both channels move one 16 bit sample per period of the PWM. With auto enable a channel
+ * starts again from the first sample at the end of the block, which loops the table.
+ * The source half empty and block done interrupts of DMA2 mark the end of the first and
+ * the second half for streaming. The tables are uncached buffers of dma_buf.c so the
+ * DMA sees the samples as soon as they are written.
+ *
+ * Payload of the 'W' frames from the host (see UART.h), numbers are little endian:
+ *  'L' channel(1) offset(2) count(2) samples(2*count)
+ *      load count (at most WAVE_FRAME_SAMPLES) 16 bit duty cycles
+ *  'P' mode(1) length(2)   start the playback
+ *  'S'                     stop the playback
+ *  'Q'                     state of the playback
+ * Every frame is answered by a line: OK, ERR or the state. At 38400 baud about 1900
+ * samples are loaded per second, so streaming over the serial link keeps up only with
+ * tables that are played a few times slower than they are loaded; a table played in a
+ * loop is not limited.
+ */
+/* ************************************************************************** */
+
+#include <xc.h>
+#include <stdio.h>
+#include "header.h"
+#include <proc/p32mz2048efm100.h>
+#include "waveform.h"
+#include "PWM.h"
+#include "control.h"
+#include "UART.h"
+#include "autotune.h"
+#include "dma_buf.h"
+#include "isr_profile.h"
+
+#define WAVE_FRAME_SAMPLES  64      // largest load frame
+
+/*Tables in uncached memory, compare values of OC1RS and OC2RS; allocated by waveform_init()*/
+static uint16_t (*wave_table)[WAVE_LENGTH] = 0;
+
+static volatile uint8_t playing = 0, mode, loaded[2];
+static volatile uint16_t half_length;
+static volatile uint32_t underruns = 0;
+static uint8_t dither[WAVE_CHANNELS];       // dithering of the channels before the playback
+
+
+/*Function to setup the DMA channels, they are enabled by waveform_start()*/
+void waveform_init()
+{
+    DMACONbits.ON = 1;      // Turn on the DMA controller
+    if(!wave_table)
+        wave_table = dma_buf_alloc(sizeof(*wave_table) * WAVE_CHANNELS, DMA_BUF_UNCACHED);
+
+    DCH2CON = 0;
+    DCH2ECON = 0;
+    DCH2INT = 0;
+    DCH2CONbits.CHPRI = 1;  // priority 1, below the SPI2 channels
+    DCH2ECONbits.CHSIRQ = _TIMER_2_VECTOR; // Transfer at the end of every period of the PWM
+    DCH2ECONbits.SIRQEN = 1;
+    DCH2SSA = dma_buf_phys(wave_table[0]);
+    DCH2DSA = KVA_TO_PA(&OC1RS);
+    DCH2DSIZ = 2;
+    DCH2CSIZ = 2;           // One sample per request
+    DCH2INTbits.CHSHIE = 1; // Interrupt at the end of the first half
+    DCH2INTbits.CHBCIE = 1; // and at the end of the second half
+
+    DCH3CON = 0;
+    DCH3ECON = 0;
+    DCH3INT = 0;
+    DCH3CONbits.CHPRI = 1;
+    DCH3ECONbits.CHSIRQ = _TIMER_2_VECTOR;
+    DCH3ECONbits.SIRQEN = 1;
+    DCH3SSA = dma_buf_phys(wave_table[1]);
+    DCH3DSA = KVA_TO_PA(&OC2RS);
+    DCH3DSIZ = 2;
+    DCH3CSIZ = 2;
+
+    reg_clear(&IFS4, _IFS4_DMA2IF_MASK);            // Clear interrupt flag for DMA2
+    IPC34bits.DMA2IP = WAVE_DMA_IPL;// Interrupt priority
+    IPC34bits.DMA2IS = 0;           // Sub-priority 0
+    IEC4bits.DMA2IE = 1;            // Enable DMA2 interrupt
+    underruns = 0;
+}
+
+/*Function to convert and copy duty cycles into a table*/
+uint8_t waveform_load(uint8_t channel, uint16_t offset, const uint16_t *duty, uint16_t count)
+{
+    uint16_t i;
+
+    if(channel >= WAVE_CHANNELS || (uint32_t)offset + count > WAVE_LENGTH)
+        return 0;
+    for(i = 0; i < count; ++i)
+        wave_table[channel][offset + i] = (uint16_t)PWM_compare(duty[i]);
+
+    /*a half is loaded once its last sample is, for the last channel*/
+    if(playing && mode == WAVE_MODE_STREAM && channel == WAVE_CHANNELS - 1 && count)
+    {
+        if(offset + count == half_length)
+            loaded[0] = 1;
+        else if(offset + count == 2 * half_length)
+            loaded[1] = 1;
+    }
+    return 1;
+}
+
+/*Function to start both channels in the same period*/
+uint8_t waveform_start(uint8_t new_mode, uint16_t length)
+{
+    uint32_t status;
+    uint8_t channel;
+
+    if(control_enabled || autotune_running(NUMBER_OF_JOINTS) || length < 2 || length > WAVE_LENGTH || length & 1)
+        return 0;
+    waveform_stop();
+
+    for(channel = 0; channel < WAVE_CHANNELS; ++channel)
+    {
+        dither[channel] = PWM_dithered(channel);
+        PWM_set_dither(channel, 0);     // the DMA is the only writer of OCxRS
+    }
+    mode = new_mode;
+    half_length = length / 2;
+    loaded[0] = loaded[1] = 1;          // both halves are loaded before the start
+    DCH2SSIZ = 2 * length;
+    DCH3SSIZ = 2 * length;
+    DCH2INTCLR = 0xFF;                  // Clear the flags of both channels
+    DCH3INTCLR = 0xFF;
+    reg_clear(&IFS4, _IFS4_DMA2IF_MASK);
+
+    status = __builtin_disable_interrupts();
+    PWM_wait_period();                  // far from the next request
+    DCH2CONbits.CHAEN = 1;              // start again at the end of the table
+    DCH3CONbits.CHAEN = 1;
+    DCH2CONbits.CHEN = 1;
+    DCH3CONbits.CHEN = 1;
+    playing = 1;
+    __builtin_mtc0(12, 0, status);
+    return 1;
+}
+
+/*Function to stop both channels, the last sample stays until the duty cycles are restored*/
+void waveform_stop()
+{
+    uint8_t channel;
+
+    DCH2CONbits.CHAEN = 0;
+    DCH3CONbits.CHAEN = 0;
+    DCH2CONbits.CHEN = 0;
+    DCH3CONbits.CHEN = 0;
+    if(playing)
+    {
+        playing = 0;
+        for(channel = 0; channel < WAVE_CHANNELS; ++channel)
+            PWM_set_dither(channel, dither[channel]);  // writes the duty cycle of the driver to OCxRS
+    }
+}
+
+uint8_t waveform_playing()
+{
+    return playing;
+}
+
+int8_t waveform_free_half()
+{
+    if(!playing || mode != WAVE_MODE_STREAM)
+        return -1;
+    if(!loaded[0])
+        return 0;
+    if(!loaded[1])
+        return 1;
+    return -1;
+}
+
+uint32_t waveform_underruns()
+{
+    return underruns;
+}
+
+
+/*ISR for DMA2 at the end of each half of the table*/
+void __attribute__((vector(_DMA2_VECTOR), interrupt(ipl2srs), nomips16)) waveform_dma_isr()
+{
+    uint8_t half = DCH2INTbits.CHBCIF;  // 0: first half played, 1: second half played
+
+    ISR_PROFILE_ENTER(ISR_ID_WAVEFORM_DMA);
+    DCH2INTCLR = 0xFF;      // Clear the flags of the channel
+    reg_clear(&IFS4, _IFS4_DMA2IF_MASK);    // Clear interrupt flag for DMA2
+    if(playing && mode == WAVE_MODE_STREAM)
+    {
+        loaded[half] = 0;
+        if(!loaded[half ^ 1])
+        {
+            ++underruns;    // the other half is played again, stop
+            waveform_stop();
+        }
+    }
+    ISR_PROFILE_EXIT(ISR_ID_WAVEFORM_DMA);
+}
+
+
+/*Serial link*/
+//little endian 16 bit number
+static uint16_t waveform_u16(const uint8_t *bytes)
+{
+    return bytes[0] | (uint16_t)bytes[1] << 8;
+}
+
+/*Function to execute the payload of a 'W' frame*/
+void waveform_command(const uint8_t *payload, uint8_t length)
+{
+    uint16_t samples[WAVE_FRAME_SAMPLES], count, i;
+    char msg[64];
+    uint8_t ok = 0;
+
+    if(!length)
+        return;
+    switch(payload[0])
+    {
+        case 'L':
+            count = length >= 6 ? waveform_u16(&payload[4]) : 0;
+            if(count && count <= WAVE_FRAME_SAMPLES && length == 6 + 2 * count)
+            {
+                for(i = 0; i < count; ++i)
+                    samples[i] = waveform_u16(&payload[6 + 2 * i]);
+                ok = waveform_load(payload[1], waveform_u16(&payload[2]), samples, count);
+            }
+            break;
+        case 'P':
+            if(length == 4)
+                ok = waveform_start(payload[1], waveform_u16(&payload[2]));
+            break;
+        case 'S':
+            waveform_stop();
+            ok = 1;
+            break;
+        case 'Q':
+            sprintf(msg, "WAVE playing %u free %d underruns %lu\r\n", playing, waveform_free_half(),
+                    (unsigned long)underruns);
+            WriteUART(msg);
+            return;
+    }
+    WriteUART(ok ? "OK\r\n" : "ERR\r\n");
+}
@@ -0,0 +1,79 @@
+/* ************************************************************************** */
+/** waveform.h
+
+@Author
+Aniket Mazumder
+Department of Robotics
+a.mazumder@rug.nl
+
+@Company
+University of Groningen
+
+  @File Name
+waveform.h
+
+@Summary
+ Playback of duty cycle waveforms on the motor PWM by DMA
+
+@Description
+ Each motor channel has a table of WAVE_LENGTH samples in RAM. At every period of the
+ * PWM, Timer2 triggers DMA2 and DMA3 and they copy the next sample of the tables to
+ * OC1RS and OC2RS, the CPU is not involved. The samples are stored as compare values, the
+ * 16 bit duty cycles are converted when they are loaded, so load them again after the
+ * frequency of the PWM is changed.
+ * Modes:
+ *  - WAVE_MODE_LOOP: the first [length] samples are played over and over
+ *  - WAVE_MODE_STREAM: the table is played as two halves. Once a half is played it is
+ *    free and has to be loaded again before the other half ends, otherwise the playback
+ *    stops (underrun). waveform_free_half() returns the half to load.
+ * While a waveform plays the duty cycles of the motors are not dithered and the current
+ * loop must not run; at the end the duty cycles set before the playback are restored.
+ * Serial link: waveform_command() executes the 'W' frames of the host, see waveform.c.
+ */
+/* ************************************************************************** */
+
+#ifndef _WAVEFORM_H    /* Guard against multiple inclusion */
+#define _WAVEFORM_H
+
+#include <stdint.h>
+
+#define WAVE_LENGTH     4096    // samples per channel, 205ms at 20KHz
+#define WAVE_CHANNELS   2       // OC1 (knee) and OC2 (ankle), played together
+#define WAVE_DMA_IPL    2       // priority of the interrupt of the halves
+
+/*Playback modes*/
+#define WAVE_MODE_LOOP      0
+#define WAVE_MODE_STREAM    1
+
+/*Methods for the playback
+ *******************************************************************
+ .................*/
+/*Setup DMA2 and DMA3, the PWM has to be initialized*/
+void waveform_init();
+
+/*Load count 16 bit duty cycles (see PWM_set_duty16()) into the table of a channel from
+ * the sample at offset. Returns 0 if they do not fit in the table*/
+uint8_t waveform_load(uint8_t channel, uint16_t offset, const uint16_t *duty, uint16_t count);
+
+/*Start playing the first length samples (even, at least 2) of the tables in the given mode,
+ * both channels start in the same period. Returns 0 if the current loop is running or a
+ * joint is tuned (autotune.h)*/
+uint8_t waveform_start(uint8_t mode, uint16_t length);
+
+/*Stop the playback and restore the duty cycles*/
+void waveform_stop();
+
+/*1 while a waveform is played*/
+uint8_t waveform_playing();
+
+/*Streaming: half (0 or 1) that has been played and can be loaded, -1 if none. Loading the
+ * last sample of a half marks it as loaded*/
+int8_t waveform_free_half();
+
+/*Number of underruns since waveform_init()*/
+uint32_t waveform_underruns();
+
+/*Execute the payload of a 'W' frame from the host*/
+void waveform_command(const uint8_t *payload, uint8_t length);
+
+#endif /* _WAVEFORM_H */